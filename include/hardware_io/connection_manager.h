@@ -61,8 +61,8 @@ public:
     void run();
 
 signals:
-    bool read_message(void* message, int mavlink_channel_);
-    bool message_received(void* message, qint64 msg_time_stamp);
+    bool read_message(void* message, int mavlink_channel_, qint64* rx_time_ns);
+    bool message_received(void* message, qint64 msg_time_ns); // time_base receive stamp
     int write_message(void* message);
 
 private:
@@ -75,18 +75,20 @@ private:
  *
  * This object defines system status thread,
  * which runs at 1 Hz and serves as an internal
- * clock / syncronization counter. We need this
+ * clock / syncronization counter. Dispatched by
+ * the shared periodic scheduler. We need this
  * if we want to sent heartbeat MAVLINK message
  * though any of the ports.
  */
-class system_status_thread  : public generic_thread
+class system_status_thread  : public periodic_task
 {
     Q_OBJECT
 public:
     explicit system_status_thread(QObject* parent, generic_thread_settings* settings_in_, kgroundcontrol_settings* kground_control_settings_in_);
     ~system_status_thread();
 
-    void run();
+protected:
+    void tick() override;
 
 public slots:
     void update_kgroundcontrol_settings(kgroundcontrol_settings* kground_control_settings_in_);
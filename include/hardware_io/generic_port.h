@@ -37,6 +37,7 @@
 
 #include <QObject>
 #include <QString>
+#include <QVector>
 
 //#include "mavlink_types.h"
 #include "settings.h"
@@ -70,7 +71,9 @@ signals:
     int ready_to_forward_new_data(QByteArray &new_data);
 
 public slots:
-    virtual bool read_message(void* message, int mavlink_channel_)=0;
+    // rx_time_ns (optional) receives the time_base stamp of the read that
+    // delivered the final byte of the returned message
+    virtual bool read_message(void* message, int mavlink_channel_, qint64* rx_time_ns)=0;
     virtual int write_message(void* message)=0;
     virtual int write_to_port(QByteArray message)=0;
 
@@ -80,7 +83,46 @@ public slots:
     virtual QString get_settings_QString(void)=0;
     virtual void get_settings(void* current_settings)=0;
 
+protected:
+    /*
+     * Receive timestamp bookkeeping
+     *
+     * Ports stamp every chunk appended to their rx buffer with the time it
+     * was read (buffered_size is the buffer size after the append). When a
+     * message is parsed out, consume_rx_bytes() returns the stamp of the chunk
+     * that completed it. Callers hold the port mutex.
+     */
+    void stamp_rx_bytes(int buffered_size, qint64 t_ns)
+    {
+        if (!rx_stamps_.isEmpty() && rx_stamps_.last().t_ns == t_ns)
+            rx_stamps_.last().end_offset = buffered_size;
+        else
+            rx_stamps_.append({buffered_size, t_ns});
+    }
+    qint64 consume_rx_bytes(int count)
+    {
+        qint64 t_ns = 0;
+        int drop = 0;
+        for (const rx_stamp& stamp : rx_stamps_)
+        {
+            t_ns = stamp.t_ns;
+            if (stamp.end_offset >= count) break;
+            drop++;
+        }
+        rx_stamps_.remove(0, drop);
+        for (rx_stamp& stamp : rx_stamps_) stamp.end_offset -= count;
+        if (!rx_stamps_.isEmpty() && rx_stamps_.first().end_offset <= 0) rx_stamps_.removeFirst();
+        return t_ns;
+    }
+    void clear_rx_stamps(void) { rx_stamps_.clear(); }
+
 private:
+    struct rx_stamp
+    {
+        int end_offset; // buffer offset one past the last byte of this chunk
+        qint64 t_ns;
+    };
+    QVector<rx_stamp> rx_stamps_;
     QString logical_name_ = "unknown_port";
 };
 
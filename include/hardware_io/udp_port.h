@@ -69,7 +69,7 @@ public:
 
     // void cleanup(void);
 public slots:
-    bool read_message(void* message, int mavlink_channel_);
+    bool read_message(void* message, int mavlink_channel_, qint64* rx_time_ns);
     int write_message(void* message);
     int write_to_port(QByteArray message);
 
@@ -44,6 +44,11 @@
 #include "plot/plotting_manager.h"
 #include "update_manager.h"
 #include "mavlink_communication/remote_control_manager.h"
+#include "mavlink_communication/parameter_manager.h"
+#include "mavlink_communication/ftp_client.h"
+#include "mavlink_communication/command_manager.h"
+#include "mavlink_communication/timesync_manager.h"
+#include "mavlink_communication/stream_rate_manager.h"
 
 // Forward declarations
 class QDialog;
@@ -53,6 +58,10 @@ class QWidget;
 class QCheckBox;
 class QLineEdit;
 class QPushButton;
+class QComboBox;
+class QSpinBox;
+class QDoubleSpinBox;
+class QPlainTextEdit;
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -182,7 +191,21 @@ private:
     QLineEdit* log_directory_display_ = nullptr;
     QPushButton* log_directory_change_button_ = nullptr;
 
+    QComboBox* realtime_policy_cmbx_[realtime_settings::THREAD_CLASS_COUNT] = {};
+    QSpinBox* realtime_priority_spin_[realtime_settings::THREAD_CLASS_COUNT] = {};
+    QLineEdit* realtime_cpus_txt_[realtime_settings::THREAD_CLASS_COUNT] = {};
+    QCheckBox* realtime_lock_memory_checkbox_ = nullptr;
+    QDoubleSpinBox* mavlink_history_spin_ = nullptr;
+    QCheckBox* stream_rate_auto_checkbox_ = nullptr;
+    QSpinBox* stream_budget_spin_ = nullptr;
+    QPlainTextEdit* realtime_report_txt_ = nullptr;
+
     mavlink_manager* mavlink_manager_ = nullptr;
+    parameter_manager* parameter_manager_ = nullptr;
+    ftp_client* ftp_client_ = nullptr;
+    command_manager* command_manager_ = nullptr;
+    timesync_manager* timesync_manager_ = nullptr;
+    stream_rate_manager* stream_rate_manager_ = nullptr;
     // no persistent plotting manager; each click spawns a new window
     // system_status_thread* systhread_ = nullptr;
     // mocap_thread* mocap_thread_ = nullptr;
@@ -192,5 +215,6 @@ private:
     void load_settings(void);
     void updateAllWidgetsFont(QWidget* parent, const QFont& font);
     void setupSettingsGroups(void);
+    void sync_realtime_widgets(void);
 };
 #endif // KGROUNDCONTROL_H
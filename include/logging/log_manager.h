@@ -4,16 +4,17 @@
 #include <QHash>
 #include <QMutex>
 #include <QString>
+#include <QVector>
 
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
-#include <deque>
 #include <mutex>
 #include <thread>
 
 #define MAVLINK_USE_MESSAGE_INFO
 #include "all/mavlink.h"
+#include "mavlink_communication/mavlink_packed_message.h"
 #include "settings.h"
 
 class log_manager {
@@ -29,8 +30,8 @@ public:
 
     void apply_settings(const kgroundcontrol_settings& settings);
 
-    // Log one fully parsed inbound MAVLink message.
-    void log_incoming_message(const QString& port_name, const mavlink_message_t& message);
+    // Log one fully parsed inbound MAVLink message, stamped with its time_base receive time.
+    void log_incoming_message(const QString& port_name, const mavlink_message_t& message, qint64 rx_time_ns);
 
     // Log one fully parsed outbound MAVLink message.
     void log_outgoing_message(const QString& port_name, const mavlink_message_t& message);
@@ -40,11 +41,10 @@ public:
 
     void shutdown();
 
+    // One record as seen by the writer, unpacked from the queue
     struct packet_record {
-        uint64_t timestamp_us = 0;
+        uint64_t timestamp_us = 0; // time_base (monotonic) microseconds
         uint8_t direction_value = static_cast<uint8_t>(io_direction::incoming);
-        QString port_name;
-        QString topic_name;
         mavlink_message_t message{};
     };
 
@@ -55,8 +55,18 @@ private:
     log_manager(const log_manager&) = delete;
     log_manager& operator=(const log_manager&) = delete;
 
-    static packet_record make_record(io_direction dir, const QString& port_name, const mavlink_message_t& message);
-    void enqueue_record(packet_record&& record);
+    // Queued records, column-wise: messages are packed back to back and port
+    // names are interned, so a queued heartbeat is a few dozen bytes and no strings.
+    struct record_batch {
+        QVector<uint64_t> timestamp_us;
+        QVector<uint8_t> direction_value;
+        QVector<quint16> port_id;
+        mavlink_packed::arena messages;
+
+        bool empty() const { return timestamp_us.isEmpty(); }
+    };
+
+    void enqueue_record(io_direction dir, const QString& port_name, const mavlink_message_t& message, qint64 t_ns);
 
     void writer_loop();
 
@@ -68,7 +78,9 @@ private:
 
     std::mutex state_mutex_;
     std::condition_variable state_cv_;
-    std::deque<packet_record> queue_;
+    record_batch queue_;
+    QHash<QString, quint16> port_ids_;  // guarded by state_mutex_
+    QVector<QString> port_names_;       // port_id -> name, append-only
 
     bool stop_requested_ = false;
     bool config_dirty_ = true;
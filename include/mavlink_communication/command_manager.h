@@ -0,0 +1,187 @@
+/****************************************************************************
+ *
+ *    Copyright (C) 2025  Yevhenii Kovryzhenko. All rights reserved.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU Affero General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License Version 3 for more details.
+ *
+ *    You should have received a copy of the
+ *    GNU Affero General Public License Version 3
+ *    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions, and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions, and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *    3. No ownership or credit shall be claimed by anyone not mentioned in
+ *       the above copyright statement.
+ *    4. Any redistribution or public use of this software, in whole or in part,
+ *       whether standalone or as part of a different project, must remain
+ *       under the terms of the GNU Affero General Public License Version 3,
+ *       and all distributions in binary form must be accompanied by a copy of
+ *       the source code, as stated in the GNU Affero General Public License.
+ *
+ ****************************************************************************/
+
+#ifndef COMMAND_MANAGER_H
+#define COMMAND_MANAGER_H
+
+#include <QHash>
+#include <QVector>
+#include <QString>
+#include <QPointer>
+#include <atomic>
+
+#include "mavlink_communication/mavlink_inspector.h"
+#include "threads.h"
+#include "settings.h"
+
+/*
+ * Command RTT Statistics
+ *
+ * Per-vehicle COMMAND_LONG outcome counters and a histogram of command
+ * round-trip times (send to COMMAND_ACK receive stamp). Buckets follow a
+ * 1-2-5 series from 5 ms to 2 s; the last bucket collects everything slower.
+ */
+struct command_rtt_stats
+{
+    static constexpr int BUCKET_COUNT = 10;
+
+    quint64 counts[BUCKET_COUNT] = {};
+    quint64 sent = 0;
+    quint64 accepted = 0;
+    quint64 rejected = 0; // any final result other than ACCEPTED
+    quint64 timeouts = 0;
+    quint64 retries = 0;
+    quint64 samples = 0;
+    qint64 min_ns = 0;
+    qint64 max_ns = 0;
+    double mean_ns = 0.0;
+
+    void record(qint64 rtt_ns);
+    QString get_QString(void) const;
+
+    static qint64 bucket_upper_ns(int bucket);
+};
+
+/*
+ * Command Manager Class
+ *
+ * COMMAND_LONG transactions with acknowledgement. Every command is tracked
+ * per (sysid, compid, command) until its COMMAND_ACK arrives; on timeout it
+ * is resent with an incremented confirmation field and a doubled timeout.
+ * MAV_RESULT_IN_PROGRESS keeps the transaction open without retrying.
+ * Any number of transactions can be in flight across vehicles; a new command
+ * with the same key supersedes the pending one.
+ *
+ * Round-trip times are recorded per vehicle, only for commands acknowledged
+ * on their first transmission (an ACK after a retry cannot be attributed
+ * to a particular attempt).
+ */
+class command_manager : public periodic_task, public mavlink_message_sink
+{
+    Q_OBJECT
+
+public:
+    explicit command_manager(QObject* parent, generic_thread_settings* settings_in_, mavlink_manager* mavlink_manager_in_);
+    ~command_manager();
+
+    static constexpr int max_attempts = 5;
+    static constexpr qint64 initial_timeout_ns = 250000000LL;      // doubled on every retry
+    static constexpr qint64 max_timeout_ns = 2000000000LL;
+    static constexpr qint64 in_progress_timeout_ns = 10000000000LL; // after MAV_RESULT_IN_PROGRESS
+    static constexpr size_t inbox_capacity = 1024;
+
+    // local outcomes, next to the MAV_RESULT values (>= 0)
+    enum local_result
+    {
+        RESULT_TIMEOUT = -1,
+        RESULT_SUPERSEDED = -2,
+        RESULT_SEND_FAILED = -3
+    };
+    static QString result_QString(int result);
+
+    // mavlink_message_sink, aggregation thread
+    void on_message(const mavlink_message_t& msg, qint64 t_ns) override;
+
+public slots:
+    // Thread-safe; the first transmission happens in the calling thread.
+    // Returns the transaction id passed to command_finished().
+    quint64 send_command(QString port_name, uint8_t sysid, uint8_t compid, uint16_t command, QVector<float> params);
+    bool toggle_arm_state(QString port_name, uint8_t sys_id_, mavlink_enums::mavlink_component_id mav_component_, bool flag, bool force);
+
+    int get_in_flight_count(void);
+    bool get_rtt_stats(uint8_t sysid, command_rtt_stats &stats_out);
+    QString get_report_QString(void);
+
+    void update_kgroundcontrol_settings(kgroundcontrol_settings* kground_control_settings_in_);
+
+signals:
+    int write_message(QString port_name, void* message);
+    void command_finished(quint64 transaction_id, uint8_t sysid, uint8_t compid, uint16_t command, int result, qint64 rtt_ns);
+
+protected:
+    void tick() override;
+
+private:
+    struct inbox_entry
+    {
+        qint64 t_ns;
+        uint8_t sysid;
+        uint8_t compid;
+        mavlink_command_ack_t ack;
+    };
+
+    struct transaction
+    {
+        quint64 id = 0;
+        QString port_name;
+        uint8_t sysid = 0;
+        uint8_t compid = 0;
+        uint16_t command = 0;
+        float params[7] = {};
+        uint8_t confirmation = 0;
+        int attempts = 0;
+        qint64 sent_ns = 0;
+        qint64 deadline_ns = 0;
+        bool in_progress = false;
+    };
+
+    struct finished_transaction
+    {
+        quint64 id;
+        uint8_t sysid;
+        uint8_t compid;
+        uint16_t command;
+        int result;
+        qint64 rtt_ns;
+    };
+
+    static quint64 transaction_key(uint8_t sysid, uint8_t compid, uint16_t command)
+    {
+        return (static_cast<quint64>(sysid) << 24) | (static_cast<quint64>(compid) << 16) | command;
+    }
+    void pack(const transaction &t, mavlink_message_t &message_out);
+    void finish(QHash<quint64, transaction>::iterator it, int result, qint64 rtt_ns);
+
+    QPointer<mavlink_manager> mavlink_manager_;
+    mpsc_ring<inbox_entry> inbox_{inbox_capacity};
+    std::atomic<quint64> inbox_dropped_{0};
+
+    QHash<quint64, transaction> in_flight_;   // guarded by mutex
+    QHash<uint8_t, command_rtt_stats> stats_; // by sysid, guarded by mutex
+    quint64 next_id_ = 1;
+    QVector<finished_transaction> finished_;  // emitted after unlocking
+    kgroundcontrol_settings kgroundcontrol_settings_;
+};
+
+#endif // COMMAND_MANAGER_H
@@ -0,0 +1,193 @@
+/****************************************************************************
+ *
+ *    Copyright (C) 2025  Yevhenii Kovryzhenko. All rights reserved.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU Affero General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License Version 3 for more details.
+ *
+ *    You should have received a copy of the
+ *    GNU Affero General Public License Version 3
+ *    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions, and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions, and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *    3. No ownership or credit shall be claimed by anyone not mentioned in
+ *       the above copyright statement.
+ *    4. Any redistribution or public use of this software, in whole or in part,
+ *       whether standalone or as part of a different project, must remain
+ *       under the terms of the GNU Affero General Public License Version 3,
+ *       and all distributions in binary form must be accompanied by a copy of
+ *       the source code, as stated in the GNU Affero General Public License.
+ *
+ ****************************************************************************/
+
+#ifndef FTP_CLIENT_H
+#define FTP_CLIENT_H
+
+#include <QWidget>
+#include <QHash>
+#include <QFile>
+#include <QVector>
+#include <QString>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QProgressBar>
+#include <QTreeWidget>
+#include <QTimer>
+#include <QPointer>
+#include <atomic>
+#include <memory>
+
+#include "mavlink_communication/ftp_session.h"
+#include "mavlink_communication/mavlink_inspector.h"
+#include "threads.h"
+#include "settings.h"
+
+/*
+ * FTP Client Class
+ *
+ * Runs one ftp_session per (sysid, compid) over a connection_manager port.
+ * FILE_TRANSFER_PROTOCOL replies arrive through the mavlink_manager message
+ * sink and are handed to tick() through an mpsc_ring. tick() runs on the
+ * shared scheduler thread, so downloaded data is only queued there; a
+ * non real-time job_thread opens, preallocates, writes and closes the file.
+ */
+class ftp_client : public periodic_task, public mavlink_message_sink
+{
+    Q_OBJECT
+
+public:
+    explicit ftp_client(QObject* parent, generic_thread_settings* settings_in_, mavlink_manager* mavlink_manager_in_);
+    ~ftp_client();
+
+    static constexpr size_t inbox_capacity = 4096; // a full burst between two ticks
+    static constexpr size_t writer_capacity = 16384; // chunks the disk may fall behind by
+
+    // mavlink_message_sink, aggregation thread
+    void on_message(const mavlink_message_t& msg, qint64 t_ns) override;
+
+public slots:
+    bool download(QString port_name, uint8_t sysid, uint8_t compid, QString remote_path, QString local_path);
+    bool list_directory(QString port_name, uint8_t sysid, uint8_t compid, QString remote_path);
+    void cancel(uint8_t sysid, uint8_t compid);
+
+    bool get_status(uint8_t sysid, uint8_t compid, ftp_transfer_status &status_out);
+    bool get_entries(uint8_t sysid, uint8_t compid, QVector<ftp_entry> &entries_out);
+
+    void update_kgroundcontrol_settings(kgroundcontrol_settings* kground_control_settings_in_);
+
+signals:
+    int write_message(QString port_name, void* message);
+    void transfer_finished(uint8_t sysid, uint8_t compid, bool success, QString error);
+
+protected:
+    void tick() override;
+
+private:
+    struct inbox_entry
+    {
+        qint64 t_ns;
+        uint8_t sysid;
+        uint8_t compid;
+        uint8_t target_system;
+        uint8_t target_component;
+        uint8_t payload[mavlink_ftp::payload_size];
+    };
+
+    // local file of one download; file is only touched by jobs on the writer thread
+    struct file_state
+    {
+        QString path;
+        QFile file;
+        QString error;                   // set by the writer before failed
+        std::atomic_bool failed{false};
+        std::atomic_bool closed{false};
+    };
+
+    class file_sink : public ftp_data_sink
+    {
+    public:
+        job_thread* writer = nullptr;
+        std::shared_ptr<file_state> state;
+
+        bool allocate(qint64 size) override;
+        bool write(qint64 offset, const uint8_t* data, int size) override;
+        QString error_QString(void) const override;
+    };
+
+    struct vehicle_link
+    {
+        QString port_name;
+        uint8_t sysid = 0;
+        uint8_t compid = 0;
+        ftp_session session;
+        file_sink sink;
+        bool was_active = false;
+        bool closing = false;            // close job queued, waiting for the writer
+    };
+
+    static quint16 link_key(uint8_t sysid, uint8_t compid) { return static_cast<quint16>((sysid << 8) | compid); }
+    vehicle_link* get_link(uint8_t sysid, uint8_t compid, const QString &port_name);
+    void queue(vehicle_link &link, const ftp_session::payload_list &payloads);
+
+    QPointer<mavlink_manager> mavlink_manager_;
+    job_thread* writer_ = nullptr;
+    mpsc_ring<inbox_entry> inbox_{inbox_capacity};
+    std::atomic<quint64> inbox_dropped_{0};
+
+    QHash<quint16, vehicle_link*> links_;   // guarded by mutex
+    QVector<QPair<QString, mavlink_message_t>> outgoing_; // built under mutex, sent after unlocking
+    kgroundcontrol_settings kgroundcontrol_settings_;
+};
+
+
+/*
+ * FTP Browser Class
+ *
+ * Window for browsing the onboard file system of one vehicle component and
+ * downloading files (e.g. flight logs) through the ftp_client.
+ */
+class ftp_browser : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ftp_browser(QWidget *parent, ftp_client* client_in_, QString port_name_in_, uint8_t sysid_in_, uint8_t compid_in_);
+
+private slots:
+    void refresh_status(void);
+    void on_list_clicked(void);
+    void on_up_clicked(void);
+    void on_download_clicked(void);
+    void on_item_double_clicked(QTreeWidgetItem* item, int column);
+
+private:
+    void populate_entries(void);
+
+    QPointer<ftp_client> client_;
+    QString port_name_;
+    uint8_t sysid_ = 0;
+    uint8_t compid_ = 0;
+
+    QLineEdit* path_edit_ = nullptr;
+    QTreeWidget* tree_ = nullptr;
+    QLabel* status_label_ = nullptr;
+    QProgressBar* progress_ = nullptr;
+    QPushButton* btn_download_ = nullptr;
+    QTimer* status_timer_ = nullptr;
+    int last_phase_ = ftp_transfer_status::IDLE;
+};
+
+#endif // FTP_CLIENT_H
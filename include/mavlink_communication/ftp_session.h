@@ -0,0 +1,261 @@
+/****************************************************************************
+ *
+ *    Copyright (C) 2025  Yevhenii Kovryzhenko. All rights reserved.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU Affero General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License Version 3 for more details.
+ *
+ *    You should have received a copy of the
+ *    GNU Affero General Public License Version 3
+ *    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions, and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions, and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *    3. No ownership or credit shall be claimed by anyone not mentioned in
+ *       the above copyright statement.
+ *    4. Any redistribution or public use of this software, in whole or in part,
+ *       whether standalone or as part of a different project, must remain
+ *       under the terms of the GNU Affero General Public License Version 3,
+ *       and all distributions in binary form must be accompanied by a copy of
+ *       the source code, as stated in the GNU Affero General Public License.
+ *
+ ****************************************************************************/
+
+#ifndef FTP_SESSION_H
+#define FTP_SESSION_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/*
+ * MAVLink FTP Payload
+ *
+ * Layout of FILE_TRANSFER_PROTOCOL.payload, see
+ * https://mavlink.io/en/services/ftp.html. Multi-byte fields are little
+ * endian on the wire, like the rest of MAVLink.
+ */
+namespace mavlink_ftp
+{
+
+enum opcode_type : uint8_t
+{
+    CMD_NONE = 0,
+    CMD_TERMINATE_SESSION = 1,
+    CMD_RESET_SESSIONS = 2,
+    CMD_LIST_DIRECTORY = 3,
+    CMD_OPEN_FILE_RO = 4,
+    CMD_READ_FILE = 5,
+    CMD_CREATE_FILE = 6,
+    CMD_WRITE_FILE = 7,
+    CMD_REMOVE_FILE = 8,
+    CMD_CREATE_DIRECTORY = 9,
+    CMD_REMOVE_DIRECTORY = 10,
+    CMD_OPEN_FILE_WO = 11,
+    CMD_TRUNCATE_FILE = 12,
+    CMD_RENAME = 13,
+    CMD_CALC_FILE_CRC32 = 14,
+    CMD_BURST_READ_FILE = 15,
+    RSP_ACK = 128,
+    RSP_NAK = 129
+};
+
+enum error_type : uint8_t
+{
+    ERR_NONE = 0,
+    ERR_FAIL = 1,
+    ERR_FAIL_ERRNO = 2,
+    ERR_INVALID_DATA_SIZE = 3,
+    ERR_INVALID_SESSION = 4,
+    ERR_NO_SESSIONS_AVAILABLE = 5,
+    ERR_EOF = 6,
+    ERR_UNKNOWN_COMMAND = 7,
+    ERR_FILE_EXISTS = 8,
+    ERR_FILE_PROTECTED = 9,
+    ERR_FILE_NOT_FOUND = 10
+};
+
+static constexpr int payload_size = 251; // FILE_TRANSFER_PROTOCOL.payload
+static constexpr int max_data = 239;
+
+struct payload
+{
+    uint16_t seq = 0;
+    uint8_t session = 0;
+    uint8_t opcode = CMD_NONE;
+    uint8_t size = 0;
+    uint8_t req_opcode = CMD_NONE;
+    uint8_t burst_complete = 0;
+    uint8_t padding = 0;
+    uint32_t offset = 0;
+    uint8_t data[max_data] = {};
+};
+static_assert(offsetof(payload, offset) == 8 && offsetof(payload, data) == 12, "FTP header layout");
+
+// raw is FILE_TRANSFER_PROTOCOL.payload (payload_size bytes)
+inline void read_payload(const uint8_t* raw, payload& out) { memcpy(static_cast<void*>(&out), raw, payload_size); }
+inline void write_payload(const payload& in, uint8_t* raw) { memcpy(raw, &in, payload_size); }
+
+QString error_QString(const payload& nak);
+
+}
+
+struct ftp_entry
+{
+    QString name;
+    bool is_directory = false;
+    qint64 size = 0;
+};
+
+struct ftp_transfer_status
+{
+    enum phase_type
+    {
+        IDLE,
+        OPENING,
+        BURSTING,     // BurstReadFile stream in progress
+        GAP_FILL,     // windowed ReadFile of the chunks the bursts missed
+        LISTING,
+        DONE,
+        FAILED
+    };
+
+    int phase = IDLE;
+    bool is_list = false;
+    QString remote_path;
+    qint64 file_size = -1;
+    qint64 bytes_received = 0;
+    int chunks_received = 0;
+    int chunk_count = 0;
+    int bursts = 0;
+    int reads_sent = 0;   // single-chunk ReadFile requests, including retries
+    qint64 elapsed_ns = 0;
+    QString error;
+
+    QString get_QString(void) const;
+};
+
+/*
+ * FTP Data Sink
+ *
+ * Receives the file of a download from ftp_session. Calls come from the
+ * thread driving the session and should not block on the disk: a sink may
+ * queue the work and report a later failure through ftp_session::fail().
+ * Returning false fails the transfer with error_QString().
+ */
+class ftp_data_sink
+{
+public:
+    virtual ~ftp_data_sink() {}
+
+    virtual bool allocate(qint64 size) = 0;
+    virtual bool write(qint64 offset, const uint8_t* data, int size) = 0;
+    virtual QString error_QString(void) const = 0;
+};
+
+/*
+ * FTP Session Class
+ *
+ * Client side of one MAVLink FTP conversation, independent of the transport:
+ * replies go in through handle(), timers are driven by service(), and every
+ * request to send is appended to the out vector. This makes it possible to
+ * run it against a local stand-in responder.
+ *
+ * Downloads open the file, then stream it with BurstReadFile. Chunks may
+ * arrive in any order and are handed to the sink at their offset, after it
+ * has been told the file size; a bitmap tracks which chunks are in. When a burst ends (complete, EOF or stalled) the session either starts
+ * a new burst at the first hole, or, if few holes are left, requests them with
+ * a sliding window of ReadFile.
+ */
+class ftp_session
+{
+public:
+    static constexpr int read_window = 8;                        // ReadFile in flight during gap fill
+    static constexpr int burst_restart_chunks = 4 * read_window; // more holes than this: burst again instead
+    static constexpr int max_attempts = 5;
+    static constexpr qint64 request_timeout_ns = 500000000LL;
+    static constexpr qint64 burst_stall_ns = 500000000LL;        // no burst data for this long ends the burst
+
+    typedef QVector<mavlink_ftp::payload> payload_list;
+
+    // sink is not owned and must outlive the transfer
+    void start_download(const QString &remote_path, ftp_data_sink* sink, qint64 now_ns, payload_list &out);
+    void start_list(const QString &remote_path, qint64 now_ns, payload_list &out);
+    void cancel(qint64 now_ns, payload_list &out);
+    // ends an active transfer with error, e.g. one the sink ran into after accepting data
+    void fail(const QString &error, qint64 now_ns, payload_list &out);
+
+    void handle(const mavlink_ftp::payload &reply, qint64 now_ns, payload_list &out);
+    void service(qint64 now_ns, payload_list &out);
+
+    bool is_active(void) const { return phase_ != ftp_transfer_status::IDLE && phase_ != ftp_transfer_status::DONE && phase_ != ftp_transfer_status::FAILED; }
+    ftp_transfer_status get_status(qint64 now_ns) const;
+    const QVector<ftp_entry>& entries(void) const { return entries_; }
+
+private:
+    struct pending_read
+    {
+        qint64 sent_ns = 0;
+        int attempts = 0;
+    };
+
+    mavlink_ftp::payload make_request(uint8_t opcode);
+    void send_control(const mavlink_ftp::payload &request, qint64 now_ns, payload_list &out);
+    void send_burst(int chunk, qint64 now_ns, payload_list &out);
+    void send_read(int chunk, payload_list &out);
+    void end_burst(qint64 now_ns, payload_list &out);
+    void finish(int phase, const QString &error, qint64 now_ns, payload_list &out);
+
+    bool store_data(const mavlink_ftp::payload &reply);
+    bool has_chunk(int chunk) const { return (chunk_bits_[chunk >> 6] >> (chunk & 63)) & 1ull; }
+    int next_missing(int from) const;
+    int chunk_length(int chunk) const;
+    void parse_list(const mavlink_ftp::payload &reply);
+
+    int phase_ = ftp_transfer_status::IDLE;
+    bool is_list_ = false;
+    QString remote_path_;
+    QString error_;
+    ftp_data_sink* sink_ = nullptr;
+    uint16_t next_seq_ = 0;
+    uint8_t session_ = 0;
+    bool session_open_ = false;
+    qint64 start_ns_ = 0;
+    qint64 end_ns_ = 0;
+
+    // the one outstanding control request (open, list, burst start)
+    mavlink_ftp::payload control_;
+    qint64 control_sent_ns_ = 0;
+    int control_attempts_ = 0;
+    bool control_pending_ = false;
+
+    qint64 file_size_ = -1;
+    int chunk_count_ = 0;
+    std::vector<quint64> chunk_bits_;
+    int chunks_received_ = 0;
+    qint64 bytes_received_ = 0;
+    qint64 last_data_ns_ = 0;
+    int bursts_ = 0;
+    QHash<int, pending_read> reads_;
+    int reads_sent_ = 0;
+
+    QVector<ftp_entry> entries_;
+    int list_skipped_ = 0;
+};
+
+#endif // FTP_SESSION_H
@@ -36,16 +36,28 @@
 #define MAVLINK_INSPECTOR_H
 
 #include <QWidget>
-#include <QVBoxLayout>
+#include <QAbstractTableModel>
 #include <QMutex>
 #include <QListWidget>
 #include <QQueue>
 #include <QShortcut>
 #include <QHash>
+#include <QWaitCondition>
+#include <QSet>
+#include <QSlider>
+#include <QLabel>
+#include <QCheckBox>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <atomic>
 
 #define MAVLINK_USE_MESSAGE_INFO
 #include "all/mavlink.h"
 #include "mavlink_communication/mavlink_enum_types.h"
+#include "mavlink_communication/mavlink_packed_message.h"
+#include "mavlink_communication/vehicle_state.h"
+#include "plot/plot_signal_registry.h"
 #include "threads.h"
 // #include "signal_filters.h"
 
@@ -91,13 +103,89 @@ public:
     // CQueue<qint64> timestamps = CQueue<qint64>(5);
     bool get_msg(mav_type_in &msg_out, qint64 &msg_time_stamp);
     bool get_msg(mav_type_in &msg_out);
-    qint64 timestamp_ms;
+    qint64 timestamp_ns; // time_base receive stamp
     bool exists(void);
 private:
     mav_type_in* msg = NULL;
     QMutex* mutex = NULL;
 };
 
+/*
+ * Message Rate Statistics
+ *
+ * Timing of one message stream, updated in O(1) on every ingest.
+ * Mean interval and jitter are exponentially weighted by elapsed time
+ * (tau_ns), so slow and fast streams settle equally quickly.
+ * All times are time_base nanoseconds.
+ */
+struct message_rate_stats
+{
+    static constexpr double tau_ns = 1.0E9;
+
+    quint64 count = 0;
+    quint64 intervals = 0;
+    qint64 last_ns = 0;
+    double rate_hz = 0.0;
+    double mean_interval_ns = 0.0;
+    double jitter_ns = 0.0; // mean absolute deviation from the mean interval
+    qint64 min_interval_ns = 0;
+    qint64 max_interval_ns = 0;
+
+    void update(qint64 t_ns);
+    QString get_QString(void) const;
+};
+
+struct PlotSignalSample;
+
+// one stored message stream: msgid, last payload length and receive statistics
+struct mavlink_stream_info
+{
+    uint32_t msgid = 0;
+    uint8_t len = 0;
+    message_rate_stats stats;
+};
+
+/*
+ * Message History
+ *
+ * Bounded time history of one message stream, stored column-wise: a
+ * timestamp column plus payloads trimmed of trailing zero bytes (as on the
+ * MAVLink 2 wire) packed back to back in one byte buffer. Records arrive in
+ * time order and are evicted from the front once older than the window or
+ * beyond max_records, so lookups by time are a binary search.
+ */
+class message_history
+{
+public:
+    static constexpr int max_records = 1 << 16;
+
+    message_history(uint8_t sysid, uint8_t compid, uint32_t msgid);
+
+    void append(const mavlink_message_t &msg, qint64 t_ns, qint64 window_ns);
+    void clear(void);
+    int size(void) const { return t_ns_.size() - head_; }
+
+    // latest record at or before t_ns, -1 if the history starts later
+    int find(qint64 t_ns) const;
+    bool get(int index, mavlink_message_t &msg_out, qint64 &t_ns_out) const;
+    // decoded values of one numeric payload field within [t_from_ns, t_to_ns]
+    int extract(unsigned offset, mavlink_message_type_t type, qint64 t_from_ns, qint64 t_to_ns, QVector<PlotSignalSample> &samples_out) const;
+
+private:
+    void evict(qint64 oldest_ns);
+
+    const uint8_t sysid_;
+    const uint8_t compid_;
+    const uint32_t msgid_;
+
+    QVector<qint64> t_ns_;
+    QVector<quint32> offset_; // start of each payload in payload_
+    QVector<quint8> len_;
+    QVector<quint8> seq_;
+    QByteArray payload_;
+    int head_ = 0; // first live record; columns are compacted once it passes half
+};
+
 class mavlink_data_aggregator : public QObject
 {
     Q_OBJECT
@@ -108,7 +196,6 @@ public:
 
     const uint8_t sysid;
     const mavlink_enums::mavlink_component_id compid;
-    static const size_t time_buffer_size = 50;
 
     static QString print_one_field(mavlink_message_t* msg, const mavlink_field_info_t* f, int idx);
     static QString print_field(mavlink_message_t* msg, const mavlink_field_info_t* f);
@@ -116,37 +203,81 @@ public:
     static bool print_name(QString &txt, mavlink_message_t* msg);
     static bool print_message(QString &txt, mavlink_message_t* msg);
 
-signals:
-
-    void updated(uint8_t sysid_out, mavlink_enums::mavlink_component_id compid_out, QString msg_name);
-
 public slots:
-    bool is_stored(uint8_t msg_id);
+    bool is_stored(uint32_t msg_id);
     bool is_stored(QString msg_name);
-    bool is_stored(uint8_t msg_id, unsigned &i);
-    bool is_stored(QString msg_name, unsigned &i);
 
     bool update(void *new_msg_in, qint64 msg_time_stamp);
 
-    bool get_msg(QString msg_name, void *msg_out, CQueue<qint64> &timestamps_out);
+    bool get_msg(uint32_t msg_id, void *msg_out, message_rate_stats &stats_out);
+    bool get_msg(QString msg_name, void *msg_out, message_rate_stats &stats_out);
     bool get_msg(QString msg_name, void *msg_out);
 
     bool get_all(QVector<QString> &msg_names_out);
-    bool get_all(QVector<CQueue<qint64>*> &timestamps_out);
-    bool get_all(QVector<mavlink_message_t*> &msgs_out);
-    bool get_all(QVector<mavlink_message_t*> &msgs_out, QVector<CQueue<qint64>*> &timestamps_out);
+    bool get_all(QVector<mavlink_message_t> &msgs_out);
+    bool get_all(QVector<mavlink_stream_info> &streams_out);
+
+    // per-message history, off when window_ns is 0
+    void set_history_window(qint64 window_ns);
+    bool get_msg_at(uint32_t msg_id, qint64 t_ns, void *msg_out, qint64 &t_ns_out);
+    int get_field_history(uint32_t msg_id, unsigned offset, mavlink_message_type_t type, qint64 t_from_ns, qint64 t_to_ns, QVector<PlotSignalSample> &samples_out);
 
     void clear(void);
 
 private:
 
-    QVector<QString> names;
-    QVector<mavlink_message_t*> msgs;
-    QVector<CQueue<qint64>*> timestamps;
+    /*
+     * Message Slot
+     *
+     * Latest copy of one msgid plus its rate statistics, stored inline so an
+     * update is a copy and a few arithmetic operations, no allocation. The
+     * message is kept packed, so only the received payload bytes are copied.
+     * The name is only resolved once, when the msgid is first seen.
+     */
+    struct message_slot
+    {
+        char packed[mavlink_packed::max_size];
+        message_rate_stats stats;
+        QString name;
+    };
+
+    // msgid -> slot index. Ids below direct_msgid_limit go through a two-level
+    // page table (pages allocated on first use); anything above falls back to a hash.
+    static constexpr int page_bits = 8;
+    static constexpr int page_size = 1 << page_bits;
+    static constexpr uint32_t direct_msgid_limit = 1u << 16;
+
+    int find_slot(uint32_t msg_id) const;
+    int find_slot(const QString &msg_name) const;
+    int insert_slot(uint32_t msg_id);
+
+    QVector<message_slot> entries_;
+    std::vector<std::unique_ptr<message_history>> histories_; // parallel to entries_, allocated on demand
+    qint64 history_window_ns_ = 0;
+    std::unique_ptr<int[]> pages_[direct_msgid_limit >> page_bits];
+    QHash<uint32_t, int> sparse_index_;
     QMutex* mutex = nullptr;    
 };
 
 
+class mavlink_aggregation_thread;
+
+/*
+ * MAVLink Message Sink Class
+ *
+ * Receives every accepted message with a msgid it subscribed to, on the
+ * aggregation thread right after the aggregators are updated. Unlike the
+ * coalesced updated() notification, no message is skipped. Implementations
+ * must not block: microservice clients hand the message over to their own
+ * thread through an mpsc_ring.
+ */
+class mavlink_message_sink
+{
+public:
+    virtual ~mavlink_message_sink() = default;
+    virtual void on_message(const mavlink_message_t& msg, qint64 t_ns) = 0;
+};
+
 class mavlink_manager : public QObject
 {
     Q_OBJECT
@@ -155,14 +286,29 @@ public:
     mavlink_manager(QObject* parent = nullptr);
     ~mavlink_manager();
 
+    // packed (sysid, compid, msgid), as used in change notifications
+    static quint64 message_key(uint8_t sysid, uint8_t compid, uint32_t msgid);
 
+    static constexpr size_t ingest_capacity = 4096;
 
 public slots:
     unsigned int get_n(void);
+    // Thread-safe and non-blocking: copies the message into the ingest ring.
+    // The caller keeps ownership of new_msg.
     bool update(void* new_msg, qint64 msg_time_stamp);
-    bool toggle_arm_state(QString port_name, uint8_t sys_id_, mavlink_enums::mavlink_component_id mav_component_, bool flag, bool force);
+    quint64 get_ingest_dropped(void) const { return ingest_dropped_.load(std::memory_order_relaxed); }
+
+    bool get_msg(uint8_t sys_id_, mavlink_enums::mavlink_component_id mav_component_, QString msg_name, void *msg_out, message_rate_stats &stats_out);
+    // latest stored copy at or before t_ns (time_base), from the message history
+    bool get_msg_at(uint8_t sys_id_, mavlink_enums::mavlink_component_id mav_component_, QString msg_name, qint64 t_ns, void *msg_out, qint64 &t_ns_out);
+    // lock-free snapshot of the decoded vehicle state; false if sysid has not been heard from
+    bool get_vehicle_state(uint8_t sysid, vehicle_state &state_out) const;
+    bool get_streams(uint8_t sysid, uint8_t compid, QVector<mavlink_stream_info> &streams_out);
 
-    bool get_msg(uint8_t sys_id_, mavlink_enums::mavlink_component_id mav_component_, QString msg_name, void *msg_out, CQueue<qint64> &timestamps_out);
+    // Per-message delivery for protocol clients. Once unsubscribe() returns,
+    // the sink is no longer called and may be deleted.
+    void subscribe(uint32_t msgid, mavlink_message_sink* sink);
+    void unsubscribe(mavlink_message_sink* sink);
 
     void update_kgroundcontrol_settings(kgroundcontrol_settings* kground_control_settings_in_);
     void clear(void);
@@ -179,31 +325,130 @@ signals:
     void get_kgroundcontrol_settings(kgroundcontrol_settings* kground_control_settings_in_);
 
 private slots:
-    void relay_updated(uint8_t sysid_out, mavlink_enums::mavlink_component_id compid_out, QString msg_name);
+    void relay_updated(QVector<quint64> changed_keys);
 
 
 private:
-    bool is_new(mavlink_message_t* new_msg);
-    bool is_new(mavlink_message_t* new_msg, unsigned int& i);
-    bool get_ind(unsigned int& i, uint8_t sys_id_, mavlink_enums::mavlink_component_id mav_component_);
+    friend class mavlink_aggregation_thread;
+
+    struct ingest_entry
+    {
+        qint64 t_ns;
+        char packed[mavlink_packed::max_size]; // see mavlink_packed::pack
+    };
+
+    // aggregation thread only
+    bool process_message(const mavlink_message_t& msg, qint64 t_ns);
+
+    /*
+     * Component Table
+     *
+     * Second level of the (sysid, compid) -> aggregator index. Slots are
+     * published with release stores and read with acquire loads, so the
+     * per-message dispatch and UI lookups never take the manager mutex.
+     * Tables are allocated once per sysid and live as long as the manager.
+     */
+    struct component_table
+    {
+        std::atomic<mavlink_data_aggregator*> by_compid[256] = {};
+        QVector<mavlink_enums::mavlink_component_id> compids; // arrival order, guarded by mutex
+    };
+
+    /*
+     * Plot Field Plan
+     *
+     * One tagged field of one (sysid, compid, msgid): where its value sits in
+     * the payload and which registry signal it feeds. Plans are rebuilt when
+     * the registry's tag generation changes.
+     */
+    struct plot_field_plan
+    {
+        PlotSignalHandle handle = kInvalidPlotSignalHandle;
+        unsigned offset = 0;
+        mavlink_message_type_t type = MAVLINK_TYPE_CHAR;
+    };
+
+    void rebuild_plot_plans(qint64 backfill_before_ns);
+    void append_plot_samples(const mavlink_message_t* msg, qint64 t_ns);
+    void update_vehicle_state(const mavlink_message_t& msg, qint64 t_ns);
+    void dispatch_to_sinks(const mavlink_message_t& msg, qint64 t_ns);
+
+    mavlink_data_aggregator* find_aggregator(uint8_t sys_id_, uint8_t comp_id_) const;
+    mavlink_data_aggregator* add_aggregator(uint8_t sys_id_, uint8_t comp_id_, bool &sysid_is_new, bool &compid_is_new);
 
     QMutex* mutex = nullptr;
-    QVector<mavlink_data_aggregator*> msgs;
+    std::atomic<component_table*> index_[256] = {};
+    QVector<uint8_t> sysids_;                        // arrival order, guarded by mutex
+    QVector<mavlink_data_aggregator*> msgs;          // live aggregators, guarded by mutex
+    QHash<quint16, mavlink_data_aggregator*> retired_; // cleared aggregators, revived on reuse
+
+    QHash<quint64, QVector<plot_field_plan>> plot_plans_; // (sysid, compid, msgid) -> tagged fields
+    quint64 plot_plans_generation_ = 0;
+    QSet<QString> plot_plan_ids_; // ids with a plan, to backfill newly tagged ones from history
+    QVector<PlotSignalTuple> plot_batch_; // reused per message by the aggregation thread
+    qint64 history_window_ns_ = 0; // guarded by mutex
+
+    std::atomic<vehicle_state_slot*> vehicle_states_[256] = {}; // written by the aggregation thread only
+    std::atomic_bool vehicle_states_reset_{false};              // set by clear(), applied by the aggregation thread
+
+    // msgid -> subscribed sinks. sink_filter_ is a lock-free prefilter on the
+    // low msgid bits, so messages nobody subscribed to never take sink_mutex_.
+    static constexpr uint32_t sink_filter_bits = 1024;
+    std::atomic<quint64> sink_filter_[sink_filter_bits / 64] = {};
+    QMutex sink_mutex_;
+    QHash<uint32_t, QVector<mavlink_message_sink*>> sinks_;
+
+    mpsc_ring<ingest_entry> ingest_{ingest_capacity};
+    std::atomic<quint64> ingest_dropped_{0};
+    mavlink_aggregation_thread* aggregation_thread_ = nullptr;
 
     kgroundcontrol_settings kgroundcontrol_settings_;
 };
 
 
+/*
+ * MAVLink Aggregation Thread
+ *
+ * Single consumer of the manager's ingest ring. Applies messages to the
+ * aggregators off the GUI thread and, at update_rate_hz, publishes the
+ * (sysid, compid, msgid) keys that changed since the previous flush, so the
+ * UI sees one event per display tick instead of one per message.
+ */
+class mavlink_aggregation_thread : public generic_thread
+{
+    Q_OBJECT
 
+public:
+    explicit mavlink_aggregation_thread(mavlink_manager* manager, generic_thread_settings* new_settings);
+    ~mavlink_aggregation_thread();
 
-class mavlink_inspector_thread  : public generic_thread
+    void run() override;
+    // called by producers after a push; cheap when the consumer is busy
+    void wake(void);
+
+signals:
+    void changed(QVector<quint64> changed_keys);
+
+private:
+    mavlink_manager* manager_ = nullptr;
+    QMutex wake_mutex_;
+    QWaitCondition wake_cond_;
+    std::atomic_bool waiting_{false};
+};
+
+
+
+
+class mavlink_inspector_thread  : public periodic_task
 {
     Q_OBJECT
 
 public:
     explicit mavlink_inspector_thread(QObject* parent, generic_thread_settings* new_settings);
     ~mavlink_inspector_thread();
-    void run();
+
+protected:
+    void tick() override;
 
 signals:
     void update_all_visuals(void);
@@ -211,43 +456,137 @@ private:
 };
 
 
-namespace Ui {
-class MavlinkInspectorMSG;
-}
-
-class MavlinkInspectorMSG : public QWidget
+/*
+ * MAVLink Inspector Model
+ *
+ * Message list of the inspector. Rows hold only the stream key and the last
+ * pulled message and statistics; text is formatted in data(), so the view pays
+ * for the rows it paints and not for the size of the list. refresh_rows() pulls
+ * one contiguous range per tick and reports it as a single dataChanged range.
+ */
+class mavlink_inspector_model : public QAbstractTableModel
 {
     Q_OBJECT
 
 public:
-    explicit MavlinkInspectorMSG(QWidget *parent, uint8_t sysid_in, mavlink_enums::mavlink_component_id compid_in, QString name_in);
-    ~MavlinkInspectorMSG();
+    enum column
+    {
+        COLUMN_RATE = 0,
+        COLUMN_NAME,
+        COLUMN_COUNT
+    };
+
+    // pulls the latest copy of one stream; false if it is not available
+    using fetch_function = std::function<bool(uint8_t sysid, mavlink_enums::mavlink_component_id compid, const QString &name, mavlink_message_t &msg_out, message_rate_stats &stats_out)>;
+
+    explicit mavlink_inspector_model(QObject* parent = nullptr);
+    ~mavlink_inspector_model();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+    bool contains(const QString &name) const;
+    int find_row(const QString &name) const;
+    void add_row(uint8_t sysid, mavlink_enums::mavlink_component_id compid, const QString &name);
+    void clear_rows(void);
+
+    bool refresh_rows(int first, int last, qint64 now_ns, const fetch_function &fetch);
+    bool get_msg(int row, mavlink_message_t &msg_out) const;
+
+    void toggle_checked(int row);
+    bool has_checked(void) const { return checked_count_ > 0; }
+    QVector<int> checked_rows(void) const;
+    QString name(int row) const;
+    bool get_stream(int row, uint8_t &sysid, mavlink_enums::mavlink_component_id &compid) const;
+
+    // rate shown for a stream: the ingest estimate, decaying once the stream goes stale
+    static double display_rate_hz(const message_rate_stats &stats, qint64 now_ns);
 
-    const uint8_t sysid;
-    const mavlink_enums::mavlink_component_id compid;
-    const QString name;
+private:
+    struct row_entry
+    {
+        uint8_t sysid = 0;
+        mavlink_enums::mavlink_component_id compid;
+        QString name;
+        mavlink_message_t msg;
+        message_rate_stats stats;
+        bool checked = false;
+    };
+
+    QVector<row_entry> rows_;
+    QHash<QString, int> row_by_name_;
+    int checked_count_ = 0;
+    qint64 display_time_ns_ = 0; // time of the last refresh, used to age rows in data()
+};
 
-signals:
-    void updated(void);
 
-public slots:
-    bool update(void* mavlink_msg_in, double update_rate_hz);
-    void get_msg(void* mavlink_msg_out);
-    double get_last_hz(void);
+class QTreeWidget;
+class QTreeWidgetItem;
 
-    bool is_button_checked(void);
-    bool is_update_scheduled(void);
-    bool schedule_update(uint8_t sysid_, mavlink_enums::mavlink_component_id compid_, QString msg_name);
+/*
+ * MAVLink Detail Tree
+ *
+ * Field tree of the messages selected in the inspector. Items are only
+ * rebuilt when the selection changes. Otherwise each message is compared
+ * with its cached copy: unchanged messages are skipped, and changed fields
+ * are marked dirty and formatted once they are on screen. Expanding a group,
+ * scrolling or resizing flushes the cells that became visible.
+ */
+class mavlink_detail_tree : public QObject
+{
+    Q_OBJECT
 
-    QString get_QString(void);
+public:
+    explicit mavlink_detail_tree(QTreeWidget* tree, QObject* parent = nullptr);
+    ~mavlink_detail_tree();
 
-private:
-    QMutex *mutex = nullptr;
-    mavlink_message_t msg;
-    Ui::MavlinkInspectorMSG *ui;
+    void update(const QVector<QPair<QString, mavlink_message_t>> &entries);
+    void clear(void);
 
-    bool update_scheduled = false;
-    double update_rate_hz_last = 0.0;
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private slots:
+    void flush_visible(void);
+
+private:
+    // one displayed value: a scalar field or one array element
+    struct field_cell
+    {
+        QTreeWidgetItem* item = nullptr;
+        unsigned offset = 0; // payload byte range compared for changes
+        unsigned size = 0;
+        int idx = 0;
+        bool dirty = true;
+        bool has_plot_box = false;
+    };
+
+    struct field_group
+    {
+        const mavlink_field_info_t* info = nullptr;
+        QTreeWidgetItem* item = nullptr;
+        QVector<field_cell> cells;
+    };
+
+    struct message_group
+    {
+        QString title;
+        QTreeWidgetItem* root = nullptr;
+        const mavlink_message_info_t* info = nullptr;
+        mavlink_message_t msg;
+        unsigned payload_extent = 0; // bytes of payload covered by fields
+        int dirty_count = 0;
+        QVector<field_group> fields;
+    };
+
+    void rebuild(const QVector<QPair<QString, mavlink_message_t>> &entries);
+    void format_cell(message_group &group, const field_group &field, field_cell &cell);
+
+    QTreeWidget* tree_ = nullptr;
+    QVector<message_group> groups_;
 };
 
 
@@ -267,6 +606,8 @@ public slots:
     //void create_new_slot_btn_display(void* msg_in, qint64 msg_time_stamp);
     bool process_new_msg(uint8_t sysid_, mavlink_enums::mavlink_component_id compid_, QString msg_name);
     void on_btn_refresh_port_names_clicked();
+    // sizes the history slider to mavlink_history_duration_sec
+    void update_kgroundcontrol_settings(kgroundcontrol_settings* kground_control_settings_in_);
 
 private slots:
 
@@ -286,8 +627,7 @@ private slots:
 
     void update_arm_state(void);
     void update_msg_browser(QString txt_in);
-
-    void addbutton(uint8_t sysid_, mavlink_enums::mavlink_component_id compid_, QString msg_name);
+    void update_command_result(quint64 transaction_id, uint8_t sysid, uint8_t compid, uint16_t command, int result, qint64 rtt_ns);
 
     void on_checkBox_arm_bind_clicked(bool checked);
     void on_checkBox_disarm_bind_clicked(bool checked);
@@ -298,23 +638,30 @@ signals:
     QVector<QString> get_port_names(void);
     bool toggle_arm_state(QString port_name, uint8_t sys_id_, mavlink_enums::mavlink_component_id mav_component_, bool flag, bool force);
 
-    bool request_get_msg(uint8_t sys_id_, mavlink_enums::mavlink_component_id mav_component_, QString msg_name_, void *msg_, CQueue<qint64> &timestamps_out);
+    bool request_get_msg(uint8_t sys_id_, mavlink_enums::mavlink_component_id mav_component_, QString msg_name_, void *msg_, message_rate_stats &stats_out);
+    bool request_get_msg_at(uint8_t sys_id_, mavlink_enums::mavlink_component_id mav_component_, QString msg_name_, qint64 t_ns, void *msg_, qint64 &t_ns_out);
+    bool request_vehicle_state(uint8_t sysid, vehicle_state &state_out);
+    void parameter_editor_requested(QString port_name, uint8_t sysid, uint8_t compid);
+    void ftp_browser_requested(QString port_name, uint8_t sysid, uint8_t compid);
+    void stream_demand_changed(quintptr viewer, QVector<quint64> keys);
 
     void heartbeat_updated(void);
     void request_update_msg_browser(QString txt_in);
 
-    bool seen_msg_processed(uint8_t sysid_, mavlink_enums::mavlink_component_id compid_, QString msg_name);
-
 private:
     bool update_msg_list_visuals(void);
-    mavlink_heartbeat_t old_heartbeat;
+    vehicle_state vehicle_state_; // snapshot of the selected sysid, GUI thread only
 
 
     Ui::MavlinkInspector *ui;
-    QWidget* main_container = nullptr;
-    QVBoxLayout* main_layout = nullptr;
+    mavlink_inspector_model* msg_model_ = nullptr;
+    mavlink_detail_tree* detail_tree_ = nullptr;
 
-    QVector<QString> names;
+    // detail view scrub-back in 0.1 s steps, 0 is live; the range follows the retained history
+    QSlider* history_slider_ = nullptr;
+    QCheckBox* latency_plot_cb_ = nullptr;
+    QVector<quint64> stream_demand_; // sorted message keys open in the detail view
+    QLabel* history_label_ = nullptr;
 
     static constexpr double sample_rate_hz = 30.0;//, cutoff_frequency_hz = 1.0;
 
@@ -323,9 +670,6 @@ private:
 
     QShortcut *arm_key_bind = nullptr, *disarm_key_bind = nullptr;
 
-    // Track last time a message of a given (sysid,compid,name) was seen
-    QHash<QString, qint64> last_seen_ms_by_key;
-
     // Temporarily pause detail tree rebuilds while user interacts with checkboxes
     bool suspendDetailRefresh_ = false;
 };
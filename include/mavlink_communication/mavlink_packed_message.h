@@ -0,0 +1,166 @@
+/****************************************************************************
+ *
+ *    Copyright (C) 2025  Yevhenii Kovryzhenko. All rights reserved.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU Affero General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License Version 3 for more details.
+ *
+ *    You should have received a copy of the
+ *    GNU Affero General Public License Version 3
+ *    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions, and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions, and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *    3. No ownership or credit shall be claimed by anyone not mentioned in
+ *       the above copyright statement.
+ *    4. Any redistribution or public use of this software, in whole or in part,
+ *       whether standalone or as part of a different project, must remain
+ *       under the terms of the GNU Affero General Public License Version 3,
+ *       and all distributions in binary form must be accompanied by a copy of
+ *       the source code, as stated in the GNU Affero General Public License.
+ *
+ ****************************************************************************/
+
+#ifndef MAVLINK_PACKED_MESSAGE_H
+#define MAVLINK_PACKED_MESSAGE_H
+
+#include <QByteArray>
+#include <QVector>
+#include <cstring>
+
+#define MAVLINK_USE_MESSAGE_INFO
+#include "all/mavlink.h"
+
+/*
+ * Packed MAVLink Message
+ *
+ * Wire-sized copy of a parsed message: the mavlink_message_t header fields
+ * followed by only the len payload bytes that were received (MAVLink 2 already
+ * trims trailing zeros). A heartbeat takes 25 bytes instead of the ~290 of a
+ * mavlink_message_t. Unpacking zero-fills the rest of the payload, which is
+ * what the MAVLink decoders expect. Signatures are not kept.
+ */
+namespace mavlink_packed
+{
+
+struct header
+{
+    uint32_t msgid;
+    uint16_t checksum;
+    uint8_t magic;
+    uint8_t len;
+    uint8_t incompat_flags;
+    uint8_t compat_flags;
+    uint8_t seq;
+    uint8_t sysid;
+    uint8_t compid;
+};
+
+static constexpr size_t max_size = sizeof(header) + MAVLINK_MAX_PAYLOAD_LEN;
+
+inline size_t packed_size(const mavlink_message_t& msg)
+{
+    return sizeof(header) + msg.len;
+}
+
+// out must hold packed_size(msg) bytes; returns the bytes written
+inline size_t pack(const mavlink_message_t& msg, char* out)
+{
+    header hdr;
+    hdr.msgid = msg.msgid;
+    hdr.checksum = msg.checksum;
+    hdr.magic = msg.magic;
+    hdr.len = msg.len;
+    hdr.incompat_flags = msg.incompat_flags;
+    hdr.compat_flags = msg.compat_flags;
+    hdr.seq = msg.seq;
+    hdr.sysid = msg.sysid;
+    hdr.compid = msg.compid;
+    memcpy(out, &hdr, sizeof(hdr));
+    memcpy(out + sizeof(hdr), _MAV_PAYLOAD(&msg), msg.len);
+    return sizeof(hdr) + msg.len;
+}
+
+inline header read_header(const char* in)
+{
+    header hdr;
+    memcpy(&hdr, in, sizeof(hdr));
+    return hdr;
+}
+
+inline void unpack(const char* in, mavlink_message_t& out)
+{
+    const header hdr = read_header(in);
+    out.msgid = hdr.msgid;
+    out.checksum = hdr.checksum;
+    out.magic = hdr.magic;
+    out.len = hdr.len;
+    out.incompat_flags = hdr.incompat_flags;
+    out.compat_flags = hdr.compat_flags;
+    out.seq = hdr.seq;
+    out.sysid = hdr.sysid;
+    out.compid = hdr.compid;
+    char* payload = _MAV_PAYLOAD_NON_CONST(&out);
+    memcpy(payload, in + sizeof(hdr), hdr.len);
+    memset(payload + hdr.len, 0, MAVLINK_MAX_PAYLOAD_LEN - hdr.len);
+    memset(out.ck, 0, sizeof(out.ck));
+    memset(out.signature, 0, sizeof(out.signature));
+}
+
+/*
+ * Packed Arena Class
+ *
+ * Append-only sequence of packed messages laid out back to back in one
+ * buffer, indexed by record offset. Suited to queues that are filled, handed
+ * over in one swap, and drained in order.
+ */
+class arena
+{
+public:
+    int append(const mavlink_message_t& msg)
+    {
+        const qsizetype offset = data_.size();
+        data_.resize(offset + static_cast<qsizetype>(packed_size(msg)));
+        pack(msg, data_.data() + offset);
+        offsets_.push_back(static_cast<quint32>(offset));
+        return offsets_.size() - 1;
+    }
+
+    bool get(int index, mavlink_message_t& msg_out) const
+    {
+        if (index < 0 || index >= offsets_.size()) return false;
+        unpack(data_.constData() + offsets_[index], msg_out);
+        return true;
+    }
+
+    header header_at(int index) const { return read_header(data_.constData() + offsets_[index]); }
+
+    int size(void) const { return offsets_.size(); }
+    bool isEmpty(void) const { return offsets_.isEmpty(); }
+    qsizetype bytes(void) const { return data_.size(); }
+
+    void clear(void)
+    {
+        data_.clear();
+        offsets_.clear();
+    }
+
+private:
+    QByteArray data_;
+    QVector<quint32> offsets_;
+};
+
+}
+
+#endif // MAVLINK_PACKED_MESSAGE_H
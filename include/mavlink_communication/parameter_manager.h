@@ -0,0 +1,321 @@
+/****************************************************************************
+ *
+ *    Copyright (C) 2025  Yevhenii Kovryzhenko. All rights reserved.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU Affero General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License Version 3 for more details.
+ *
+ *    You should have received a copy of the
+ *    GNU Affero General Public License Version 3
+ *    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions, and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions, and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *    3. No ownership or credit shall be claimed by anyone not mentioned in
+ *       the above copyright statement.
+ *    4. Any redistribution or public use of this software, in whole or in part,
+ *       whether standalone or as part of a different project, must remain
+ *       under the terms of the GNU Affero General Public License Version 3,
+ *       and all distributions in binary form must be accompanied by a copy of
+ *       the source code, as stated in the GNU Affero General Public License.
+ *
+ ****************************************************************************/
+
+#ifndef PARAMETER_MANAGER_H
+#define PARAMETER_MANAGER_H
+
+#include <QWidget>
+#include <QHash>
+#include <QQueue>
+#include <QVector>
+#include <QString>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QTimer>
+#include <QPointer>
+#include <atomic>
+#include <vector>
+
+#include "mavlink_communication/mavlink_inspector.h"
+#include "threads.h"
+#include "settings.h"
+
+/*
+ * Parameter Entry
+ *
+ * One onboard parameter as carried by PARAM_VALUE / PARAM_SET. raw is the
+ * wire float; how it maps to the declared type depends on the autopilot
+ * (see parameter_manager::decode_value).
+ */
+struct parameter_entry
+{
+    char id[17] = {}; // param_id, always null-terminated here
+    float raw = 0.0f;
+    uint8_t type = MAV_PARAM_TYPE_REAL32;
+    bool received = false;
+
+    QString name(void) const { return QString::fromLatin1(id); }
+    void set_name(const QString &name_in);
+};
+
+/*
+ * Parameter Sync Status
+ *
+ * Progress of the download / upload session of one (sysid, compid).
+ */
+struct parameter_sync_status
+{
+    enum phase_type
+    {
+        IDLE,
+        HASH_CHECK,   // asking the vehicle for its parameter hash
+        LISTING,      // PARAM_REQUEST_LIST stream in progress
+        GAP_FILL,     // stream went quiet, reading the missing indices
+        DONE,
+        FAILED
+    };
+
+    int phase = IDLE;
+    int count = -1;   // as reported by the vehicle, -1 until the first PARAM_VALUE
+    int received = 0;
+    int reads_sent = 0;
+    int uploads_pending = 0; // queued or in flight
+    int uploads_failed = 0;
+    bool from_cache = false;
+    qint64 elapsed_ns = 0;
+
+    QString get_QString(void) const;
+};
+
+/*
+ * Parameter Manager Class
+ *
+ * Pipelined MAVLink parameter protocol client for any number of vehicles.
+ * Downloads start with PARAM_REQUEST_LIST; received indices are tracked in
+ * a bitmap and, once the stream goes quiet, the holes are filled with a
+ * window of PARAM_REQUEST_READ by index instead of one request per round
+ * trip. Uploads are queued and sent as PARAM_SET with a bounded number in
+ * flight, each confirmed by the echoed PARAM_VALUE. If the vehicle answers
+ * the "_HASH_CHECK" request (PX4), a local cache keyed by (sysid, compid)
+ * and hash skips unchanged downloads.
+ *
+ * PARAM_VALUE messages arrive on the mavlink_manager aggregation thread and
+ * are handed over through an mpsc_ring; all protocol work runs in tick().
+ * tick() shares the real-time scheduler thread, so the cache is read and
+ * written by a non real-time job_thread and loads are posted back to tick().
+ */
+class parameter_manager : public periodic_task, public mavlink_message_sink
+{
+    Q_OBJECT
+
+public:
+    explicit parameter_manager(QObject* parent, generic_thread_settings* settings_in_, mavlink_manager* mavlink_manager_in_);
+    ~parameter_manager();
+
+    static constexpr int read_window = 16;                         // PARAM_REQUEST_READ in flight per vehicle
+    static constexpr int set_window = 4;                           // PARAM_SET in flight per vehicle
+    static constexpr int max_attempts = 5;                         // per request, before giving up
+    static constexpr qint64 hash_timeout_ns = 500000000LL;         // autopilots without hash support stay silent
+    static constexpr qint64 list_timeout_ns = 1000000000LL;        // no answer at all to PARAM_REQUEST_LIST
+    static constexpr qint64 list_quiet_ns = 300000000LL;           // stream gap after which holes are requested
+    static constexpr qint64 request_timeout_ns = 400000000LL;      // per PARAM_REQUEST_READ / PARAM_SET
+    static constexpr size_t inbox_capacity = 4096;
+
+    // mavlink_message_sink, aggregation thread
+    void on_message(const mavlink_message_t& msg, qint64 t_ns) override;
+
+    // PX4 stores integers bytewise in the float; others (ArduPilot) cast the value
+    static double decode_value(float raw, uint8_t type, bool bytewise);
+    static float encode_value(double value, uint8_t type, bool bytewise);
+    static QString type_QString(uint8_t type);
+
+public slots:
+    bool download(QString port_name, uint8_t sysid, uint8_t compid, bool use_cache = true);
+    // changes carry id, raw (already encoded) and type
+    bool upload(QString port_name, uint8_t sysid, uint8_t compid, QVector<parameter_entry> changes);
+    void cancel(uint8_t sysid, uint8_t compid);
+
+    bool get_status(uint8_t sysid, uint8_t compid, parameter_sync_status &status_out);
+    bool get_parameters(uint8_t sysid, uint8_t compid, QVector<parameter_entry> &params_out);
+    bool is_bytewise(uint8_t sysid);
+
+    void update_kgroundcontrol_settings(kgroundcontrol_settings* kground_control_settings_in_);
+
+signals:
+    int write_message(QString port_name, void* message);
+    void sync_finished(uint8_t sysid, uint8_t compid, bool success);
+
+protected:
+    void tick() override;
+
+private:
+    struct inbox_entry
+    {
+        qint64 t_ns;
+        uint8_t sysid;
+        uint8_t compid;
+        mavlink_param_value_t value;
+    };
+
+    struct pending_request
+    {
+        qint64 sent_ns = 0;
+        int attempts = 0;
+    };
+
+    struct pending_set
+    {
+        parameter_entry entry;
+        pending_request request;
+    };
+
+    // cache load as posted back by the I/O thread; params are empty on a miss
+    struct cache_result
+    {
+        quint16 key = 0;
+        quint64 ticket = 0;
+        QVector<parameter_entry> params;
+    };
+
+    struct outgoing_message
+    {
+        QString port_name;
+        mavlink_message_t message;
+    };
+
+    /*
+     * Parameter Session
+     *
+     * Protocol state of one (sysid, compid), guarded by mutex.
+     */
+    struct session
+    {
+        QString port_name;
+        uint8_t sysid = 0;
+        uint8_t compid = 0;
+        int phase = parameter_sync_status::IDLE;
+        bool use_cache = true;
+        bool from_cache = false;
+        quint64 cache_ticket = 0;           // cache load in progress, 0 if none
+        qint64 start_ns = 0;
+        qint64 phase_ns = 0;
+        qint64 last_rx_ns = 0;
+        int list_attempts = 0;
+        quint32 hash = 0;
+        bool hash_valid = false;
+
+        QVector<parameter_entry> params;    // by param_index
+        std::vector<quint64> received_bits; // by param_index
+        int received = 0;
+        QHash<QString, int> index_by_name;
+
+        QHash<int, pending_request> reads;  // param_index -> in flight
+        int gap_cursor = 0;
+        int reads_sent = 0;
+
+        QQueue<parameter_entry> set_queue;
+        QHash<QString, pending_set> sets;   // in flight, by name
+        int uploads_failed = 0;
+    };
+
+    static quint16 session_key(uint8_t sysid, uint8_t compid) { return static_cast<quint16>((sysid << 8) | compid); }
+    session* get_session(uint8_t sysid, uint8_t compid, const QString &port_name);
+
+    void handle_param_value(session &s, const inbox_entry &entry);
+    void service(session &s, qint64 now_ns);
+    void start_listing(session &s, qint64 now_ns);
+    void finish(session &s, int phase, qint64 now_ns);
+    void resize(session &s, int count);
+
+    void queue_request_list(session &s);
+    void queue_request_read(session &s, const char* id, int16_t index);
+    void queue_set(session &s, const parameter_entry &entry);
+
+    static QString cache_path(uint8_t sysid, uint8_t compid);
+    void request_cache(session &s, qint64 now_ns);
+    void apply_cache(session &s, const QVector<parameter_entry> &params, qint64 now_ns);
+    void save_cache(const session &s);
+    // I/O thread
+    static bool read_cache(const QString &path, quint32 hash, QVector<parameter_entry> &params_out);
+    static void write_cache(const QString &path, quint32 hash, const QVector<parameter_entry> &params);
+
+    QPointer<mavlink_manager> mavlink_manager_;
+    job_thread* cache_io_ = nullptr;
+    QMutex cache_mutex_;
+    QVector<cache_result> cache_results_;   // guarded by cache_mutex_, taken by tick()
+    quint64 next_cache_ticket_ = 1;
+    mpsc_ring<inbox_entry> inbox_{inbox_capacity};
+    std::atomic<quint64> inbox_dropped_{0};
+
+    QHash<quint16, session*> sessions_;     // guarded by mutex
+    QVector<outgoing_message> outgoing_;    // built under mutex, sent after unlocking
+    QVector<QPair<quint16, bool>> finished_; // (session key, success), emitted after unlocking
+    kgroundcontrol_settings kgroundcontrol_settings_;
+};
+
+
+/*
+ * Parameter Editor Class
+ *
+ * Window listing the parameters of one (sysid, compid). Edited values are
+ * collected and uploaded as one batch.
+ */
+class parameter_editor : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit parameter_editor(QWidget *parent, parameter_manager* manager_in_, QString port_name_in_, uint8_t sysid_in_, uint8_t compid_in_);
+
+private slots:
+    void refresh_status(void);
+    void populate_table(void);
+    void apply_filter(const QString &text);
+    void on_item_changed(QTableWidgetItem* item);
+    void on_download_clicked(bool use_cache);
+    void on_upload_clicked(void);
+
+private:
+    enum column_type
+    {
+        COLUMN_NAME,
+        COLUMN_VALUE,
+        COLUMN_TYPE,
+        COLUMN_COUNT
+    };
+
+    QPointer<parameter_manager> manager_;
+    QString port_name_;
+    uint8_t sysid_ = 0;
+    uint8_t compid_ = 0;
+    bool bytewise_ = false;
+
+    QLabel* status_label_ = nullptr;
+    QLineEdit* filter_edit_ = nullptr;
+    QTableWidget* table_ = nullptr;
+    QPushButton* btn_download_ = nullptr;
+    QPushButton* btn_refresh_ = nullptr;
+    QPushButton* btn_upload_ = nullptr;
+    QTimer* status_timer_ = nullptr;
+
+    QVector<parameter_entry> params_;  // as last populated
+    QHash<QString, double> edits_;     // name -> edited value, not yet uploaded
+    int populated_phase_ = parameter_sync_status::IDLE;
+    int uploads_pending_ = 0;
+    bool populating_ = false;
+};
+
+#endif // PARAMETER_MANAGER_H
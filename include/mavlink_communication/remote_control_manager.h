@@ -40,6 +40,7 @@
 #include <QList>
 
 #include "threads.h"
+#include "plot/plot_signal_registry.h"
 
 #include <QMutex>
 #include <QVector>
@@ -51,6 +52,7 @@
 
 class QJoystickDevice;
 class connection_manager;
+class command_manager;
 class Generic_Port;
 
 //this function applies linear maping for transforming anything in [in_min, in_max] into [out_min, out, max] range
@@ -122,8 +124,8 @@ namespace remote_control {
     // Build a user-facing label for a relay field signal.
     QString relayPlotSignalLabel(const QString& relayName, const QString& fieldName);
     
-    // Relay thread for joystick-to-MAVLink relaying
-    class JoystickRelayThread : public generic_thread {
+    // Relay task for joystick-to-MAVLink relaying (dispatched by the periodic scheduler)
+    class JoystickRelayThread : public periodic_task {
         Q_OBJECT
     public:
         JoystickRelayThread(QObject* parent,
@@ -133,7 +135,6 @@ namespace remote_control {
                         const QVector<int>& field_roles);
         ~JoystickRelayThread();
 
-        void run() override;
         void requestStop();
         void updateSettings(const JoystickRelaySettings& relay_settings, const QVector<int>& field_roles);
 
@@ -151,12 +152,22 @@ namespace remote_control {
     public slots:
         void update_kgroundcontrol_settings(kgroundcontrol_settings* kground_control_settings_in_);
 
+    protected:
+        void tick() override;
+
     private:
+        // relay rate lives in the relay settings; mirror it into the task period
+        void applyRelayRate();
+
         JoystickRelaySettings relaySettings;
         QVector<int> fieldRoles;
-        bool stopRequested = false;
+        bool plotHandlesStale = true; // guarded by mutex; set when the relay fields may have changed
 
         kgroundcontrol_settings kgroundcontrol_settings_;
+
+        // tagged (handle, field index) pairs, only touched by tick()
+        QVector<QPair<PlotSignalHandle, int>> plotHandles;
+        quint64 plotHandlesGeneration = 0;
     };
 
     // Thread-safe storage for latest role values (axis/button/pov) for all roles
@@ -498,6 +509,8 @@ namespace remote_control {
         // ---- Connection management (call from main thread) ----
         // Provide a connection_manager so relay threads can be wired to their ports.
         void setConnectionManager(connection_manager* cm);
+        // Route arm/disarm, mode and action commands through acknowledged transactions.
+        void setCommandManager(command_manager* cm);
         // Notify backend of currently-available ports/sysids/compids.
         // Backend will auto-enable/disable relay threads and rewire write_to_port.
         void onPortsUpdated(const QStringList& ports);
@@ -568,6 +581,7 @@ namespace remote_control {
 
         // ---- Connection management state ----
         connection_manager* m_connectionManager = nullptr;
+        command_manager* m_commandManager = nullptr;
         QStringList m_availPorts;
         QVector<uint8_t> m_availSysids;
         QHash<uint8_t, QVector<mavlink_enums::mavlink_component_id>> m_availCompids;
@@ -0,0 +1,176 @@
+/****************************************************************************
+ *
+ *    Copyright (C) 2025  Yevhenii Kovryzhenko. All rights reserved.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU Affero General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License Version 3 for more details.
+ *
+ *    You should have received a copy of the
+ *    GNU Affero General Public License Version 3
+ *    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions, and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions, and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *    3. No ownership or credit shall be claimed by anyone not mentioned in
+ *       the above copyright statement.
+ *    4. Any redistribution or public use of this software, in whole or in part,
+ *       whether standalone or as part of a different project, must remain
+ *       under the terms of the GNU Affero General Public License Version 3,
+ *       and all distributions in binary form must be accompanied by a copy of
+ *       the source code, as stated in the GNU Affero General Public License.
+ *
+ ****************************************************************************/
+
+#ifndef STREAM_RATE_MANAGER_H
+#define STREAM_RATE_MANAGER_H
+
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QString>
+#include <QPointer>
+#include <atomic>
+
+#include "mavlink_communication/mavlink_inspector.h"
+#include "mavlink_communication/command_manager.h"
+#include "mavlink_communication/timesync_manager.h"
+#include "threads.h"
+#include "settings.h"
+
+/*
+ * Stream Rate Manager Class
+ *
+ * Negotiates vehicle message intervals (MAV_CMD_SET_MESSAGE_INTERVAL) from
+ * what is actually in use. A stream is needed when one of its fields is
+ * tagged in the plot registry or the message is open in an inspector; it
+ * is then kept at least at needed_rate_hz. Messages behind the decoded
+ * vehicle state are kept at baseline_rate_hz, everything else is lowered
+ * to idle_rate_hz. Rates above what the vehicle streams by default are
+ * only requested for needed streams.
+ *
+ * With a link budget set, the bytes per second of all streams of the
+ * vehicles on a link are estimated from the received payload lengths;
+ * idle streams give way first, then needed streams are scaled down
+ * together. Vehicles on ports that are routed elsewhere are left at their
+ * defaults, since the other end may consume anything.
+ *
+ * The ACK of SET_MESSAGE_INTERVAL does not say which message it is for,
+ * so one request per vehicle component is in flight at a time. Turning
+ * the feature off restores every changed stream to its default (interval 0).
+ */
+class stream_rate_manager : public periodic_task
+{
+    Q_OBJECT
+
+public:
+    explicit stream_rate_manager(QObject* parent, generic_thread_settings* settings_in_, mavlink_manager* mavlink_manager_in_,
+                                 command_manager* command_manager_in_, timesync_manager* timesync_manager_in_);
+    ~stream_rate_manager();
+
+    static constexpr double needed_rate_hz = 10.0;
+    static constexpr double baseline_rate_hz = 2.0;
+    static constexpr double idle_rate_hz = 0.5;
+    static constexpr double starved_rate_hz = 0.1;          // idle rate when the budget is exhausted
+    static constexpr int frame_overhead_bytes = 12;         // MAVLink 2 header and checksum
+    static constexpr qint64 evaluation_period_ns = 1000000000LL;
+    static constexpr qint64 min_evaluation_period_ns = 200000000LL;
+    static constexpr qint64 retry_delay_ns = 5000000000LL;  // after a failed request
+    static constexpr qint64 stale_stream_ns = 10000000000LL;
+    static constexpr int stale_intervals = 3;               // missed requested intervals before a slowed stream is stale
+    static constexpr size_t results_capacity = 256;
+
+public slots:
+    // Messages (mavlink_manager::message_key) a viewer currently displays; an empty set removes it
+    void set_viewer_demand(quintptr viewer, QVector<quint64> keys);
+    void command_finished(quint64 transaction_id, uint8_t sysid, uint8_t compid, uint16_t command, int result, qint64 rtt_ns);
+
+    void update_kgroundcontrol_settings(kgroundcontrol_settings* kground_control_settings_in_);
+
+signals:
+    bool get_routing(QString src_port_name_, QVector<QString> &routing_port_names);
+
+protected:
+    void tick() override;
+
+private:
+    enum stream_class
+    {
+        IDLE,
+        BASELINE,
+        NEEDED
+    };
+
+    struct stream_state
+    {
+        double default_rate_hz = 0.0;  // observed while at the vehicle default
+        uint8_t len = 0;
+        qint64 last_ns = 0;
+        stream_class cls = IDLE;
+        qint32 desired_interval_us = 0; // 0 = vehicle default
+        qint32 requested_interval_us = 0;
+        bool rejected = false;          // vehicle refused an interval for this message
+    };
+
+    struct target_state
+    {
+        QString port_name;
+        bool in_flight = false;
+        quint64 transaction_id = 0;
+        quint64 stream_key = 0;
+        qint32 interval_us = 0;
+        qint64 retry_ns = 0;
+        bool unsupported = false;       // SET_MESSAGE_INTERVAL not implemented
+    };
+
+    struct result_entry
+    {
+        quint64 transaction_id;
+        uint8_t sysid;
+        uint8_t compid;
+        int result;
+    };
+
+    struct send_request
+    {
+        quint16 target;
+        QString port_name;
+        uint32_t msgid;
+        qint32 interval_us;
+    };
+
+    static quint16 target_key(uint8_t sysid, uint8_t compid) { return static_cast<quint16>((sysid << 8) | compid); }
+    static qint32 interval_us(double rate_hz) { return static_cast<qint32>(1.0E6 / rate_hz); }
+
+    void update_plot_demand(void);
+    void evaluate(qint64 now_ns);
+    void process_result(const result_entry &entry, qint64 now_ns);
+    void collect_requests(qint64 now_ns, QVector<send_request> &requests_out);
+
+    QPointer<mavlink_manager> mavlink_manager_;
+    QPointer<command_manager> command_manager_;
+    QPointer<timesync_manager> timesync_manager_;
+    mpsc_ring<result_entry> results_{results_capacity};
+
+    // guarded by mutex
+    QHash<quint64, stream_state> streams_;       // by mavlink_manager::message_key
+    QHash<quint16, target_state> targets_;       // by (sysid, compid)
+    QHash<quintptr, QSet<quint64>> viewer_demand_;
+    QSet<quint64> plot_demand_;
+    quint64 tag_generation_ = 0;
+    bool demand_changed_ = true;
+    qint64 last_evaluation_ns_ = 0;
+    kgroundcontrol_settings kgroundcontrol_settings_;
+};
+
+#endif // STREAM_RATE_MANAGER_H
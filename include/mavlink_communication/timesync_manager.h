@@ -0,0 +1,177 @@
+/****************************************************************************
+ *
+ *    Copyright (C) 2025  Yevhenii Kovryzhenko. All rights reserved.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU Affero General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License Version 3 for more details.
+ *
+ *    You should have received a copy of the
+ *    GNU Affero General Public License Version 3
+ *    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions, and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions, and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *    3. No ownership or credit shall be claimed by anyone not mentioned in
+ *       the above copyright statement.
+ *    4. Any redistribution or public use of this software, in whole or in part,
+ *       whether standalone or as part of a different project, must remain
+ *       under the terms of the GNU Affero General Public License Version 3,
+ *       and all distributions in binary form must be accompanied by a copy of
+ *       the source code, as stated in the GNU Affero General Public License.
+ *
+ ****************************************************************************/
+
+#ifndef TIMESYNC_MANAGER_H
+#define TIMESYNC_MANAGER_H
+
+#include <QHash>
+#include <QVector>
+#include <QString>
+#include <QPointer>
+#include <atomic>
+
+#include "mavlink_communication/mavlink_inspector.h"
+#include "threads.h"
+#include "settings.h"
+
+/*
+ * Vehicle Clock
+ *
+ * Lock-free table of the offset between each vehicle's TIMESYNC clock and
+ * time_base (vehicle time = time_base + offset), published by
+ * timesync_manager. Relays read it to stamp outgoing data in the vehicle's
+ * time base; an entry is only valid while the estimate is converged.
+ */
+class vehicle_clock
+{
+public:
+    static bool get_offset_ns(uint8_t sysid, qint64 &offset_ns_out);
+    static bool to_vehicle_ns(uint8_t sysid, qint64 t_ns, qint64 &vehicle_ns_out);
+
+    static void publish(uint8_t sysid, qint64 offset_ns);
+    static void invalidate(uint8_t sysid);
+
+private:
+    static std::atomic<qint64> offsets_ns_[256];
+    static std::atomic<bool> valid_[256];
+};
+
+/*
+ * Timesync Estimate
+ *
+ * Filtered clock offset and link round-trip time of one vehicle, from
+ * TIMESYNC exchanges initiated by KGroundControl.
+ */
+struct timesync_estimate
+{
+    QString port_name;        // port the last reply arrived through
+    uint8_t compid = 0;       // component answering TIMESYNC
+    qint64 offset_ns = 0;     // vehicle clock - time_base
+    qint64 rtt_ns = 0;        // filtered round trip
+    qint64 rtt_min_ns = 0;
+    quint64 samples = 0;
+    quint64 rejected = 0;     // RTT outliers
+    int offset_outliers = 0;  // consecutive offset jumps, reset on a clock change
+    qint64 last_sample_ns = 0;
+    bool converged = false;
+
+    qint64 latency_ns(void) const { return rtt_ns / 2; }
+    QString get_QString(qint64 now_ns) const;
+};
+
+/*
+ * Timesync Manager Class
+ *
+ * TIMESYNC initiator and responder. Requests are sent on every open port
+ * (each with a distinct ts1, so the reply tells which port a vehicle is
+ * on); replies update a per-vehicle estimate of clock offset and one-way
+ * latency (half the filtered round trip). Requests from vehicles are
+ * answered on their port, stamped at the midpoint of the time the request
+ * was held here, so our own processing delay does not bias the vehicle's
+ * offset estimate.
+ *
+ * The filter converges quickly on the first samples, then smooths;
+ * round trips far above the filtered value are rejected (the symmetric
+ * delay assumption fails for them), and a persistent offset jump resets
+ * the estimate (vehicle reboot).
+ *
+ * Latency is published to the plot registry as
+ * "timesync/<sysid>/latency_ms" (filtered) and "timesync/<sysid>/rtt_ms"
+ * (raw samples).
+ */
+class timesync_manager : public periodic_task, public mavlink_message_sink
+{
+    Q_OBJECT
+
+public:
+    explicit timesync_manager(QObject* parent, generic_thread_settings* settings_in_, mavlink_manager* mavlink_manager_in_);
+    ~timesync_manager();
+
+    static constexpr qint64 request_period_ns = 1000000000LL;
+    static constexpr qint64 converging_request_period_ns = 100000000LL;
+    static constexpr qint64 max_rtt_ns = 500000000LL;          // replies later than this are dropped
+    static constexpr qint64 stale_timeout_ns = 5000000000LL;   // no valid sample: estimate invalid
+    static constexpr qint64 offset_jump_ns = 100000000LL;
+    static constexpr int offset_jump_samples = 5;
+    static constexpr int convergence_samples = 5;
+    static constexpr double converging_gain = 0.3;
+    static constexpr double tracking_gain = 0.05;
+    static constexpr size_t inbox_capacity = 256;
+
+    static QString latency_signal_id(uint8_t sysid);
+    static QString rtt_signal_id(uint8_t sysid);
+
+    // mavlink_message_sink, aggregation thread
+    void on_message(const mavlink_message_t& msg, qint64 t_ns) override;
+
+public slots:
+    bool get_estimate(uint8_t sysid, timesync_estimate &estimate_out);
+    QString get_report_QString(void);
+
+    void update_kgroundcontrol_settings(kgroundcontrol_settings* kground_control_settings_in_);
+
+signals:
+    int write_message(QString port_name, void* message);
+    QVector<QString> get_port_names(void);
+
+protected:
+    void tick() override;
+
+private:
+    struct inbox_entry
+    {
+        qint64 t_ns;
+        uint8_t sysid;
+        uint8_t compid;
+        mavlink_timesync_t timesync;
+    };
+
+    void reset_estimate(uint8_t sysid, timesync_estimate &estimate);
+
+    QPointer<mavlink_manager> mavlink_manager_;
+    mpsc_ring<inbox_entry> inbox_{inbox_capacity};
+    std::atomic<quint64> inbox_dropped_{0};
+
+    QHash<uint8_t, timesync_estimate> estimates_; // by sysid, guarded by mutex
+    QHash<qint64, QString> pending_;              // ts1 of requests in flight -> port
+    qint64 last_ts1_ = 0;
+    qint64 next_request_ns_ = 0;
+    kgroundcontrol_settings kgroundcontrol_settings_;
+
+    // sysid -> (latency, rtt) plot handles, only touched by tick()
+    QHash<uint8_t, QPair<PlotSignalHandle, PlotSignalHandle>> plot_handles_;
+    quint64 plot_handles_generation_ = 0;
+};
+
+#endif // TIMESYNC_MANAGER_H
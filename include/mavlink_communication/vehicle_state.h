@@ -0,0 +1,181 @@
+/****************************************************************************
+ *
+ *    Copyright (C) 2025  Yevhenii Kovryzhenko. All rights reserved.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU Affero General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License Version 3 for more details.
+ *
+ *    You should have received a copy of the
+ *    GNU Affero General Public License Version 3
+ *    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions, and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions, and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *    3. No ownership or credit shall be claimed by anyone not mentioned in
+ *       the above copyright statement.
+ *    4. Any redistribution or public use of this software, in whole or in part,
+ *       whether standalone or as part of a different project, must remain
+ *       under the terms of the GNU Affero General Public License Version 3,
+ *       and all distributions in binary form must be accompanied by a copy of
+ *       the source code, as stated in the GNU Affero General Public License.
+ *
+ ****************************************************************************/
+
+#ifndef VEHICLE_STATE_H
+#define VEHICLE_STATE_H
+
+#include <QString>
+#include <QThread>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+#define MAVLINK_USE_MESSAGE_INFO
+#include "all/mavlink.h"
+
+/*
+ * Vehicle State Class
+ *
+ * Typed view of one vehicle (sysid), decoded once per message by the
+ * mavlink_manager aggregation stage. Each group carries the time_base stamp
+ * of its last update; 0 means the vehicle has not sent it yet. Plain data,
+ * so snapshots are a single copy.
+ */
+struct vehicle_state
+{
+    uint8_t sysid = 0;
+
+    // HEARTBEAT of the autopilot component
+    qint64 heartbeat_ns = 0;
+    uint8_t autopilot_compid = 0;
+    uint8_t type = 0;
+    uint8_t autopilot = 0;
+    uint8_t base_mode = 0;
+    uint8_t system_status = 0;
+    uint32_t custom_mode = 0;
+    bool armed = false;
+
+    // ATTITUDE (rad, rad/s)
+    qint64 attitude_ns = 0;
+    float roll = 0.0f, pitch = 0.0f, yaw = 0.0f;
+    float rollspeed = 0.0f, pitchspeed = 0.0f, yawspeed = 0.0f;
+
+    // LOCAL_POSITION_NED (m, m/s)
+    qint64 local_position_ns = 0;
+    float x = 0.0f, y = 0.0f, z = 0.0f;
+    float vx = 0.0f, vy = 0.0f, vz = 0.0f;
+
+    // GLOBAL_POSITION_INT (deg, m, m/s)
+    qint64 global_position_ns = 0;
+    double lat_deg = 0.0, lon_deg = 0.0;
+    float alt_m = 0.0f, relative_alt_m = 0.0f;
+    float ground_vx = 0.0f, ground_vy = 0.0f, ground_vz = 0.0f;
+    float heading_deg = 0.0f;
+
+    // SYS_STATUS / BATTERY_STATUS (first battery)
+    qint64 battery_ns = 0;
+    float battery_voltage_v = 0.0f;  // NaN if unknown
+    float battery_current_a = 0.0f;  // NaN if unknown
+    int8_t battery_remaining_pct = -1;
+
+    // link health, over all components of this sysid
+    qint64 last_rx_ns = 0;
+    quint64 rx_count = 0;
+    quint64 lost_count = 0; // inferred from sequence gaps
+
+    // decode msg into the matching group; returns false if msg carries nothing tracked here
+    bool update(const mavlink_message_t &msg, qint64 t_ns);
+    double link_loss_ratio(void) const;
+    QString get_QString(qint64 now_ns) const;
+};
+
+static_assert(std::is_trivially_copyable<vehicle_state>::value, "vehicle_state snapshots are raw copies");
+
+/*
+ * Vehicle State Slot
+ *
+ * Single-writer seqlock around one vehicle_state. The aggregation thread
+ * updates its private working copy and publishes it after each message;
+ * readers copy a consistent snapshot without locks and retry only if they
+ * raced a publish. Slots are allocated once per sysid and never freed while
+ * the manager lives.
+ */
+class vehicle_state_slot
+{
+public:
+    explicit vehicle_state_slot(uint8_t sysid)
+    {
+        working.sysid = sysid;
+        published_.sysid = sysid;
+        last_seq_.fill(-1);
+    }
+
+    // writer only
+    vehicle_state working;
+    bool track(const mavlink_message_t &msg, qint64 t_ns)
+    {
+        // sequence numbers are per component
+        const int16_t last = last_seq_[msg.compid];
+        if (last >= 0)
+        {
+            // large jumps are duplicates or reordering (e.g. the same vehicle on two links), not loss
+            const uint8_t gap = static_cast<uint8_t>(msg.seq - static_cast<uint8_t>(last) - 1);
+            if (gap < 128) working.lost_count += gap;
+        }
+        last_seq_[msg.compid] = msg.seq;
+        working.rx_count++;
+        working.last_rx_ns = t_ns;
+        return working.update(msg, t_ns);
+    }
+    void reset(void)
+    {
+        const uint8_t sysid = working.sysid;
+        working = vehicle_state();
+        working.sysid = sysid;
+        last_seq_.fill(-1);
+    }
+    void publish(void)
+    {
+        const uint32_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(static_cast<void*>(&published_), &working, sizeof(vehicle_state));
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    // any thread
+    void read(vehicle_state &state_out) const
+    {
+        for (;;)
+        {
+            const uint32_t seq = seq_.load(std::memory_order_acquire);
+            if (seq & 1u)
+            {
+                QThread::yieldCurrentThread();
+                continue;
+            }
+            memcpy(static_cast<void*>(&state_out), &published_, sizeof(vehicle_state));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == seq) return;
+        }
+    }
+
+private:
+    std::array<int16_t, 256> last_seq_;
+    std::atomic<uint32_t> seq_{0};
+    vehicle_state published_;
+};
+
+#endif // VEHICLE_STATE_H
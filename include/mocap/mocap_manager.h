@@ -49,6 +49,7 @@
 #include "optitrack.hpp"
 #include "hardware_io/generic_port.h"
 #include "settings.h"
+#include "plot/plot_signal_registry.h"
 #include <QElapsedTimer>
 #include <QPlainTextEdit>
 #include <QLineEdit>
@@ -67,7 +68,7 @@ class mocap_relay_thread;
 class mocap_data_t: public optitrack_message_t
 {
 public:
-    uint64_t time_ms;
+    qint64 time_ns; // time_base receive stamp
     double roll;
     double pitch;
     double yaw;
@@ -86,7 +87,7 @@ public:
     ~mocap_data_aggegator();
 
 public slots:
-    void update(QVector<optitrack_message_t> incoming_data, mocap_rotation rotation);
+    void update(QVector<optitrack_message_t> incoming_data, mocap_rotation rotation, qint64 rx_time_ns);
     void clear(void);
 
     QVector<int> get_ids(void);
@@ -103,7 +104,7 @@ private:
     QVector<int> frame_ids_;
     QVector<mocap_data_t> frames_;
     QHash<int, int> frame_id_to_index_; // Maps frame ID to index in frames_ vector
-    QHash<int, uint64_t> last_time_ms_; // last timestamp per frame id
+    QHash<int, qint64> last_time_ns_; // last time_base stamp per frame id
     QMutex* mutex = nullptr;
     QTimer* cleanup_timer_ = nullptr;
 };
@@ -128,7 +129,7 @@ public:
 
 signals:
     // void new_data_available(void);
-    bool update(QVector<optitrack_message_t> incoming_data, mocap_rotation rotation);
+    bool update(QVector<optitrack_message_t> incoming_data, mocap_rotation rotation, qint64 rx_time_ns);
 
 public slots:
 
@@ -149,14 +150,15 @@ private:
 
 
 
-class mocap_data_inspector_thread : public generic_thread
+class mocap_data_inspector_thread : public periodic_task
 {
     Q_OBJECT
 public:
     explicit mocap_data_inspector_thread(QObject* parent, generic_thread_settings *new_settings);
     ~mocap_data_inspector_thread();
 
-    void run();
+protected:
+    void tick() override;
 
 public slots:
     void new_data_available(void);
@@ -170,14 +172,15 @@ private:
     bool new_data_available_ = false;
 };
 
-class mocap_relay_thread : public generic_thread
+class mocap_relay_thread : public periodic_task
 {
     Q_OBJECT
 public:
     explicit mocap_relay_thread(QObject *parent, generic_thread_settings *new_settings, mocap_relay_settings *relay_settings, mocap_data_aggegator** mocap_data_ptr);    
     ~mocap_relay_thread();
 
-    void run();
+protected:
+    void tick() override;
 
 public slots:    
     void update_settings(mocap_relay_settings* settings_in_);
@@ -188,6 +191,7 @@ signals:
 
 private:
     QByteArray pack_most_recent_msg(mocap_data_t data);
+    qint64 relay_time_ns(qint64 t_ns);
     mocap_relay_settings* relay_settings = nullptr;
     mocap_data_aggegator** mocap_data_ptr = nullptr;
     mocap_data_t previous_data;
@@ -204,7 +208,7 @@ public:
     void run() override;
 
 signals:
-    bool update(QVector<optitrack_message_t> incoming_data, mocap_rotation rotation);
+    bool update(QVector<optitrack_message_t> incoming_data, mocap_rotation rotation, qint64 rx_time_ns);
 
 public slots:
     void update_settings(const fake_mocap_settings& settings);
@@ -323,6 +327,9 @@ private:
     QString mocapCurrentFrameId_;
     bool mocapTreeResetting_ = false; // guard against updates during reset/clear
     QTimer* mocapQueueTimer_ = nullptr;
+    // frame id -> tagged (handle, field) pairs, rebuilt when the registry tag generation changes
+    QHash<int, QVector<QPair<PlotSignalHandle, int>>> mocapPlotFields_;
+    quint64 mocapPlotGeneration_ = 0;
 
 private slots:
     void onRegistrySignalsChanged();
@@ -9,8 +9,11 @@
 #include <QTimer>
 #include <QTimer>
 #include <QQuaternion>
+#include <QVector3D>
+#include <deque>
+#include <memory>
 
-class PlotSignalRegistry;
+#include "plot/plot_signal_registry.h"
 
 struct Plot3DGroup {
     QString name;
@@ -280,6 +283,29 @@ private:
     bool transformValue(const QString& id, double x, double& yOut) const; // returns true if valid
     void render3D(QPainter& p, const QRect& rect);
 
+    // Newest value of a signal, read in place from the registry
+    bool latestValue(const QString& id, double& value) const;
+
+    // Timestamp-aligned (x, y, z) points of a 3D group, extended by a merge join over
+    // the samples each signal's registry cursor returns instead of being rebuilt every paint
+    struct AlignedPoint {
+        qint64 t_ns;
+        QVector3D v;
+    };
+    struct AlignedTrail {
+        QVector<PlotSignalHandle> handles;
+        QVector<PlotSignalCursor> cursors;
+        QVector<std::deque<PlotSignalSample>> pending; // read but not yet joined, per signal
+        std::deque<AlignedPoint> points;
+        std::deque<AlignedPoint> fallback; // used when the signals share no timestamp
+        quint64 lastPaint = 0;
+    };
+    const std::deque<AlignedPoint>& alignedPoints(const Plot3DGroup& group);
+    void pruneTrails();
+    QHash<QString, std::shared_ptr<AlignedTrail>> trails_; // key: group signal ids
+    QVector<PlotSignalSample> trailScratch_;
+    quint64 paintSerial_ = 0;
+
     // visuals
     bool showCornerAxes_ = true;
     bool showCenterAxes_ = false;
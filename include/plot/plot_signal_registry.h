@@ -7,6 +7,9 @@
 #include <QColor>
 #include <QString>
 #include <QDateTime>
+#include <atomic>
+#include <deque>
+#include <memory>
 
 // A shared registry of tagged signals available to all plotting manager instances.
 // Minimal interface: tag/untag signals and append samples. Emits updates when list changes.
@@ -21,6 +24,112 @@ struct PlotSignalDef {
     QString label;    // human readable label
 };
 
+// Stable integer key of a signal id, valid for the lifetime of the process.
+// Producers resolve it once (handleOf) and append without hashing the id.
+using PlotSignalHandle = int;
+constexpr PlotSignalHandle kInvalidPlotSignalHandle = -1;
+
+struct PlotSignalTuple {
+    PlotSignalHandle handle;
+    qint64 t_ns;
+    double value;
+};
+
+// Time-ordered samples of one signal in a contiguous ring. Capacity doubles when
+// the window does not fit and halves once it is mostly empty, so append and trim
+// are amortized O(1). At kMaxCapacity the oldest samples give way instead.
+class PlotSignalBuffer {
+public:
+    int size() const { return size_; }
+    bool isEmpty() const { return size_ == 0; }
+    int capacity() const { return ring_.size(); }
+    // i = 0 is the oldest sample
+    const PlotSignalSample& at(int i) const { return ring_[wrap(head_ + i)]; }
+    const PlotSignalSample& front() const { return at(0); }
+    const PlotSignalSample& back() const { return at(size_ - 1); }
+
+    class const_iterator {
+    public:
+        const_iterator(const PlotSignalBuffer* buffer, int i) : buffer_(buffer), i_(i) {}
+        const PlotSignalSample& operator*() const { return buffer_->at(i_); }
+        const PlotSignalSample* operator->() const { return &buffer_->at(i_); }
+        const_iterator& operator++() { ++i_; return *this; }
+        bool operator==(const const_iterator& o) const { return i_ == o.i_; }
+        bool operator!=(const const_iterator& o) const { return i_ != o.i_; }
+    private:
+        const PlotSignalBuffer* buffer_;
+        int i_;
+    };
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size_); }
+
+    // Sequence numbers let readers pick up only new samples: every appended sample
+    // gets the next one, trimming keeps them, and anything that reorders or drops
+    // history from the middle (merge, clear) bumps generation() instead.
+    quint64 generation() const { return generation_; }
+    quint64 endSeq() const { return endSeq_; } // sequence number after back()
+    quint64 firstSeq() const { return endSeq_ - static_cast<quint64>(size_); }
+
+    // Appends in time order; an older sample is merged into place (O(n), rare)
+    void append(const PlotSignalSample& s);
+    // Adds a batch that may overlap or predate the stored samples
+    void merge(const QVector<PlotSignalSample>& samples);
+    // Drops samples older than oldest_ns
+    void trimBefore(qint64 oldest_ns);
+    void clear();
+
+    // index of the first sample with t_ns >= t (size() if none)
+    int lowerBound(qint64 t_ns) const;
+    QVector<PlotSignalSample> toVector() const;
+    // Appends samples [from, to) to out
+    void copyTo(int from, int to, QVector<PlotSignalSample>& out) const;
+    // Lowest and highest value of samples [from, to), NaN skipped; false if there is none.
+    // Answered from the min/max pyramid, so the cost is O(log n) rather than O(to - from).
+    bool minMax(int from, int to, double& lo, double& hi) const;
+
+private:
+    // Min/max pyramid over sequence numbers: level k has one entry per complete,
+    // aligned block of (kPyramidBlock << k) samples. Entries are added as blocks
+    // complete and dropped once trimmed, so upkeep is amortized O(1) per append.
+    struct PyramidEntry {
+        double min;
+        double max;
+    };
+    struct PyramidLevel {
+        quint64 first = 0; // block index of entries.front()
+        std::deque<PyramidEntry> entries;
+    };
+    static constexpr int kPyramidBlock = 8;
+    static constexpr int kPyramidLevels = 24;
+
+    static constexpr int kMinCapacity = 64;
+    static constexpr int kMaxCapacity = 1 << 21; // 32 MB of samples per signal
+    int wrap(int i) const { const int n = ring_.size(); return i >= n ? i - n : i; }
+    void reserveFor(int needed);
+    void dropFront(int count);
+    void reallocate(int capacity);
+    void pyramidAppend(quint64 seq);
+    void pyramidPush(int level, quint64 block, const PyramidEntry& entry);
+    void pyramidTrim();
+    void pyramidRebuild();
+    // folds blocks [from, to) of a level into lo/hi, scanning raw samples for any missing entry
+    void pyramidRange(int level, quint64 from, quint64 to, double& lo, double& hi) const;
+    void scanRange(quint64 from_seq, quint64 to_seq, double& lo, double& hi) const;
+
+    QVector<PlotSignalSample> ring_;
+    int head_ = 0;
+    int size_ = 0;
+    quint64 generation_ = 1;
+    quint64 endSeq_ = 0;
+    QVector<PyramidLevel> pyramid_;
+};
+
+// Per-consumer read position in one signal; see PlotSignalRegistry::readNew()
+struct PlotSignalCursor {
+    quint64 generation = 0; // 0: nothing read yet
+    quint64 next = 0;       // sequence number of the first unread sample
+};
+
 class PlotSignalRegistry : public QObject {
     Q_OBJECT
 public:
@@ -33,13 +142,44 @@ public:
     bool isTagged(const QString& id) const;
     QSet<QString> taggedIds() const;
     QSet<QString> taggedIdsByPrefix(const QString& prefix) const;
+    // Bumped on every tag/untag; lets producers cache tag-derived lookups (lock-free)
+    quint64 tagGeneration() const { return tagGeneration_.load(std::memory_order_acquire); }
+
+    // Handle of a tagged signal, kInvalidPlotSignalHandle if not tagged. A handle
+    // survives untag/re-tag of the same id, so it may be cached per tagGeneration().
+    PlotSignalHandle handleOf(const QString& id) const;
 
-    // Append a sample (thread-safe). If id unknown, ignored.
+    // Append a sample (thread-safe). If id unknown or untagged, ignored.
     void appendSample(const QString& id, qint64 t_ns, double value);
+    void appendSample(PlotSignalHandle handle, qint64 t_ns, double value);
+    // Append a time-ordered batch (e.g. history backfill) with one trim
+    void appendSamples(const QString& id, const QVector<PlotSignalSample>& samples);
+    void appendSamples(PlotSignalHandle handle, const QVector<PlotSignalSample>& samples);
+    // Append samples of many signals with a single registry lookup
+    void appendBatch(const QVector<PlotSignalTuple>& samples);
 
     // Snapshot accessors (thread-safe)
     QVector<PlotSignalDef> listSignals() const;
     QVector<PlotSignalSample> getSamples(const QString& id) const;
+    // Runs fn(const PlotSignalBuffer&) on the signal's samples in place, under the signal's
+    // read lock. Producers of that signal wait meanwhile: keep fn short and do not paint
+    // or touch the registry from it. Returns false if the id was never tagged.
+    template <typename Fn>
+    bool readSamples(const QString& id, Fn&& fn) const {
+        const auto data = findData(id);
+        if (!data) return false;
+        QReadLocker guard(&data->lock);
+        fn(static_cast<const PlotSignalBuffer&>(data->buffer));
+        return true;
+    }
+    // Lowest and highest value with t0_ns <= t_ns <= t1_ns, NaN skipped, from the signal's
+    // min/max pyramid under its read lock. Returns false if there is no such sample.
+    bool minMax(const QString& id, qint64 t0_ns, qint64 t1_ns, double& lo, double& hi) const;
+    // Copies only the samples appended since cursor into out and advances it, for
+    // consumers that keep incremental state derived from a signal. Returns
+    // false if the cursor is stale (history merged, cleared or trimmed past it);
+    // out then holds the whole retained history and replaces the consumer's copy.
+    bool readNew(PlotSignalHandle handle, PlotSignalCursor& cursor, QVector<PlotSignalSample>& out) const;
 
     // Buffer duration management (seconds)
     void setBufferDurationSec(double seconds);
@@ -53,17 +193,40 @@ public:
 
 signals:
     void signalsChanged();
-    void samplesAppended(QString id);
+    // Coalesced: at most once per notify interval, with every id that received samples
+    void samplesAppended(QSet<QString> ids);
     void bufferDurationChanged(double seconds);
     void samplesCleared();
     void epochChanged(qint64 epoch_ns);
 
 private:
+    // Per-signal storage with its own lock, so a busy producer only contends
+    // with readers of the same signal. Shared so an untag during a read is safe.
+    struct SignalData {
+        mutable QReadWriteLock lock;
+        QString id;
+        bool tagged = false; // guarded by lock; appends to an untagged signal are dropped
+        PlotSignalBuffer buffer;
+        std::atomic<bool> dirty{false}; // received samples since the last notification
+    };
+
     PlotSignalRegistry();
-    mutable QReadWriteLock lock_;
+    std::shared_ptr<SignalData> findData(const QString& id) const;
+    std::shared_ptr<SignalData> findData(PlotSignalHandle handle) const;
+    // Appends under the signal's own lock; false if the signal is no longer tagged
+    bool appendTo(SignalData& data, const PlotSignalSample* samples, int count, qint64 window_ns);
+    void noteFirstSample(qint64 t_ns);
+    void markDirty(SignalData& data);
+    void flushNotifications();
+    qint64 windowNs() const { return windowNs_.load(std::memory_order_relaxed); }
+
+    mutable QReadWriteLock lock_;                // guards defs_, order_, handles_ and slots_ (the tables, not the samples)
     QHash<QString, PlotSignalDef> defs_;         // id -> def
     QVector<QString> order_;                     // insertion order of ids
-    QHash<QString, QVector<PlotSignalSample>> data_; // id -> samples (append-only)
-    double bufferDurationSec_ = 60.0; // default 60 seconds
-    qint64 epoch_ns_ = -1; // first-sample time or reset time; -1 if unset
+    QHash<QString, PlotSignalHandle> handles_;   // id -> handle, never removed
+    QVector<std::shared_ptr<SignalData>> slots_; // handle -> samples
+    std::atomic<bool> notifyPending_{false};
+    std::atomic<qint64> windowNs_{60000000000LL}; // buffer duration, default 60 seconds
+    std::atomic<qint64> epoch_ns_{-1}; // first-sample time or reset time; -1 if unset
+    std::atomic<quint64> tagGeneration_{1};
 };
@@ -204,6 +204,48 @@ public:
 };
 
 
+/*
+ * Real-Time Settings Class
+ *
+ * Opt-in real-time scheduling profile shared by one
+ * class of threads (port I/O, relays, mocap). Only
+ * honoured on Linux and requires CAP_SYS_NICE (or root).
+ * Defines save/load and print functionality.
+ */
+class realtime_settings
+{
+public:
+    enum policy_type
+    {
+        OFF,
+        FIFO,
+        RR
+    };
+    enum thread_class
+    {
+        UNASSIGNED = -1,
+        PORT_IO,
+        RELAYS,
+        MOCAP,
+        THREAD_CLASS_COUNT
+    };
+
+    int policy = OFF;
+    int priority = 50; // 1 (lowest) .. 99 (highest)
+    quint64 cpu_mask = 0; // bit i allows CPU i, 0 means no pinning
+
+    QString get_QString(void) const;
+
+    void save(QSettings &settings, const QString &group) const;
+    void load(QSettings &settings, const QString &group);
+
+    static QString policy_name(int policy);
+    static QString thread_class_name(int thread_class);
+    static QString cpu_mask_to_QString(quint64 mask);
+    static quint64 cpu_mask_from_QString(const QString &text);
+};
+
+
 /*
  * Generic Thread Settings Class
  *
@@ -219,6 +261,8 @@ public:
 
     unsigned int update_rate_hz = 10;
     QThread::Priority priority = QThread::Priority::NormalPriority;
+    // real-time profile this thread follows (see realtime_settings)
+    int realtime_class = realtime_settings::UNASSIGNED;
 
     QString get_QString(void);
     void printf(void);
@@ -251,6 +295,13 @@ public:
 
     // Plotting buffer (seconds)
     double plot_buffer_duration_sec = 60.0;
+
+    // Per-message MAVLink history kept for scrub-back and late plotting (seconds, 0 disables)
+    double mavlink_history_duration_sec = 30.0;
+
+    // Negotiate vehicle stream rates (SET_MESSAGE_INTERVAL) from what is being viewed
+    bool stream_rate_auto = false;
+    int stream_budget_bytes_per_s = 0; // per link, 0 = unlimited
     
     // Auto-update preferences
     bool check_updates_on_startup = true;
@@ -266,6 +317,10 @@ public:
     // settings panel controls this flag.
     bool auto_install_on_startup = true;
 
+    // Real-time scheduling profiles (per thread class) and memory locking
+    realtime_settings realtime[realtime_settings::THREAD_CLASS_COUNT];
+    bool realtime_lock_memory = false;
+
 
     QString get_QString(void);
     void printf(void);
@@ -336,6 +391,7 @@ public:
     mavlink_enums::mavlink_component_id compid = mavlink_enums::ALL;
     uint32_t update_rate_hz = 40;
     int priority = 0;
+    bool vehicle_time = false; // stamp in the vehicle's TIMESYNC clock once it is known
 
     QString get_QString(void);
     void printf(void);
@@ -356,6 +412,7 @@ public:
             compid = other.compid;
             update_rate_hz = other.update_rate_hz;
             priority = other.priority;
+            vehicle_time = other.vehicle_time;
         }
         return *this; // Return a reference to this object
     }
@@ -36,9 +36,150 @@
 #define THREADS_H
 
 #include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QDeadlineTimer>
+#include <QHash>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
 
 #include "settings.h"
 
+namespace realtime
+{
+/*
+ * Latency Histogram Class
+ *
+ * Lock-free histogram of thread wake-up latencies
+ * (actual wake time minus intended wake time).
+ * Buckets follow a 1-2-5 series from 10 us to 20 ms.
+ */
+class latency_histogram
+{
+public:
+    static constexpr int BUCKET_COUNT = 12;
+
+    void record(int64_t latency_ns);
+    void reset(void);
+
+    uint64_t count(void) const;
+    int64_t max_ns(void) const { return max_ns_.load(std::memory_order_relaxed); }
+    QString get_QString(void) const;
+
+    static int64_t bucket_upper_ns(int bucket);
+
+private:
+    std::atomic<uint64_t> counts_[BUCKET_COUNT] = {};
+    std::atomic<int64_t> max_ns_{0};
+};
+
+// Update the real-time profile of a thread class and re-apply it to its running threads
+void configure(int thread_class, const realtime_settings& settings);
+// Apply all class profiles and the memory lock from the global settings
+void configure(const kgroundcontrol_settings& settings);
+realtime_settings get_class_settings(int thread_class);
+bool lock_memory(bool enable);
+
+// Register the calling thread under a class (must be called from that thread)
+void attach(int thread_class, QObject* owner, latency_histogram* histogram);
+void detach(void);
+
+// Per-thread real-time status and wake-up latency histograms, for display
+QString get_report_QString(void);
+}
+
+/*
+ * MPSC Ring Class
+ *
+ * Bounded lock-free queue for many producer threads and a single consumer
+ * (per-cell sequence numbers, after D. Vyukov). push() never blocks; it
+ * fails when the ring is full so a stalled consumer cannot stall producers.
+ * Capacity is rounded up to a power of two.
+ */
+template <typename T>
+class mpsc_ring
+{
+public:
+    explicit mpsc_ring(size_t capacity)
+    {
+        size_t size_ = 2;
+        while (size_ < capacity) size_ <<= 1;
+        mask_ = size_ - 1;
+        cells_.reset(new cell[size_]);
+        for (size_t i = 0; i < size_; i++) cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // any thread
+    bool push(const T& value)
+    {
+        return push_with([&value](T& cell_value) { cell_value = value; });
+    }
+    // any thread; fill(T&) writes the value in place, so only what it touches is copied
+    template <typename Fill>
+    bool push_with(Fill&& fill)
+    {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        cell* cell_ = nullptr;
+        for (;;)
+        {
+            cell_ = &cells_[pos & mask_];
+            const size_t seq = cell_->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0) return false; // full
+            else pos = tail_.load(std::memory_order_relaxed);
+        }
+        fill(cell_->value);
+        cell_->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer thread only
+    bool pop(T& value_out)
+    {
+        cell& cell_ = cells_[head_ & mask_];
+        if (cell_.sequence.load(std::memory_order_acquire) != head_ + 1) return false; // empty
+        value_out = std::move(cell_.value); // the cell is dead until a producer refills it
+        cell_.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+        head_++;
+        return true;
+    }
+    // consumer thread only; read(const T&) consumes the value in place
+    template <typename Read>
+    bool pop_with(Read&& read)
+    {
+        cell& cell_ = cells_[head_ & mask_];
+        if (cell_.sequence.load(std::memory_order_acquire) != head_ + 1) return false; // empty
+        read(static_cast<const T&>(cell_.value));
+        cell_.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+        head_++;
+        return true;
+    }
+    bool empty(void) const
+    {
+        return cells_[head_ & mask_].sequence.load(std::memory_order_acquire) != head_ + 1;
+    }
+
+    size_t capacity(void) const { return mask_ + 1; }
+
+private:
+    struct cell
+    {
+        std::atomic<size_t> sequence{0};
+        T value;
+    };
+
+    size_t mask_ = 0;
+    std::unique_ptr<cell[]> cells_;
+    alignas(64) std::atomic<size_t> tail_{0};
+    alignas(64) size_t head_ = 0;
+};
+
 /*
  * Generic Thread Class
  *
@@ -65,8 +206,191 @@ public slots:
     QString get_settings_QString(void);
 
 protected:
+    // sleep one update period, recording the wake-up latency
+    void sleep_period(void);
+
+    QMutex* mutex;
+    generic_thread_settings generic_thread_settings_;
+    realtime::latency_histogram wakeup_latency_;
+};
+
+/*
+ * Job Thread Class
+ *
+ * Non real-time worker for blocking work (file writes, caches) handed off
+ * by periodic tasks. Those share the scheduler thread of the RELAYS class,
+ * so a slow disk must never be waited on there. Jobs are queued through an
+ * mpsc_ring and run in order; the queue is drained before the thread exits.
+ */
+class job_thread : public generic_thread
+{
+    Q_OBJECT
+
+public:
+    typedef std::function<void()> job_type;
+
+    explicit job_thread(QObject* parent, generic_thread_settings* settings_in_, size_t capacity);
+    ~job_thread();
+
+    // any thread; false if the queue is full
+    bool post(job_type job);
+
+    void run() override;
+
+private:
+    void wake(void);
+
+    mpsc_ring<job_type> jobs_;
+    QMutex wake_mutex_;
+    QWaitCondition wake_cond_;
+    std::atomic_bool waiting_{false};
+};
+
+/*
+ * Periodic Task Statistics
+ *
+ * Timing counters collected by the periodic scheduler
+ * for every task. All times are steady clock nanoseconds.
+ * Jitter is the dispatch time minus the absolute deadline.
+ */
+struct periodic_task_stats
+{
+    uint64_t period_ns = 0;
+    uint64_t dispatches = 0;
+    uint64_t overruns = 0; // periods skipped because the task was dispatched too late
+    int64_t last_jitter_ns = 0;
+    int64_t max_jitter_ns = 0;
+    double mean_jitter_ns = 0.0;
+    int64_t last_exec_ns = 0;
+    int64_t max_exec_ns = 0;
+
+    QString get_QString(void) const;
+};
+
+/*
+ * Periodic Task Class
+ *
+ * Base class for lightweight periodic jobs (heartbeat, relays,
+ * visual refresh). Instead of owning a QThread with a sleep loop,
+ * each task is dispatched by the shared periodic_scheduler against
+ * absolute deadlines, so the output rate does not drift.
+ * Mirrors the subset of the QThread interface used throughout
+ * the project (start, requestInterruption, isRunning, isFinished,
+ * wait, terminate), so owners can manage it the same way.
+ */
+class periodic_task : public QObject
+{
+    Q_OBJECT
+
+public:
+    periodic_task(QObject* parent, generic_thread_settings* settings_in_);
+    ~periodic_task();
+
+    void start(void);
+    void start(QThread::Priority priority);
+    void requestInterruption(void);
+    bool isInterruptionRequested(void) const;
+    bool isRunning(void) const;
+    bool isFinished(void) const;
+    bool wait(QDeadlineTimer deadline = QDeadlineTimer(QDeadlineTimer::Forever));
+    void terminate(void);
+
+    periodic_task_stats get_stats(void) const;
+
+    void save_settings(QSettings &qsettings);
+    void load_settings(QSettings &qsettings);
+
+public slots:
+    void update_settings(generic_thread_settings* settings_in_);
+
+    QString get_settings_QString(void);
+
+protected:
+    // called by the scheduler thread once per period
+    virtual void tick(void) = 0;
+
     QMutex* mutex;
     generic_thread_settings generic_thread_settings_;
+
+private:
+    friend class periodic_scheduler;
+
+    enum task_state
+    {
+        IDLE,
+        SCHEDULED,
+        FINISHED
+    };
+
+    std::atomic<bool> interruption_requested_{false};
+    std::atomic<int> state_{IDLE};
+};
+
+/*
+ * Periodic Scheduler Class
+ *
+ * Single high-resolution dispatcher shared by all periodic tasks.
+ * Keeps a binary heap of absolute steady clock deadlines and sleeps
+ * precisely until the earliest one. A late task is dispatched once
+ * and the missed periods are counted as overruns rather than
+ * replayed in a burst. Runs at the highest priority requested
+ * by any of its tasks.
+ */
+class periodic_scheduler : public QThread
+{
+    Q_OBJECT
+
+public:
+    static periodic_scheduler& instance(void);
+
+    void add(periodic_task* task);
+    void reschedule(periodic_task* task);
+    // non-blocking removal; the task is marked finished once it is not being dispatched
+    void remove(periodic_task* task);
+    // blocks until the task is no longer being dispatched (unless called from a task)
+    void remove_and_wait(periodic_task* task);
+    bool wait_finished(periodic_task* task, QDeadlineTimer deadline);
+
+    periodic_task_stats get_stats(const periodic_task* task);
+    QString get_stats_QString(void);
+
+    static int64_t now_ns(void);
+
+protected:
+    void run() override;
+
+private:
+    periodic_scheduler();
+    ~periodic_scheduler();
+
+    struct task_slot
+    {
+        int64_t period_ns = 0;
+        int64_t deadline_ns = 0;
+        uint64_t generation = 0;
+        periodic_task_stats stats;
+    };
+    struct heap_entry
+    {
+        int64_t deadline_ns;
+        periodic_task* task;
+        uint64_t generation;
+        bool operator<(const heap_entry& other) const { return deadline_ns > other.deadline_ns; }
+    };
+
+    void push_locked(periodic_task* task, task_slot& slot);
+    void raise_priority_locked(QThread::Priority priority);
+    static int64_t period_from_settings(const generic_thread_settings& settings);
+
+    realtime::latency_histogram wakeup_latency_;
+    QMutex lock_;
+    QWaitCondition wakeup_;
+    QWaitCondition dispatch_done_;
+    QHash<periodic_task*, task_slot> slots_;
+    std::vector<heap_entry> heap_;
+    periodic_task* current_ = nullptr;
+    uint64_t next_generation_ = 1;
+    QThread::Priority priority_ = QThread::IdlePriority;
 };
 
 #endif // THREADS_H
@@ -0,0 +1,74 @@
+/****************************************************************************
+ *
+ *    Copyright (C) 2025  Yevhenii Kovryzhenko. All rights reserved.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU Affero General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License Version 3 for more details.
+ *
+ *    You should have received a copy of the
+ *    GNU Affero General Public License Version 3
+ *    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions, and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions, and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *    3. No ownership or credit shall be claimed by anyone not mentioned in
+ *       the above copyright statement.
+ *    4. Any redistribution or public use of this software, in whole or in part,
+ *       whether standalone or as part of a different project, must remain
+ *       under the terms of the GNU Affero General Public License Version 3,
+ *       and all distributions in binary form must be accompanied by a copy of
+ *       the source code, as stated in the GNU Affero General Public License.
+ *
+ ****************************************************************************/
+
+#ifndef TIME_BASE_H
+#define TIME_BASE_H
+
+#include <QtGlobal>
+#include <chrono>
+
+/*
+ * Time Base
+ *
+ * Single monotonic clock shared by the whole data pipeline. Every sample,
+ * log record and plot point is stamped in nanoseconds on this base, so
+ * ordering and rate estimates are immune to wall-clock steps (NTP, DST,
+ * manual changes). Values are only meaningful relative to each other.
+ */
+namespace time_base
+{
+
+inline qint64 now_ns(void)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline qint64 now_us(void)
+{
+    return now_ns() / 1000LL;
+}
+
+inline qint64 ns_to_us(qint64 t_ns)
+{
+    return t_ns / 1000LL;
+}
+
+inline double ns_to_ms(qint64 t_ns)
+{
+    return static_cast<double>(t_ns) * 1.0E-6;
+}
+
+}
+
+#endif // TIME_BASE_H
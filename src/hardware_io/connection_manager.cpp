@@ -43,6 +43,7 @@
 port_read_thread::port_read_thread(QObject* parent, generic_thread_settings *new_settings)
     : generic_thread(parent, new_settings)
 {
+    generic_thread_settings_.realtime_class = realtime_settings::PORT_IO;
     start(generic_thread_settings_.priority);
 }
 
@@ -52,52 +53,55 @@ void port_read_thread::run()
     {
         // Keep processing messages as long as they are available
         bool message_processed = false;
+        mavlink_message_t message;
+        void* ptr = static_cast<mavlink_message_t*>(&message);
         do {
-            mavlink_message_t* message = new mavlink_message_t;
-            void* ptr = static_cast<mavlink_message_t*>(message);
-            if (emit read_message(ptr, static_cast<int>(MAVLINK_COMM_0)))
+            qint64 rx_time_ns = 0;
+            if (emit read_message(ptr, static_cast<int>(MAVLINK_COMM_0), &rx_time_ns))
             {
-                emit message_received(ptr, QDateTime::currentMSecsSinceEpoch());
+                // receivers copy what they need before returning
+                emit message_received(ptr, rx_time_ns);
                 emit write_message(ptr);
                 message_processed = true; // Continue processing more messages
             } else {
-                delete message;
                 message_processed = false; // No more messages, exit inner loop
             }
         } while (message_processed && !(QThread::currentThread()->isInterruptionRequested()));
         
         // Only sleep when no messages are available
-        sleep(std::chrono::nanoseconds{static_cast<uint64_t>(1.0E9/static_cast<double>(generic_thread_settings_.update_rate_hz))});
+        sleep_period();
     }
 }
 
 
 
 system_status_thread::system_status_thread(QObject* parent, generic_thread_settings* settings_in_, kgroundcontrol_settings* kground_control_settings_in_)
-    : generic_thread(parent, settings_in_)
+    : periodic_task(parent, settings_in_)
 {
+    setObjectName("system_status");
     update_kgroundcontrol_settings(kground_control_settings_in_);
     start(generic_thread_settings_.priority);
 }
 system_status_thread::~system_status_thread()
 {
-
+    periodic_scheduler::instance().remove_and_wait(this);
 }
 
 
-void system_status_thread::run()
+void system_status_thread::tick()
 {
-    while (!(QThread::currentThread()->isInterruptionRequested()))
-    {
-        mavlink_message_t message;
-        mavlink_msg_heartbeat_pack(kgroundcontrol_settings_.sysid, kgroundcontrol_settings_.compid, &message, MAV_TYPE_GCS, MAV_AUTOPILOT_INVALID, MAV_MODE_GUIDED_ARMED, 0, MAV_STATE_ACTIVE);
-        // Serialise to bytes here (background thread) so the QueuedConnection
-        // carries a deep-copied QByteArray instead of a raw stack pointer.
-        uint8_t buf[MAVLINK_MAX_PACKET_LEN];
-        uint16_t len = mavlink_msg_to_send_buffer(buf, &message);
-        emit send_heartbeat_bytes(QByteArray(reinterpret_cast<const char*>(buf), len));
-        sleep(std::chrono::nanoseconds{static_cast<uint64_t>(1.0E9/static_cast<double>(generic_thread_settings_.update_rate_hz))});
-    }
+    mutex->lock();
+    const uint8_t sysid_ = kgroundcontrol_settings_.sysid;
+    const uint8_t compid_ = static_cast<uint8_t>(kgroundcontrol_settings_.compid);
+    mutex->unlock();
+
+    mavlink_message_t message;
+    mavlink_msg_heartbeat_pack(sysid_, compid_, &message, MAV_TYPE_GCS, MAV_AUTOPILOT_INVALID, MAV_MODE_GUIDED_ARMED, 0, MAV_STATE_ACTIVE);
+    // Serialise to bytes here (scheduler thread) so the QueuedConnection
+    // carries a deep-copied QByteArray instead of a raw stack pointer.
+    uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+    uint16_t len = mavlink_msg_to_send_buffer(buf, &message);
+    emit send_heartbeat_bytes(QByteArray(reinterpret_cast<const char*>(buf), len));
 }
 
 void system_status_thread::update_kgroundcontrol_settings(kgroundcontrol_settings* kground_control_settings_in_)
@@ -285,10 +289,12 @@ bool connection_manager::add(QString new_port_name, \
     if (port_->start() == 0)
     {
         new_port_thread = new port_read_thread(this, thread_settings_);
+        new_port_thread->setObjectName(new_port_name);
         port_->setParent(new_port_thread);
 
         connect(new_port_thread, &port_read_thread::read_message, port_, &Generic_Port::read_message, Qt::DirectConnection);
-        connect(new_port_thread, &port_read_thread::message_received, mavlink_manager_, &mavlink_manager::update);
+        // straight into the manager's ingest ring, no event per message
+        connect(new_port_thread, &port_read_thread::message_received, mavlink_manager_, &mavlink_manager::update, Qt::DirectConnection);
 
         QThread::sleep(std::chrono::nanoseconds{static_cast<uint64_t>(1.0E9*0.1)});
         if (!new_port_thread->isRunning())
@@ -587,6 +593,12 @@ QString connection_manager::get_port_settings_QString(QString port_name_)
         }
         else out += " NONE";
         out += "\n";
+
+        if (heartbeat_emited[index] && systhread_ != NULL)
+        {
+            out += "\nHeartbeat Timing:\n";
+            out += systhread_->get_stats().get_QString();
+        }
         mutex->unlock();
         return out;
     }
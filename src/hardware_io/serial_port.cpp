@@ -39,6 +39,7 @@
 #include <QErrorMessage>
 #include "hardware_io/serial_port.h"
 #include "logging/log_manager.h"
+#include "time_base.h"
 
 
 //#define DEBUG
@@ -103,9 +104,12 @@ bool Serial_Port::toggle_heartbeat_emited(bool val)
 // ------------------------------------------------------------------------------
 void Serial_Port::read_port(void)
 {
+    // stamp at readyRead, before any buffering or parsing delay
+    const qint64 rx_ns = time_base::now_ns();
     mutex->lock();
     QByteArray new_data = Port->readAll();
     bytearray.append(new_data);
+    stamp_rx_bytes(bytearray.size(), rx_ns);
     mutex->unlock();
 
     emit ready_to_forward_new_data(new_data);
@@ -113,10 +117,11 @@ void Serial_Port::read_port(void)
 // ------------------------------------------------------------------------------
 //   Read from Internal Buffer and Parse MAVLINK message
 // ------------------------------------------------------------------------------
-bool Serial_Port::read_message(void* message, int mavlink_channel_)
+bool Serial_Port::read_message(void* message, int mavlink_channel_, qint64* rx_time_ns)
 {
     bool msgReceived = false;
     mavlink_status_t status{};
+    qint64 rx_ns = 0;
 
     mutex->lock();
     if (bytearray.size() > 0)
@@ -131,8 +136,16 @@ bool Serial_Port::read_message(void* message, int mavlink_channel_)
             msgReceived = static_cast<bool>(mavlink_parse_char(static_cast<mavlink_channel_t>(mavlink_channel_), static_cast<uint8_t>(bytearray[i]), static_cast<mavlink_message_t*>(message), &status));
             if (msgReceived) break;
         }
-        if (msgReceived) bytearray.remove(0, i + 1);
-        else bytearray.clear();
+        if (msgReceived)
+        {
+            bytearray.remove(0, i + 1);
+            rx_ns = consume_rx_bytes(i + 1);
+        }
+        else
+        {
+            bytearray.clear();
+            clear_rx_stamps();
+        }
     }
     lastStatus = status;
     mutex->unlock();
@@ -144,7 +157,9 @@ bool Serial_Port::read_message(void* message, int mavlink_channel_)
 
     if (msgReceived)
     {
-        log_manager::instance().log_incoming_message(logical_name(), *static_cast<mavlink_message_t*>(message));
+        if (rx_ns == 0) rx_ns = time_base::now_ns();
+        if (rx_time_ns) *rx_time_ns = rx_ns;
+        log_manager::instance().log_incoming_message(logical_name(), *static_cast<mavlink_message_t*>(message), rx_ns);
     }
 
     // Done!
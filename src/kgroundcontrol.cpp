@@ -64,6 +64,10 @@
 #include <QPushButton>
 #include <QProgressBar>
 #include <QFileDialog>
+#include <QComboBox>
+#include <QSpinBox>
+#include <QDoubleSpinBox>
+#include <QPlainTextEdit>
 
 // Ensure APP_VERSION is available for update checks
 #ifndef APP_VERSION
@@ -87,6 +91,7 @@ KGroundControl::KGroundControl(QWidget *parent)
     // Apply plotting buffer duration globally
     PlotSignalRegistry::instance().setBufferDurationSec(settings.plot_buffer_duration_sec);
     log_manager::instance().apply_settings(settings);
+    realtime::configure(settings);
     ui->stackedWidget_main->setCurrentIndex(0);
 
     // Apply loaded font settings
@@ -104,8 +109,47 @@ KGroundControl::KGroundControl(QWidget *parent)
 
     settings_mutex_ = new QMutex;
     mavlink_manager_ = new mavlink_manager(this);
+    mavlink_manager_->update_kgroundcontrol_settings(&settings);
+    connect(this, &KGroundControl::settings_updated, mavlink_manager_, &mavlink_manager::update_kgroundcontrol_settings, Qt::DirectConnection);
     connection_manager_ = new connection_manager(this);
 
+    generic_thread_settings parameter_settings_;
+    parameter_settings_.update_rate_hz = 100; // bounds the turnaround of pipelined requests
+    parameter_manager_ = new parameter_manager(this, &parameter_settings_, mavlink_manager_);
+    parameter_manager_->update_kgroundcontrol_settings(&settings);
+    connect(this, &KGroundControl::settings_updated, parameter_manager_, &parameter_manager::update_kgroundcontrol_settings, Qt::DirectConnection);
+    connect(parameter_manager_, &parameter_manager::write_message, connection_manager_, &connection_manager::write_mavlink_msg_2port, Qt::DirectConnection);
+
+    generic_thread_settings ftp_settings_;
+    ftp_settings_.update_rate_hz = 100; // bounds the turnaround of gap reads and burst restarts
+    ftp_client_ = new ftp_client(this, &ftp_settings_, mavlink_manager_);
+    ftp_client_->update_kgroundcontrol_settings(&settings);
+    connect(this, &KGroundControl::settings_updated, ftp_client_, &ftp_client::update_kgroundcontrol_settings, Qt::DirectConnection);
+    connect(ftp_client_, &ftp_client::write_message, connection_manager_, &connection_manager::write_mavlink_msg_2port, Qt::DirectConnection);
+
+    generic_thread_settings command_settings_;
+    command_settings_.update_rate_hz = 100; // resolution of ACK timeouts and RTT bookkeeping
+    command_manager_ = new command_manager(this, &command_settings_, mavlink_manager_);
+    command_manager_->update_kgroundcontrol_settings(&settings);
+    connect(this, &KGroundControl::settings_updated, command_manager_, &command_manager::update_kgroundcontrol_settings, Qt::DirectConnection);
+    connect(command_manager_, &command_manager::write_message, connection_manager_, &connection_manager::write_mavlink_msg_2port, Qt::DirectConnection);
+
+    generic_thread_settings timesync_settings_;
+    timesync_settings_.update_rate_hz = 100; // bounds the hold time of answers to vehicle requests
+    timesync_manager_ = new timesync_manager(this, &timesync_settings_, mavlink_manager_);
+    timesync_manager_->update_kgroundcontrol_settings(&settings);
+    connect(this, &KGroundControl::settings_updated, timesync_manager_, &timesync_manager::update_kgroundcontrol_settings, Qt::DirectConnection);
+    connect(timesync_manager_, &timesync_manager::get_port_names, connection_manager_, &connection_manager::get_names, Qt::DirectConnection);
+    connect(timesync_manager_, &timesync_manager::write_message, connection_manager_, &connection_manager::write_mavlink_msg_2port, Qt::DirectConnection);
+
+    generic_thread_settings stream_rate_settings_;
+    stream_rate_settings_.update_rate_hz = 10;
+    stream_rate_manager_ = new stream_rate_manager(this, &stream_rate_settings_, mavlink_manager_, command_manager_, timesync_manager_);
+    stream_rate_manager_->update_kgroundcontrol_settings(&settings);
+    connect(this, &KGroundControl::settings_updated, stream_rate_manager_, &stream_rate_manager::update_kgroundcontrol_settings, Qt::DirectConnection);
+    connect(stream_rate_manager_, &stream_rate_manager::get_routing, connection_manager_, &connection_manager::get_routing, Qt::DirectConnection);
+    connect(command_manager_, &command_manager::command_finished, stream_rate_manager_, &stream_rate_manager::command_finished, Qt::DirectConnection);
+
     // Create the QJoysticks singleton on the MAIN thread so that:
     //  • SDL_Init is called from the UI thread (required on some platforms)
     //  • direct method calls like joysticks->count() / joystickExists() from
@@ -120,6 +164,7 @@ KGroundControl::KGroundControl(QWidget *parent)
     // Provide the connection manager so the backend can wire relay thread
     // write_to_port signals directly to Generic_Port objects as ports appear.
     remote_control_manager_->setConnectionManager(connection_manager_);
+    remote_control_manager_->setCommandManager(command_manager_);
 
     // Seed KGC system ID into remote control manager (and update it whenever settings change).
     // connect(remote_control_manager_, &remote_control::manager::get_kgroundcontrol_settings, this, &KGroundControl::get_settings);
@@ -430,6 +475,9 @@ void KGroundControl::load_settings(void)
         log_directory_display_->setText(log_dir);
         log_directory_display_->setToolTip(log_dir);
     }
+    if (mavlink_history_spin_) mavlink_history_spin_->setValue(settings.mavlink_history_duration_sec);
+    if (stream_rate_auto_checkbox_) stream_rate_auto_checkbox_->setChecked(settings.stream_rate_auto);
+    if (stream_budget_spin_) stream_budget_spin_->setValue(settings.stream_budget_bytes_per_s);
 #ifdef Q_OS_LINUX
     ui->chk_auto_install->setChecked(settings.auto_install_on_startup);
 #else
@@ -532,6 +580,28 @@ void KGroundControl::closeEvent(QCloseEvent *event)
         mocap_manager_ = nullptr;
     }
 
+    // stop parameter, file transfer, command and timesync traffic before the ports go away
+    if (stream_rate_manager_) {
+        delete stream_rate_manager_;
+        stream_rate_manager_ = nullptr;
+    }
+    if (parameter_manager_) {
+        delete parameter_manager_;
+        parameter_manager_ = nullptr;
+    }
+    if (ftp_client_) {
+        delete ftp_client_;
+        ftp_client_ = nullptr;
+    }
+    if (command_manager_) {
+        delete command_manager_;
+        command_manager_ = nullptr;
+    }
+    if (timesync_manager_) {
+        delete timesync_manager_;
+        timesync_manager_ = nullptr;
+    }
+
     //close all other active ports:
     connection_manager_->remove_all(false);
     log_manager::instance().shutdown();
@@ -745,14 +815,35 @@ void KGroundControl::on_btn_mavlink_inspector_clicked()
     connect(this, &KGroundControl::about2close, mavlink_inpector_, &MavlinkInspector::close, Qt::DirectConnection);
     mavlink_inpector_->show();
 
+    settings_mutex_->lock();
+    mavlink_inpector_->update_kgroundcontrol_settings(&settings);
+    settings_mutex_->unlock();
+    connect(this, &KGroundControl::settings_updated, mavlink_inpector_, &MavlinkInspector::update_kgroundcontrol_settings, Qt::DirectConnection);
+
     connect(mavlink_manager_, &mavlink_manager::updated, mavlink_inpector_, &MavlinkInspector::process_new_msg, Qt::DirectConnection);
     //connect(mavlink_manager_, &mavlink_manager::updated, mavlink_inpector_, &MavlinkInspector::create_new_slot_btn_display, Qt::QueuedConnection);
     connect(mavlink_manager_, &mavlink_manager::write_message, connection_manager_, &connection_manager::write_mavlink_msg_2port, Qt::DirectConnection);
 
     connect(mavlink_inpector_, &MavlinkInspector::request_get_msg, mavlink_manager_, &mavlink_manager::get_msg, Qt::DirectConnection);
+    connect(mavlink_inpector_, &MavlinkInspector::request_get_msg_at, mavlink_manager_, &mavlink_manager::get_msg_at, Qt::DirectConnection);
+    connect(mavlink_inpector_, &MavlinkInspector::request_vehicle_state, mavlink_manager_, &mavlink_manager::get_vehicle_state, Qt::DirectConnection);
     connect(mavlink_inpector_, &MavlinkInspector::clear_mav_manager, mavlink_manager_, &mavlink_manager::clear);
     connect(mavlink_inpector_, &MavlinkInspector::get_port_names, connection_manager_, &connection_manager::get_names, Qt::DirectConnection);
-    connect(mavlink_inpector_, &MavlinkInspector::toggle_arm_state, mavlink_manager_, &mavlink_manager::toggle_arm_state);
+    connect(mavlink_inpector_, &MavlinkInspector::toggle_arm_state, command_manager_, &command_manager::toggle_arm_state, Qt::DirectConnection);
+    connect(command_manager_, &command_manager::command_finished, mavlink_inpector_, &MavlinkInspector::update_command_result, Qt::QueuedConnection);
+    connect(mavlink_inpector_, &MavlinkInspector::stream_demand_changed, stream_rate_manager_, &stream_rate_manager::set_viewer_demand, Qt::DirectConnection);
+    connect(mavlink_inpector_, &MavlinkInspector::parameter_editor_requested, this, [this](QString port_name, uint8_t sysid, uint8_t compid) {
+        parameter_editor* editor_ = new parameter_editor(nullptr, parameter_manager_, port_name, sysid, compid);
+        editor_->setAttribute(Qt::WidgetAttribute::WA_DeleteOnClose, true);
+        connect(this, &KGroundControl::about2close, editor_, &parameter_editor::close, Qt::DirectConnection);
+        editor_->show();
+    });
+    connect(mavlink_inpector_, &MavlinkInspector::ftp_browser_requested, this, [this](QString port_name, uint8_t sysid, uint8_t compid) {
+        ftp_browser* browser_ = new ftp_browser(nullptr, ftp_client_, port_name, sysid, compid);
+        browser_->setAttribute(Qt::WidgetAttribute::WA_DeleteOnClose, true);
+        connect(this, &KGroundControl::about2close, browser_, &ftp_browser::close, Qt::DirectConnection);
+        browser_->show();
+    });
     //connect(mavlink_inpector_, &MavlinkInspector::get_heartbeat, mavlink_manager_, &mavlink_manager::get_heartbeat, Qt::DirectConnection);
 
     //connect(connection_manager_, &connection_manager::port_names_updated, mavlink_inpector_, &MavlinkInspector::on_btn_refresh_port_names_clicked, Qt::QueuedConnection);
@@ -781,6 +872,21 @@ void KGroundControl::on_btn_settings_confirm_clicked()
         settings.mavlink_logging_enabled = logging_enable_checkbox_->isChecked();
     if (log_directory_display_)
         settings.mavlink_logging_directory = log_directory_display_->text().trimmed();
+    if (mavlink_history_spin_)
+        settings.mavlink_history_duration_sec = mavlink_history_spin_->value();
+    if (stream_rate_auto_checkbox_)
+        settings.stream_rate_auto = stream_rate_auto_checkbox_->isChecked();
+    if (stream_budget_spin_)
+        settings.stream_budget_bytes_per_s = stream_budget_spin_->value();
+    for (int i = 0; i < realtime_settings::THREAD_CLASS_COUNT; i++)
+    {
+        if (!realtime_policy_cmbx_[i]) continue;
+        settings.realtime[i].policy = realtime_policy_cmbx_[i]->currentIndex();
+        settings.realtime[i].priority = realtime_priority_spin_[i]->value();
+        settings.realtime[i].cpu_mask = realtime_settings::cpu_mask_from_QString(realtime_cpus_txt_[i]->text());
+    }
+    if (realtime_lock_memory_checkbox_)
+        settings.realtime_lock_memory = realtime_lock_memory_checkbox_->isChecked();
     settings_mutex_->unlock();
 
     // Persist immediately so settings survive even if the app exits unexpectedly.
@@ -791,6 +897,7 @@ void KGroundControl::on_btn_settings_confirm_clicked()
     }
 
     log_manager::instance().apply_settings(settings);
+    realtime::configure(settings);
     emit settings_updated(&settings);
 
     // Apply font live
@@ -848,6 +955,7 @@ void KGroundControl::on_btn_settings_reset_now_clicked()
     settings = kgroundcontrol_settings{};
     settings.mavlink_logging_directory = log_manager::default_log_directory();
     log_manager::instance().apply_settings(settings);
+    realtime::configure(settings);
     emit settings_updated(&settings);
 
     // Apply font and buffer defaults
@@ -876,10 +984,14 @@ void KGroundControl::on_btn_settings_reset_now_clicked()
         log_directory_display_->setText(settings.mavlink_logging_directory);
         log_directory_display_->setToolTip(settings.mavlink_logging_directory);
     }
+    if (mavlink_history_spin_) mavlink_history_spin_->setValue(settings.mavlink_history_duration_sec);
+    if (stream_rate_auto_checkbox_) stream_rate_auto_checkbox_->setChecked(settings.stream_rate_auto);
+    if (stream_budget_spin_) stream_budget_spin_->setValue(settings.stream_budget_bytes_per_s);
     ui->chk_auto_update->setChecked(settings.check_updates_on_startup);
 #ifdef Q_OS_LINUX
     ui->chk_auto_install->setChecked(settings.auto_install_on_startup);
 #endif
+    sync_realtime_widgets();
 
     QMessageBox::information(this, "Reset Complete", "All settings cleared. Defaults are now active.");
 }
@@ -921,7 +1033,20 @@ void KGroundControl::on_btn_settings_clicked()
         log_directory_display_->setText(log_dir);
         log_directory_display_->setToolTip(log_dir);
     }
+    sync_realtime_widgets();
+}
 
+void KGroundControl::sync_realtime_widgets(void)
+{
+    for (int i = 0; i < realtime_settings::THREAD_CLASS_COUNT; i++)
+    {
+        if (!realtime_policy_cmbx_[i]) continue;
+        realtime_policy_cmbx_[i]->setCurrentIndex(settings.realtime[i].policy);
+        realtime_priority_spin_[i]->setValue(settings.realtime[i].priority);
+        realtime_cpus_txt_[i]->setText(realtime_settings::cpu_mask_to_QString(settings.realtime[i].cpu_mask));
+    }
+    if (realtime_lock_memory_checkbox_) realtime_lock_memory_checkbox_->setChecked(settings.realtime_lock_memory);
+    if (realtime_report_txt_) realtime_report_txt_->setPlainText(realtime::get_report_QString());
 }
 
 
@@ -1078,11 +1203,75 @@ void KGroundControl::setupSettingsGroups()
     commLayout->addWidget(ui->txt_sysid, 0, 1);
     commLayout->addWidget(compidLabel, 1, 0);
     commLayout->addWidget(ui->cmbx_compid, 1, 1);
+    mavlink_history_spin_ = new QDoubleSpinBox(this);
+    mavlink_history_spin_->setRange(0.0, 600.0);
+    mavlink_history_spin_->setDecimals(0);
+    mavlink_history_spin_->setSuffix(" s");
+    mavlink_history_spin_->setSpecialValueText("Off");
+    mavlink_history_spin_->setToolTip("Per-message history kept for inspector scrub-back and plotting fields tagged later");
+    commLayout->addWidget(new QLabel("Message History:"), 2, 0);
+    commLayout->addWidget(mavlink_history_spin_, 2, 1);
+    stream_rate_auto_checkbox_ = new QCheckBox("Negotiate stream rates", this);
+    stream_rate_auto_checkbox_->setToolTip("Raise vehicle streams that are plotted or inspected and lower the rest (MAV_CMD_SET_MESSAGE_INTERVAL)");
+    commLayout->addWidget(stream_rate_auto_checkbox_, 3, 0, 1, 2);
+    stream_budget_spin_ = new QSpinBox(this);
+    stream_budget_spin_->setRange(0, 10000000);
+    stream_budget_spin_->setSingleStep(500);
+    stream_budget_spin_->setSuffix(" B/s");
+    stream_budget_spin_->setSpecialValueText("Unlimited");
+    stream_budget_spin_->setToolTip("Telemetry bandwidth allowed per link when negotiating stream rates");
+    commLayout->addWidget(new QLabel("Link Budget:"), 4, 0);
+    commLayout->addWidget(stream_budget_spin_, 4, 1);
     commLayout->setColumnStretch(0, 0);
     commLayout->setColumnStretch(1, 1);
     ui->group_communication->setTitle("Communication");
     ui->group_communication->setContentLayout(commLayout);
     ui->group_communication->setCollapsed(true);  // Start collapsed
+
+    // Create layout for Real-Time group (opt-in scheduling per thread class)
+    QGridLayout* realtimeLayout = new QGridLayout();
+    realtimeLayout->addWidget(new QLabel("Thread Class"), 0, 0);
+    realtimeLayout->addWidget(new QLabel("Policy"), 0, 1);
+    realtimeLayout->addWidget(new QLabel("Priority"), 0, 2);
+    realtimeLayout->addWidget(new QLabel("CPUs"), 0, 3);
+    for (int i = 0; i < realtime_settings::THREAD_CLASS_COUNT; i++)
+    {
+        realtime_policy_cmbx_[i] = new QComboBox(this);
+        realtime_policy_cmbx_[i]->addItems({realtime_settings::policy_name(realtime_settings::OFF),
+                                            realtime_settings::policy_name(realtime_settings::FIFO),
+                                            realtime_settings::policy_name(realtime_settings::RR)});
+        realtime_priority_spin_[i] = new QSpinBox(this);
+        realtime_priority_spin_[i]->setRange(1, 99);
+        realtime_cpus_txt_[i] = new QLineEdit(this);
+        realtime_cpus_txt_[i]->setPlaceholderText("any (e.g. 2,3 or 0-3)");
+
+        realtimeLayout->addWidget(new QLabel(realtime_settings::thread_class_name(i)), i + 1, 0);
+        realtimeLayout->addWidget(realtime_policy_cmbx_[i], i + 1, 1);
+        realtimeLayout->addWidget(realtime_priority_spin_[i], i + 1, 2);
+        realtimeLayout->addWidget(realtime_cpus_txt_[i], i + 1, 3);
+    }
+    realtime_lock_memory_checkbox_ = new QCheckBox("Lock process memory (mlockall)", this);
+    realtimeLayout->addWidget(realtime_lock_memory_checkbox_, realtime_settings::THREAD_CLASS_COUNT + 1, 0, 1, 4);
+
+    realtime_report_txt_ = new QPlainTextEdit(this);
+    realtime_report_txt_->setReadOnly(true);
+    realtime_report_txt_->setMinimumHeight(120);
+    QPushButton* realtime_refresh_button = new QPushButton("Refresh Latency", this);
+    realtime_refresh_button->setMinimumWidth(150);
+    realtimeLayout->addWidget(realtime_report_txt_, realtime_settings::THREAD_CLASS_COUNT + 2, 0, 1, 4);
+    realtimeLayout->addWidget(realtime_refresh_button, realtime_settings::THREAD_CLASS_COUNT + 3, 3);
+    realtimeLayout->setColumnStretch(0, 0);
+    realtimeLayout->setColumnStretch(3, 1);
+    ui->group_realtime->setTitle("Real-Time");
+    ui->group_realtime->setContentLayout(realtimeLayout);
+    ui->group_realtime->setCollapsed(true);  // Start collapsed
+#ifndef Q_OS_LINUX
+    ui->group_realtime->setVisible(false);
+#endif
+
+    connect(realtime_refresh_button, &QPushButton::clicked, this, [this]() {
+        if (realtime_report_txt_) realtime_report_txt_->setPlainText(realtime::get_report_QString());
+    });
     
     // Show all widgets now that they're in groups (except progress widget which stays hidden)
     ui->txt_sysid->setVisible(true);
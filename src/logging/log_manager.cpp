@@ -1,4 +1,5 @@
 #include "logging/log_manager.h"
+#include "time_base.h"
 
 #include <QDataStream>
 #include <QDateTime>
@@ -15,6 +16,7 @@
 #include <memory>
 #include <utility>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <ulog_cpp/writer.hpp>
 
@@ -213,6 +215,7 @@ public:
         });
 
         topic_to_msg_id_.clear();
+        mavlink_to_topic_id_.clear();
 
         writer_->fileHeader(ulog_cpp::FileHeader(current_timestamp_us()));
 
@@ -239,6 +242,7 @@ public:
         }
         writer_.reset();
         topic_to_msg_id_.clear();
+        mavlink_to_topic_id_.clear();
     }
 
     bool write_record(const log_manager::packet_record& rec)
@@ -247,13 +251,8 @@ public:
             return false;
         }
 
-        const QString topic_name = rec.topic_name.trimmed();
-        if (topic_name.isEmpty()) {
-            return true;
-        }
-
-        const auto it = topic_to_msg_id_.find(topic_name);
-        if (it == topic_to_msg_id_.end()) {
+        const auto it = mavlink_to_topic_id_.find(rec.message.msgid);
+        if (it == mavlink_to_topic_id_.end()) {
             return true;
         }
 
@@ -272,9 +271,10 @@ public:
     }
 
 private:
+    // Same monotonic base as the records, so header and data timestamps line up
     static uint64_t current_timestamp_us()
     {
-        return static_cast<uint64_t>(QDateTime::currentDateTimeUtc().toMSecsSinceEpoch()) * 1000ULL;
+        return static_cast<uint64_t>(time_base::now_us());
     }
 
     bool write_known_topics()
@@ -292,6 +292,7 @@ private:
 
             const quint16 assigned = static_cast<quint16>(topic_to_msg_id_.size());
             topic_to_msg_id_.emplace(topic_name, assigned);
+            mavlink_to_topic_id_.emplace(info->msgid, assigned);
 
             if (!write_topic_format(topic_name, info)) {
                 return false;
@@ -403,6 +404,7 @@ private:
 
     QFile file_;
     std::map<QString, quint16> topic_to_msg_id_;
+    std::unordered_map<uint32_t, quint16> mavlink_to_topic_id_; // per-record lookup, no name strings
     std::unique_ptr<ulog_cpp::Writer> writer_;
 };
 
@@ -502,42 +504,33 @@ void log_manager::apply_settings(const kgroundcontrol_settings& settings)
     state_cv_.notify_one();
 }
 
-log_manager::packet_record log_manager::make_record(io_direction dir, const QString& port_name, const mavlink_message_t& message)
-{
-    packet_record rec;
-    rec.timestamp_us = static_cast<uint64_t>(QDateTime::currentDateTimeUtc().toMSecsSinceEpoch()) * 1000ULL;
-    rec.message = message;
-    rec.direction_value = static_cast<uint8_t>(dir);
-    rec.port_name = port_name;
-
-    if (const mavlink_message_info_t* info = mavlink_get_message_info(&rec.message)) {
-        if (info->name != nullptr) {
-            rec.topic_name = QString::fromLatin1(info->name);
-        }
-    }
-
-    return rec;
-}
-
-void log_manager::enqueue_record(packet_record&& record)
+void log_manager::enqueue_record(io_direction dir, const QString& port_name, const mavlink_message_t& message, qint64 t_ns)
 {
     {
         std::lock_guard<std::mutex> lock(state_mutex_);
-        queue_.push_back(std::move(record));
+        auto port_it = port_ids_.constFind(port_name);
+        if (port_it == port_ids_.constEnd()) {
+            port_it = port_ids_.insert(port_name, static_cast<quint16>(port_names_.size()));
+            port_names_.push_back(port_name);
+        }
+        queue_.timestamp_us.push_back(static_cast<uint64_t>(time_base::ns_to_us(t_ns)));
+        queue_.direction_value.push_back(static_cast<uint8_t>(dir));
+        queue_.port_id.push_back(port_it.value());
+        queue_.messages.append(message);
     }
     state_cv_.notify_one();
 }
 
-void log_manager::log_incoming_message(const QString& port_name, const mavlink_message_t& message)
+void log_manager::log_incoming_message(const QString& port_name, const mavlink_message_t& message, qint64 rx_time_ns)
 {
     if (!enabled_fast_.load(std::memory_order_acquire)) return;
-    enqueue_record(make_record(io_direction::incoming, port_name, message));
+    enqueue_record(io_direction::incoming, port_name, message, rx_time_ns);
 }
 
 void log_manager::log_outgoing_message(const QString& port_name, const mavlink_message_t& message)
 {
     if (!enabled_fast_.load(std::memory_order_acquire)) return;
-    enqueue_record(make_record(io_direction::outgoing, port_name, message));
+    enqueue_record(io_direction::outgoing, port_name, message, time_base::now_ns());
 }
 
 void log_manager::log_outgoing_bytes(const QString& port_name, const QByteArray& bytes)
@@ -582,12 +575,21 @@ void log_manager::writer_loop()
         writers.clear();
     };
 
-    auto write_record = [&writers, &session_name, &session_dir](const packet_record& rec) -> bool {
-        const QString stream_key = rec.port_name + QLatin1Char('|') + direction_label(rec.direction_value);
+    // (port_id, direction) -> stream writer; the key is built without touching strings
+    std::map<quint32, ulog_stream_writer*> writer_by_stream;
+
+    auto write_record = [&writers, &writer_by_stream, &session_name, &session_dir](const packet_record& rec, quint16 port_id, const QString& port_name) -> bool {
+        const quint32 stream_id = (static_cast<quint32>(port_id) << 8) | rec.direction_value;
+        auto cached = writer_by_stream.find(stream_id);
+        if (cached != writer_by_stream.end() && cached->second->is_open()) {
+            return cached->second->write_record(rec);
+        }
+
+        const QString stream_key = port_name + QLatin1Char('|') + direction_label(rec.direction_value);
         auto it = writers.find(stream_key);
         if (it == writers.end()) {
             std::unique_ptr<ulog_stream_writer> new_writer = std::make_unique<ulog_stream_writer>();
-            const QString stream_file_name = build_stream_file_name(rec.port_name, rec.direction_value, session_name);
+            const QString stream_file_name = build_stream_file_name(port_name, rec.direction_value, session_name);
             const QString stream_file_path = QDir(session_dir).filePath(stream_file_name);
             if (!new_writer->open(stream_file_path)) {
                 return false;
@@ -600,12 +602,14 @@ void log_manager::writer_loop()
         if (!writer || !writer->is_open()) {
             return false;
         }
+        writer_by_stream[stream_id] = writer;
 
         return writer->write_record(rec);
     };
 
     while (true) {
-        std::deque<packet_record> local_queue;
+        record_batch local_queue;
+        QVector<QString> local_port_names;
         bool local_stop = false;
         bool local_enabled = false;
         bool local_rotate = false;
@@ -623,7 +627,8 @@ void log_manager::writer_loop()
 
         rotate_requested_ = false;
         config_dirty_ = false;
-        queue_.swap(local_queue);
+        std::swap(queue_, local_queue);
+        local_port_names = port_names_;
 
         lock.unlock();
         if (local_stop && local_queue.empty()) {
@@ -633,6 +638,7 @@ void log_manager::writer_loop()
         if (!local_enabled) {
             if (!writers.empty()) {
                 close_all_writers();
+                writer_by_stream.clear();
                 session_name.clear();
                 session_dir.clear();
             }
@@ -641,6 +647,7 @@ void log_manager::writer_loop()
 
         if (local_rotate || session_dir.isEmpty()) {
             close_all_writers();
+            writer_by_stream.clear();
             session_name = build_unique_session_name(local_directory);
             session_dir = QDir(local_directory).filePath(session_name);
             if (!QDir().mkpath(session_dir)) {
@@ -650,9 +657,15 @@ void log_manager::writer_loop()
             }
         }
 
-        for (const auto& rec : local_queue) {
-            if (!write_record(rec)) {
+        packet_record rec;
+        for (int i = 0; i < local_queue.messages.size(); ++i) {
+            rec.timestamp_us = local_queue.timestamp_us[i];
+            rec.direction_value = local_queue.direction_value[i];
+            local_queue.messages.get(i, rec.message);
+            const quint16 port_id = local_queue.port_id[i];
+            if (!write_record(rec, port_id, local_port_names[port_id])) {
                 close_all_writers();
+                writer_by_stream.clear();
                 session_name.clear();
                 session_dir.clear();
                 break;
@@ -0,0 +1,287 @@
+/****************************************************************************
+ *
+ *    Copyright (C) 2025  Yevhenii Kovryzhenko. All rights reserved.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU Affero General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License Version 3 for more details.
+ *
+ *    You should have received a copy of the
+ *    GNU Affero General Public License Version 3
+ *    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions, and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions, and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *    3. No ownership or credit shall be claimed by anyone not mentioned in
+ *       the above copyright statement.
+ *    4. Any redistribution or public use of this software, in whole or in part,
+ *       whether standalone or as part of a different project, must remain
+ *       under the terms of the GNU Affero General Public License Version 3,
+ *       and all distributions in binary form must be accompanied by a copy of
+ *       the source code, as stated in the GNU Affero General Public License.
+ *
+ ****************************************************************************/
+
+#include "mavlink_communication/command_manager.h"
+#include "time_base.h"
+
+#include <algorithm>
+
+qint64 command_rtt_stats::bucket_upper_ns(int bucket)
+{
+    static const qint64 upper_ms[BUCKET_COUNT - 1] = {5, 10, 20, 50, 100, 200, 500, 1000, 2000};
+    if (bucket < 0 || bucket >= BUCKET_COUNT - 1) return INT64_MAX;
+    return upper_ms[bucket] * 1000000LL;
+}
+
+void command_rtt_stats::record(qint64 rtt_ns)
+{
+    int bucket = 0;
+    while (bucket < BUCKET_COUNT - 1 && rtt_ns > bucket_upper_ns(bucket)) bucket++;
+    counts[bucket]++;
+    if (samples == 0 || rtt_ns < min_ns) min_ns = rtt_ns;
+    if (rtt_ns > max_ns) max_ns = rtt_ns;
+    samples++;
+    mean_ns += (static_cast<double>(rtt_ns) - mean_ns) / static_cast<double>(samples);
+}
+
+QString command_rtt_stats::get_QString(void) const
+{
+    QString txt = QString("%1 sent, %2 accepted, %3 rejected, %4 timed out, %5 retries")
+                      .arg(sent).arg(accepted).arg(rejected).arg(timeouts).arg(retries);
+    if (samples == 0) return txt;
+    txt += QString("\n  RTT ms: min %1, mean %2, max %3 |")
+               .arg(static_cast<double>(min_ns) * 1.0E-6, 0, 'f', 1)
+               .arg(mean_ns * 1.0E-6, 0, 'f', 1)
+               .arg(static_cast<double>(max_ns) * 1.0E-6, 0, 'f', 1);
+    for (int i = 0; i < BUCKET_COUNT; i++)
+    {
+        if (counts[i] == 0) continue;
+        if (i < BUCKET_COUNT - 1) txt += QString(" <=%1:%2").arg(bucket_upper_ns(i) / 1000000).arg(counts[i]);
+        else txt += QString(" >%1:%2").arg(bucket_upper_ns(i - 1) / 1000000).arg(counts[i]);
+    }
+    return txt;
+}
+
+
+
+command_manager::command_manager(QObject* parent, generic_thread_settings* settings_in_, mavlink_manager* mavlink_manager_in_)
+    : periodic_task(parent, settings_in_), mavlink_manager_(mavlink_manager_in_)
+{
+    setObjectName("command_manager");
+    mavlink_manager_->subscribe(MAVLINK_MSG_ID_COMMAND_ACK, this);
+    start(generic_thread_settings_.priority);
+}
+
+command_manager::~command_manager()
+{
+    if (!mavlink_manager_.isNull()) mavlink_manager_->unsubscribe(this);
+    periodic_scheduler::instance().remove_and_wait(this);
+}
+
+QString command_manager::result_QString(int result)
+{
+    switch (result)
+    {
+    case MAV_RESULT_ACCEPTED:             return "ACCEPTED";
+    case MAV_RESULT_TEMPORARILY_REJECTED: return "TEMPORARILY REJECTED";
+    case MAV_RESULT_DENIED:               return "DENIED";
+    case MAV_RESULT_UNSUPPORTED:          return "UNSUPPORTED";
+    case MAV_RESULT_FAILED:               return "FAILED";
+    case MAV_RESULT_IN_PROGRESS:          return "IN PROGRESS";
+    case MAV_RESULT_CANCELLED:            return "CANCELLED";
+    case RESULT_TIMEOUT:                  return "NO ACK";
+    case RESULT_SUPERSEDED:               return "SUPERSEDED";
+    case RESULT_SEND_FAILED:              return "SEND FAILED";
+    default:                              return QString("RESULT %1").arg(result);
+    }
+}
+
+void command_manager::on_message(const mavlink_message_t& msg, qint64 t_ns)
+{
+    const bool res = inbox_.push_with([&msg, t_ns](inbox_entry& entry)
+    {
+        entry.t_ns = t_ns;
+        entry.sysid = msg.sysid;
+        entry.compid = msg.compid;
+        mavlink_msg_command_ack_decode(&msg, &entry.ack);
+    });
+    if (!res) inbox_dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+quint64 command_manager::send_command(QString port_name, uint8_t sysid, uint8_t compid, uint16_t command, QVector<float> params)
+{
+    mavlink_message_t message;
+    transaction t;
+    t.port_name = port_name;
+    t.sysid = sysid;
+    t.compid = compid;
+    t.command = command;
+    for (int i = 0; i < 7 && i < params.size(); i++) t.params[i] = params[i];
+    t.attempts = 1;
+
+    mutex->lock();
+    t.id = next_id_++;
+    const quint64 key = transaction_key(sysid, compid, command);
+    auto it = in_flight_.find(key);
+    if (it != in_flight_.end()) finish(it, RESULT_SUPERSEDED, 0);
+    pack(t, message);
+    t.sent_ns = time_base::now_ns();
+    t.deadline_ns = t.sent_ns + initial_timeout_ns;
+    in_flight_.insert(key, t);
+    stats_[sysid].sent++;
+    QVector<finished_transaction> finished;
+    finished.swap(finished_);
+    mutex->unlock();
+
+    for (const finished_transaction& f : finished) emit command_finished(f.id, f.sysid, f.compid, f.command, f.result, f.rtt_ns);
+
+    if (emit write_message(port_name, &message) <= 0)
+    {
+        // unknown port: fail now instead of after all the retries
+        mutex->lock();
+        it = in_flight_.find(key);
+        if (it != in_flight_.end() && it->id == t.id) finish(it, RESULT_SEND_FAILED, 0);
+        finished.clear();
+        finished.swap(finished_);
+        mutex->unlock();
+        for (const finished_transaction& f : finished) emit command_finished(f.id, f.sysid, f.compid, f.command, f.result, f.rtt_ns);
+    }
+    return t.id;
+}
+
+bool command_manager::toggle_arm_state(QString port_name, uint8_t sys_id_, mavlink_enums::mavlink_component_id mav_component_, bool flag, bool force)
+{
+    QVector<float> params = {flag ? 1.0f : 0.0f, force ? 21196.0f : 0.0f};
+    return send_command(port_name, sys_id_, static_cast<uint8_t>(mav_component_), MAV_CMD_COMPONENT_ARM_DISARM, params) != 0;
+}
+
+int command_manager::get_in_flight_count(void)
+{
+    mutex->lock();
+    const int out = in_flight_.size();
+    mutex->unlock();
+    return out;
+}
+
+bool command_manager::get_rtt_stats(uint8_t sysid, command_rtt_stats &stats_out)
+{
+    mutex->lock();
+    auto it = stats_.constFind(sysid);
+    const bool res = it != stats_.cend();
+    if (res) stats_out = it.value();
+    mutex->unlock();
+    return res;
+}
+
+QString command_manager::get_report_QString(void)
+{
+    mutex->lock();
+    QList<uint8_t> sysids = stats_.keys();
+    std::sort(sysids.begin(), sysids.end());
+    QString txt = QString("Commands in flight: %1").arg(in_flight_.size());
+    for (const uint8_t sysid : sysids) txt += QString("\nSystem %1: %2").arg(sysid).arg(stats_.value(sysid).get_QString());
+    mutex->unlock();
+    return txt;
+}
+
+void command_manager::update_kgroundcontrol_settings(kgroundcontrol_settings* kground_control_settings_in_)
+{
+    mutex->lock();
+    kgroundcontrol_settings_ = *kground_control_settings_in_;
+    mutex->unlock();
+}
+
+void command_manager::tick()
+{
+    QVector<QPair<QString, mavlink_message_t>> outgoing;
+
+    mutex->lock();
+    inbox_entry entry;
+    while (inbox_.pop(entry))
+    {
+        const mavlink_command_ack_t& ack = entry.ack;
+        auto it = in_flight_.find(transaction_key(entry.sysid, entry.compid, ack.command));
+        if (it == in_flight_.end())
+        {
+            // broadcast targets may be acknowledged by any component of the vehicle
+            for (it = in_flight_.begin(); it != in_flight_.end(); ++it)
+            {
+                if (it->sysid == entry.sysid && it->command == ack.command) break;
+            }
+            if (it == in_flight_.end()) continue;
+        }
+
+        if (ack.result == MAV_RESULT_IN_PROGRESS)
+        {
+            it->in_progress = true;
+            it->deadline_ns = entry.t_ns + in_progress_timeout_ns;
+            continue;
+        }
+        command_rtt_stats& stats = stats_[it->sysid];
+        if (ack.result == MAV_RESULT_ACCEPTED) stats.accepted++;
+        else stats.rejected++;
+        const qint64 rtt_ns = entry.t_ns - it->sent_ns;
+        if (it->attempts == 1) stats.record(rtt_ns);
+        finish(it, ack.result, rtt_ns);
+    }
+
+    const qint64 now_ns = time_base::now_ns();
+    QVector<quint64> expired;
+    for (auto it = in_flight_.begin(); it != in_flight_.end(); ++it)
+    {
+        if (now_ns < it->deadline_ns) continue;
+        if (it->in_progress || it->attempts >= max_attempts)
+        {
+            expired.append(it.key());
+            continue;
+        }
+        it->attempts++;
+        it->confirmation++;
+        it->sent_ns = now_ns;
+        it->deadline_ns = now_ns + qMin(initial_timeout_ns << (it->attempts - 1), max_timeout_ns);
+        stats_[it->sysid].retries++;
+        QPair<QString, mavlink_message_t> out;
+        out.first = it->port_name;
+        pack(*it, out.second);
+        outgoing.append(out);
+    }
+    for (const quint64 key : expired)
+    {
+        auto it = in_flight_.find(key);
+        stats_[it->sysid].timeouts++;
+        finish(it, RESULT_TIMEOUT, 0);
+    }
+
+    QVector<finished_transaction> finished;
+    finished.swap(finished_);
+    mutex->unlock();
+
+    for (auto& out : outgoing) emit write_message(out.first, &out.second);
+    for (const finished_transaction& f : finished) emit command_finished(f.id, f.sysid, f.compid, f.command, f.result, f.rtt_ns);
+}
+
+// caller holds mutex
+void command_manager::pack(const transaction &t, mavlink_message_t &message_out)
+{
+    mavlink_msg_command_long_pack(kgroundcontrol_settings_.sysid, static_cast<uint8_t>(kgroundcontrol_settings_.compid), &message_out,
+                                  t.sysid, t.compid, t.command, t.confirmation,
+                                  t.params[0], t.params[1], t.params[2], t.params[3], t.params[4], t.params[5], t.params[6]);
+}
+
+// caller holds mutex
+void command_manager::finish(QHash<quint64, transaction>::iterator it, int result, qint64 rtt_ns)
+{
+    finished_.append({it->id, it->sysid, it->compid, it->command, result, rtt_ns});
+    in_flight_.erase(it);
+}
@@ -0,0 +1,441 @@
+/****************************************************************************
+ *
+ *    Copyright (C) 2025  Yevhenii Kovryzhenko. All rights reserved.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU Affero General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License Version 3 for more details.
+ *
+ *    You should have received a copy of the
+ *    GNU Affero General Public License Version 3
+ *    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions, and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions, and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *    3. No ownership or credit shall be claimed by anyone not mentioned in
+ *       the above copyright statement.
+ *    4. Any redistribution or public use of this software, in whole or in part,
+ *       whether standalone or as part of a different project, must remain
+ *       under the terms of the GNU Affero General Public License Version 3,
+ *       and all distributions in binary form must be accompanied by a copy of
+ *       the source code, as stated in the GNU Affero General Public License.
+ *
+ ****************************************************************************/
+
+#include <QFileDialog>
+#include <QDir>
+#include <QHeaderView>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QLocale>
+#include <algorithm>
+
+#include "mavlink_communication/ftp_client.h"
+#include "time_base.h"
+
+
+
+ftp_client::ftp_client(QObject* parent, generic_thread_settings* settings_in_, mavlink_manager* mavlink_manager_in_)
+    : periodic_task(parent, settings_in_), mavlink_manager_(mavlink_manager_in_)
+{
+    setObjectName("ftp_client");
+
+    generic_thread_settings writer_settings_;
+    writer_settings_.priority = QThread::Priority::LowPriority; // never real-time: it waits on the disk
+    writer_ = new job_thread(this, &writer_settings_, writer_capacity);
+    writer_->setObjectName("ftp_file_writer");
+    writer_->start(writer_settings_.priority);
+
+    mavlink_manager_->subscribe(MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL, this);
+    start(generic_thread_settings_.priority);
+}
+
+ftp_client::~ftp_client()
+{
+    if (!mavlink_manager_.isNull()) mavlink_manager_->unsubscribe(this);
+    periodic_scheduler::instance().remove_and_wait(this);
+    delete writer_; // runs the queued jobs first
+    qDeleteAll(links_);
+}
+
+void ftp_client::on_message(const mavlink_message_t& msg, qint64 t_ns)
+{
+    const bool res = inbox_.push_with([&msg, t_ns](inbox_entry& entry)
+    {
+        mavlink_file_transfer_protocol_t ftp;
+        mavlink_msg_file_transfer_protocol_decode(&msg, &ftp);
+        entry.t_ns = t_ns;
+        entry.sysid = msg.sysid;
+        entry.compid = msg.compid;
+        entry.target_system = ftp.target_system;
+        entry.target_component = ftp.target_component;
+        memcpy(entry.payload, ftp.payload, sizeof(entry.payload));
+    });
+    if (!res) inbox_dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool ftp_client::download(QString port_name, uint8_t sysid, uint8_t compid, QString remote_path, QString local_path)
+{
+    if (port_name.isEmpty() || remote_path.isEmpty() || local_path.isEmpty()) return false;
+    mutex->lock();
+    vehicle_link* link = get_link(sysid, compid, port_name);
+    if (link->session.is_active() || link->was_active) // was_active: the last file is still being closed
+    {
+        mutex->unlock();
+        return false;
+    }
+    std::shared_ptr<file_state> state = std::make_shared<file_state>();
+    state->path = local_path;
+    const bool queued = writer_->post([state]()
+    {
+        state->file.setFileName(state->path);
+        if (state->file.open(QIODevice::ReadWrite | QIODevice::Truncate)) return;
+        state->error = state->file.errorString();
+        state->failed.store(true, std::memory_order_release);
+    });
+    if (!queued)
+    {
+        mutex->unlock();
+        return false;
+    }
+    link->sink.writer = writer_;
+    link->sink.state = state;
+    ftp_session::payload_list payloads;
+    link->session.start_download(remote_path, &link->sink, time_base::now_ns(), payloads);
+    link->was_active = true;
+    queue(*link, payloads);
+    mutex->unlock();
+    return true;
+}
+
+bool ftp_client::list_directory(QString port_name, uint8_t sysid, uint8_t compid, QString remote_path)
+{
+    if (port_name.isEmpty() || remote_path.isEmpty()) return false;
+    mutex->lock();
+    vehicle_link* link = get_link(sysid, compid, port_name);
+    if (link->session.is_active() || link->was_active) // was_active: the last file is still being closed
+    {
+        mutex->unlock();
+        return false;
+    }
+    ftp_session::payload_list payloads;
+    link->session.start_list(remote_path, time_base::now_ns(), payloads);
+    link->was_active = true;
+    queue(*link, payloads);
+    mutex->unlock();
+    return true;
+}
+
+void ftp_client::cancel(uint8_t sysid, uint8_t compid)
+{
+    mutex->lock();
+    vehicle_link* link = links_.value(link_key(sysid, compid), nullptr);
+    if (link)
+    {
+        ftp_session::payload_list payloads;
+        link->session.cancel(time_base::now_ns(), payloads);
+        queue(*link, payloads);
+    }
+    mutex->unlock();
+}
+
+bool ftp_client::get_status(uint8_t sysid, uint8_t compid, ftp_transfer_status &status_out)
+{
+    mutex->lock();
+    const vehicle_link* link = links_.value(link_key(sysid, compid), nullptr);
+    if (link) status_out = link->session.get_status(time_base::now_ns());
+    mutex->unlock();
+    return link != nullptr;
+}
+
+bool ftp_client::get_entries(uint8_t sysid, uint8_t compid, QVector<ftp_entry> &entries_out)
+{
+    mutex->lock();
+    const vehicle_link* link = links_.value(link_key(sysid, compid), nullptr);
+    if (link) entries_out = link->session.entries();
+    mutex->unlock();
+    return link != nullptr;
+}
+
+void ftp_client::update_kgroundcontrol_settings(kgroundcontrol_settings* kground_control_settings_in_)
+{
+    mutex->lock();
+    kgroundcontrol_settings_ = *kground_control_settings_in_;
+    mutex->unlock();
+}
+
+void ftp_client::tick()
+{
+    const qint64 now_ns = time_base::now_ns();
+    QVector<QPair<quint16, QString>> finished;
+    QVector<bool> finished_ok;
+
+    mutex->lock();
+    const uint8_t own_sysid = kgroundcontrol_settings_.sysid;
+    const uint8_t own_compid = static_cast<uint8_t>(kgroundcontrol_settings_.compid);
+    ftp_session::payload_list payloads;
+    inbox_entry entry;
+    while (inbox_.pop(entry))
+    {
+        // replies addressed to another ground station sharing the link are not ours
+        if (entry.target_system != 0 && entry.target_system != own_sysid) continue;
+        if (entry.target_component != 0 && entry.target_component != own_compid) continue;
+        vehicle_link* link = links_.value(link_key(entry.sysid, entry.compid), nullptr);
+        if (link == nullptr) continue;
+        mavlink_ftp::payload reply;
+        mavlink_ftp::read_payload(entry.payload, reply);
+        payloads.clear();
+        link->session.handle(reply, entry.t_ns, payloads);
+        queue(*link, payloads);
+    }
+    for (vehicle_link* link : std::as_const(links_))
+    {
+        payloads.clear();
+        const std::shared_ptr<file_state> state = link->sink.state;
+        // the writer could not open or write the file
+        if (state && state->failed.load(std::memory_order_acquire)) link->session.fail(state->error, now_ns, payloads);
+        link->session.service(now_ns, payloads);
+        queue(*link, payloads);
+        if (!link->was_active || link->session.is_active()) continue;
+
+        const ftp_transfer_status status = link->session.get_status(now_ns);
+        if (state)
+        {
+            // report the download once the writer has closed the file
+            if (!link->closing)
+            {
+                const bool keep = status.phase == ftp_transfer_status::DONE;
+                link->closing = writer_->post([state, keep]()
+                {
+                    if (state->file.isOpen() && !state->file.flush() && !state->failed.load(std::memory_order_relaxed))
+                    {
+                        state->error = state->file.errorString();
+                        state->failed.store(true, std::memory_order_release);
+                    }
+                    state->file.close();
+                    if (!keep || state->failed.load(std::memory_order_relaxed)) state->file.remove(); // partial, preallocated
+                    state->closed.store(true, std::memory_order_release);
+                });
+            }
+            if (!state->closed.load(std::memory_order_acquire)) continue;
+        }
+        link->was_active = false;
+        link->closing = false;
+        link->sink.state.reset();
+        const bool failed = state && state->failed.load(std::memory_order_acquire);
+        finished.append(qMakePair(link_key(link->sysid, link->compid), status.error.isEmpty() && failed ? state->error : status.error));
+        finished_ok.append(status.phase == ftp_transfer_status::DONE && !failed);
+    }
+    QVector<QPair<QString, mavlink_message_t>> outgoing;
+    outgoing.swap(outgoing_);
+    mutex->unlock();
+
+    for (auto& out : outgoing) emit write_message(out.first, &out.second);
+    for (int i = 0; i < finished.size(); i++)
+    {
+        emit transfer_finished(static_cast<uint8_t>(finished[i].first >> 8), static_cast<uint8_t>(finished[i].first & 0xFF), finished_ok[i], finished[i].second);
+    }
+}
+
+// scheduler thread; every call only queues a job for the writer
+bool ftp_client::file_sink::allocate(qint64 size)
+{
+    const std::shared_ptr<file_state> state_ = state;
+    return writer->post([state_, size]()
+    {
+        if (state_->failed.load(std::memory_order_relaxed) || state_->file.resize(size)) return;
+        state_->error = state_->file.errorString();
+        state_->failed.store(true, std::memory_order_release);
+    });
+}
+
+bool ftp_client::file_sink::write(qint64 offset, const uint8_t* data, int size)
+{
+    const std::shared_ptr<file_state> state_ = state;
+    const QByteArray bytes(reinterpret_cast<const char*>(data), size);
+    return writer->post([state_, offset, bytes]()
+    {
+        if (state_->failed.load(std::memory_order_relaxed)) return;
+        if (state_->file.seek(offset) && state_->file.write(bytes) == bytes.size()) return;
+        state_->error = state_->file.errorString();
+        state_->failed.store(true, std::memory_order_release);
+    });
+}
+
+QString ftp_client::file_sink::error_QString(void) const
+{
+    return "File writer is falling behind";
+}
+
+// caller holds mutex
+ftp_client::vehicle_link* ftp_client::get_link(uint8_t sysid, uint8_t compid, const QString &port_name)
+{
+    vehicle_link*& link = links_[link_key(sysid, compid)];
+    if (link == nullptr)
+    {
+        link = new vehicle_link;
+        link->sysid = sysid;
+        link->compid = compid;
+    }
+    link->port_name = port_name;
+    return link;
+}
+
+// caller holds mutex
+void ftp_client::queue(vehicle_link &link, const ftp_session::payload_list &payloads)
+{
+    for (const mavlink_ftp::payload& request : payloads)
+    {
+        uint8_t raw[mavlink_ftp::payload_size];
+        mavlink_ftp::write_payload(request, raw);
+        QPair<QString, mavlink_message_t> out;
+        out.first = link.port_name;
+        mavlink_msg_file_transfer_protocol_pack(kgroundcontrol_settings_.sysid, static_cast<uint8_t>(kgroundcontrol_settings_.compid), &out.second, 0, link.sysid, link.compid, raw);
+        outgoing_.append(out);
+    }
+}
+
+
+
+ftp_browser::ftp_browser(QWidget *parent, ftp_client* client_in_, QString port_name_in_, uint8_t sysid_in_, uint8_t compid_in_)
+    : QWidget(parent), client_(client_in_), port_name_(port_name_in_), sysid_(sysid_in_), compid_(compid_in_)
+{
+    setWindowIcon(QIcon(":/resources/Images/Logo/KGC_Logo.png"));
+    setWindowTitle(QString("Files: System %1, Component %2 (%3)").arg(sysid_).arg(compid_).arg(port_name_));
+    resize(520, 560);
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    QHBoxLayout* path_layout = new QHBoxLayout;
+    QPushButton* btn_up = new QPushButton("Up", this);
+    path_edit_ = new QLineEdit("/", this);
+    path_edit_->setToolTip("Onboard directory, e.g. /fs/microsd/log (PX4) or /APM/LOGS (ArduPilot)");
+    QPushButton* btn_list = new QPushButton("List", this);
+    path_layout->addWidget(btn_up);
+    path_layout->addWidget(path_edit_, 1);
+    path_layout->addWidget(btn_list);
+    layout->addLayout(path_layout);
+
+    tree_ = new QTreeWidget(this);
+    tree_->setColumnCount(2);
+    tree_->setHeaderLabels({"Name", "Size"});
+    tree_->setRootIsDecorated(false);
+    tree_->setUniformRowHeights(true);
+    tree_->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    tree_->header()->setSectionResizeMode(1, QHeaderView::ResizeToContents);
+    layout->addWidget(tree_, 1);
+
+    QHBoxLayout* status_layout = new QHBoxLayout;
+    progress_ = new QProgressBar(this);
+    progress_->setRange(0, 1000);
+    progress_->setValue(0);
+    btn_download_ = new QPushButton("Download", this);
+    QPushButton* btn_cancel = new QPushButton("Cancel", this);
+    status_layout->addWidget(progress_, 1);
+    status_layout->addWidget(btn_download_);
+    status_layout->addWidget(btn_cancel);
+    layout->addLayout(status_layout);
+    status_label_ = new QLabel(this);
+    status_label_->setWordWrap(true);
+    layout->addWidget(status_label_);
+
+    connect(btn_up, &QPushButton::clicked, this, &ftp_browser::on_up_clicked);
+    connect(btn_list, &QPushButton::clicked, this, &ftp_browser::on_list_clicked);
+    connect(path_edit_, &QLineEdit::returnPressed, this, &ftp_browser::on_list_clicked);
+    connect(btn_download_, &QPushButton::clicked, this, &ftp_browser::on_download_clicked);
+    connect(btn_cancel, &QPushButton::clicked, this, [this]() { if (!client_.isNull()) client_->cancel(sysid_, compid_); });
+    connect(tree_, &QTreeWidget::itemDoubleClicked, this, &ftp_browser::on_item_double_clicked);
+
+    status_timer_ = new QTimer(this);
+    connect(status_timer_, &QTimer::timeout, this, &ftp_browser::refresh_status);
+    status_timer_->start(200);
+}
+
+void ftp_browser::refresh_status(void)
+{
+    ftp_transfer_status status;
+    if (client_.isNull() || !client_->get_status(sysid_, compid_, status)) return;
+    status_label_->setText(status.get_QString());
+    if (!status.is_list && status.file_size > 0)
+    {
+        progress_->setValue(static_cast<int>(1000 * status.bytes_received / status.file_size));
+    }
+    if (status.is_list && status.phase != last_phase_ && (status.phase == ftp_transfer_status::DONE || status.phase == ftp_transfer_status::FAILED))
+    {
+        populate_entries();
+    }
+    last_phase_ = status.phase;
+}
+
+void ftp_browser::populate_entries(void)
+{
+    QVector<ftp_entry> entries;
+    if (client_.isNull() || !client_->get_entries(sysid_, compid_, entries)) return;
+    std::sort(entries.begin(), entries.end(), [](const ftp_entry& a, const ftp_entry& b) {
+        if (a.is_directory != b.is_directory) return a.is_directory;
+        return a.name < b.name;
+    });
+    tree_->clear();
+    for (const ftp_entry& entry : std::as_const(entries))
+    {
+        QTreeWidgetItem* item = new QTreeWidgetItem(tree_);
+        item->setText(0, entry.is_directory ? entry.name + "/" : entry.name);
+        item->setText(1, entry.is_directory ? QString() : QLocale().formattedDataSize(entry.size));
+        item->setData(0, Qt::UserRole, entry.name);
+        item->setData(1, Qt::UserRole, entry.is_directory);
+    }
+}
+
+void ftp_browser::on_list_clicked(void)
+{
+    if (client_.isNull()) return;
+    last_phase_ = ftp_transfer_status::IDLE;
+    if (!client_->list_directory(port_name_, sysid_, compid_, path_edit_->text())) status_label_->setText("Busy, cancel the running transfer first");
+}
+
+void ftp_browser::on_up_clicked(void)
+{
+    QString path = path_edit_->text();
+    while (path.size() > 1 && path.endsWith('/')) path.chop(1);
+    const int slash = path.lastIndexOf('/');
+    path_edit_->setText(slash <= 0 ? QString("/") : path.left(slash));
+    on_list_clicked();
+}
+
+void ftp_browser::on_download_clicked(void)
+{
+    QTreeWidgetItem* item = tree_->currentItem();
+    if (client_.isNull() || item == nullptr || item->data(1, Qt::UserRole).toBool()) return;
+    const QString name = item->data(0, Qt::UserRole).toString();
+    QString remote_path = path_edit_->text();
+    if (!remote_path.endsWith('/')) remote_path += '/';
+    remote_path += name;
+
+    const QString local_path = QFileDialog::getSaveFileName(this, "Save file", QDir::home().filePath(name));
+    if (local_path.isEmpty()) return;
+    progress_->setValue(0);
+    if (!client_->download(port_name_, sysid_, compid_, remote_path, local_path)) status_label_->setText("Could not start the download");
+}
+
+void ftp_browser::on_item_double_clicked(QTreeWidgetItem* item, int)
+{
+    if (item == nullptr) return;
+    if (!item->data(1, Qt::UserRole).toBool())
+    {
+        on_download_clicked();
+        return;
+    }
+    QString path = path_edit_->text();
+    if (!path.endsWith('/')) path += '/';
+    path_edit_->setText(path + item->data(0, Qt::UserRole).toString());
+    on_list_clicked();
+}
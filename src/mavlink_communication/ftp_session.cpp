@@ -0,0 +1,436 @@
+/****************************************************************************
+ *
+ *    Copyright (C) 2025  Yevhenii Kovryzhenko. All rights reserved.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU Affero General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License Version 3 for more details.
+ *
+ *    You should have received a copy of the
+ *    GNU Affero General Public License Version 3
+ *    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions, and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions, and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *    3. No ownership or credit shall be claimed by anyone not mentioned in
+ *       the above copyright statement.
+ *    4. Any redistribution or public use of this software, in whole or in part,
+ *       whether standalone or as part of a different project, must remain
+ *       under the terms of the GNU Affero General Public License Version 3,
+ *       and all distributions in binary form must be accompanied by a copy of
+ *       the source code, as stated in the GNU Affero General Public License.
+ *
+ ****************************************************************************/
+
+#include <QByteArray>
+#include <QList>
+
+#include "mavlink_communication/ftp_session.h"
+
+QString mavlink_ftp::error_QString(const payload& nak)
+{
+    if (nak.size == 0) return "Unknown error";
+    switch (nak.data[0])
+    {
+    case ERR_FAIL:                  return "Failed";
+    case ERR_FAIL_ERRNO:            return QString("Failed (errno %1)").arg(nak.size > 1 ? nak.data[1] : 0);
+    case ERR_INVALID_DATA_SIZE:     return "Invalid data size";
+    case ERR_INVALID_SESSION:       return "Invalid session";
+    case ERR_NO_SESSIONS_AVAILABLE: return "No sessions available";
+    case ERR_EOF:                   return "End of file";
+    case ERR_UNKNOWN_COMMAND:       return "Unknown command";
+    case ERR_FILE_EXISTS:           return "File exists";
+    case ERR_FILE_PROTECTED:        return "File protected";
+    case ERR_FILE_NOT_FOUND:        return "File not found";
+    default:                        return QString("Error %1").arg(nak.data[0]);
+    }
+}
+
+QString ftp_transfer_status::get_QString(void) const
+{
+    static const char* phase_names[] = {"Idle", "Opening", "Burst reading", "Filling gaps", "Listing", "Done", "Failed"};
+    QString txt = QString("%1 %2").arg(phase_names[phase], remote_path);
+    const double elapsed_s = static_cast<double>(elapsed_ns) * 1.0E-9;
+    if (!is_list && file_size >= 0)
+    {
+        txt += QString(": %1/%2 kB").arg(bytes_received / 1024).arg(file_size / 1024);
+        if (elapsed_s > 0.0) txt += QString(", %1 kB/s").arg(static_cast<double>(bytes_received) / 1024.0 / elapsed_s, 0, 'f', 1);
+        txt += QString(", %1 bursts, %2 re-reads").arg(bursts).arg(reads_sent);
+    }
+    txt += QString(", %1 s").arg(elapsed_s, 0, 'f', 1);
+    if (!error.isEmpty()) txt += " (" + error + ")";
+    return txt;
+}
+
+static void set_payload_data(mavlink_ftp::payload &request, const QByteArray &data)
+{
+    const int n = qMin<int>(data.size(), mavlink_ftp::max_data);
+    memcpy(request.data, data.constData(), n);
+    request.size = static_cast<uint8_t>(n);
+}
+
+
+
+void ftp_session::start_download(const QString &remote_path, ftp_data_sink* sink, qint64 now_ns, payload_list &out)
+{
+    cancel(now_ns, out);
+    is_list_ = false;
+    remote_path_ = remote_path;
+    error_.clear();
+    sink_ = sink;
+    start_ns_ = now_ns;
+    end_ns_ = 0;
+    file_size_ = -1;
+    chunk_count_ = 0;
+    chunk_bits_.clear();
+    chunks_received_ = 0;
+    bytes_received_ = 0;
+    bursts_ = 0;
+    reads_.clear();
+    reads_sent_ = 0;
+
+    phase_ = ftp_transfer_status::OPENING;
+    mavlink_ftp::payload request = make_request(mavlink_ftp::CMD_OPEN_FILE_RO);
+    set_payload_data(request, remote_path.toUtf8());
+    send_control(request, now_ns, out);
+}
+
+void ftp_session::start_list(const QString &remote_path, qint64 now_ns, payload_list &out)
+{
+    cancel(now_ns, out);
+    is_list_ = true;
+    remote_path_ = remote_path;
+    error_.clear();
+    sink_ = nullptr;
+    start_ns_ = now_ns;
+    end_ns_ = 0;
+    entries_.clear();
+    list_skipped_ = 0;
+
+    phase_ = ftp_transfer_status::LISTING;
+    mavlink_ftp::payload request = make_request(mavlink_ftp::CMD_LIST_DIRECTORY);
+    set_payload_data(request, remote_path.toUtf8());
+    send_control(request, now_ns, out);
+}
+
+void ftp_session::cancel(qint64 now_ns, payload_list &out)
+{
+    if (is_active()) finish(ftp_transfer_status::FAILED, "Cancelled", now_ns, out);
+}
+
+void ftp_session::fail(const QString &error, qint64 now_ns, payload_list &out)
+{
+    if (is_active()) finish(ftp_transfer_status::FAILED, error, now_ns, out);
+}
+
+void ftp_session::handle(const mavlink_ftp::payload &reply, qint64 now_ns, payload_list &out)
+{
+    if (reply.opcode != mavlink_ftp::RSP_ACK && reply.opcode != mavlink_ftp::RSP_NAK) return;
+    const bool nak = reply.opcode == mavlink_ftp::RSP_NAK;
+    // replies to the control request carry its seq + 1; older ones are retransmissions
+    const bool control_reply = control_pending_ && reply.seq == static_cast<uint16_t>(control_.seq + 1);
+
+    switch (reply.req_opcode)
+    {
+    case mavlink_ftp::CMD_OPEN_FILE_RO:
+    {
+        if (phase_ != ftp_transfer_status::OPENING || !control_reply) return;
+        control_pending_ = false;
+        if (nak || reply.size < 4)
+        {
+            finish(ftp_transfer_status::FAILED, nak ? mavlink_ftp::error_QString(reply) : "Invalid open reply", now_ns, out);
+            return;
+        }
+        session_ = reply.session;
+        session_open_ = true;
+        uint32_t size = 0;
+        memcpy(&size, reply.data, sizeof(size));
+        file_size_ = size;
+        chunk_count_ = static_cast<int>((file_size_ + mavlink_ftp::max_data - 1) / mavlink_ftp::max_data);
+        chunk_bits_.assign((chunk_count_ + 63) / 64, 0);
+        // bits past the end read as received, so the hole scan can skip whole words
+        if (chunk_count_ & 63) chunk_bits_.back() = ~((1ull << (chunk_count_ & 63)) - 1);
+        if (sink_ && !sink_->allocate(file_size_))
+        {
+            finish(ftp_transfer_status::FAILED, sink_->error_QString(), now_ns, out);
+            return;
+        }
+        if (chunk_count_ == 0) finish(ftp_transfer_status::DONE, QString(), now_ns, out);
+        else send_burst(0, now_ns, out);
+        return;
+    }
+
+    case mavlink_ftp::CMD_BURST_READ_FILE:
+        if (phase_ != ftp_transfer_status::BURSTING || reply.session != session_) return;
+        control_pending_ = false; // any reply confirms the burst started
+        if (nak)
+        {
+            if (reply.size > 0 && reply.data[0] == mavlink_ftp::ERR_EOF) end_burst(now_ns, out);
+            else finish(ftp_transfer_status::FAILED, mavlink_ftp::error_QString(reply), now_ns, out);
+            return;
+        }
+        if (!store_data(reply))
+        {
+            finish(ftp_transfer_status::FAILED, sink_->error_QString(), now_ns, out);
+            return;
+        }
+        last_data_ns_ = now_ns;
+        if (chunks_received_ == chunk_count_) finish(ftp_transfer_status::DONE, QString(), now_ns, out);
+        else if (reply.burst_complete) end_burst(now_ns, out);
+        return;
+
+    case mavlink_ftp::CMD_READ_FILE:
+        if (is_list_ || !is_active() || reply.session != session_) return;
+        if (nak)
+        {
+            // holes are inside the file, so even EOF means something is wrong
+            finish(ftp_transfer_status::FAILED, mavlink_ftp::error_QString(reply), now_ns, out);
+            return;
+        }
+        if (!store_data(reply))
+        {
+            finish(ftp_transfer_status::FAILED, sink_->error_QString(), now_ns, out);
+            return;
+        }
+        if (chunks_received_ == chunk_count_) finish(ftp_transfer_status::DONE, QString(), now_ns, out);
+        return;
+
+    case mavlink_ftp::CMD_LIST_DIRECTORY:
+    {
+        if (phase_ != ftp_transfer_status::LISTING || !control_reply) return;
+        control_pending_ = false;
+        if (nak)
+        {
+            if (reply.size > 0 && reply.data[0] == mavlink_ftp::ERR_EOF) finish(ftp_transfer_status::DONE, QString(), now_ns, out);
+            else finish(ftp_transfer_status::FAILED, mavlink_ftp::error_QString(reply), now_ns, out);
+            return;
+        }
+        parse_list(reply);
+        // continue after the last entry we have
+        mavlink_ftp::payload request = make_request(mavlink_ftp::CMD_LIST_DIRECTORY);
+        request.offset = static_cast<uint32_t>(entries_.size() + list_skipped_);
+        set_payload_data(request, remote_path_.toUtf8());
+        send_control(request, now_ns, out);
+        return;
+    }
+
+    default:
+        return;
+    }
+}
+
+void ftp_session::service(qint64 now_ns, payload_list &out)
+{
+    if (!is_active()) return;
+
+    if (control_pending_ && now_ns - control_sent_ns_ > request_timeout_ns)
+    {
+        if (control_attempts_ >= max_attempts)
+        {
+            finish(ftp_transfer_status::FAILED, "No response", now_ns, out);
+            return;
+        }
+        // same seq, so the responder can tell a retry from a new request
+        control_attempts_++;
+        control_sent_ns_ = now_ns;
+        out.append(control_);
+    }
+
+    if (phase_ == ftp_transfer_status::BURSTING && !control_pending_ && now_ns - last_data_ns_ > burst_stall_ns)
+    {
+        end_burst(now_ns, out);
+    }
+
+    if (phase_ != ftp_transfer_status::GAP_FILL) return;
+
+    for (auto it = reads_.begin(); it != reads_.end();)
+    {
+        if (now_ns - it->sent_ns < request_timeout_ns)
+        {
+            ++it;
+            continue;
+        }
+        if (it->attempts >= max_attempts)
+        {
+            finish(ftp_transfer_status::FAILED, "Chunk read timed out", now_ns, out);
+            return;
+        }
+        it->attempts++;
+        it->sent_ns = now_ns;
+        send_read(it.key(), out);
+        ++it;
+    }
+
+    // slide the window over the remaining holes
+    int chunk = next_missing(0);
+    while (reads_.size() < read_window && chunk >= 0)
+    {
+        pending_read& read = reads_[chunk];
+        read.attempts = 1;
+        read.sent_ns = now_ns;
+        send_read(chunk, out);
+        chunk = next_missing(chunk + 1);
+    }
+}
+
+ftp_transfer_status ftp_session::get_status(qint64 now_ns) const
+{
+    ftp_transfer_status status;
+    status.phase = phase_;
+    status.is_list = is_list_;
+    status.remote_path = remote_path_;
+    status.file_size = file_size_;
+    status.bytes_received = bytes_received_;
+    status.chunks_received = chunks_received_;
+    status.chunk_count = chunk_count_;
+    status.bursts = bursts_;
+    status.reads_sent = reads_sent_;
+    status.elapsed_ns = (is_active() ? now_ns : end_ns_) - start_ns_;
+    status.error = error_;
+    return status;
+}
+
+mavlink_ftp::payload ftp_session::make_request(uint8_t opcode)
+{
+    mavlink_ftp::payload request;
+    request.seq = next_seq_++;
+    request.session = session_;
+    request.opcode = opcode;
+    return request;
+}
+
+void ftp_session::send_control(const mavlink_ftp::payload &request, qint64 now_ns, payload_list &out)
+{
+    control_ = request;
+    control_sent_ns_ = now_ns;
+    control_attempts_ = 1;
+    control_pending_ = true;
+    out.append(request);
+}
+
+void ftp_session::send_burst(int chunk, qint64 now_ns, payload_list &out)
+{
+    phase_ = ftp_transfer_status::BURSTING;
+    bursts_++;
+    last_data_ns_ = now_ns;
+    mavlink_ftp::payload request = make_request(mavlink_ftp::CMD_BURST_READ_FILE);
+    request.offset = static_cast<uint32_t>(chunk) * mavlink_ftp::max_data;
+    request.size = mavlink_ftp::max_data;
+    send_control(request, now_ns, out);
+}
+
+void ftp_session::send_read(int chunk, payload_list &out)
+{
+    mavlink_ftp::payload request = make_request(mavlink_ftp::CMD_READ_FILE);
+    request.offset = static_cast<uint32_t>(chunk) * mavlink_ftp::max_data;
+    request.size = static_cast<uint8_t>(chunk_length(chunk));
+    out.append(request);
+    reads_sent_++;
+}
+
+void ftp_session::end_burst(qint64 now_ns, payload_list &out)
+{
+    control_pending_ = false;
+    const int missing = chunk_count_ - chunks_received_;
+    if (missing == 0)
+    {
+        finish(ftp_transfer_status::DONE, QString(), now_ns, out);
+        return;
+    }
+    // long runs are cheaper to stream again than to request one by one
+    if (missing > burst_restart_chunks) send_burst(next_missing(0), now_ns, out);
+    else phase_ = ftp_transfer_status::GAP_FILL;
+}
+
+void ftp_session::finish(int phase, const QString &error, qint64 now_ns, payload_list &out)
+{
+    phase_ = phase;
+    error_ = error;
+    end_ns_ = now_ns;
+    control_pending_ = false;
+    reads_.clear();
+    if (session_open_)
+    {
+        out.append(make_request(mavlink_ftp::CMD_TERMINATE_SESSION));
+        session_open_ = false;
+    }
+}
+
+// false if the data could not be written; the chunks are then left missing
+bool ftp_session::store_data(const mavlink_ftp::payload &reply)
+{
+    if (sink_ == nullptr || reply.size == 0 || reply.offset >= file_size_) return true;
+    const qint64 offset = reply.offset;
+    const qint64 end = qMin<qint64>(offset + reply.size, file_size_);
+    if (!sink_->write(offset, reply.data, static_cast<int>(end - offset))) return false;
+
+    // mark every chunk the reply covers completely; replies normally align with chunks
+    for (int chunk = static_cast<int>((offset + mavlink_ftp::max_data - 1) / mavlink_ftp::max_data); chunk < chunk_count_; chunk++)
+    {
+        const qint64 chunk_start = static_cast<qint64>(chunk) * mavlink_ftp::max_data;
+        if (chunk_start + chunk_length(chunk) > end) break;
+        reads_.remove(chunk);
+        if (has_chunk(chunk)) continue;
+        chunk_bits_[chunk >> 6] |= 1ull << (chunk & 63);
+        chunks_received_++;
+        bytes_received_ += chunk_length(chunk);
+    }
+    return true;
+}
+
+int ftp_session::next_missing(int from) const
+{
+    for (int chunk = from; chunk < chunk_count_;)
+    {
+        const quint64 word = chunk_bits_[chunk >> 6];
+        if (word == ~0ull)
+        {
+            chunk = (chunk | 63) + 1;
+            continue;
+        }
+        if (((word >> (chunk & 63)) & 1ull) == 0 && !reads_.contains(chunk)) return chunk;
+        chunk++;
+    }
+    return -1;
+}
+
+int ftp_session::chunk_length(int chunk) const
+{
+    const qint64 chunk_start = static_cast<qint64>(chunk) * mavlink_ftp::max_data;
+    return static_cast<int>(qMin<qint64>(mavlink_ftp::max_data, file_size_ - chunk_start));
+}
+
+void ftp_session::parse_list(const mavlink_ftp::payload &reply)
+{
+    // entries are null separated: "F<name>\t<size>", "D<name>" or "S" (skipped)
+    const QByteArray data(reinterpret_cast<const char*>(reply.data), reply.size);
+    for (const QByteArray& token : data.split('\0'))
+    {
+        if (token.isEmpty()) continue;
+        const char type = token.at(0);
+        ftp_entry entry;
+        if (type == 'F')
+        {
+            const QList<QByteArray> parts = token.mid(1).split('\t');
+            entry.name = QString::fromUtf8(parts.value(0));
+            entry.size = parts.value(1).toLongLong();
+        }
+        else if (type == 'D')
+        {
+            entry.name = QString::fromUtf8(token.mid(1));
+            entry.is_directory = true;
+        }
+        if (entry.name.isEmpty() || entry.name == "." || entry.name == "..") list_skipped_++;
+        else entries_.append(entry);
+    }
+}
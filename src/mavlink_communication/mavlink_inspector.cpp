@@ -45,17 +45,24 @@
 #include <QSet>
 #include <QPalette>
 #include <functional>
+#include <algorithm>
+#include <cstring>
+#include <limits>
 #include <QCheckBox>
 #include <QScrollBar>
+#include <QTableView>
+#include <QHBoxLayout>
 
 #include "mavlink_communication/mavlink_inspector.h"
 #include "ui_mavlink_inspector.h"
-#include "ui_mavlink_inspector_msg.h"
 #include "mavlink_communication/keybinddialog.h"
+#include "mavlink_communication/command_manager.h"
+#include "mavlink_communication/timesync_manager.h"
 #include "default_ui_config.h"
 // Plotting registry for globally tagged signals
 #include "plot/plot_signal_registry.h"
 #include "plot/plot_signal_ui_helpers.h"
+#include "time_base.h"
 
 template <typename mav_type_in>
 mavlink_processor<mav_type_in>::mavlink_processor()
@@ -87,7 +94,7 @@ void mavlink_processor<mav_type_in>::update_msg(mav_type_in& new_msg, qint64 new
     }
 
     std::memcpy(msg, &new_msg, sizeof(new_msg));
-    timestamp_ms = new_msg_timestamp;
+    timestamp_ns = new_msg_timestamp;
     // timestamps.enqueue(timestamp);
     mutex->unlock();
 }
@@ -97,7 +104,7 @@ bool mavlink_processor<mav_type_in>::get_msg(mav_type_in& msg_out, qint64 &msg_t
     if (msg == NULL || mutex == NULL) return false;
     mutex->lock();
     std::memcpy(&msg_out, msg, sizeof(*msg));
-    msg_timestamp_out = timestamp_ms;
+    msg_timestamp_out = timestamp_ns;
     mutex->unlock();
     return true;
 }
@@ -121,8 +128,6 @@ mavlink_data_aggregator::mavlink_data_aggregator(QObject* parent, uint8_t sysid_
 }
 mavlink_data_aggregator::~mavlink_data_aggregator()
 {
-    while (msgs.count()) delete msgs.takeLast();
-    while (timestamps.count()) delete timestamps.takeLast();
     delete mutex;
 }
 
@@ -231,186 +236,365 @@ bool mavlink_data_aggregator::print_message(QString &txt, mavlink_message_t* msg
     return true;
 }
 
-bool mavlink_data_aggregator::is_stored(QString msg_name, unsigned &i)
+void message_rate_stats::update(qint64 t_ns)
 {
-    mutex->lock();
-    if (!msgs.isEmpty())
+    if (count > 0)
     {
-        for (i = 0; i < names.count(); i++)
+        const qint64 dt_ns = t_ns - last_ns;
+        if (dt_ns > 0)
         {
-            //QString tmp = QString();
-            if (names[i] == msg_name)
+            const double dt = static_cast<double>(dt_ns);
+            if (intervals == 0)
             {
-                mutex->unlock();
-                return true;
+                mean_interval_ns = dt;
+                min_interval_ns = max_interval_ns = dt_ns;
+            }
+            else
+            {
+                // time-based weight: ~tau_ns of history whatever the message rate
+                const double alpha = 1.0 - std::exp(-dt / tau_ns);
+                jitter_ns += alpha * (std::fabs(dt - mean_interval_ns) - jitter_ns);
+                mean_interval_ns += alpha * (dt - mean_interval_ns);
+                min_interval_ns = qMin(min_interval_ns, dt_ns);
+                max_interval_ns = qMax(max_interval_ns, dt_ns);
             }
+            intervals++;
+            rate_hz = 1.0E9 / mean_interval_ns;
         }
     }
-    mutex->unlock();
-    return false;
+    last_ns = t_ns;
+    count++;
 }
-bool mavlink_data_aggregator::is_stored(uint8_t msg_id, unsigned &i)
+
+QString message_rate_stats::get_QString(void) const
 {
-    mutex->lock();
-    if (!msgs.isEmpty())
+    return QString("Rate: %1 (Hz), Jitter: %2 (ms), Interval: %3 .. %4 (ms)")
+        .arg(rate_hz, 0, 'f', 2)
+        .arg(jitter_ns * 1.0E-6, 0, 'f', 3)
+        .arg(static_cast<double>(min_interval_ns) * 1.0E-6, 0, 'f', 3)
+        .arg(static_cast<double>(max_interval_ns) * 1.0E-6, 0, 'f', 3);
+}
+
+static unsigned mav_type_size(mavlink_message_type_t type)
+{
+    switch (type) {
+    case MAVLINK_TYPE_CHAR:
+    case MAVLINK_TYPE_UINT8_T:
+    case MAVLINK_TYPE_INT8_T:   return 1;
+    case MAVLINK_TYPE_UINT16_T:
+    case MAVLINK_TYPE_INT16_T:  return 2;
+    case MAVLINK_TYPE_UINT32_T:
+    case MAVLINK_TYPE_INT32_T:
+    case MAVLINK_TYPE_FLOAT:    return 4;
+    default:                    return 8;
+    }
+}
+
+// Decode one little-endian MAVLink value from raw payload bytes
+static bool mav_decode_numeric(const char* bytes, mavlink_message_type_t type, double& out)
+{
+    switch (type) {
+    case MAVLINK_TYPE_UINT8_T:  { uint8_t v;  memcpy(&v, bytes, sizeof(v)); out = static_cast<double>(v); return true; }
+    case MAVLINK_TYPE_INT8_T:   { int8_t v;   memcpy(&v, bytes, sizeof(v)); out = static_cast<double>(v); return true; }
+    case MAVLINK_TYPE_UINT16_T: { uint16_t v; memcpy(&v, bytes, sizeof(v)); out = static_cast<double>(v); return true; }
+    case MAVLINK_TYPE_INT16_T:  { int16_t v;  memcpy(&v, bytes, sizeof(v)); out = static_cast<double>(v); return true; }
+    case MAVLINK_TYPE_UINT32_T: { uint32_t v; memcpy(&v, bytes, sizeof(v)); out = static_cast<double>(v); return true; }
+    case MAVLINK_TYPE_INT32_T:  { int32_t v;  memcpy(&v, bytes, sizeof(v)); out = static_cast<double>(v); return true; }
+    case MAVLINK_TYPE_UINT64_T: { uint64_t v; memcpy(&v, bytes, sizeof(v)); out = static_cast<double>(v); return true; }
+    case MAVLINK_TYPE_INT64_T:  { int64_t v;  memcpy(&v, bytes, sizeof(v)); out = static_cast<double>(v); return true; }
+    case MAVLINK_TYPE_FLOAT:    { float v;    memcpy(&v, bytes, sizeof(v)); out = static_cast<double>(v); return true; }
+    case MAVLINK_TYPE_DOUBLE:   { double v;   memcpy(&v, bytes, sizeof(v)); out = v; return true; }
+    default: return false;
+    }
+}
+
+message_history::message_history(uint8_t sysid, uint8_t compid, uint32_t msgid)
+    : sysid_(sysid), compid_(compid), msgid_(msgid)
+{
+
+}
+
+void message_history::append(const mavlink_message_t &msg, qint64 t_ns, qint64 window_ns)
+{
+    // keep the time column sorted even if stamps from different ports interleave
+    if (size() > 0 && t_ns < t_ns_.last()) t_ns = t_ns_.last();
+
+    const char* payload = _MAV_PAYLOAD(&msg);
+    int len = msg.len;
+    while (len > 0 && payload[len - 1] == 0) len--;
+
+    t_ns_.push_back(t_ns);
+    offset_.push_back(static_cast<quint32>(payload_.size()));
+    len_.push_back(static_cast<quint8>(len));
+    seq_.push_back(msg.seq);
+    payload_.append(payload, len);
+
+    evict(t_ns - window_ns);
+}
+
+void message_history::evict(qint64 oldest_ns)
+{
+    const int end = t_ns_.size();
+    while (head_ < end - 1 && (t_ns_[head_] < oldest_ns || end - head_ > max_records)) head_++;
+
+    // amortized O(1): drop the dead prefix once it outweighs the live part
+    if (head_ > 0 && head_ * 2 >= end)
     {
-        for (i = 0; i < msgs.count(); i++)
+        const quint32 base = offset_[head_];
+        t_ns_.remove(0, head_);
+        offset_.remove(0, head_);
+        len_.remove(0, head_);
+        seq_.remove(0, head_);
+        payload_.remove(0, static_cast<qsizetype>(base));
+        for (quint32 &offset : offset_) offset -= base;
+        head_ = 0;
+    }
+}
+
+void message_history::clear(void)
+{
+    t_ns_.clear();
+    offset_.clear();
+    len_.clear();
+    seq_.clear();
+    payload_.clear();
+    head_ = 0;
+}
+
+int message_history::find(qint64 t_ns) const
+{
+    auto it = std::upper_bound(t_ns_.cbegin() + head_, t_ns_.cend(), t_ns);
+    return static_cast<int>(it - (t_ns_.cbegin() + head_)) - 1;
+}
+
+bool message_history::get(int index, mavlink_message_t &msg_out, qint64 &t_ns_out) const
+{
+    if (index < 0 || index >= size()) return false;
+    const int i = head_ + index;
+
+    memset(&msg_out, 0, sizeof(msg_out));
+    msg_out.magic = MAVLINK_STX;
+    msg_out.len = len_[i];
+    msg_out.seq = seq_[i];
+    msg_out.sysid = sysid_;
+    msg_out.compid = compid_;
+    msg_out.msgid = msgid_;
+    memcpy(msg_out.payload64, payload_.constData() + offset_[i], len_[i]);
+    t_ns_out = t_ns_[i];
+    return true;
+}
+
+int message_history::extract(unsigned offset, mavlink_message_type_t type, qint64 t_from_ns, qint64 t_to_ns, QVector<PlotSignalSample> &samples_out) const
+{
+    auto first = std::lower_bound(t_ns_.cbegin() + head_, t_ns_.cend(), t_from_ns);
+    auto last = std::upper_bound(first, t_ns_.cend(), t_to_ns);
+    const int i0 = static_cast<int>(first - t_ns_.cbegin());
+    const int i1 = static_cast<int>(last - t_ns_.cbegin());
+
+    const unsigned size = mav_type_size(type);
+    samples_out.reserve(samples_out.size() + (i1 - i0));
+    for (int i = i0; i < i1; i++)
+    {
+        // bytes past the trimmed length were zeros on the wire
+        char bytes[8] = {};
+        if (offset < len_[i]) memcpy(bytes, payload_.constData() + offset_[i] + offset, std::min<unsigned>(size, len_[i] - offset));
+        double value = 0.0;
+        if (!mav_decode_numeric(bytes, type, value)) return 0;
+        samples_out.push_back({t_ns_[i], value});
+    }
+    return i1 - i0;
+}
+
+// caller holds mutex
+int mavlink_data_aggregator::find_slot(uint32_t msg_id) const
+{
+    if (msg_id < direct_msgid_limit)
+    {
+        const int* page = pages_[msg_id >> page_bits].get();
+        return page ? page[msg_id & (page_size - 1)] : -1;
+    }
+    return sparse_index_.value(msg_id, -1);
+}
+int mavlink_data_aggregator::find_slot(const QString &msg_name) const
+{
+    const mavlink_message_info_t* info = mavlink_get_message_info_by_name(msg_name.toLatin1().constData());
+    if (info == NULL) return -1;
+    return find_slot(info->msgid);
+}
+int mavlink_data_aggregator::insert_slot(uint32_t msg_id)
+{
+    const int ind = entries_.size();
+    if (msg_id < direct_msgid_limit)
+    {
+        std::unique_ptr<int[]>& page = pages_[msg_id >> page_bits];
+        if (!page)
         {
-            if (msgs[i]->msgid == msg_id)
-            {
-                mutex->unlock();
-                return true;
-            }
+            page.reset(new int[page_size]);
+            std::fill(page.get(), page.get() + page_size, -1);
         }
+        page[msg_id & (page_size - 1)] = ind;
     }
-    mutex->unlock();
-    return false;
+    else sparse_index_.insert(msg_id, ind);
+    entries_.resize(ind + 1);
+    return ind;
 }
-bool mavlink_data_aggregator::is_stored(QString msg_name)
+
+bool mavlink_data_aggregator::is_stored(uint32_t msg_id)
 {
-    unsigned i;
-    return is_stored(msg_name, i);
+    mutex->lock();
+    const bool res = find_slot(msg_id) >= 0;
+    mutex->unlock();
+    return res;
 }
-bool mavlink_data_aggregator::is_stored(uint8_t msg_id)
+bool mavlink_data_aggregator::is_stored(QString msg_name)
 {
-    unsigned i;
-    return is_stored(msg_id, i);
+    mutex->lock();
+    const bool res = find_slot(msg_name) >= 0;
+    mutex->unlock();
+    return res;
 }
 
 void mavlink_data_aggregator::clear(void)
 {
     mutex->lock();
-    while (msgs.count()) delete msgs.takeLast();
-    while (timestamps.count()) delete timestamps.takeLast();
-    names.clear();
+    entries_.clear();
+    histories_.clear();
+    for (auto& page : pages_) page.reset();
+    sparse_index_.clear();
     mutex->unlock();
 }
 
 bool mavlink_data_aggregator::update(void *new_msg_in, qint64 msg_time_stamp)
 {
     if (new_msg_in == NULL) return false; //empty pointer
-    QString name;
     mavlink_message_t* msg_cast_ = static_cast<mavlink_message_t*>(new_msg_in);
 
-    if (!print_name(name, msg_cast_)) return false; //invaid message
-
-
-    if (msgs.count() < 1)
-    {
-        mavlink_message_t* new_msg = new mavlink_message_t;
-        memcpy(new_msg, msg_cast_, sizeof(*msg_cast_));
-        CQueue<qint64>* new_cque = new CQueue<qint64>(time_buffer_size);
-        new_cque->enqueue(msg_time_stamp);        
-
-        mutex->lock();
-        msgs.push_back(new_msg);
-        timestamps.push_back(new_cque);
-        names.push_back(name);
-        mutex->unlock();
-
-        emit updated(sysid, compid, name);
-        return true;
-    }
-    else
+    mutex->lock();
+    int ind = find_slot(msg_cast_->msgid);
+    if (ind < 0)
     {
-        unsigned int matching_entry;
-        if (is_stored(name, matching_entry))
+        const mavlink_message_info_t* info = mavlink_get_message_info(msg_cast_);
+        if (info == NULL) //invaid message
         {
-            mutex->lock();
-            memcpy(msgs[matching_entry], msg_cast_, sizeof(*msg_cast_));
-            timestamps[matching_entry]->enqueue(msg_time_stamp);
             mutex->unlock();
-            emit updated(sysid, compid, name);
-            return true;
-        }
-        else
-        {
-            mavlink_message_t* new_msg = new mavlink_message_t;
-            memcpy(new_msg, msg_cast_, sizeof(*msg_cast_));
-            CQueue<qint64>* new_cque = new CQueue<qint64>(time_buffer_size);
-            new_cque->enqueue(msg_time_stamp);
-
-            mutex->lock();
-            msgs.push_back(new_msg);
-            timestamps.push_back(new_cque);
-            names.push_back(name);
-            mutex->unlock();
-            emit updated(sysid, compid, name);
-            return true;
+            return false;
         }
+        ind = insert_slot(msg_cast_->msgid);
+        entries_[ind].name = QString::fromLatin1(info->name);
     }
-    return false;
+    message_slot& slot = entries_[ind];
+    mavlink_packed::pack(*msg_cast_, slot.packed);
+    slot.stats.update(msg_time_stamp);
+    if (history_window_ns_ > 0)
+    {
+        if (histories_.size() < static_cast<size_t>(entries_.size())) histories_.resize(entries_.size());
+        std::unique_ptr<message_history>& history = histories_[ind];
+        if (!history) history.reset(new message_history(sysid, static_cast<uint8_t>(compid), msg_cast_->msgid));
+        history->append(*msg_cast_, msg_time_stamp, history_window_ns_);
+    }
+    mutex->unlock();
+    return true;
 }
 
-bool mavlink_data_aggregator::get_msg(QString msg_name, void *msg_out, CQueue<qint64> &timestamps_out)
+bool mavlink_data_aggregator::get_msg(uint32_t msg_id, void *msg_out, message_rate_stats &stats_out)
 {
-    unsigned int matching_entry;
-    if (is_stored(msg_name, matching_entry))
+    mutex->lock();
+    const int ind = find_slot(msg_id);
+    if (ind >= 0)
     {
-        mutex->lock();
-
-        memcpy(static_cast<mavlink_message_t*>(msg_out), msgs[matching_entry], sizeof(*msgs[matching_entry]));
-        timestamps_out.clear();
-        for (int i = 0; i < timestamps[matching_entry]->count(); i++) timestamps_out.enqueue(timestamps[matching_entry]->data()[i]);
-
-        mutex->unlock();
-        return true;
+        mavlink_packed::unpack(entries_[ind].packed, *static_cast<mavlink_message_t*>(msg_out));
+        stats_out = entries_[ind].stats;
     }
-    return false;
+    mutex->unlock();
+    return ind >= 0;
 }
-bool mavlink_data_aggregator::get_msg(QString msg_name, void *msg_out)
+bool mavlink_data_aggregator::get_msg(QString msg_name, void *msg_out, message_rate_stats &stats_out)
 {
-    unsigned int matching_entry;
-    if (is_stored(msg_name, matching_entry))
+    mutex->lock();
+    const int ind = find_slot(msg_name);
+    if (ind >= 0)
     {
-        mutex->lock();
-        memcpy(static_cast<mavlink_message_t*>(msg_out), msgs[matching_entry], sizeof(*msgs[matching_entry]));
-        mutex->unlock();
-        return true;
+        mavlink_packed::unpack(entries_[ind].packed, *static_cast<mavlink_message_t*>(msg_out));
+        stats_out = entries_[ind].stats;
     }
-    return false;
+    mutex->unlock();
+    return ind >= 0;
+}
+bool mavlink_data_aggregator::get_msg(QString msg_name, void *msg_out)
+{
+    mutex->lock();
+    const int ind = find_slot(msg_name);
+    if (ind >= 0) mavlink_packed::unpack(entries_[ind].packed, *static_cast<mavlink_message_t*>(msg_out));
+    mutex->unlock();
+    return ind >= 0;
 }
 
-bool mavlink_data_aggregator::get_all(QVector<mavlink_message_t*> &msgs_out)
+void mavlink_data_aggregator::set_history_window(qint64 window_ns)
 {
-    if (msgs.empty()) return false;
     mutex->lock();
-    msgs_out = QVector<mavlink_message_t*>(msgs);
-    msgs_out.detach();
+    history_window_ns_ = std::max<qint64>(window_ns, 0);
+    if (history_window_ns_ == 0) histories_.clear();
     mutex->unlock();
-    return true;
 }
-bool mavlink_data_aggregator::get_all(QVector<CQueue<qint64>*> &timestamps_out)
+
+bool mavlink_data_aggregator::get_msg_at(uint32_t msg_id, qint64 t_ns, void *msg_out, qint64 &t_ns_out)
 {
-    if (timestamps.empty()) return false;
+    bool res = false;
     mutex->lock();
-    timestamps_out = QVector<CQueue<qint64>*>(timestamps);
-    timestamps_out.detach();
+    const int ind = find_slot(msg_id);
+    if (ind >= 0 && static_cast<size_t>(ind) < histories_.size() && histories_[ind])
+    {
+        const message_history& history = *histories_[ind];
+        res = history.get(history.find(t_ns), *static_cast<mavlink_message_t*>(msg_out), t_ns_out);
+    }
     mutex->unlock();
-    return true;
+    return res;
 }
-bool mavlink_data_aggregator::get_all(QVector<QString> &names_out)
+
+int mavlink_data_aggregator::get_field_history(uint32_t msg_id, unsigned offset, mavlink_message_type_t type, qint64 t_from_ns, qint64 t_to_ns, QVector<PlotSignalSample> &samples_out)
 {
-    if (names.empty()) return false;
+    int n = 0;
     mutex->lock();
-    names_out = QVector<QString>(names);
-    names_out.detach();
+    const int ind = find_slot(msg_id);
+    if (ind >= 0 && static_cast<size_t>(ind) < histories_.size() && histories_[ind])
+    {
+        n = histories_[ind]->extract(offset, type, t_from_ns, t_to_ns, samples_out);
+    }
     mutex->unlock();
-    return true;
+    return n;
 }
 
-bool mavlink_data_aggregator::get_all(QVector<mavlink_message_t*> &msgs_out, QVector<CQueue<qint64>*> &timestamps_out)
+bool mavlink_data_aggregator::get_all(QVector<mavlink_message_t> &msgs_out)
 {
-    if (msgs.empty()) return false;
     mutex->lock();
-    msgs_out = QVector<mavlink_message_t*>(msgs);
-    msgs_out.detach();
-    timestamps_out = QVector<CQueue<qint64>*>(timestamps);
-    timestamps_out.detach();
+    msgs_out.resize(entries_.size());
+    for (int i = 0; i < entries_.size(); i++) mavlink_packed::unpack(entries_[i].packed, msgs_out[i]);
     mutex->unlock();
-    return true;
+    return !msgs_out.isEmpty();
+}
+bool mavlink_data_aggregator::get_all(QVector<mavlink_stream_info> &streams_out)
+{
+    mutex->lock();
+    streams_out.resize(entries_.size());
+    for (int i = 0; i < entries_.size(); i++)
+    {
+        const mavlink_packed::header hdr = mavlink_packed::read_header(entries_[i].packed);
+        streams_out[i].msgid = hdr.msgid;
+        streams_out[i].len = hdr.len;
+        streams_out[i].stats = entries_[i].stats;
+    }
+    mutex->unlock();
+    return !streams_out.isEmpty();
+}
+bool mavlink_data_aggregator::get_all(QVector<QString> &names_out)
+{
+    mutex->lock();
+    names_out.clear();
+    names_out.reserve(entries_.size());
+    for (const message_slot& slot : entries_) names_out.push_back(slot.name);
+    mutex->unlock();
+    return !names_out.isEmpty();
 }
-bool get_all(QVector<mavlink_message_t*> *msgs_out);
 
 
 
@@ -421,52 +605,80 @@ mavlink_manager::mavlink_manager(QObject* parent)
     : QObject(parent)
 {
     mutex = new QMutex;
+
+    generic_thread_settings aggregation_settings_;
+    aggregation_settings_.update_rate_hz = 30; // UI notification rate
+    aggregation_settings_.priority = QThread::Priority::HighPriority;
+    aggregation_settings_.realtime_class = realtime_settings::PORT_IO;
+    aggregation_thread_ = new mavlink_aggregation_thread(this, &aggregation_settings_);
+    connect(aggregation_thread_, &mavlink_aggregation_thread::changed, this, &mavlink_manager::relay_updated, Qt::QueuedConnection);
+    aggregation_thread_->start(aggregation_settings_.priority);
 }
 
 mavlink_manager::~mavlink_manager()
 {
+    aggregation_thread_->requestInterruption();
+    aggregation_thread_->wake();
+    aggregation_thread_->wait();
+    delete aggregation_thread_;
+
+    qDeleteAll(msgs);
+    qDeleteAll(retired_);
+    for (auto& table : index_) delete table.load(std::memory_order_relaxed);
+    for (auto& slot : vehicle_states_) delete slot.load(std::memory_order_relaxed);
     delete mutex;
 }
 
-// Extract a numeric field value as double; return true if extracted
-static bool mav_extract_numeric_field(const mavlink_message_t* msg, const mavlink_field_info_t* f, int idx, double& out)
-{
-    if (!msg || !f) return false;
-    switch (f->type) {
-    case MAVLINK_TYPE_UINT8_T:    out = static_cast<double>(_MAV_RETURN_uint8_t(const_cast<mavlink_message_t*>(msg), f->wire_offset + idx * 1)); return true;
-    case MAVLINK_TYPE_INT8_T:     out = static_cast<double>(_MAV_RETURN_int8_t(const_cast<mavlink_message_t*>(msg), f->wire_offset + idx * 1)); return true;
-    case MAVLINK_TYPE_UINT16_T:   out = static_cast<double>(_MAV_RETURN_uint16_t(const_cast<mavlink_message_t*>(msg), f->wire_offset + idx * 2)); return true;
-    case MAVLINK_TYPE_INT16_T:    out = static_cast<double>(_MAV_RETURN_int16_t(const_cast<mavlink_message_t*>(msg), f->wire_offset + idx * 2)); return true;
-    case MAVLINK_TYPE_UINT32_T:   out = static_cast<double>(_MAV_RETURN_uint32_t(const_cast<mavlink_message_t*>(msg), f->wire_offset + idx * 4)); return true;
-    case MAVLINK_TYPE_INT32_T:    out = static_cast<double>(_MAV_RETURN_int32_t(const_cast<mavlink_message_t*>(msg), f->wire_offset + idx * 4)); return true;
-    case MAVLINK_TYPE_UINT64_T:   out = static_cast<double>(_MAV_RETURN_uint64_t(const_cast<mavlink_message_t*>(msg), f->wire_offset + idx * 8)); return true;
-    case MAVLINK_TYPE_INT64_T:    out = static_cast<double>(_MAV_RETURN_int64_t(const_cast<mavlink_message_t*>(msg), f->wire_offset + idx * 8)); return true;
-    case MAVLINK_TYPE_FLOAT:      out = static_cast<double>(_MAV_RETURN_float(const_cast<mavlink_message_t*>(msg), f->wire_offset + idx * 4)); return true;
-    case MAVLINK_TYPE_DOUBLE:     out = static_cast<double>(_MAV_RETURN_double(const_cast<mavlink_message_t*>(msg), f->wire_offset + idx * 8)); return true;
+// Read a numeric payload value as double; return true if the type is numeric
+static bool mav_extract_numeric_field(const mavlink_message_t* msg, mavlink_message_type_t type, unsigned offset, double& out)
+{
+    if (!msg) return false;
+    mavlink_message_t* m = const_cast<mavlink_message_t*>(msg);
+    switch (type) {
+    case MAVLINK_TYPE_UINT8_T:    out = static_cast<double>(_MAV_RETURN_uint8_t(m, offset)); return true;
+    case MAVLINK_TYPE_INT8_T:     out = static_cast<double>(_MAV_RETURN_int8_t(m, offset)); return true;
+    case MAVLINK_TYPE_UINT16_T:   out = static_cast<double>(_MAV_RETURN_uint16_t(m, offset)); return true;
+    case MAVLINK_TYPE_INT16_T:    out = static_cast<double>(_MAV_RETURN_int16_t(m, offset)); return true;
+    case MAVLINK_TYPE_UINT32_T:   out = static_cast<double>(_MAV_RETURN_uint32_t(m, offset)); return true;
+    case MAVLINK_TYPE_INT32_T:    out = static_cast<double>(_MAV_RETURN_int32_t(m, offset)); return true;
+    case MAVLINK_TYPE_UINT64_T:   out = static_cast<double>(_MAV_RETURN_uint64_t(m, offset)); return true;
+    case MAVLINK_TYPE_INT64_T:    out = static_cast<double>(_MAV_RETURN_int64_t(m, offset)); return true;
+    case MAVLINK_TYPE_FLOAT:      out = static_cast<double>(_MAV_RETURN_float(m, offset)); return true;
+    case MAVLINK_TYPE_DOUBLE:     out = static_cast<double>(_MAV_RETURN_double(m, offset)); return true;
     default: return false;
     }
 }
 
-// Append samples for any currently tagged signals that match this message
-static void appendTaggedSamplesFromMessage(const mavlink_message_t* msg, qint64 msg_time_ms)
+quint64 mavlink_manager::message_key(uint8_t sysid, uint8_t compid, uint32_t msgid)
 {
-    if (!msg) return;
-    const mavlink_message_info_t* mi = mavlink_get_message_info(const_cast<mavlink_message_t*>(msg));
-    if (!mi) return;
-
-    const QString base = QString("mavlink/%1/%2/%3/")
-            .arg(msg->sysid)
-            .arg(msg->compid)
-            .arg(msg->msgid);
+    return (static_cast<quint64>(sysid) << 32) | (static_cast<quint64>(compid) << 24) | (msgid & 0xFFFFFF);
+}
 
-    const auto taggedIds = PlotSignalRegistry::instance().taggedIdsByPrefix(base);
-    if (taggedIds.isEmpty()) return;
+// Compile every tagged "mavlink/<sysid>/<compid>/<msgid>/<field>[idx]" id into
+// a payload offset and type, so per-message work is one lookup plus typed loads.
+void mavlink_manager::rebuild_plot_plans(qint64 backfill_before_ns)
+{
+    plot_plans_generation_ = PlotSignalRegistry::instance().tagGeneration();
+    plot_plans_.clear();
+    QSet<QString> plan_ids;
 
-    for (const auto& id : taggedIds)
+    const QString prefix("mavlink/");
+    const QSet<QString> taggedIds = PlotSignalRegistry::instance().taggedIdsByPrefix(prefix);
+    for (const QString& id : taggedIds)
     {
-        const QString fieldPath = id.mid(base.size()); // e.g., "x" or "x[2]"
+        const QStringList parts = id.mid(prefix.size()).split('/');
+        if (parts.size() != 4) continue;
+        bool ok_sys = false, ok_comp = false, ok_msg = false;
+        const uint sysid = parts[0].toUInt(&ok_sys);
+        const uint compid = parts[1].toUInt(&ok_comp);
+        const uint msgid = parts[2].toUInt(&ok_msg);
+        if (!ok_sys || !ok_comp || !ok_msg || sysid > 255 || compid > 255) continue;
+
+        const mavlink_message_info_t* mi = mavlink_get_message_info_by_id(msgid);
+        if (!mi) continue;
 
         // Parse name and optional index
+        const QString& fieldPath = parts[3]; // e.g., "x" or "x[2]"
         QString fieldName = fieldPath;
         int idx = 0;
         bool hasIndex = false;
@@ -482,11 +694,12 @@ static void appendTaggedSamplesFromMessage(const mavlink_message_t* msg, qint64
         }
 
         // Locate field by name
+        const QByteArray fieldName_ = fieldName.toLatin1();
         const mavlink_field_info_t* fMatch = nullptr;
         for (unsigned i = 0; i < mi->num_fields; ++i) {
-            if (QString::fromLatin1(mi->fields[i].name) == fieldName) { fMatch = &mi->fields[i]; break; }
+            if (std::strcmp(mi->fields[i].name, fieldName_.constData()) == 0) { fMatch = &mi->fields[i]; break; }
         }
-        if (!fMatch) continue;
+        if (!fMatch || fMatch->type == MAVLINK_TYPE_CHAR) continue;
 
         // Validate index
         if (fMatch->array_length == 0) {
@@ -497,24 +710,64 @@ static void appendTaggedSamplesFromMessage(const mavlink_message_t* msg, qint64
             if (idx < 0 || idx >= fMatch->array_length) continue;
         }
 
-        double value = 0.0;
-        if (!mav_extract_numeric_field(msg, fMatch, idx, value)) continue;
+        plot_field_plan plan;
+        plan.handle = PlotSignalRegistry::instance().handleOf(id);
+        if (plan.handle == kInvalidPlotSignalHandle) continue; // untagged since the snapshot
+        plan.offset = fMatch->wire_offset + static_cast<unsigned>(idx) * mav_type_size(fMatch->type);
+        plan.type = fMatch->type;
+        plot_plans_[message_key(sysid, compid, msgid)].push_back(plan);
+        plan_ids.insert(id);
+
+        // Newly tagged field: seed the plot with what the message history already holds
+        if (!plot_plan_ids_.contains(id))
+        {
+            mavlink_data_aggregator* msg_aggr = find_aggregator(static_cast<uint8_t>(sysid), static_cast<uint8_t>(compid));
+            QVector<PlotSignalSample> samples;
+            if (msg_aggr != nullptr && msg_aggr->get_field_history(msgid, plan.offset, plan.type, std::numeric_limits<qint64>::min(), backfill_before_ns - 1, samples) > 0)
+            {
+                PlotSignalRegistry::instance().appendSamples(plan.handle, samples);
+            }
+        }
+    }
+    plot_plan_ids_ = plan_ids;
+}
+
+void mavlink_manager::append_plot_samples(const mavlink_message_t* msg, qint64 t_ns)
+{
+    if (PlotSignalRegistry::instance().tagGeneration() != plot_plans_generation_) rebuild_plot_plans(t_ns);
+    if (plot_plans_.isEmpty()) return;
 
-        const qint64 t_ns = msg_time_ms * 1000000LL;
-        PlotSignalRegistry::instance().appendSample(id, t_ns, value);
+    auto it = plot_plans_.constFind(message_key(msg->sysid, msg->compid, msg->msgid));
+    if (it == plot_plans_.constEnd()) return;
+
+    plot_batch_.clear();
+    for (const plot_field_plan& plan : it.value())
+    {
+        double value = 0.0;
+        if (!mav_extract_numeric_field(msg, plan.type, plan.offset, value)) continue;
+        plot_batch_.append(PlotSignalTuple{ plan.handle, t_ns, value });
     }
+    PlotSignalRegistry::instance().appendBatch(plot_batch_);
 }
 
 void mavlink_manager::clear(void)
 {
     mutex->lock();
-    while(msgs.count() > 0)
+    // Unpublish everything, but keep the aggregators alive: lock-free readers
+    // may still hold a pointer. They are revived if the same component shows up again.
+    for (mavlink_data_aggregator* msg_aggr : msgs)
     {
-        auto tmp = msgs.takeLast();
-        tmp->clear();
-        delete tmp;
+        component_table* table = index_[msg_aggr->sysid].load(std::memory_order_relaxed);
+        table->by_compid[static_cast<uint8_t>(msg_aggr->compid)].store(nullptr, std::memory_order_release);
+        table->compids.clear();
+        msg_aggr->clear();
+        retired_.insert(static_cast<quint16>((msg_aggr->sysid << 8) | static_cast<uint8_t>(msg_aggr->compid)), msg_aggr);
     }
+    msgs.clear();
+    sysids_.clear();
     mutex->unlock();
+    // slots are owned by the aggregation thread; it resets them before the next message
+    vehicle_states_reset_.store(true, std::memory_order_release);
 }
 
 unsigned int mavlink_manager::get_n()
@@ -525,294 +778,529 @@ unsigned int mavlink_manager::get_n()
     return out;
 }
 
-bool mavlink_manager::is_new(mavlink_message_t* new_msg)
+mavlink_data_aggregator* mavlink_manager::find_aggregator(uint8_t sys_id_, uint8_t comp_id_) const
 {
-    unsigned int i;
-    return is_new(new_msg, i);
+    const component_table* table = index_[sys_id_].load(std::memory_order_acquire);
+    if (table == nullptr) return nullptr;
+    return table->by_compid[comp_id_].load(std::memory_order_acquire);
 }
 
-bool mavlink_manager::is_new(mavlink_message_t* new_msg, unsigned int& i)
-{
-    return !get_ind(i, new_msg->sysid, mavlink_enums::mavlink_component_id(new_msg->compid));
-}
-bool mavlink_manager::get_ind(unsigned int& i, uint8_t sys_id_, mavlink_enums::mavlink_component_id mav_component_)
+mavlink_data_aggregator* mavlink_manager::add_aggregator(uint8_t sys_id_, uint8_t comp_id_, bool &sysid_is_new, bool &compid_is_new)
 {
     mutex->lock();
-    for(i = 0; i < msgs.count(); i++)
+    // another caller may have published it while we were not holding the lock
+    mavlink_data_aggregator* msg_aggr = find_aggregator(sys_id_, comp_id_);
+    if (msg_aggr != nullptr)
     {
-        if (sys_id_ == msgs[i]->sysid && mav_component_ == msgs[i]->compid)
-        {
-            mutex->unlock();
-            return true;
-        }
+        mutex->unlock();
+        sysid_is_new = compid_is_new = false;
+        return msg_aggr;
+    }
+
+    component_table* table = index_[sys_id_].load(std::memory_order_relaxed);
+    if (table == nullptr)
+    {
+        table = new component_table;
+        index_[sys_id_].store(table, std::memory_order_release);
     }
+    sysid_is_new = table->compids.isEmpty();
+    compid_is_new = true;
+    if (sysid_is_new) sysids_.push_back(sys_id_);
+
+    msg_aggr = retired_.take(static_cast<quint16>((sys_id_ << 8) | comp_id_));
+    if (msg_aggr == nullptr)
+    {
+        // created on the aggregation thread, so no QObject parent; owned by the manager
+        msg_aggr = new mavlink_data_aggregator(nullptr, sys_id_, mavlink_enums::mavlink_component_id(comp_id_));
+    }
+    msg_aggr->set_history_window(history_window_ns_);
+    table->compids.push_back(mavlink_enums::mavlink_component_id(comp_id_));
+    msgs.push_back(msg_aggr);
+    table->by_compid[comp_id_].store(msg_aggr, std::memory_order_release);
     mutex->unlock();
-    return false;
+    return msg_aggr;
 }
 
 QVector<uint8_t> mavlink_manager::get_sysids(void)
 {
-    QVector<uint8_t> sysid_list;
-    foreach (mavlink_data_aggregator* msg_aggr, msgs)
-    {
-        bool is_old_ = false;
-        foreach (uint8_t sysid, sysid_list)
-        {
-            if (sysid == msg_aggr->sysid)
-            {
-                is_old_ = true;
-                break;
-            }
-        }
-        if (!is_old_) sysid_list.push_back(msg_aggr->sysid);
-    }
+    mutex->lock();
+    QVector<uint8_t> sysid_list = sysids_;
+    mutex->unlock();
     return sysid_list;
 }
 QVector<mavlink_enums::mavlink_component_id> mavlink_manager::get_compids(uint8_t sysid)
 {
     QVector<mavlink_enums::mavlink_component_id> compid_list;
-    foreach (mavlink_data_aggregator* msg_aggr, msgs)
+    mutex->lock();
+    const component_table* table = index_[sysid].load(std::memory_order_relaxed);
+    if (table != nullptr) compid_list = table->compids;
+    mutex->unlock();
+    return compid_list;
+}
+
+bool mavlink_manager::update(void* message, qint64 msg_time_stamp)
+{
+    if (message == NULL) return false;
+    const mavlink_message_t* msg = static_cast<const mavlink_message_t*>(message);
+    // only the header and the received payload bytes go through the ring
+    const bool pushed = ingest_.push_with([msg, msg_time_stamp](ingest_entry& entry) {
+        mavlink_packed::pack(*msg, entry.packed);
+        entry.t_ns = msg_time_stamp;
+    });
+    if (!pushed)
+    {
+        ingest_dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    aggregation_thread_->wake();
+    return true;
+}
+
+bool mavlink_manager::process_message(const mavlink_message_t& msg, qint64 t_ns)
+{
+    mavlink_message_t* msg_cast_ = const_cast<mavlink_message_t*>(&msg);
+
+    mavlink_data_aggregator* msg_aggr = find_aggregator(msg.sysid, msg.compid);
+    bool sysid_is_new = false, compid_is_new = false;
+    if (msg_aggr == nullptr)
+    {
+        // do not create components for frames we cannot decode
+        if (mavlink_get_message_info(msg_cast_) == NULL) return false;
+        msg_aggr = add_aggregator(msg.sysid, msg.compid, sysid_is_new, compid_is_new);
+    }
+
+    const bool res = msg_aggr->update(msg_cast_, t_ns);
+    // Append samples for any tagged fields from this message
+    if (res)
+    {
+        append_plot_samples(&msg, t_ns);
+        update_vehicle_state(msg, t_ns);
+        dispatch_to_sinks(msg, t_ns);
+    }
+
+    if (sysid_is_new) emit sysid_list_changed(get_sysids());
+    if (compid_is_new) emit compid_list_changed(msg.sysid, get_compids(msg.sysid));
+
+    return res;
+}
+
+// aggregation thread only
+void mavlink_manager::update_vehicle_state(const mavlink_message_t& msg, qint64 t_ns)
+{
+    if (vehicle_states_reset_.exchange(false, std::memory_order_acq_rel))
     {
-        if (msg_aggr->sysid == sysid)
+        for (auto& slot_ptr : vehicle_states_)
         {
-            bool is_old_ = false;
-            foreach (mavlink_enums::mavlink_component_id compid, compid_list)
-            {
-                if (compid == msg_aggr->compid)
-                {
-                    is_old_ = true;
-                    break;
-                }
-            }
-            if (!is_old_) compid_list.push_back(msg_aggr->compid);
+            vehicle_state_slot* slot = slot_ptr.load(std::memory_order_relaxed);
+            if (slot == nullptr) continue;
+            slot->reset();
+            slot->publish();
         }
     }
-    return compid_list;
+
+    vehicle_state_slot* slot = vehicle_states_[msg.sysid].load(std::memory_order_relaxed);
+    if (slot == nullptr)
+    {
+        slot = new vehicle_state_slot(msg.sysid);
+        vehicle_states_[msg.sysid].store(slot, std::memory_order_release);
+    }
+    slot->track(msg, t_ns);
+    slot->publish();
+}
+
+void mavlink_manager::subscribe(uint32_t msgid, mavlink_message_sink* sink)
+{
+    if (sink == nullptr) return;
+    sink_mutex_.lock();
+    QVector<mavlink_message_sink*>& sinks = sinks_[msgid];
+    if (!sinks.contains(sink)) sinks.append(sink);
+    const uint32_t bit = msgid % sink_filter_bits;
+    sink_filter_[bit / 64].fetch_or(1ull << (bit % 64), std::memory_order_release);
+    sink_mutex_.unlock();
+}
+
+void mavlink_manager::unsubscribe(mavlink_message_sink* sink)
+{
+    // dispatch holds sink_mutex_, so no call into sink is in flight once this returns
+    sink_mutex_.lock();
+    for (auto it = sinks_.begin(); it != sinks_.end();)
+    {
+        it.value().removeAll(sink);
+        if (it.value().isEmpty()) it = sinks_.erase(it);
+        else ++it;
+    }
+    // stale filter bits only cost a lookup; rebuild them anyway
+    quint64 filter[sink_filter_bits / 64] = {};
+    for (auto it = sinks_.cbegin(); it != sinks_.cend(); ++it)
+    {
+        const uint32_t bit = it.key() % sink_filter_bits;
+        filter[bit / 64] |= 1ull << (bit % 64);
+    }
+    for (uint32_t i = 0; i < sink_filter_bits / 64; i++) sink_filter_[i].store(filter[i], std::memory_order_release);
+    sink_mutex_.unlock();
+}
+
+// aggregation thread only
+void mavlink_manager::dispatch_to_sinks(const mavlink_message_t& msg, qint64 t_ns)
+{
+    const uint32_t bit = msg.msgid % sink_filter_bits;
+    if ((sink_filter_[bit / 64].load(std::memory_order_acquire) & (1ull << (bit % 64))) == 0) return;
+
+    sink_mutex_.lock();
+    auto it = sinks_.constFind(msg.msgid);
+    if (it != sinks_.cend())
+    {
+        for (mavlink_message_sink* sink : it.value()) sink->on_message(msg, t_ns);
+    }
+    sink_mutex_.unlock();
 }
 
-bool mavlink_manager::update(void* message, qint64 msg_time_stamp)
-{
-    if (message == NULL) return false;
-    unsigned int matching_entry;
-    mavlink_message_t* msg_cast_ = static_cast<mavlink_message_t*>(message); //incomming message was dynamically allocated
+bool mavlink_manager::get_vehicle_state(uint8_t sysid, vehicle_state &state_out) const
+{
+    const vehicle_state_slot* slot = vehicle_states_[sysid].load(std::memory_order_acquire);
+    if (slot == nullptr) return false;
+    slot->read(state_out);
+    return state_out.rx_count > 0;
+}
+
+void mavlink_manager::relay_updated(QVector<quint64> changed_keys)
+{
+    // names are resolved here, only for what is about to be displayed
+    for (const quint64 key : changed_keys)
+    {
+        const uint32_t msgid = static_cast<uint32_t>(key & 0xFFFFFF);
+        const mavlink_message_info_t* info = mavlink_get_message_info_by_id(msgid);
+        if (info == NULL) continue;
+        emit updated(static_cast<uint8_t>(key >> 32), mavlink_enums::mavlink_component_id(static_cast<uint8_t>(key >> 24)), QString::fromLatin1(info->name));
+    }
+}
+
+bool mavlink_manager::get_msg(uint8_t sys_id_, mavlink_enums::mavlink_component_id mav_component_, QString msg_name, void *msg_out, message_rate_stats &stats_out)
+{
+    mavlink_data_aggregator* msg_aggr = find_aggregator(sys_id_, static_cast<uint8_t>(mav_component_));
+    if (msg_aggr == nullptr) return false;
+    return msg_aggr->get_msg(msg_name, msg_out, stats_out);
+}
+
+bool mavlink_manager::get_streams(uint8_t sysid, uint8_t compid, QVector<mavlink_stream_info> &streams_out)
+{
+    mavlink_data_aggregator* msg_aggr = find_aggregator(sysid, compid);
+    if (msg_aggr == nullptr) return false;
+    return msg_aggr->get_all(streams_out);
+}
+
+bool mavlink_manager::get_msg_at(uint8_t sys_id_, mavlink_enums::mavlink_component_id mav_component_, QString msg_name, qint64 t_ns, void *msg_out, qint64 &t_ns_out)
+{
+    mavlink_data_aggregator* msg_aggr = find_aggregator(sys_id_, static_cast<uint8_t>(mav_component_));
+    if (msg_aggr == nullptr) return false;
+    const mavlink_message_info_t* info = mavlink_get_message_info_by_name(msg_name.toLatin1().constData());
+    if (info == NULL) return false;
+    return msg_aggr->get_msg_at(info->msgid, t_ns, msg_out, t_ns_out);
+}
+
+void mavlink_manager::update_kgroundcontrol_settings(kgroundcontrol_settings* kground_control_settings_in_)
+{
+    mutex->lock();
+    kgroundcontrol_settings_ = *kground_control_settings_in_;
+    const qint64 window_ns = static_cast<qint64>(std::max(kgroundcontrol_settings_.mavlink_history_duration_sec, 0.0) * 1.0E9);
+    if (window_ns != history_window_ns_)
+    {
+        history_window_ns_ = window_ns;
+        for (mavlink_data_aggregator* msg_aggr : msgs) msg_aggr->set_history_window(window_ns);
+        for (mavlink_data_aggregator* msg_aggr : retired_) msg_aggr->set_history_window(window_ns);
+    }
+    mutex->unlock();
+}
+
+
+
+mavlink_aggregation_thread::mavlink_aggregation_thread(mavlink_manager* manager, generic_thread_settings* new_settings)
+    : generic_thread(manager, new_settings), manager_(manager)
+{
+    setObjectName("mavlink_aggregation");
+}
+
+mavlink_aggregation_thread::~mavlink_aggregation_thread()
+{
+    requestInterruption();
+    wake();
+    wait();
+}
+
+void mavlink_aggregation_thread::wake(void)
+{
+    // pairs with the fence in run(): either we see waiting_ or the consumer sees our push
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!waiting_.load(std::memory_order_relaxed)) return;
+    wake_mutex_.lock();
+    wake_cond_.wakeOne();
+    wake_mutex_.unlock();
+}
+
+void mavlink_aggregation_thread::run()
+{
+    mutex->lock();
+    const qint64 flush_period_ns = static_cast<qint64>(1.0E9 / static_cast<double>(qMax(1u, generic_thread_settings_.update_rate_hz)));
+    mutex->unlock();
+
+    QSet<quint64> pending;
+    qint64 next_flush_ns = time_base::now_ns() + flush_period_ns;
+    mavlink_message_t msg;
+    qint64 t_ns = 0;
+    const auto unpack_entry = [&msg, &t_ns](const mavlink_manager::ingest_entry& entry) {
+        mavlink_packed::unpack(entry.packed, msg);
+        t_ns = entry.t_ns;
+    };
 
-    if (is_new(msg_cast_, matching_entry))
+    while (!isInterruptionRequested())
     {
-        bool sysid_is_old = false, compid_is_old = false;
-        if (msgs.count() > 0)
+        // drain everything the producers have pushed so far
+        while (manager_->ingest_.pop_with(unpack_entry))
         {
-            foreach (mavlink_data_aggregator* msg_aggr, msgs)
+            if (manager_->process_message(msg, t_ns))
+                pending.insert(mavlink_manager::message_key(msg.sysid, msg.compid, msg.msgid));
+        }
+
+        const qint64 now_ns = time_base::now_ns();
+        if (now_ns >= next_flush_ns)
+        {
+            if (!pending.isEmpty())
             {
-                if (msg_aggr->sysid == msg_cast_->sysid)
-                {
-                    sysid_is_old = true;
-                    if (msg_aggr->compid == msg_cast_->compid)
-                    {
-                        compid_is_old = true;
-                        break;
-                    }
-                }
+                emit changed(QVector<quint64>(pending.begin(), pending.end()));
+                pending.clear();
             }
+            next_flush_ns = now_ns + flush_period_ns;
         }
 
-        mavlink_data_aggregator* new_msg_aggregator = new mavlink_data_aggregator(this, msg_cast_->sysid, mavlink_enums::mavlink_component_id(msg_cast_->compid));
-    // Aggregator may live in different thread; relay via queued connection
-    connect(new_msg_aggregator, &mavlink_data_aggregator::updated, this, &mavlink_manager::relay_updated, Qt::QueuedConnection);
-
-        if (new_msg_aggregator->update(message, msg_time_stamp))
+        // sleep until new data or the next flush, whichever comes first
+        waiting_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        wake_mutex_.lock();
+        if (manager_->ingest_.empty() && !isInterruptionRequested())
         {
-            // Append samples for any tagged fields from this message
-            appendTaggedSamplesFromMessage(msg_cast_, msg_time_stamp);
-            mutex->lock();
-            msgs.push_back(new_msg_aggregator);            
-            mutex->unlock();
+            const qint64 wait_ns = qMax<qint64>(next_flush_ns - time_base::now_ns(), 0);
+            wake_cond_.wait(&wake_mutex_, QDeadlineTimer(std::chrono::nanoseconds{wait_ns}, Qt::PreciseTimer));
+        }
+        wake_mutex_.unlock();
+        waiting_.store(false, std::memory_order_relaxed);
+    }
+}
 
-            if (!sysid_is_old) emit sysid_list_changed(get_sysids());
-            if (!compid_is_old) emit compid_list_changed(msg_cast_->sysid, get_compids(msg_cast_->sysid));
-            delete msg_cast_;
 
 
-            return true;
-        }
-        else delete new_msg_aggregator;
-    }
-    else
-    {
-    // Existing aggregator updated; also append any tagged samples
-    bool res = msgs[matching_entry]->update(msg_cast_, msg_time_stamp);
-    appendTaggedSamplesFromMessage(msg_cast_, msg_time_stamp);
-        delete msg_cast_;
-        return res;
-    }
-    delete msg_cast_;
-    return false;
+
+mavlink_inspector_thread::mavlink_inspector_thread(QObject* parent, generic_thread_settings* new_settings)
+    : periodic_task(parent, new_settings)
+{
+    start(generic_thread_settings_.priority);
 }
-void mavlink_manager::relay_updated(uint8_t sysid_out, mavlink_enums::mavlink_component_id compid_out, QString msg_name)
+
+mavlink_inspector_thread::~mavlink_inspector_thread()
 {
-    emit updated(sysid_out, compid_out, msg_name);
+    periodic_scheduler::instance().remove_and_wait(this);
 }
 
-bool mavlink_manager::toggle_arm_state(QString port_name, uint8_t sys_id_, mavlink_enums::mavlink_component_id mav_component_, bool flag, bool force)
+void mavlink_inspector_thread::tick()
 {
-    mutex->lock();
-    emit get_kgroundcontrol_settings(&kgroundcontrol_settings_);
+    emit update_all_visuals();
+}
+
 
-    // Prepare command for off-board mode
-    mavlink_command_long_t com = { 0 };
-    com.target_system    = sys_id_;
-    com.target_component = mav_component_;
 
-    com.command = MAV_CMD::MAV_CMD_COMPONENT_ARM_DISARM;
-    com.confirmation = 0;
-    com.param1 = (float) flag;
-    if (force) com.param2 = 21196;
+mavlink_inspector_model::mavlink_inspector_model(QObject* parent)
+    : QAbstractTableModel(parent)
+{
 
-    // Encode
-    mavlink_message_t message;
-    mavlink_msg_command_long_encode(kgroundcontrol_settings_.sysid, kgroundcontrol_settings_.compid, &message, &com);
+}
+
+mavlink_inspector_model::~mavlink_inspector_model()
+{
 
-    // Send the message
-    if (emit write_message(port_name, &message) > 0)
-    {
-        mutex->unlock();
-        return true;
-    }
-    else
-    {
-        mutex->unlock();
-        return false;
-    }
 }
-bool mavlink_manager::get_msg(uint8_t sys_id_, mavlink_enums::mavlink_component_id mav_component_, QString msg_name, void *msg_out, CQueue<qint64> &timestamps_out)
+
+int mavlink_inspector_model::rowCount(const QModelIndex &parent) const
 {
-    unsigned int i;
-    if (get_ind(i, sys_id_, mav_component_))
-    {
-        mutex->lock();
-        msgs[i]->get_msg(msg_name, msg_out, timestamps_out);
-        mutex->unlock();
-        return true;
-    }
-    return false;
+    if (parent.isValid()) return 0;
+    return rows_.size();
 }
 
-void mavlink_manager::update_kgroundcontrol_settings(kgroundcontrol_settings* kground_control_settings_in_)
+int mavlink_inspector_model::columnCount(const QModelIndex &parent) const
 {
-    mutex->lock();
-    kgroundcontrol_settings_ = *kground_control_settings_in_;
-    mutex->unlock();
+    if (parent.isValid()) return 0;
+    return COLUMN_COUNT;
 }
 
+double mavlink_inspector_model::display_rate_hz(const message_rate_stats &stats, qint64 now_ns)
+{
+    const qint64 timeout_ns = 2500000000LL;  // start artificial decay after 2.5s without new messages
+    const double linear_decay_hz_per_s = 1.0; // drop 1.0 Hz per second
 
+    // a single message so far carries no rate
+    if (stats.intervals < 1) return 0.0;
 
+    double rate = stats.rate_hz;
+    const qint64 age_ns = now_ns - stats.last_ns;
+    if (age_ns > timeout_ns)
+    {
+        rate -= linear_decay_hz_per_s * static_cast<double>(age_ns - timeout_ns) * 1.0E-9;
+    }
 
-mavlink_inspector_thread::mavlink_inspector_thread(QObject* parent, generic_thread_settings* new_settings)
-    : generic_thread(parent, new_settings)
-{
-    start(generic_thread_settings_.priority);
+    // Cleanly clamp tiny values to zero
+    if (rate < 0.05) rate = 0.0;
+    return rate;
 }
 
-mavlink_inspector_thread::~mavlink_inspector_thread()
+QVariant mavlink_inspector_model::data(const QModelIndex &index, int role) const
 {
+    if (!index.isValid() || index.row() >= rows_.size()) return QVariant();
+    const row_entry &entry = rows_[index.row()];
+
+    switch (role)
+    {
+    case Qt::DisplayRole:
+        if (index.column() == COLUMN_RATE)
+        {
+            return QString("%1Hz").arg(display_rate_hz(entry.stats, display_time_ns_), 0, 'f', 1);
+        }
+        if (index.column() == COLUMN_NAME) return entry.name;
+        break;
+    case Qt::TextAlignmentRole:
+        if (index.column() == COLUMN_RATE) return QVariant(Qt::AlignRight | Qt::AlignVCenter);
+        return QVariant(Qt::AlignLeft | Qt::AlignVCenter);
+    case Qt::CheckStateRole:
+        if (index.column() == COLUMN_NAME) return entry.checked ? Qt::Checked : Qt::Unchecked;
+        break;
+    case Qt::ToolTipRole:
+        if (index.column() == COLUMN_RATE) return entry.stats.get_QString();
+        break;
+    default:
+        break;
+    }
+    return QVariant();
 }
 
-void mavlink_inspector_thread::run()
+QVariant mavlink_inspector_model::headerData(int section, Qt::Orientation orientation, int role) const
 {
-    while (!(QThread::currentThread()->isInterruptionRequested()))// && mav_inspector->isVisible())
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) return QVariant();
+    switch (section)
     {
-        emit update_all_visuals();
-        sleep(std::chrono::nanoseconds{static_cast<uint64_t>(1.0E9/static_cast<double>(generic_thread_settings_.update_rate_hz))});
+    case COLUMN_RATE:
+        return QString("Rate");
+    case COLUMN_NAME:
+        return QString("Message");
+    default:
+        return QVariant();
     }
 }
 
-
-
-MavlinkInspectorMSG::MavlinkInspectorMSG(QWidget *parent, uint8_t sysid_in, mavlink_enums::mavlink_component_id compid_in, QString name_in)
-    : QWidget(parent), sysid(sysid_in), compid(compid_in), name(name_in)
-    , ui(new Ui::MavlinkInspectorMSG)    
+Qt::ItemFlags mavlink_inspector_model::flags(const QModelIndex &index) const
 {
-    ui->setupUi(this);
-    mutex = new QMutex;
-    ui->pushButton->setStyleSheet("text-align:left;");
-    QString tmp_name = QString("%1").arg(QString("%1Hz %2").arg(0.0,-6, 'f', 1, ' ').arg(name, 30, ' '), 30 + 3 + 5, ' ');
-    ui->pushButton->setText(tmp_name);
+    if (!index.isValid()) return Qt::NoItemFlags;
+    // rows are toggled by clicking anywhere on them (see MavlinkInspector), not via the indicator
+    return Qt::ItemIsEnabled | Qt::ItemNeverHasChildren;
+}
 
-    // No inline tree under each message anymore; toggling just marks selection
-    connect(ui->pushButton, &QPushButton::toggled, this, [this](bool){ emit updated(); });
+bool mavlink_inspector_model::contains(const QString &name) const
+{
+    return row_by_name_.contains(name);
 }
 
-MavlinkInspectorMSG::~MavlinkInspectorMSG()
+int mavlink_inspector_model::find_row(const QString &name) const
 {
-    delete ui;
-    delete mutex;
+    return row_by_name_.value(name, -1);
 }
 
-bool MavlinkInspectorMSG::update(void* mavlink_msg_in, double update_rate_hz)
+void mavlink_inspector_model::add_row(uint8_t sysid, mavlink_enums::mavlink_component_id compid, const QString &name)
 {
-    if (mavlink_msg_in == NULL) return false;
-    mutex->lock();
-    mavlink_message_t tmp_msg;
-    memcpy(&tmp_msg, static_cast<mavlink_message_t*>(mavlink_msg_in), sizeof(*(static_cast<mavlink_message_t*>(mavlink_msg_in))));
-    QString msg_name;
-    if (mavlink_data_aggregator::print_name(msg_name, &tmp_msg) && tmp_msg.sysid == sysid && tmp_msg.compid == compid && msg_name == name)
-    {        
-        memcpy(&msg, &tmp_msg, sizeof(tmp_msg));
-        update_rate_hz_last = update_rate_hz;
-    QString tmp_name = QString("%1").arg(QString("%1Hz %2").arg(update_rate_hz,-6, 'f', 1, ' ').arg(name, 30, ' '), 30 + 3 + 5, ' ');
-        ui->pushButton->setText(tmp_name);
-        update_scheduled = false;
-    // Row-only update; detailed view is rendered in the bottom panel
-        mutex->unlock();
-        emit updated();
-        return true;
-    }
-    mutex->unlock();
-    return false;
+    if (row_by_name_.contains(name)) return;
+
+    const int row = rows_.size();
+    beginInsertRows(QModelIndex(), row, row);
+    row_entry entry;
+    entry.sysid = sysid;
+    entry.compid = compid;
+    entry.name = name;
+    memset(&entry.msg, 0, sizeof(entry.msg));
+    rows_.push_back(entry);
+    row_by_name_.insert(name, row);
+    endInsertRows();
 }
 
-void MavlinkInspectorMSG::get_msg(void* mavlink_msg_out)
+void mavlink_inspector_model::clear_rows(void)
 {
-    mutex->lock();
-    memcpy(static_cast<mavlink_message_t*>(mavlink_msg_out), &msg, sizeof(msg));
-    mutex->unlock();
+    beginResetModel();
+    rows_.clear();
+    row_by_name_.clear();
+    checked_count_ = 0;
+    endResetModel();
 }
 
-double MavlinkInspectorMSG::get_last_hz(void)
+bool mavlink_inspector_model::refresh_rows(int first, int last, qint64 now_ns, const fetch_function &fetch)
 {
-    return update_rate_hz_last;
+    display_time_ns_ = now_ns;
+    first = std::max(first, 0);
+    last = std::min(last, static_cast<int>(rows_.size()) - 1);
+    if (first > last || !fetch) return false;
+
+    for (int i = first; i <= last; i++)
+    {
+        row_entry &entry = rows_[i];
+        mavlink_message_t msg_;
+        message_rate_stats stats_;
+        // keep the cached copy when the stream is gone (e.g. after a manager clear)
+        if (fetch(entry.sysid, entry.compid, entry.name, msg_, stats_))
+        {
+            entry.msg = msg_;
+            entry.stats = stats_;
+        }
+    }
+
+    // only the rate text changes between ticks
+    emit dataChanged(index(first, COLUMN_RATE), index(last, COLUMN_RATE), {Qt::DisplayRole, Qt::ToolTipRole});
+    return true;
 }
 
-bool MavlinkInspectorMSG::is_button_checked(void)
+bool mavlink_inspector_model::get_msg(int row, mavlink_message_t &msg_out) const
 {
-    return ui->pushButton->isChecked();
+    if (row < 0 || row >= rows_.size()) return false;
+    msg_out = rows_[row].msg;
+    return true;
 }
-bool MavlinkInspectorMSG::is_update_scheduled(void)
+
+void mavlink_inspector_model::toggle_checked(int row)
 {
-    bool out;
-    mutex->lock();
-    out = update_scheduled;
-    mutex->unlock();
-    return out;
+    if (row < 0 || row >= rows_.size()) return;
+    row_entry &entry = rows_[row];
+    entry.checked = !entry.checked;
+    checked_count_ += entry.checked ? 1 : -1;
+    const QModelIndex idx = index(row, COLUMN_NAME);
+    emit dataChanged(idx, idx, {Qt::CheckStateRole});
 }
-bool MavlinkInspectorMSG::schedule_update(uint8_t sysid_, mavlink_enums::mavlink_component_id compid_, QString msg_name)
+
+QVector<int> mavlink_inspector_model::checked_rows(void) const
 {
-    if (sysid == sysid_ && compid == compid_ && name == msg_name)
+    QVector<int> out;
+    if (checked_count_ < 1) return out;
+    out.reserve(checked_count_);
+    for (int i = 0; i < rows_.size(); i++)
     {
-        mutex->lock();
-        update_scheduled = true;
-        mutex->unlock();
-        return true;
+        if (rows_[i].checked) out.push_back(i);
     }
+    return out;
+}
 
-    return false;
+QString mavlink_inspector_model::name(int row) const
+{
+    if (row < 0 || row >= rows_.size()) return QString();
+    return rows_[row].name;
 }
-QString MavlinkInspectorMSG::get_QString(void)
+
+bool mavlink_inspector_model::get_stream(int row, uint8_t &sysid, mavlink_enums::mavlink_component_id &compid) const
 {
-    QString txt;
-    mutex->lock();
-    mavlink_data_aggregator::print_message(txt, &msg);
-    mutex->unlock();
-    return txt;
+    if (row < 0 || row >= rows_.size()) return false;
+    sysid = rows_[row].sysid;
+    compid = rows_[row].compid;
+    return true;
 }
 
 // Build a stable path for a tree item based on its ancestry
@@ -875,44 +1363,140 @@ static inline bool isNumericMavType(uint8_t t)
     }
 }
 
-// Fast path: update only Value cells, keep Plot checkbox widgets intact
-static void updateDetailTreeValues(QTreeWidget* tree, const QVector<QPair<QString, mavlink_message_t>>& entries)
+mavlink_detail_tree::mavlink_detail_tree(QTreeWidget* tree, QObject* parent)
+    : QObject(parent), tree_(tree)
 {
-    if (!tree) return;
-    if (tree->topLevelItemCount() != entries.size()) return;
-    for (int mIdx = 0; mIdx < entries.size(); ++mIdx) {
-        QTreeWidgetItem* root = tree->topLevelItem(mIdx);
-        if (!root) continue;
-        const mavlink_message_t& m = entries[mIdx].second;
-        const mavlink_message_info_t* mi = mavlink_get_message_info(const_cast<mavlink_message_t*>(&m));
-        if (!mi) continue;
-        for (unsigned i = 0; i < mi->num_fields; ++i) {
-            const mavlink_field_info_t* f = &mi->fields[i];
-            QTreeWidgetItem* item = root->child(static_cast<int>(i));
-            if (!item) continue;
-            if (f->array_length == 0) {
-                const QString v = mavlink_data_aggregator::print_one_field(const_cast<mavlink_message_t*>(&m), f, 0);
-                if (item->text(1) != v) item->setText(1, v);
-            } else {
-                for (int idx = 0; idx < f->array_length; ++idx) {
-                    QTreeWidgetItem* child = item->child(idx);
-                    if (!child) continue;
-                    const QString v = mavlink_data_aggregator::print_one_field(const_cast<mavlink_message_t*>(&m), f, idx);
-                    if (child->text(1) != v) child->setText(1, v);
+    if (!tree_) return;
+    connect(tree_, &QTreeWidget::itemExpanded, this, &mavlink_detail_tree::flush_visible);
+    if (tree_->verticalScrollBar())
+        connect(tree_->verticalScrollBar(), &QScrollBar::valueChanged, this, &mavlink_detail_tree::flush_visible);
+    tree_->viewport()->installEventFilter(this);
+}
+
+mavlink_detail_tree::~mavlink_detail_tree()
+{
+
+}
+
+bool mavlink_detail_tree::eventFilter(QObject* watched, QEvent* event)
+{
+    if (tree_ && watched == tree_->viewport() && event->type() == QEvent::Resize)
+    {
+        // a taller viewport can uncover cells that went dirty while hidden
+        QMetaObject::invokeMethod(this, &mavlink_detail_tree::flush_visible, Qt::QueuedConnection);
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void mavlink_detail_tree::clear(void)
+{
+    groups_.clear();
+    if (tree_) tree_->clear();
+}
+
+void mavlink_detail_tree::update(const QVector<QPair<QString, mavlink_message_t>> &entries)
+{
+    if (!tree_) return;
+
+    bool same_layout = !groups_.isEmpty() && groups_.size() == entries.size();
+    for (int i = 0; same_layout && i < entries.size(); i++)
+    {
+        const mavlink_message_t &a = groups_[i].msg;
+        const mavlink_message_t &b = entries[i].second;
+        same_layout = groups_[i].title == entries[i].first && a.sysid == b.sysid && a.compid == b.compid && a.msgid == b.msgid;
+    }
+    if (!same_layout)
+    {
+        rebuild(entries);
+        return;
+    }
+
+    bool any_dirty = false;
+    for (int i = 0; i < entries.size(); i++)
+    {
+        message_group &group = groups_[i];
+        const mavlink_message_t &m = entries[i].second;
+        const char* old_payload = _MAV_PAYLOAD(&group.msg);
+        const char* new_payload = _MAV_PAYLOAD(&m);
+
+        // unchanged message: nothing to compare, nothing to format
+        if (memcmp(old_payload, new_payload, group.payload_extent) == 0) continue;
+
+        for (field_group &field : group.fields)
+        {
+            for (field_cell &cell : field.cells)
+            {
+                if (cell.dirty) continue;
+                if (memcmp(old_payload + cell.offset, new_payload + cell.offset, cell.size) != 0)
+                {
+                    cell.dirty = true;
+                    group.dirty_count++;
                 }
             }
         }
+        memcpy(&group.msg, &m, sizeof(m));
+        any_dirty = any_dirty || group.dirty_count > 0;
+    }
+
+    if (any_dirty) flush_visible();
+}
+
+void mavlink_detail_tree::format_cell(message_group &group, const field_group &field, field_cell &cell)
+{
+    const mavlink_field_info_t* f = field.info;
+    const QString v = mavlink_data_aggregator::print_one_field(&group.msg, f, cell.idx);
+    if (cell.item->text(1) != v) cell.item->setText(1, v);
+
+    // Plot checkboxes are created on first display, so large arrays cost nothing until opened
+    if (!cell.has_plot_box && isNumericMavType(f->type))
+    {
+        QString fieldPath = QString::fromLatin1(f->name);
+        if (f->array_length > 0) fieldPath += QString("[%1]").arg(cell.idx);
+        const QString id = QString("mavlink/%1/%2/%3/%4")
+                .arg(group.msg.sysid)
+                .arg(group.msg.compid)
+                .arg(group.msg.msgid)
+                .arg(fieldPath);
+        const QString label = QString("MAVLink | %1/%2 %3.%4")
+            .arg(group.msg.sysid)
+            .arg(group.msg.compid)
+            .arg(QString::fromLatin1(group.info->name))
+            .arg(fieldPath);
+        QCheckBox* cb = plot_signal_ui_helpers::createPlotCheckBox(tree_, id, label);
+        tree_->setItemWidget(cell.item, 2, cb);
+    }
+    cell.has_plot_box = true;
+
+    cell.dirty = false;
+    group.dirty_count--;
+}
+
+void mavlink_detail_tree::flush_visible(void)
+{
+    if (!tree_ || !tree_->isVisible()) return;
+    const QRect viewport_rect = tree_->viewport()->rect();
+
+    for (message_group &group : groups_)
+    {
+        // collapsed message: none of its cells are on screen
+        if (group.dirty_count < 1 || !group.root->isExpanded()) continue;
+
+        for (field_group &field : group.fields)
+        {
+            if (field.info->array_length > 0 && !field.item->isExpanded()) continue;
+            for (field_cell &cell : field.cells)
+            {
+                if (!cell.dirty) continue;
+                if (!tree_->visualItemRect(cell.item).intersects(viewport_rect)) continue;
+                format_cell(group, field, cell);
+            }
+        }
     }
 }
 
-// Populate a QTreeWidget with hierarchical fields for one or more MAVLink messages, with a Plot checkbox column
-static void fillDetailTree(QTreeWidget* tree, const QVector<QPair<QString, mavlink_message_t>>& entries)
+void mavlink_detail_tree::rebuild(const QVector<QPair<QString, mavlink_message_t>> &entries)
 {
-    if (!tree) return;
-    // If titles match, only update Value cells and return (preserve checkboxes & scroll)
-    QStringList oldTitles; for (int i = 0; i < tree->topLevelItemCount(); ++i) oldTitles << tree->topLevelItem(i)->text(0);
-    QStringList newTitles; for (const auto& p : entries) newTitles << p.first;
-    if (!oldTitles.isEmpty() && oldTitles == newTitles) { updateDetailTreeValues(tree, entries); return; }
+    QTreeWidget* tree = tree_;
 
     // Save expanded state and scroll position
     QSet<QString> expanded;
@@ -920,6 +1504,7 @@ static void fillDetailTree(QTreeWidget* tree, const QVector<QPair<QString, mavli
     int vScroll = tree->verticalScrollBar() ? tree->verticalScrollBar()->value() : 0;
     tree->setUpdatesEnabled(false);
     tree->blockSignals(true);
+    groups_.clear();
     tree->clear();
     QStringList headers; headers << "Field" << "Value" << "Plot";
     tree->setHeaderLabels(headers);
@@ -930,85 +1515,57 @@ static void fillDetailTree(QTreeWidget* tree, const QVector<QPair<QString, mavli
     const QPalette pal = tree->palette();
     const QBrush headerBrush = pal.alternateBase();
 
-    auto addMessage = [&](const QString& title, const mavlink_message_t& m) {
+    groups_.reserve(entries.size());
+    for (const auto& p : entries)
+    {
+        const mavlink_message_t& m = p.second;
         const mavlink_message_info_t* mi = mavlink_get_message_info(const_cast<mavlink_message_t*>(&m));
-        if (!mi) return;
-        QTreeWidgetItem* root = nullptr;
+        if (!mi) continue;
+
+        message_group group;
+        group.title = p.first;
+        group.info = mi;
+        memcpy(&group.msg, &m, sizeof(m));
+
         // Always create a header item for consistency (even single message)
-        root = new QTreeWidgetItem(tree);
-        root->setText(0, title);
-        QTreeWidget* parentTree = tree;
-        QTreeWidgetItem* parentItem = root;
+        group.root = new QTreeWidgetItem(tree);
+        group.root->setText(0, p.first);
+        for (int c = 0; c < tree->columnCount(); ++c) group.root->setBackground(c, headerBrush);
 
+        group.fields.reserve(static_cast<int>(mi->num_fields));
         for (unsigned i = 0; i < mi->num_fields; ++i)
         {
             const mavlink_field_info_t* f = &mi->fields[i];
-            QTreeWidgetItem* item = parentItem ? new QTreeWidgetItem(parentItem)
-                                               : new QTreeWidgetItem(parentTree);
-            item->setText(0, QString::fromLatin1(f->name));
+            const unsigned element_size = mav_type_size(static_cast<mavlink_message_type_t>(f->type));
+
+            field_group field;
+            field.info = f;
+            field.item = new QTreeWidgetItem(group.root);
+            field.item->setText(0, QString::fromLatin1(f->name));
 
-            if (f->array_length == 0)
+            const int n_cells = f->array_length == 0 ? 1 : f->array_length;
+            field.cells.resize(n_cells);
+            for (int idx = 0; idx < n_cells; ++idx)
             {
-                QString v = mavlink_data_aggregator::print_one_field(const_cast<mavlink_message_t*>(&m), f, 0);
-                item->setText(1, v);
-                // Add checkbox for numeric scalars via widget for reliable interaction
-                if (isNumericMavType(f->type)) {
-                    const QString fieldPath = QString::fromLatin1(f->name);
-                    const QString id = QString("mavlink/%1/%2/%3/%4")
-                            .arg(m.sysid)
-                            .arg(m.compid)
-                            .arg(m.msgid)
-                            .arg(fieldPath);
-                    const QString label = QString("MAVLink | %1/%2 %3.%4")
-                        .arg(m.sysid)
-                        .arg(m.compid)
-                        .arg(QString::fromLatin1(mi->name))
-                        .arg(fieldPath);
-                    QCheckBox* cb = plot_signal_ui_helpers::createPlotCheckBox(tree, id, label);
-                    tree->setItemWidget(item, 2, cb);
+                field_cell &cell = field.cells[idx];
+                cell.idx = idx;
+                cell.offset = f->wire_offset + static_cast<unsigned>(idx) * element_size;
+                cell.size = element_size;
+                if (f->array_length == 0)
+                {
+                    cell.item = field.item;
                 }
-            }
-            else
-            {
-                // For arrays: no checkbox on the group, but add on each numeric element
-                for (int idx = 0; idx < f->array_length; ++idx)
+                else
                 {
-                    QTreeWidgetItem* child = new QTreeWidgetItem(item);
-                    child->setText(0, QString("[%1]").arg(idx));
-                    QString v = mavlink_data_aggregator::print_one_field(const_cast<mavlink_message_t*>(&m), f, idx);
-                    child->setText(1, v);
-                    if (isNumericMavType(f->type)) {
-                        const QString fieldPath = QString::fromLatin1(f->name) + QString("[%1]").arg(idx);
-                        const QString id = QString("mavlink/%1/%2/%3/%4")
-                                .arg(m.sysid)
-                                .arg(m.compid)
-                                .arg(m.msgid)
-                                .arg(fieldPath);
-                        const QString label = QString("MAVLink | %1/%2 %3.%4")
-                            .arg(m.sysid)
-                            .arg(m.compid)
-                            .arg(QString::fromLatin1(mi->name))
-                            .arg(fieldPath);
-                        QCheckBox* cb = plot_signal_ui_helpers::createPlotCheckBox(tree, id, label);
-                        tree->setItemWidget(child, 2, cb);
-                    }
+                    cell.item = new QTreeWidgetItem(field.item);
+                    cell.item->setText(0, QString("[%1]").arg(idx));
                 }
+                group.payload_extent = std::max(group.payload_extent, cell.offset + cell.size);
             }
+            group.dirty_count += n_cells;
+            group.fields.push_back(field);
         }
-
-    // Coloring is handled after building each group
-    };
-
-    // Build messages; color only the header rows (no alternating scheme)
-    for (const auto& p : entries) {
-        // Build subtree
-        addMessage(p.first, p.second);
-        // Color header row gray (always present now)
-        QTreeWidgetItem* root = tree->topLevelItem(tree->topLevelItemCount() - 1);
-        if (root) {
-            const int cols = tree->columnCount();
-            for (int c = 0; c < cols; ++c) root->setBackground(c, headerBrush);
-        }
+        groups_.push_back(group);
     }
 
     // Start collapsed by default; if user had expansions, restore them
@@ -1025,6 +1582,7 @@ static void fillDetailTree(QTreeWidget* tree, const QVector<QPair<QString, mavli
     tree->blockSignals(false);
     tree->setUpdatesEnabled(true);
     if (tree->verticalScrollBar()) tree->verticalScrollBar()->setValue(vScroll);
+    flush_visible();
 }
 
 
@@ -1036,11 +1594,19 @@ MavlinkInspector::MavlinkInspector(QWidget *parent)
     setWindowFlags(Qt::Window);
     setWindowIcon(QIcon(":/resources/Images/Logo/KGC_Logo.png"));
     setWindowTitle("Mavlink Inspector");
-    main_container = new QWidget();
-    ui->scrollArea->setWidget(main_container);
-    main_layout = new QVBoxLayout(main_container);
     mutex = new QMutex;
 
+    // Message list: one model row per stream, only visible rows are formatted and painted
+    msg_model_ = new mavlink_inspector_model(this);
+    ui->table_msgs->setModel(msg_model_);
+    ui->table_msgs->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    ui->table_msgs->horizontalHeader()->setSectionResizeMode(mavlink_inspector_model::COLUMN_RATE, QHeaderView::ResizeToContents);
+    ui->table_msgs->setFocusPolicy(Qt::NoFocus);
+    // clicking a row toggles it into the detail view, like the old checkable buttons
+    connect(ui->table_msgs, &QTableView::clicked, this, [this](const QModelIndex &index){
+        if (index.isValid()) msg_model_->toggle_checked(index.row());
+    });
+
 
     generic_thread_settings mavlink_inspector_settings_;
     mavlink_inspector_settings_.update_rate_hz = static_cast<unsigned int>(sample_rate_hz);
@@ -1053,6 +1619,44 @@ MavlinkInspector::MavlinkInspector(QWidget *parent)
             Qt::QueuedConnection);
 
     on_btn_refresh_port_names_clicked();
+
+    // Parameter editor and file browser for the selected port / vehicle / component
+    QHBoxLayout* tools_layout = new QHBoxLayout();
+    QPushButton* btn_parameters = new QPushButton("Parameters...", ui->groupBox_vehicle_commands);
+    QPushButton* btn_files = new QPushButton("Files...", ui->groupBox_vehicle_commands);
+    tools_layout->addWidget(btn_parameters);
+    tools_layout->addWidget(btn_files);
+    // TIMESYNC link latency of the selected vehicle, as a plot signal
+    tools_layout->addWidget(new QLabel("Plot latency:", ui->groupBox_vehicle_commands));
+    latency_plot_cb_ = plot_signal_ui_helpers::createPlotCheckBox(ui->groupBox_vehicle_commands, QString(), QString());
+    tools_layout->addWidget(latency_plot_cb_);
+    ui->verticalLayout_5->addLayout(tools_layout);
+    connect(ui->cmbx_sysid, &QComboBox::currentTextChanged, this, [this](const QString &txt) {
+        bool sysid_ok = false;
+        const uint8_t sysid_ = static_cast<uint8_t>(txt.toUInt(&sysid_ok));
+        if (sysid_ok) plot_signal_ui_helpers::bindPlotCheckBox(latency_plot_cb_, timesync_manager::latency_signal_id(sysid_), QString("System %1 link latency [ms]").arg(sysid_));
+        else plot_signal_ui_helpers::bindPlotCheckBox(latency_plot_cb_, QString(), QString());
+    });
+    auto selected_target = [this](QString &port_name_, uint8_t &sysid_, uint8_t &compid_) {
+        mavlink_enums::mavlink_component_id comp_id;
+        bool sysid_ok = false;
+        sysid_ = static_cast<uint8_t>(ui->cmbx_sysid->currentText().toUInt(&sysid_ok));
+        port_name_ = ui->cmbx_port_name->currentText();
+        if (!sysid_ok || port_name_.isEmpty() || !mavlink_enums::get_compid(comp_id, ui->cmbx_compid->currentText())) return false;
+        compid_ = static_cast<uint8_t>(comp_id);
+        return true;
+    };
+    connect(btn_parameters, &QPushButton::clicked, this, [this, selected_target]() {
+        QString port_name_;
+        uint8_t sysid_, compid_;
+        if (selected_target(port_name_, sysid_, compid_)) emit parameter_editor_requested(port_name_, sysid_, compid_);
+    });
+    connect(btn_files, &QPushButton::clicked, this, [this, selected_target]() {
+        QString port_name_;
+        uint8_t sysid_, compid_;
+        if (selected_target(port_name_, sysid_, compid_)) emit ftp_browser_requested(port_name_, sysid_, compid_);
+    });
+
     // Self-signal -> self-slot that touch UI must also be queued because signals may be emitted from worker thread
     connect(this, &MavlinkInspector::heartbeat_updated,
         this, &MavlinkInspector::update_arm_state,
@@ -1081,10 +1685,29 @@ MavlinkInspector::MavlinkInspector(QWidget *parent)
         connect(ui->tree_msg_browser, &QTreeWidget::itemPressed, this, [this](QTreeWidgetItem*, int){ suspendDetailRefresh_ = true; });
         connect(ui->tree_msg_browser, &QTreeWidget::itemClicked, this, [this](QTreeWidgetItem*, int){ suspendDetailRefresh_ = false; });
         connect(ui->tree_msg_browser, &QTreeWidget::itemChanged, this, [this](QTreeWidgetItem*, int){ suspendDetailRefresh_ = false; });
+
+        detail_tree_ = new mavlink_detail_tree(ui->tree_msg_browser, this);
+
+        // Scrub the detail view back through the per-message history
+        QHBoxLayout* history_layout = new QHBoxLayout();
+        history_slider_ = new QSlider(Qt::Horizontal, ui->groupBox_msg_browser);
+        history_slider_->setRange(0, 0);
+        history_slider_->setValue(0);
+        history_slider_->setEnabled(false); // until the history duration is known
+        history_label_ = new QLabel("Live", ui->groupBox_msg_browser);
+        history_label_->setMinimumWidth(60);
+        history_layout->addWidget(new QLabel("History", ui->groupBox_msg_browser));
+        history_layout->addWidget(history_slider_, 1);
+        history_layout->addWidget(history_label_);
+        ui->verticalLayout_7->insertLayout(0, history_layout);
+        connect(history_slider_, &QSlider::valueChanged, this, [this](int value){
+            history_label_->setText(value == 0 ? QString("Live") : QString("%1 s").arg(0.1 * value, 0, 'f', 1));
+        });
     }
 
     // Sync Plot checkboxes with Plotting Manager actions (e.g., when a tag is removed there)
     connect(&PlotSignalRegistry::instance(), &PlotSignalRegistry::signalsChanged, this, [this]{
+        plot_signal_ui_helpers::syncPlotCheckBoxes(ui->groupBox_vehicle_commands);
         if (!ui->tree_msg_browser) return;
         plot_signal_ui_helpers::syncPlotCheckBoxes(ui->tree_msg_browser);
     });
@@ -1104,6 +1727,7 @@ MavlinkInspector::MavlinkInspector(QWidget *parent)
 
 MavlinkInspector::~MavlinkInspector()
 {
+    if (!stream_demand_.isEmpty()) emit stream_demand_changed(reinterpret_cast<quintptr>(this), {});
     if (mavlink_inspector_thread_ != NULL)
     {
         mavlink_inspector_thread_->requestInterruption();
@@ -1130,6 +1754,17 @@ MavlinkInspector::~MavlinkInspector()
     delete ui;
 }
 
+void MavlinkInspector::update_kgroundcontrol_settings(kgroundcontrol_settings* kground_control_settings_in_)
+{
+    if (history_slider_ == nullptr) return;
+    const double history_sec = std::max(kground_control_settings_in_->mavlink_history_duration_sec, 0.0);
+    const int max_ds = static_cast<int>(std::floor(10.0 * history_sec));
+    history_slider_->setRange(-max_ds, 0); // clamps the current position into the new range
+    history_slider_->setEnabled(max_ds > 0);
+    if (max_ds > 0) history_slider_->setToolTip(QString("Show the selected messages as they were up to %1 s ago").arg(0.1 * max_ds, 0, 'f', 1));
+    else history_slider_->setToolTip("Message history is off (Settings, MAVLink history duration)");
+}
+
 bool MavlinkInspector::process_new_msg(uint8_t sysid_, mavlink_enums::mavlink_component_id compid_, QString msg_name)
 {
     if (!msg_name.isEmpty())
@@ -1141,7 +1776,7 @@ bool MavlinkInspector::process_new_msg(uint8_t sysid_, mavlink_enums::mavlink_co
             ui->cmbx_sysid->addItem(QString::number(sysid_)); //this will trigger a full cleanup
             ui->cmbx_compid->addItem(enum_helpers::value2key(compid_)); //this should not clean anything extra, but just in case
 
-            addbutton(sysid_, compid_, msg_name);
+            msg_model_->add_row(sysid_, compid_, msg_name);
             mutex->unlock();
 
             on_btn_refresh_port_names_clicked();
@@ -1174,24 +1809,12 @@ bool MavlinkInspector::process_new_msg(uint8_t sysid_, mavlink_enums::mavlink_co
                 //check if selected this compid
                 if (ui->cmbx_compid->currentText() == mav_compoennt_qstr_)
                 {
-                    //we need to scan for the created buttons
-                    bool msg_exists = false;
-                    for (int i = 0; i < names.size(); i++)
-                    {
-                        if (names[i] == msg_name)
-                        {
-                            msg_exists = true;
-                            break;
-                        }
-                    }
-                    if (!msg_exists)
+                    if (!msg_model_->contains(msg_name))
                     {
-                        names.push_back(msg_name);
-                        addbutton(sysid_, compid_, msg_name);
+                        msg_model_->add_row(sysid_, compid_, msg_name);
                         mutex->unlock();
                         return true;
                     }
-                    else emit seen_msg_processed(sysid_, compid_, msg_name);;
                 }
             }
             mutex->unlock();
@@ -1202,228 +1825,93 @@ bool MavlinkInspector::process_new_msg(uint8_t sysid_, mavlink_enums::mavlink_co
     return false;
 }
 
-void MavlinkInspector::addbutton(uint8_t sysid_, mavlink_enums::mavlink_component_id compid_, QString msg_name)
-{
-    names.push_back(msg_name);
-
-    mavlink_message_t msg_;
-    CQueue<qint64> timestamps_(mavlink_data_aggregator::time_buffer_size);
-    emit request_get_msg(sysid_, compid_, msg_name, static_cast<void*>(&msg_), timestamps_);
-    MavlinkInspectorMSG* button = new MavlinkInspectorMSG(main_container, sysid_, compid_, msg_name);
-    button->update(static_cast<void*>(&msg_), 0.0);
-    connect(this, &MavlinkInspector::seen_msg_processed, button, &MavlinkInspectorMSG::schedule_update, Qt::QueuedConnection);
-    main_layout->addWidget(button);
-}
-
-
 bool MavlinkInspector::update_msg_list_visuals(void)
 {
-    bool res = false, detailed_data_printed = false;
+    bool res = false;
     QVector<QPair<QString, mavlink_message_t>> detail_entries;
     mutex->lock();
 
-    // Sliding-window estimator + adaptive smoothing and decay
-    const double window_min_s = 0.5;   // small for responsiveness at high rates
-    const double window_max_s = 30.0;  // large enough to cover < 1 Hz
-    const int min_intervals = 5;       // aim to average across at least 5 intervals
-    const double dt_update_s = 1.0 / sample_rate_hz; // UI/update tick period
-
-    const qint64 now_ms = QDateTime::currentMSecsSinceEpoch();
-
-    // Update all existing message widgets every tick
-    for (int i__ = 0; i__ < main_layout->count(); i__++)
+    // message timestamps are time_base receive stamps, so compare on the same clock
+    const qint64 now_ns = time_base::now_ns();
+    const mavlink_inspector_model::fetch_function fetch =
+        [this](uint8_t sysid_, mavlink_enums::mavlink_component_id compid_, const QString &name_, mavlink_message_t &msg_, message_rate_stats &stats_)
     {
-        QLayoutItem* layout_item = main_layout->itemAt(i__);
-        if (!layout_item || layout_item->isEmpty()) continue;
-
-        MavlinkInspectorMSG* item = qobject_cast<MavlinkInspectorMSG*>(layout_item->widget());
-        if (!item)
-        {
-            qDebug() << "MavlinkInspectorMSG is NULL, resetting...";
-            on_btn_clear_clicked();
-            mutex->unlock();
-            return false;
-        }
-
-        // Pull latest timestamps (and current stored message). If unavailable, fall back to
-        // the cached message in the widget so we can still decay the displayed rate.
-        mavlink_message_t msg_;
-        CQueue<qint64> timestamps_(mavlink_data_aggregator::time_buffer_size);
-        const bool got_fresh = emit request_get_msg(item->sysid, item->compid, item->name, static_cast<void*>(&msg_), timestamps_);
-        if (!got_fresh)
-        {
-            // No fresh message/timestamps from aggregator; use the item's last cached message
-            item->get_msg(static_cast<void*>(&msg_));
-            timestamps_.clear();
-        }
-
-        // Build a stable key per message to track last-seen time
-        const QString key = QString::number(item->sysid) + "|" + QString::number(static_cast<int>(item->compid)) + "|" + item->name;
-        if (!last_seen_ms_by_key.contains(key))
-        {
-            last_seen_ms_by_key.insert(key, now_ms); // initialize to now so first frame doesn't instantly decay
-        }
-        // If we have at least one timestamp, update last seen to the last message time
-        if (timestamps_.count() >= 1)
-        {
-            const qint64 t_last = timestamps_.data()[timestamps_.count() - 1];
-            last_seen_ms_by_key[key] = t_last;
-        }
+        return emit request_get_msg(sysid_, compid_, name_, static_cast<void*>(&msg_), stats_);
+    };
 
-        // Compute base rate over an adaptive time window ending at 'now'
-        double base_rate_hz = 0.0;
-        bool have_intervals = false;
-        qint64 t_last_ms = 0;
-        const int n = timestamps_.count();
-        if (n >= 1) t_last_ms = timestamps_.data()[n - 1];
-        if (n >= 2)
+    // Only the rows on screen are pulled; rates are derived from ingest statistics,
+    // so rows scrolled out of view need no per-tick bookkeeping.
+    const int n_rows = msg_model_->rowCount();
+    if (n_rows > 0)
+    {
+        QTableView* view = ui->table_msgs;
+        int first = view->rowAt(0);
+        int last = view->rowAt(view->viewport()->height() - 1);
+        if (first < 0) first = 0;
+        if (last < 0) last = n_rows - 1;
+        res = msg_model_->refresh_rows(first, last, now_ns, fetch);
+
+        // Detailed view selection aggregation (selected rows may be off screen)
+        const int scrub_ds = history_slider_ ? history_slider_->value() : 0;
+        const QVector<int> checked = msg_model_->checked_rows();
+        for (int row : checked)
         {
-            // Grow window until we have at least 'min_intervals' intervals or hit window_max_s
-            double W_s = window_min_s;
-            int i0 = n - 1; // start index (will move earlier)
-            auto ts = timestamps_.data();
-            while (W_s <= window_max_s)
+            mavlink_message_t mcache;
+            if (scrub_ds < 0)
             {
-                const qint64 window_start_ms = now_ms - static_cast<qint64>(W_s * 1000.0);
-                // move i0 back to include timestamps within [window_start_ms, now]
-                while (i0 > 0 && ts[i0] >= window_start_ms) { --i0; }
-                // after loop, i0 points to the last element BEFORE the window (or 0)
-                int first_in_window = i0;
-                if (ts[first_in_window] < window_start_ms)
-                {
-                    // advance to first index inside window
-                    while (first_in_window < n && ts[first_in_window] < window_start_ms) { ++first_in_window; }
-                }
-
-                const int last_in_window = n - 1;
-                const int samples_in_window = (first_in_window <= last_in_window) ? (last_in_window - first_in_window + 1) : 0;
-                const int intervals_in_window = (samples_in_window > 0) ? (samples_in_window - 1) : 0;
-
-                if (intervals_in_window >= min_intervals || W_s >= window_max_s)
+                // delayed view: the copy that was current scrub_ds tenths of a second ago
+                uint8_t sysid_;
+                mavlink_enums::mavlink_component_id compid_;
+                qint64 t_found_ns = 0;
+                const qint64 t_ns = now_ns + static_cast<qint64>(scrub_ds) * 100000000LL;
+                if (msg_model_->get_stream(row, sysid_, compid_)
+                    && emit request_get_msg_at(sysid_, compid_, msg_model_->name(row), t_ns, static_cast<void*>(&mcache), t_found_ns))
                 {
-                    if (intervals_in_window >= 1)
-                    {
-                        const double span_s = static_cast<double>(ts[last_in_window] - ts[first_in_window]) * 1.0e-3;
-                        if (span_s > 0.0)
-                        {
-                            base_rate_hz = static_cast<double>(intervals_in_window) / span_s;
-                            have_intervals = true;
-                        }
-                    }
-                    break; // window adequate (or maxed), compute with what we have
+                    detail_entries.append(qMakePair(msg_model_->name(row), mcache));
                 }
-
-                // not enough intervals yet, expand window (exponentially for efficiency)
-                W_s = qMin(window_max_s, W_s * 2.0);
-                i0 = n - 1; // reset search origin for widened window
+                continue;
             }
+            if (row < first || row > last) msg_model_->refresh_rows(row, row, now_ns, fetch);
+            if (msg_model_->get_msg(row, mcache)) detail_entries.append(qMakePair(msg_model_->name(row), mcache));
         }
 
-        // Adaptive smoothing and graceful staleness decay
-        const double prev_rate = item->get_last_hz();
-
-        // Adaptive smoothing time constant: smoother for high rates, more responsive for low rates
-        auto adapt_tau = [](double rate_hz) -> double {
-            const double tau_low = 0.15;  // s, at ~1 Hz
-            const double tau_high = 0.8;  // s, at >= 50 Hz
-            if (rate_hz <= 1.0) return tau_low;
-            if (rate_hz >= 50.0) return tau_high;
-            const double t = (rate_hz - 1.0) / (50.0 - 1.0);
-            return tau_low + t * (tau_high - tau_low);
-        };
-
-        // Decay time constant based on current displayed rate's period; ensures slow signals decay smoothly
-        auto decay_tau = [](double last_rate_hz) -> double {
-            if (last_rate_hz <= 1.0e-6) return 0.3; // small default when already near zero
-            const double period_s = 1.0 / last_rate_hz;
-            // decay roughly over ~0.75 periods, bounded for stability
-            double tau = 0.75 * period_s;
-            if (tau < 0.15) tau = 0.15;
-            if (tau > 1.8)  tau = 1.8;
-            return tau;
-        };
-
-        // Adaptive display with timeout + linear decay for sporadic signals
-        const qint64 last_seen_ms = last_seen_ms_by_key.value(key, now_ms);
-        const qint64 stale_ms = now_ms - last_seen_ms;
-        const qint64 timeout_ms = 2500;          // start artificial decay after 2.5s without new messages
-        const double linear_decay_hz_per_s = 1.0; // drop 1.0 Hz per second
-
-        double new_rate = prev_rate;
-        if (stale_ms > timeout_ms)
-        {
-            // Apply linear decay after timeout regardless of base intervals
-            new_rate = prev_rate - linear_decay_hz_per_s * dt_update_s;
-        }
-        else if (have_intervals)
-        {
-            // Fresh data available — apply adaptive EMA smoothing
-            const double tau = adapt_tau(base_rate_hz);
-            const double alpha = dt_update_s / (tau + dt_update_s);
-            new_rate = alpha * base_rate_hz + (1.0 - alpha) * prev_rate;
-        }
-        else
-        {
-            // Before timeout and without new intervals — hold the current display steady
-            new_rate = prev_rate;
-        }
-
-        // Cleanly clamp tiny values to zero
-        if (new_rate < 0.05) new_rate = 0.0;
-
-        // Update the item UI every tick
-        item->update(static_cast<void*>(&msg_), new_rate);
-        res = true;
-
-        // Heartbeat / ACK handling
-        switch (msg_.msgid)
+        // Arm state comes from the manager's decoded vehicle state, not from the HEARTBEAT row
+        if (ui->scrollArea_cmds->isVisible())
         {
-        case MAVLINK_MSG_ID_HEARTBEAT:
-            if (ui->scrollArea_cmds->isVisible())
+            bool sysid_ok = false;
+            const uint8_t sysid_ = static_cast<uint8_t>(ui->cmbx_sysid->currentText().toUInt(&sysid_ok));
+            if (sysid_ok && emit request_vehicle_state(sysid_, vehicle_state_) && vehicle_state_.heartbeat_ns > 0)
             {
-                mavlink_heartbeat_t heartbeat;
-                mavlink_msg_heartbeat_decode(&msg_, &heartbeat);
-                old_heartbeat = heartbeat;
                 emit heartbeat_updated();
             }
-            break;
-        case MAVLINK_MSG_ID_COMMAND_ACK:
-        {
-            mavlink_command_ack_t ack;
-            mavlink_msg_command_ack_decode(&msg_, &ack);
-            switch (ack.command)
-            {
-            case MAV_CMD::MAV_CMD_COMPONENT_ARM_DISARM:
-                break;
-            }
-            break;
-        }
-        default:
-            break;
-        }
-
-        // Detailed view selection aggregation
-        if (item->is_button_checked())
-        {
-            detailed_data_printed = true;
-            mavlink_message_t mcache; item->get_msg(&mcache);
-            detail_entries.append(qMakePair(item->name, mcache));
         }
     }
     mutex->unlock();
 
-    if (detailed_data_printed)
+    // messages open in the detail view are what this inspector needs streamed
+    QVector<quint64> stream_demand;
+    stream_demand.reserve(detail_entries.size());
+    for (const auto& entry : detail_entries)
+        stream_demand.append(mavlink_manager::message_key(entry.second.sysid, entry.second.compid, entry.second.msgid));
+    std::sort(stream_demand.begin(), stream_demand.end());
+    if (stream_demand != stream_demand_)
+    {
+        stream_demand_ = stream_demand;
+        emit stream_demand_changed(reinterpret_cast<quintptr>(this), stream_demand_);
+    }
+
+    if (!detail_entries.isEmpty())
     {
         ui->groupBox_msg_browser->setVisible(true);
         // Populate the bottom detail tree with the selected message(s) unless user is interacting
         if (!suspendDetailRefresh_) {
-            fillDetailTree(ui->tree_msg_browser, detail_entries);
+            if (detail_tree_) detail_tree_->update(detail_entries);
         }
     }
     else
     {
         ui->groupBox_msg_browser->setVisible(false);
-        if (ui->tree_msg_browser) ui->tree_msg_browser->clear();
+        if (detail_tree_) detail_tree_->clear();
     }
 
     return res;
@@ -1433,11 +1921,22 @@ void MavlinkInspector::update_arm_state(void)
 {
     //mutex->lock();
     ui->txt_armed_state->clear();
-    if (old_heartbeat.base_mode & MAV_MODE_FLAG_DECODE_POSITION_SAFETY) ui->txt_armed_state->setText("ARMED");
+    if (vehicle_state_.armed) ui->txt_armed_state->setText("ARMED");
     else ui->txt_armed_state->setText("DISARMED");
+    ui->txt_armed_state->setToolTip(vehicle_state_.get_QString(time_base::now_ns()));
     //mutex->unlock();
 }
 
+void MavlinkInspector::update_command_result(quint64, uint8_t sysid, uint8_t, uint16_t command, int result, qint64 rtt_ns)
+{
+    if (command != MAV_CMD_COMPONENT_ARM_DISARM) return;
+    if (ui->cmbx_sysid->currentText().toUInt() != sysid) return;
+    QString txt = "Last arm/disarm command: " + command_manager::result_QString(result);
+    if (rtt_ns > 0) txt += QString(" in %1 ms").arg(static_cast<double>(rtt_ns) * 1.0E-6, 0, 'f', 1);
+    ui->btn_arm->setToolTip(txt);
+    ui->btn_disarm->setToolTip(txt);
+}
+
 void MavlinkInspector::update_msg_browser(QString)
 {
     // No-op: detailed tree is updated directly in update_msg_list_visuals
@@ -1491,18 +1990,7 @@ void MavlinkInspector::clear_compid_list(void)
 }
 void MavlinkInspector::clear_msg_list_container(void)
 {
-    if (main_container != NULL)
-    {
-        delete main_container; //clear everything
-        main_container = nullptr;
-    }
-    names.clear();
-    last_seen_ms_by_key.clear();
-
-    //start fresh:    
-    main_container = new QWidget();
-    ui->scrollArea->setWidget(main_container);
-    main_layout = new QVBoxLayout(main_container);
+    if (msg_model_ != nullptr) msg_model_->clear_rows();
 }
 
 void MavlinkInspector::on_btn_arm_clicked()
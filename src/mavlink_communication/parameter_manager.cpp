@@ -0,0 +1,806 @@
+/****************************************************************************
+ *
+ *    Copyright (C) 2025  Yevhenii Kovryzhenko. All rights reserved.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU Affero General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License Version 3 for more details.
+ *
+ *    You should have received a copy of the
+ *    GNU Affero General Public License Version 3
+ *    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions, and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions, and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *    3. No ownership or credit shall be claimed by anyone not mentioned in
+ *       the above copyright statement.
+ *    4. Any redistribution or public use of this software, in whole or in part,
+ *       whether standalone or as part of a different project, must remain
+ *       under the terms of the GNU Affero General Public License Version 3,
+ *       and all distributions in binary form must be accompanied by a copy of
+ *       the source code, as stated in the GNU Affero General Public License.
+ *
+ ****************************************************************************/
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QStandardPaths>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <cmath>
+#include <cstring>
+
+#include "mavlink_communication/parameter_manager.h"
+#include "time_base.h"
+
+void parameter_entry::set_name(const QString &name_in)
+{
+    const QByteArray latin = name_in.toLatin1();
+    memset(id, 0, sizeof(id));
+    memcpy(id, latin.constData(), qMin<qsizetype>(latin.size(), 16));
+}
+
+QString parameter_sync_status::get_QString(void) const
+{
+    static const char* phase_names[] = {"Idle", "Checking hash", "Listing", "Filling gaps", "Done", "Failed"};
+    QString txt = QString("%1: %2/%3").arg(phase_names[phase]).arg(received).arg(count < 0 ? QString("?") : QString::number(count));
+    if (from_cache) txt += " (cache)";
+    else if (reads_sent > 0) txt += QString(", %1 re-reads").arg(reads_sent);
+    txt += QString(", %1 s").arg(static_cast<double>(elapsed_ns) * 1.0E-9, 0, 'f', 2);
+    if (uploads_pending > 0) txt += QString(", %1 uploads pending").arg(uploads_pending);
+    if (uploads_failed > 0) txt += QString(", %1 uploads failed").arg(uploads_failed);
+    return txt;
+}
+
+
+
+parameter_manager::parameter_manager(QObject* parent, generic_thread_settings* settings_in_, mavlink_manager* mavlink_manager_in_)
+    : periodic_task(parent, settings_in_), mavlink_manager_(mavlink_manager_in_)
+{
+    setObjectName("parameter_manager");
+
+    generic_thread_settings cache_io_settings_;
+    cache_io_settings_.priority = QThread::Priority::LowPriority; // never real-time: it waits on the disk
+    cache_io_ = new job_thread(this, &cache_io_settings_, 256);
+    cache_io_->setObjectName("parameter_cache_io");
+    cache_io_->start(cache_io_settings_.priority);
+
+    mavlink_manager_->subscribe(MAVLINK_MSG_ID_PARAM_VALUE, this);
+    start(generic_thread_settings_.priority);
+}
+
+parameter_manager::~parameter_manager()
+{
+    if (!mavlink_manager_.isNull()) mavlink_manager_->unsubscribe(this);
+    periodic_scheduler::instance().remove_and_wait(this);
+    delete cache_io_; // finishes queued cache writes
+    qDeleteAll(sessions_);
+}
+
+void parameter_manager::on_message(const mavlink_message_t& msg, qint64 t_ns)
+{
+    const bool res = inbox_.push_with([&msg, t_ns](inbox_entry& entry)
+    {
+        entry.t_ns = t_ns;
+        entry.sysid = msg.sysid;
+        entry.compid = msg.compid;
+        mavlink_msg_param_value_decode(&msg, &entry.value);
+    });
+    if (!res) inbox_dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+double parameter_manager::decode_value(float raw, uint8_t type, bool bytewise)
+{
+    if (!bytewise) return static_cast<double>(raw);
+    mavlink_param_union_t u;
+    u.param_float = raw;
+    switch (type)
+    {
+    case MAV_PARAM_TYPE_UINT8:  return static_cast<double>(u.param_uint8);
+    case MAV_PARAM_TYPE_INT8:   return static_cast<double>(u.param_int8);
+    case MAV_PARAM_TYPE_UINT16: return static_cast<double>(u.param_uint16);
+    case MAV_PARAM_TYPE_INT16:  return static_cast<double>(u.param_int16);
+    case MAV_PARAM_TYPE_UINT32: return static_cast<double>(u.param_uint32);
+    case MAV_PARAM_TYPE_INT32:  return static_cast<double>(u.param_int32);
+    default:                    return static_cast<double>(u.param_float);
+    }
+}
+
+float parameter_manager::encode_value(double value, uint8_t type, bool bytewise)
+{
+    if (!bytewise) return static_cast<float>(value);
+    mavlink_param_union_t u;
+    u.param_uint32 = 0;
+    const double v = std::round(value);
+    switch (type)
+    {
+    case MAV_PARAM_TYPE_UINT8:  u.param_uint8 = static_cast<uint8_t>(qBound(0.0, v, 255.0)); break;
+    case MAV_PARAM_TYPE_INT8:   u.param_int8 = static_cast<int8_t>(qBound(-128.0, v, 127.0)); break;
+    case MAV_PARAM_TYPE_UINT16: u.param_uint16 = static_cast<uint16_t>(qBound(0.0, v, 65535.0)); break;
+    case MAV_PARAM_TYPE_INT16:  u.param_int16 = static_cast<int16_t>(qBound(-32768.0, v, 32767.0)); break;
+    case MAV_PARAM_TYPE_UINT32: u.param_uint32 = static_cast<uint32_t>(qBound(0.0, v, 4294967295.0)); break;
+    case MAV_PARAM_TYPE_INT32:  u.param_int32 = static_cast<int32_t>(qBound(-2147483648.0, v, 2147483647.0)); break;
+    default:                    u.param_float = static_cast<float>(value); break;
+    }
+    return u.param_float;
+}
+
+QString parameter_manager::type_QString(uint8_t type)
+{
+    switch (type)
+    {
+    case MAV_PARAM_TYPE_UINT8:  return "uint8";
+    case MAV_PARAM_TYPE_INT8:   return "int8";
+    case MAV_PARAM_TYPE_UINT16: return "uint16";
+    case MAV_PARAM_TYPE_INT16:  return "int16";
+    case MAV_PARAM_TYPE_UINT32: return "uint32";
+    case MAV_PARAM_TYPE_INT32:  return "int32";
+    case MAV_PARAM_TYPE_UINT64: return "uint64";
+    case MAV_PARAM_TYPE_INT64:  return "int64";
+    case MAV_PARAM_TYPE_REAL32: return "float";
+    case MAV_PARAM_TYPE_REAL64: return "double";
+    default:                    return "unknown";
+    }
+}
+
+bool parameter_manager::download(QString port_name, uint8_t sysid, uint8_t compid, bool use_cache)
+{
+    if (port_name.isEmpty()) return false;
+    const qint64 now_ns = time_base::now_ns();
+
+    mutex->lock();
+    session* s = get_session(sysid, compid, port_name);
+    s->use_cache = use_cache;
+    s->from_cache = false;
+    s->cache_ticket = 0; // a load still running for an earlier download is ignored
+    s->start_ns = now_ns;
+    s->last_rx_ns = 0;
+    s->list_attempts = 0;
+    s->hash_valid = false;
+    s->reads_sent = 0;
+    resize(*s, 0);
+    if (use_cache)
+    {
+        s->phase = parameter_sync_status::HASH_CHECK;
+        s->phase_ns = now_ns;
+        queue_request_read(*s, "_HASH_CHECK", -1);
+    }
+    else start_listing(*s, now_ns);
+    mutex->unlock();
+    return true;
+}
+
+bool parameter_manager::upload(QString port_name, uint8_t sysid, uint8_t compid, QVector<parameter_entry> changes)
+{
+    if (port_name.isEmpty() || changes.isEmpty()) return false;
+
+    mutex->lock();
+    session* s = get_session(sysid, compid, port_name);
+    for (const parameter_entry& entry : changes) s->set_queue.enqueue(entry);
+    mutex->unlock();
+    return true;
+}
+
+void parameter_manager::cancel(uint8_t sysid, uint8_t compid)
+{
+    mutex->lock();
+    session* s = sessions_.value(session_key(sysid, compid), nullptr);
+    if (s)
+    {
+        if (s->phase != parameter_sync_status::DONE) s->phase = parameter_sync_status::IDLE;
+        s->reads.clear();
+        s->set_queue.clear();
+        s->sets.clear();
+    }
+    mutex->unlock();
+}
+
+bool parameter_manager::get_status(uint8_t sysid, uint8_t compid, parameter_sync_status &status_out)
+{
+    const qint64 now_ns = time_base::now_ns();
+    mutex->lock();
+    const session* s = sessions_.value(session_key(sysid, compid), nullptr);
+    if (s == nullptr)
+    {
+        mutex->unlock();
+        return false;
+    }
+    status_out.phase = s->phase;
+    status_out.count = s->params.isEmpty() ? -1 : s->params.size();
+    status_out.received = s->received;
+    status_out.reads_sent = s->reads_sent;
+    status_out.uploads_pending = s->set_queue.size() + s->sets.size();
+    status_out.uploads_failed = s->uploads_failed;
+    status_out.from_cache = s->from_cache;
+    const bool finished = s->phase == parameter_sync_status::DONE || s->phase == parameter_sync_status::FAILED;
+    status_out.elapsed_ns = (finished ? s->phase_ns : now_ns) - s->start_ns;
+    mutex->unlock();
+    return true;
+}
+
+bool parameter_manager::get_parameters(uint8_t sysid, uint8_t compid, QVector<parameter_entry> &params_out)
+{
+    mutex->lock();
+    const session* s = sessions_.value(session_key(sysid, compid), nullptr);
+    if (s) params_out = s->params;
+    mutex->unlock();
+    return s != nullptr;
+}
+
+bool parameter_manager::is_bytewise(uint8_t sysid)
+{
+    vehicle_state state;
+    if (mavlink_manager_.isNull() || !mavlink_manager_->get_vehicle_state(sysid, state)) return false;
+    return state.autopilot == MAV_AUTOPILOT_PX4;
+}
+
+void parameter_manager::update_kgroundcontrol_settings(kgroundcontrol_settings* kground_control_settings_in_)
+{
+    mutex->lock();
+    kgroundcontrol_settings_ = *kground_control_settings_in_;
+    mutex->unlock();
+}
+
+void parameter_manager::tick()
+{
+    const qint64 now_ns = time_base::now_ns();
+
+    QVector<cache_result> cache_results;
+    cache_mutex_.lock();
+    cache_results.swap(cache_results_);
+    cache_mutex_.unlock();
+
+    mutex->lock();
+    for (const cache_result& result : std::as_const(cache_results))
+    {
+        session* s = sessions_.value(result.key, nullptr);
+        if (s && s->cache_ticket == result.ticket && s->phase == parameter_sync_status::HASH_CHECK) apply_cache(*s, result.params, now_ns);
+    }
+    inbox_entry entry;
+    while (inbox_.pop(entry))
+    {
+        session* s = sessions_.value(session_key(entry.sysid, entry.compid), nullptr);
+        if (s) handle_param_value(*s, entry); // not a vehicle we asked
+    }
+    for (session* s : std::as_const(sessions_)) service(*s, now_ns);
+
+    QVector<outgoing_message> outgoing;
+    QVector<QPair<quint16, bool>> finished;
+    outgoing.swap(outgoing_);
+    finished.swap(finished_);
+    mutex->unlock();
+
+    for (outgoing_message& out : outgoing) emit write_message(out.port_name, &out.message);
+    for (const auto& done : finished) emit sync_finished(static_cast<uint8_t>(done.first >> 8), static_cast<uint8_t>(done.first & 0xFF), done.second);
+}
+
+// caller holds mutex
+parameter_manager::session* parameter_manager::get_session(uint8_t sysid, uint8_t compid, const QString &port_name)
+{
+    session*& s = sessions_[session_key(sysid, compid)];
+    if (s == nullptr)
+    {
+        s = new session;
+        s->sysid = sysid;
+        s->compid = compid;
+    }
+    s->port_name = port_name;
+    return s;
+}
+
+// caller holds mutex
+void parameter_manager::handle_param_value(session &s, const inbox_entry &entry)
+{
+    const mavlink_param_value_t& value = entry.value;
+    const QString name = QString::fromLatin1(value.param_id, qstrnlen(value.param_id, sizeof(value.param_id)));
+
+    if (name == "_HASH_CHECK")
+    {
+        memcpy(&s.hash, &value.param_value, sizeof(s.hash));
+        s.hash_valid = true;
+        if (s.phase == parameter_sync_status::HASH_CHECK && s.cache_ticket == 0)
+        {
+            if (s.use_cache) request_cache(s, entry.t_ns);
+            else start_listing(s, entry.t_ns);
+        }
+        return;
+    }
+    s.last_rx_ns = entry.t_ns;
+
+    // a PARAM_SET is confirmed once the vehicle echoes the value we sent;
+    // anything else (a stale list entry, a clamped value) waits for the retry
+    auto set_it = s.sets.find(name);
+    if (set_it != s.sets.end() && memcmp(&set_it->entry.raw, &value.param_value, sizeof(float)) == 0) s.sets.erase(set_it);
+
+    if (value.param_count > 0 && value.param_count != s.params.size())
+    {
+        // first value of a download, or the vehicle's parameter set changed
+        if (s.phase == parameter_sync_status::DONE || s.phase == parameter_sync_status::FAILED || s.phase == parameter_sync_status::IDLE) return;
+        resize(s, value.param_count);
+    }
+
+    int index = value.param_index;
+    if (index >= s.params.size()) index = s.index_by_name.value(name, -1); // replies to PARAM_SET may omit the index
+    if (index < 0) return;
+
+    parameter_entry& param = s.params[index];
+    memcpy(param.id, value.param_id, sizeof(value.param_id));
+    param.id[16] = '\0';
+    param.raw = value.param_value;
+    param.type = value.param_type;
+    param.received = true;
+    quint64& word = s.received_bits[index >> 6];
+    const quint64 bit = 1ull << (index & 63);
+    if ((word & bit) == 0)
+    {
+        word |= bit;
+        s.received++;
+        s.index_by_name.insert(name, index);
+    }
+    s.reads.remove(index);
+
+    if ((s.phase == parameter_sync_status::LISTING || s.phase == parameter_sync_status::GAP_FILL) && s.received == s.params.size())
+    {
+        finish(s, parameter_sync_status::DONE, entry.t_ns);
+    }
+}
+
+// caller holds mutex
+void parameter_manager::service(session &s, qint64 now_ns)
+{
+    switch (s.phase)
+    {
+    case parameter_sync_status::HASH_CHECK:
+        // once the hash is in, the cache load posts its result back instead
+        if (s.cache_ticket == 0 && now_ns - s.phase_ns > hash_timeout_ns) start_listing(s, now_ns);
+        break;
+
+    case parameter_sync_status::LISTING:
+        if (s.last_rx_ns < s.phase_ns)
+        {
+            // nothing back yet
+            if (now_ns - s.phase_ns < list_timeout_ns) break;
+            if (s.list_attempts >= max_attempts) finish(s, parameter_sync_status::FAILED, now_ns);
+            else
+            {
+                s.phase_ns = now_ns;
+                queue_request_list(s);
+            }
+        }
+        else if (!s.params.isEmpty() && now_ns - s.last_rx_ns > list_quiet_ns)
+        {
+            s.phase = parameter_sync_status::GAP_FILL;
+            s.phase_ns = now_ns;
+            s.gap_cursor = 0;
+        }
+        break;
+
+    case parameter_sync_status::GAP_FILL:
+    {
+        for (auto it = s.reads.begin(); it != s.reads.end(); ++it)
+        {
+            if (now_ns - it->sent_ns < request_timeout_ns) continue;
+            if (it->attempts >= max_attempts)
+            {
+                finish(s, parameter_sync_status::FAILED, now_ns);
+                return;
+            }
+            it->attempts++;
+            it->sent_ns = now_ns;
+            queue_request_read(s, "", static_cast<int16_t>(it.key()));
+        }
+
+        // keep the window full: scan the bitmap for holes that are not already requested
+        const int count = s.params.size();
+        bool wrapped = false;
+        while (s.reads.size() < read_window)
+        {
+            int index = -1;
+            for (int i = s.gap_cursor; i < count;)
+            {
+                const quint64 word = s.received_bits[i >> 6];
+                if (word == ~0ull)
+                {
+                    i = (i | 63) + 1;
+                    continue;
+                }
+                if (((word >> (i & 63)) & 1ull) == 0 && !s.reads.contains(i))
+                {
+                    index = i;
+                    break;
+                }
+                i++;
+            }
+            if (index < 0)
+            {
+                if (wrapped || s.gap_cursor == 0) break;
+                s.gap_cursor = 0;
+                wrapped = true;
+                continue;
+            }
+            pending_request& request = s.reads[index];
+            request.attempts = 1;
+            request.sent_ns = now_ns;
+            s.gap_cursor = index + 1;
+            s.reads_sent++;
+            queue_request_read(s, "", static_cast<int16_t>(index));
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    // uploads run independently of the download phase
+    for (auto it = s.sets.begin(); it != s.sets.end();)
+    {
+        if (now_ns - it->request.sent_ns < request_timeout_ns)
+        {
+            ++it;
+            continue;
+        }
+        if (it->request.attempts >= max_attempts)
+        {
+            s.uploads_failed++;
+            it = s.sets.erase(it);
+            continue;
+        }
+        it->request.attempts++;
+        it->request.sent_ns = now_ns;
+        queue_set(s, it->entry);
+        ++it;
+    }
+    while (s.sets.size() < set_window && !s.set_queue.isEmpty())
+    {
+        const parameter_entry entry = s.set_queue.dequeue();
+        pending_set& set = s.sets[entry.name()]; // a newer value replaces one still in flight
+        set.entry = entry;
+        set.request.attempts = 1;
+        set.request.sent_ns = now_ns;
+        queue_set(s, entry);
+    }
+}
+
+// caller holds mutex
+void parameter_manager::start_listing(session &s, qint64 now_ns)
+{
+    s.phase = parameter_sync_status::LISTING;
+    s.phase_ns = now_ns;
+    s.list_attempts = 0;
+    queue_request_list(s);
+}
+
+// caller holds mutex
+void parameter_manager::finish(session &s, int phase, qint64 now_ns)
+{
+    s.phase = phase;
+    s.phase_ns = now_ns;
+    s.reads.clear();
+    if (phase == parameter_sync_status::DONE && !s.from_cache && s.hash_valid) save_cache(s);
+    finished_.append(qMakePair(session_key(s.sysid, s.compid), phase == parameter_sync_status::DONE));
+}
+
+// caller holds mutex
+void parameter_manager::resize(session &s, int count)
+{
+    s.params = QVector<parameter_entry>(count);
+    s.received_bits.assign((count + 63) / 64, 0);
+    // bits past the end read as received, so the gap scan can skip whole words
+    if (count & 63) s.received_bits.back() = ~((1ull << (count & 63)) - 1);
+    s.received = 0;
+    s.index_by_name.clear();
+    s.reads.clear();
+    s.gap_cursor = 0;
+}
+
+// caller holds mutex
+void parameter_manager::queue_request_list(session &s)
+{
+    outgoing_message out;
+    out.port_name = s.port_name;
+    mavlink_msg_param_request_list_pack(kgroundcontrol_settings_.sysid, static_cast<uint8_t>(kgroundcontrol_settings_.compid), &out.message, s.sysid, s.compid);
+    outgoing_.append(out);
+    s.list_attempts++;
+}
+
+// caller holds mutex
+void parameter_manager::queue_request_read(session &s, const char* id, int16_t index)
+{
+    char param_id[16] = {}; // the packer always copies 16 bytes
+    strncpy(param_id, id, sizeof(param_id));
+    outgoing_message out;
+    out.port_name = s.port_name;
+    mavlink_msg_param_request_read_pack(kgroundcontrol_settings_.sysid, static_cast<uint8_t>(kgroundcontrol_settings_.compid), &out.message, s.sysid, s.compid, param_id, index);
+    outgoing_.append(out);
+}
+
+// caller holds mutex
+void parameter_manager::queue_set(session &s, const parameter_entry &entry)
+{
+    outgoing_message out;
+    out.port_name = s.port_name;
+    mavlink_msg_param_set_pack(kgroundcontrol_settings_.sysid, static_cast<uint8_t>(kgroundcontrol_settings_.compid), &out.message, s.sysid, s.compid, entry.id, entry.raw, entry.type);
+    outgoing_.append(out);
+}
+
+QString parameter_manager::cache_path(uint8_t sysid, uint8_t compid)
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QString("/param_cache/%1_%2.bin").arg(sysid).arg(compid);
+}
+
+static constexpr quint32 param_cache_magic = 0x4B475043; // "KGPC"
+static constexpr quint32 param_cache_version = 1;
+
+// caller holds mutex; the file is read on the I/O thread and the result applied by tick()
+void parameter_manager::request_cache(session &s, qint64 now_ns)
+{
+    const quint16 key = session_key(s.sysid, s.compid);
+    const quint64 ticket = next_cache_ticket_++;
+    const QString path = cache_path(s.sysid, s.compid);
+    const quint32 hash = s.hash;
+    const bool queued = cache_io_->post([this, key, ticket, path, hash]()
+    {
+        cache_result result;
+        result.key = key;
+        result.ticket = ticket;
+        if (!read_cache(path, hash, result.params)) result.params.clear();
+        cache_mutex_.lock();
+        cache_results_.append(result);
+        cache_mutex_.unlock();
+    });
+    if (!queued)
+    {
+        start_listing(s, now_ns);
+        return;
+    }
+    s.cache_ticket = ticket;
+}
+
+// caller holds mutex
+void parameter_manager::apply_cache(session &s, const QVector<parameter_entry> &params, qint64 now_ns)
+{
+    s.cache_ticket = 0;
+    if (params.isEmpty())
+    {
+        start_listing(s, now_ns);
+        return;
+    }
+    resize(s, params.size());
+    s.params = params;
+    for (int i = 0; i < params.size(); i++)
+    {
+        s.received_bits[i >> 6] |= 1ull << (i & 63);
+        s.index_by_name.insert(params[i].name(), i);
+    }
+    s.received = params.size();
+    s.from_cache = true;
+    finish(s, parameter_sync_status::DONE, now_ns);
+}
+
+// caller holds mutex; only queues the write
+void parameter_manager::save_cache(const session &s)
+{
+    const QString path = cache_path(s.sysid, s.compid);
+    const quint32 hash = s.hash;
+    const QVector<parameter_entry> params = s.params;
+    cache_io_->post([path, hash, params]() { write_cache(path, hash, params); });
+}
+
+bool parameter_manager::read_cache(const QString &path, quint32 hash, QVector<parameter_entry> &params_out)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    QDataStream in(&file);
+    quint32 magic = 0, version = 0, file_hash = 0;
+    qint32 count = 0;
+    in >> magic >> version >> file_hash >> count;
+    if (magic != param_cache_magic || version != param_cache_version || file_hash != hash || count <= 0 || count > UINT16_MAX) return false;
+
+    params_out = QVector<parameter_entry>(count);
+    for (int i = 0; i < count; i++)
+    {
+        QByteArray id;
+        quint32 raw = 0;
+        quint8 type = 0;
+        in >> id >> raw >> type;
+        parameter_entry& param = params_out[i];
+        memcpy(param.id, id.constData(), qMin<qsizetype>(id.size(), 16));
+        memcpy(&param.raw, &raw, sizeof(raw));
+        param.type = type;
+        param.received = true;
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+void parameter_manager::write_cache(const QString &path, quint32 hash, const QVector<parameter_entry> &params)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return;
+    QDataStream out(&file);
+    out << param_cache_magic << param_cache_version << hash << static_cast<qint32>(params.size());
+    for (const parameter_entry& param : params)
+    {
+        quint32 raw = 0;
+        memcpy(&raw, &param.raw, sizeof(raw));
+        out << QByteArray(param.id) << raw << static_cast<quint8>(param.type);
+    }
+    file.commit();
+}
+
+
+
+parameter_editor::parameter_editor(QWidget *parent, parameter_manager* manager_in_, QString port_name_in_, uint8_t sysid_in_, uint8_t compid_in_)
+    : QWidget(parent), manager_(manager_in_), port_name_(port_name_in_), sysid_(sysid_in_), compid_(compid_in_)
+{
+    setWindowIcon(QIcon(":/resources/Images/Logo/KGC_Logo.png"));
+    setWindowTitle(QString("Parameters: System %1, Component %2 (%3)").arg(sysid_).arg(compid_).arg(port_name_));
+    resize(520, 640);
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    QHBoxLayout* top_layout = new QHBoxLayout;
+    filter_edit_ = new QLineEdit(this);
+    filter_edit_->setPlaceholderText("Filter");
+    filter_edit_->setClearButtonEnabled(true);
+    status_label_ = new QLabel(this);
+    top_layout->addWidget(filter_edit_, 1);
+    top_layout->addWidget(status_label_, 1);
+    layout->addLayout(top_layout);
+
+    table_ = new QTableWidget(0, COLUMN_COUNT, this);
+    table_->setHorizontalHeaderLabels({"Name", "Value", "Type"});
+    table_->horizontalHeader()->setSectionResizeMode(COLUMN_NAME, QHeaderView::ResizeToContents);
+    table_->horizontalHeader()->setSectionResizeMode(COLUMN_VALUE, QHeaderView::Stretch);
+    table_->horizontalHeader()->setSectionResizeMode(COLUMN_TYPE, QHeaderView::ResizeToContents);
+    table_->verticalHeader()->setVisible(false);
+    table_->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    layout->addWidget(table_, 1);
+
+    QHBoxLayout* btn_layout = new QHBoxLayout;
+    btn_download_ = new QPushButton("Download", this);
+    btn_download_->setToolTip("Download all parameters, reusing the local cache if the vehicle reports an unchanged hash");
+    btn_refresh_ = new QPushButton("Download (ignore cache)", this);
+    btn_upload_ = new QPushButton("Upload changes", this);
+    btn_upload_->setEnabled(false);
+    btn_layout->addWidget(btn_download_);
+    btn_layout->addWidget(btn_refresh_);
+    btn_layout->addStretch(1);
+    btn_layout->addWidget(btn_upload_);
+    layout->addLayout(btn_layout);
+
+    connect(filter_edit_, &QLineEdit::textChanged, this, &parameter_editor::apply_filter);
+    connect(table_, &QTableWidget::itemChanged, this, &parameter_editor::on_item_changed);
+    connect(btn_download_, &QPushButton::clicked, this, [this]() { on_download_clicked(true); });
+    connect(btn_refresh_, &QPushButton::clicked, this, [this]() { on_download_clicked(false); });
+    connect(btn_upload_, &QPushButton::clicked, this, &parameter_editor::on_upload_clicked);
+
+    status_timer_ = new QTimer(this);
+    connect(status_timer_, &QTimer::timeout, this, &parameter_editor::refresh_status);
+    status_timer_->start(200);
+
+    // reuse what an earlier editor already downloaded
+    parameter_sync_status status;
+    if (manager_.isNull()) return;
+    if (manager_->get_status(sysid_, compid_, status) && status.phase == parameter_sync_status::DONE) populate_table();
+    else on_download_clicked(true);
+}
+
+void parameter_editor::refresh_status(void)
+{
+    parameter_sync_status status;
+    if (manager_.isNull() || !manager_->get_status(sysid_, compid_, status)) return;
+    status_label_->setText(status.get_QString());
+
+    const bool finished = status.phase == parameter_sync_status::DONE || status.phase == parameter_sync_status::FAILED;
+    // repopulate when a download ends, and once uploads have been confirmed
+    if ((finished && status.phase != populated_phase_) || (uploads_pending_ > 0 && status.uploads_pending == 0)) populate_table();
+    uploads_pending_ = status.uploads_pending;
+}
+
+void parameter_editor::populate_table(void)
+{
+    if (manager_.isNull()) return;
+    parameter_sync_status status;
+    if (manager_->get_status(sysid_, compid_, status)) populated_phase_ = status.phase;
+    manager_->get_parameters(sysid_, compid_, params_);
+    bytewise_ = manager_->is_bytewise(sysid_);
+
+    populating_ = true;
+    table_->setUpdatesEnabled(false);
+    table_->setRowCount(params_.size());
+    for (int row = 0; row < params_.size(); row++)
+    {
+        const parameter_entry& param = params_[row];
+        const QString name = param.received ? param.name() : QString("[%1]").arg(row);
+        const bool edited = edits_.contains(name);
+        const double value = edited ? edits_.value(name) : parameter_manager::decode_value(param.raw, param.type, bytewise_);
+
+        QTableWidgetItem* name_item = new QTableWidgetItem(name);
+        name_item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
+        QTableWidgetItem* value_item = new QTableWidgetItem(param.received ? QString::number(value, 'g', 9) : QString());
+        value_item->setFlags(param.received ? (Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsEditable) : Qt::ItemIsEnabled);
+        QFont font = value_item->font();
+        font.setBold(edited);
+        value_item->setFont(font);
+        QTableWidgetItem* type_item = new QTableWidgetItem(parameter_manager::type_QString(param.type));
+        type_item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
+
+        table_->setItem(row, COLUMN_NAME, name_item);
+        table_->setItem(row, COLUMN_VALUE, value_item);
+        table_->setItem(row, COLUMN_TYPE, type_item);
+    }
+    apply_filter(filter_edit_->text());
+    table_->setUpdatesEnabled(true);
+    populating_ = false;
+}
+
+void parameter_editor::apply_filter(const QString &text)
+{
+    for (int row = 0; row < table_->rowCount(); row++)
+    {
+        const QTableWidgetItem* name_item = table_->item(row, COLUMN_NAME);
+        table_->setRowHidden(row, name_item && !text.isEmpty() && !name_item->text().contains(text, Qt::CaseInsensitive));
+    }
+}
+
+void parameter_editor::on_item_changed(QTableWidgetItem* item)
+{
+    if (populating_ || item->column() != COLUMN_VALUE || item->row() >= params_.size()) return;
+    const parameter_entry& param = params_[item->row()];
+
+    bool ok = false;
+    const double value = item->text().toDouble(&ok);
+    populating_ = true;
+    if (!ok) item->setText(QString::number(edits_.value(param.name(), parameter_manager::decode_value(param.raw, param.type, bytewise_)), 'g', 9));
+    else
+    {
+        edits_.insert(param.name(), value);
+        QFont font = item->font();
+        font.setBold(true);
+        item->setFont(font);
+    }
+    populating_ = false;
+    btn_upload_->setEnabled(!edits_.isEmpty());
+}
+
+void parameter_editor::on_download_clicked(bool use_cache)
+{
+    if (manager_.isNull()) return;
+    edits_.clear();
+    btn_upload_->setEnabled(false);
+    populated_phase_ = parameter_sync_status::IDLE;
+    manager_->download(port_name_, sysid_, compid_, use_cache);
+}
+
+void parameter_editor::on_upload_clicked(void)
+{
+    if (manager_.isNull() || edits_.isEmpty()) return;
+    QVector<parameter_entry> changes;
+    changes.reserve(edits_.size());
+    for (const parameter_entry& param : std::as_const(params_))
+    {
+        auto it = edits_.constFind(param.name());
+        if (it == edits_.cend()) continue;
+        parameter_entry change = param;
+        change.raw = parameter_manager::encode_value(it.value(), param.type, bytewise_);
+        changes.append(change);
+    }
+    edits_.clear();
+    btn_upload_->setEnabled(false);
+    if (manager_->upload(port_name_, sysid_, compid_, changes)) uploads_pending_ = changes.size();
+}
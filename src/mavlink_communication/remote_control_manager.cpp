@@ -35,8 +35,11 @@
 #include "mavlink_communication/remote_control_manager.h"
 #include "hardware_io/joystick.h"
 #include "hardware_io/connection_manager.h"
+#include "mavlink_communication/command_manager.h"
+#include "mavlink_communication/timesync_manager.h"
 #include "hardware_io/generic_port.h"
 #include "plot/plot_signal_registry.h"
+#include "time_base.h"
 #include <QSettings>
 #include <QDebug>
 #include <QDateTime>
@@ -171,28 +174,43 @@ namespace remote_control {
                                             const JoystickRelaySettings& relay_settings,
                                             kgroundcontrol_settings* kgroundcontrol_settings_in,
                                             const QVector<int>& field_roles)
-        : generic_thread(parent, thread_settings),
+        : periodic_task(parent, thread_settings),
         relaySettings(relay_settings),
         fieldRoles(field_roles)
     {
-        stopRequested = false;
-
         update_kgroundcontrol_settings(kgroundcontrol_settings_in);
+        applyRelayRate();
     }
 
     JoystickRelayThread::~JoystickRelayThread() {
-        requestStop();
+        periodic_scheduler::instance().remove_and_wait(this);
     }
 
     void JoystickRelayThread::requestStop() {
-        QMutexLocker locker(mutex);
-        stopRequested = true;
+        requestInterruption();
     }
 
     void JoystickRelayThread::updateSettings(const JoystickRelaySettings& relay_settings, const QVector<int>& field_roles) {
-        QMutexLocker locker(mutex);
-        relaySettings = relay_settings;
-        fieldRoles = field_roles;
+        {
+            QMutexLocker locker(mutex);
+            relaySettings = relay_settings;
+            fieldRoles = field_roles;
+            plotHandlesStale = true;
+        }
+        applyRelayRate();
+    }
+
+    void JoystickRelayThread::applyRelayRate() {
+        generic_thread_settings ts;
+        {
+            QMutexLocker locker(mutex);
+            ts = generic_thread_settings_;
+            // fallback to 40 Hz when the relay rate is not configured
+            const unsigned int hz = relaySettings.update_rate_hz > 0 ? static_cast<unsigned int>(relaySettings.update_rate_hz) : 40;
+            if (ts.update_rate_hz == hz) return;
+            ts.update_rate_hz = hz;
+        }
+        update_settings(&ts);
     }
 
     QString JoystickRelayThread::portName() const {
@@ -297,7 +315,10 @@ namespace remote_control {
         case JoystickRelaySettings::mavlink_rc_channels: {
             // All 18 channels; unassigned channels get UINT16_MAX ("not available").
             mavlink_rc_channels_t rc{};
-            rc.time_boot_ms = 0;
+            // vehicle boot time once TIMESYNC has converged, 0 ("unknown") before
+            qint64 vehicle_ns = 0;
+            if (vehicle_clock::to_vehicle_ns(s.sysid, time_base::now_ns(), vehicle_ns) && vehicle_ns > 0)
+                rc.time_boot_ms = static_cast<uint32_t>(vehicle_ns / 1000000LL);
             rc.chan1_raw  = getChan(0);
             rc.chan2_raw  = getChan(1);
             rc.chan3_raw  = getChan(2);
@@ -361,59 +382,55 @@ namespace remote_control {
         return QByteArray(reinterpret_cast<const char*>(buf), static_cast<int>(len));
     }
 
-    void JoystickRelayThread::run() {
-        // simple loop that periodically copies shared role values and emits them
-        while (true) {
-            {
-                QMutexLocker locker(mutex);
-                if (stopRequested) break;
-            }
-            bool enabled;
-            {
-                QMutexLocker locker(mutex);
-                enabled = relaySettings.enabled;
-            }
-            if (enabled) {
-                // Pack and send MAVLink bytes to the configured port.
-                JoystickRelaySettings settingsCopy;
-                QVector<int> rolesCopy;
-                uint8_t kgcSysidCopy;
-                kgroundcontrol_settings kgc_settings_copy; 
-                {
-                    QMutexLocker lk(mutex);
-                    settingsCopy  = relaySettings;
-                    rolesCopy     = fieldRoles;
-                    kgc_settings_copy  = kgroundcontrol_settings_;
-                }
-                if (!settingsCopy.Port_Name.isEmpty()) {
-                    QByteArray packed = packJoystickMavlink(settingsCopy, rolesCopy, kgc_settings_copy);
-                    if (!packed.isEmpty())
-                        emit write_to_port(packed);
-                }
+    void JoystickRelayThread::tick() {
+        // periodically copy shared role values and emit them
+        JoystickRelaySettings settingsCopy;
+        QVector<int> rolesCopy;
+        kgroundcontrol_settings kgc_settings_copy;
+        bool plotStale = false;
+        {
+            QMutexLocker lk(mutex);
+            if (!relaySettings.enabled) return;
+            settingsCopy  = relaySettings;
+            rolesCopy     = fieldRoles;
+            kgc_settings_copy  = kgroundcontrol_settings_;
+            plotStale = plotHandlesStale;
+            plotHandlesStale = false;
+        }
+        // Pack and send MAVLink bytes to the configured port.
+        if (!settingsCopy.Port_Name.isEmpty()) {
+            QByteArray packed = packJoystickMavlink(settingsCopy, rolesCopy, kgc_settings_copy);
+            if (!packed.isEmpty())
+                emit write_to_port(packed);
+        }
 
-                // Publish tagged relay field samples for plotting independent of UI lifetime.
-                const QString base = QString("remote_control/%1/").arg(settingsCopy.uid);
-                const auto taggedIds = PlotSignalRegistry::instance().taggedIdsByPrefix(base);
-                if (!taggedIds.isEmpty()) {
-                    const auto fields = relayFieldNames(settingsCopy);
-                    const qint64 t_ns = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch() * 1000000LL;
-                    for (int fi = 0; fi < fields.size(); ++fi) {
-                        const QString id = relayPlotSignalId(settingsCopy, fields[fi]);
-                        if (id.isEmpty() || !taggedIds.contains(id)) continue;
-
-                        double value = 0.0;
-                        if (fi >= 0 && fi < rolesCopy.size()) {
-                            const int role = rolesCopy[fi];
-                            if (role > 0) value = sharedRoleValues().getValue(role);
-                        }
-                        PlotSignalRegistry::instance().appendSample(id, t_ns, value);
-                    }
-                }
+        // Publish tagged relay field samples for plotting independent of UI lifetime.
+        PlotSignalRegistry& registry = PlotSignalRegistry::instance();
+        const quint64 generation = registry.tagGeneration();
+        if (plotStale || generation != plotHandlesGeneration) {
+            // resolve field -> handle once per tag or settings change
+            plotHandlesGeneration = generation;
+            plotHandles.clear();
+            const auto fields = relayFieldNames(settingsCopy);
+            for (int fi = 0; fi < fields.size(); ++fi) {
+                const QString id = relayPlotSignalId(settingsCopy, fields[fi]);
+                const PlotSignalHandle handle = id.isEmpty() ? kInvalidPlotSignalHandle : registry.handleOf(id);
+                if (handle != kInvalidPlotSignalHandle) plotHandles.append(qMakePair(handle, fi));
+            }
+        }
+        if (!plotHandles.isEmpty()) {
+            const qint64 t_ns = time_base::now_ns();
+            QVector<PlotSignalTuple> batch;
+            batch.reserve(plotHandles.size());
+            for (const auto& field : plotHandles) {
+                double value = 0.0;
+                if (field.second < rolesCopy.size()) {
+                    const int role = rolesCopy[field.second];
+                    if (role > 0) value = sharedRoleValues().getValue(role);
+                }
+                batch.append(PlotSignalTuple{ field.first, t_ns, value });
             }
-            // sleep according to configured rate (fallback to 40 Hz)
-            int hz = relaySettings.update_rate_hz > 0 ? relaySettings.update_rate_hz : 40;
-            int ms = 1000 / hz;
-            QThread::msleep(ms);
+            registry.appendBatch(batch);
         }
     }
 
@@ -539,6 +556,11 @@ namespace remote_control {
         m_connectionManager = cm;
     }
 
+    void manager::setCommandManager(command_manager* cm)
+    {
+        m_commandManager = cm;
+    }
+
     // checkRelayConnectable: port in avail list AND sysid seen AND compid observed.
     bool manager::checkRelayConnectable(int idx)
     {
@@ -1068,6 +1090,18 @@ namespace remote_control {
                 return; // Safety guard: skip axes, arm, or AUX pass-through channels safely
         }
 
+        // Acknowledged pathway: actions as-is, modes as MAV_CMD_DO_SET_MODE (SET_MODE has no ACK)
+        if (m_commandManager) {
+            if (isActionCommand)
+                m_commandManager->send_command(cmd.Port_Name, cmd.sysid, static_cast<uint8_t>(cmd.compid), actionCommandId,
+                                               {param1, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, param7});
+            else
+                m_commandManager->send_command(cmd.Port_Name, cmd.sysid, static_cast<uint8_t>(cmd.compid), MAV_CMD_DO_SET_MODE,
+                                               {static_cast<float>(MAV_MODE_FLAG_CUSTOM_MODE_ENABLED),
+                                                static_cast<float>(mainMode), static_cast<float>(subMode)});
+            return;
+        }
+
         // Pack the appropriate MAVLink packet context based on the mode type
         {
             QMutexLocker locker(mutex);
@@ -1118,6 +1152,11 @@ namespace remote_control {
     {
         if (!cmd.enabled) return;
 
+        if (m_commandManager) {
+            m_commandManager->toggle_arm_state(cmd.Port_Name, cmd.sysid, cmd.compid, active, cmd.armDisarm.force);
+            return;
+        }
+
         mavlink_message_t msg;
         {
             QMutexLocker locker(mutex);
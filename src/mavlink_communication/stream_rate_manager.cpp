@@ -0,0 +1,333 @@
+/****************************************************************************
+ *
+ *    Copyright (C) 2025  Yevhenii Kovryzhenko. All rights reserved.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU Affero General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License Version 3 for more details.
+ *
+ *    You should have received a copy of the
+ *    GNU Affero General Public License Version 3
+ *    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions, and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions, and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *    3. No ownership or credit shall be claimed by anyone not mentioned in
+ *       the above copyright statement.
+ *    4. Any redistribution or public use of this software, in whole or in part,
+ *       whether standalone or as part of a different project, must remain
+ *       under the terms of the GNU Affero General Public License Version 3,
+ *       and all distributions in binary form must be accompanied by a copy of
+ *       the source code, as stated in the GNU Affero General Public License.
+ *
+ ****************************************************************************/
+
+#include "mavlink_communication/stream_rate_manager.h"
+#include "plot/plot_signal_registry.h"
+#include "time_base.h"
+
+// Messages that are not periodic streams: protocol traffic and one-shot replies
+static bool is_stream_msgid(uint32_t msgid)
+{
+    switch (msgid)
+    {
+    case MAVLINK_MSG_ID_HEARTBEAT:
+    case MAVLINK_MSG_ID_PARAM_VALUE:
+    case MAVLINK_MSG_ID_PARAM_EXT_VALUE:
+    case MAVLINK_MSG_ID_COMMAND_LONG:
+    case MAVLINK_MSG_ID_COMMAND_INT:
+    case MAVLINK_MSG_ID_COMMAND_ACK:
+    case MAVLINK_MSG_ID_TIMESYNC:
+    case MAVLINK_MSG_ID_PING:
+    case MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL:
+    case MAVLINK_MSG_ID_STATUSTEXT:
+    case MAVLINK_MSG_ID_MISSION_COUNT:
+    case MAVLINK_MSG_ID_MISSION_ITEM_INT:
+    case MAVLINK_MSG_ID_MISSION_REQUEST_INT:
+    case MAVLINK_MSG_ID_MISSION_ACK:
+    case MAVLINK_MSG_ID_LOG_ENTRY:
+    case MAVLINK_MSG_ID_LOG_DATA:
+    case MAVLINK_MSG_ID_AUTOPILOT_VERSION:
+    case MAVLINK_MSG_ID_PROTOCOL_VERSION:
+        return false;
+    default:
+        return true;
+    }
+}
+
+// Messages decoded into vehicle_state (see vehicle_state.cpp)
+static bool is_baseline_msgid(uint32_t msgid)
+{
+    switch (msgid)
+    {
+    case MAVLINK_MSG_ID_ATTITUDE:
+    case MAVLINK_MSG_ID_LOCAL_POSITION_NED:
+    case MAVLINK_MSG_ID_GLOBAL_POSITION_INT:
+    case MAVLINK_MSG_ID_SYS_STATUS:
+    case MAVLINK_MSG_ID_BATTERY_STATUS:
+        return true;
+    default:
+        return false;
+    }
+}
+
+
+
+stream_rate_manager::stream_rate_manager(QObject* parent, generic_thread_settings* settings_in_, mavlink_manager* mavlink_manager_in_,
+                                         command_manager* command_manager_in_, timesync_manager* timesync_manager_in_)
+    : periodic_task(parent, settings_in_),
+      mavlink_manager_(mavlink_manager_in_),
+      command_manager_(command_manager_in_),
+      timesync_manager_(timesync_manager_in_)
+{
+    setObjectName("stream_rate_manager");
+    start(generic_thread_settings_.priority);
+}
+
+stream_rate_manager::~stream_rate_manager()
+{
+    periodic_scheduler::instance().remove_and_wait(this);
+}
+
+void stream_rate_manager::set_viewer_demand(quintptr viewer, QVector<quint64> keys)
+{
+    mutex->lock();
+    if (keys.isEmpty()) viewer_demand_.remove(viewer);
+    else viewer_demand_.insert(viewer, QSet<quint64>(keys.cbegin(), keys.cend()));
+    demand_changed_ = true;
+    mutex->unlock();
+}
+
+void stream_rate_manager::command_finished(quint64 transaction_id, uint8_t sysid, uint8_t compid, uint16_t command, int result, qint64)
+{
+    if (command != MAV_CMD_SET_MESSAGE_INTERVAL) return;
+    // may be called from inside send_command() in tick(): hand over without locking
+    results_.push({transaction_id, sysid, compid, result});
+}
+
+void stream_rate_manager::update_kgroundcontrol_settings(kgroundcontrol_settings* kground_control_settings_in_)
+{
+    mutex->lock();
+    kgroundcontrol_settings_ = *kground_control_settings_in_;
+    demand_changed_ = true;
+    mutex->unlock();
+}
+
+void stream_rate_manager::tick()
+{
+    if (mavlink_manager_.isNull() || command_manager_.isNull()) return;
+    const qint64 now_ns = time_base::now_ns();
+    QVector<send_request> requests;
+
+    mutex->lock();
+    result_entry result;
+    while (results_.pop(result)) process_result(result, now_ns);
+
+    update_plot_demand();
+    if (now_ns - last_evaluation_ns_ >= evaluation_period_ns
+        || (demand_changed_ && now_ns - last_evaluation_ns_ >= min_evaluation_period_ns))
+    {
+        evaluate(now_ns);
+        last_evaluation_ns_ = now_ns;
+        demand_changed_ = false;
+    }
+    collect_requests(now_ns, requests);
+    mutex->unlock();
+
+    for (const send_request& request : requests)
+    {
+        const quint64 id = command_manager_->send_command(request.port_name, static_cast<uint8_t>(request.target >> 8), static_cast<uint8_t>(request.target & 0xFF),
+                                                          MAV_CMD_SET_MESSAGE_INTERVAL, {static_cast<float>(request.msgid), static_cast<float>(request.interval_us)});
+        mutex->lock();
+        auto it = targets_.find(request.target);
+        if (it != targets_.end()) it->transaction_id = id;
+        mutex->unlock();
+    }
+}
+
+// caller holds mutex
+void stream_rate_manager::update_plot_demand(void)
+{
+    PlotSignalRegistry& registry = PlotSignalRegistry::instance();
+    const quint64 generation = registry.tagGeneration();
+    if (generation == tag_generation_) return;
+    tag_generation_ = generation;
+
+    // "mavlink/<sysid>/<compid>/<msgid>/<field>"
+    plot_demand_.clear();
+    const QSet<QString> ids = registry.taggedIdsByPrefix("mavlink/");
+    for (const QString& id : ids)
+    {
+        const QStringList parts = id.split('/');
+        if (parts.size() < 5) continue;
+        bool ok_sysid = false, ok_compid = false, ok_msgid = false;
+        const uint sysid = parts[1].toUInt(&ok_sysid);
+        const uint compid = parts[2].toUInt(&ok_compid);
+        const uint msgid = parts[3].toUInt(&ok_msgid);
+        if (!(ok_sysid && ok_compid && ok_msgid) || sysid > 255 || compid > 255) continue;
+        plot_demand_.insert(mavlink_manager::message_key(static_cast<uint8_t>(sysid), static_cast<uint8_t>(compid), msgid));
+    }
+    demand_changed_ = true;
+}
+
+// caller holds mutex
+void stream_rate_manager::evaluate(qint64 now_ns)
+{
+    const bool enabled = kgroundcontrol_settings_.stream_rate_auto;
+    const double budget = static_cast<double>(kgroundcontrol_settings_.stream_budget_bytes_per_s);
+    QHash<QString, QVector<quint64>> port_streams; // managed streams per link
+
+    const QVector<uint8_t> sysids = mavlink_manager_->get_sysids();
+    for (const uint8_t sysid : sysids)
+    {
+        // the port a vehicle is reachable on is learned from its TIMESYNC replies
+        timesync_estimate estimate;
+        if (timesync_manager_.isNull() || !timesync_manager_->get_estimate(sysid, estimate) || estimate.port_name.isEmpty()) continue;
+        QVector<QString> routes;
+        const bool routed = (emit get_routing(estimate.port_name, routes)) && !routes.isEmpty();
+
+        const QVector<mavlink_enums::mavlink_component_id> compids = mavlink_manager_->get_compids(sysid);
+        for (const mavlink_enums::mavlink_component_id compid_ : compids)
+        {
+            const uint8_t compid = static_cast<uint8_t>(compid_);
+            QVector<mavlink_stream_info> infos;
+            if (!mavlink_manager_->get_streams(sysid, compid, infos)) continue;
+            target_state& target = targets_[target_key(sysid, compid)];
+            target.port_name = estimate.port_name;
+
+            for (const mavlink_stream_info& info : infos)
+            {
+                if (!is_stream_msgid(info.msgid) || info.stats.intervals < 3) continue;
+                const quint64 key = mavlink_manager::message_key(sysid, compid, info.msgid);
+                stream_state& stream = streams_[key];
+                stream.len = info.len;
+                stream.last_ns = info.stats.last_ns;
+                if (stream.requested_interval_us == 0 && !(target.in_flight && target.stream_key == key))
+                    stream.default_rate_hz = info.stats.rate_hz;
+
+                bool viewed = plot_demand_.contains(key);
+                for (auto it = viewer_demand_.cbegin(); !viewed && it != viewer_demand_.cend(); ++it) viewed = it->contains(key);
+                stream.cls = viewed ? NEEDED : (is_baseline_msgid(info.msgid) ? BASELINE : IDLE);
+
+                // a stream we slowed down (down to starved_rate_hz) is only stale after missing a few of its own intervals
+                qint32 slowest_interval_us = stream.requested_interval_us;
+                if (target.in_flight && target.stream_key == key) slowest_interval_us = qMax(slowest_interval_us, target.interval_us);
+                const qint64 stale_ns = qMax(stale_stream_ns, stale_intervals * 1000LL * slowest_interval_us);
+                if (!enabled || routed || now_ns - stream.last_ns > stale_ns || stream.default_rate_hz <= 0.0)
+                {
+                    stream.desired_interval_us = 0; // back to (or stay at) the vehicle default
+                    continue;
+                }
+                port_streams[estimate.port_name].append(key);
+            }
+        }
+    }
+
+    for (auto port = port_streams.cbegin(); port != port_streams.cend(); ++port)
+    {
+        const QVector<quint64>& keys = port.value();
+        QVector<double> rates(keys.size());
+        double needed_cost = 0.0, other_cost = 0.0;
+        for (int i = 0; i < keys.size(); i++)
+        {
+            const stream_state& stream = streams_[keys[i]];
+            switch (stream.cls)
+            {
+            case NEEDED:   rates[i] = qMax(stream.default_rate_hz, needed_rate_hz); break;
+            case BASELINE: rates[i] = qMin(stream.default_rate_hz, baseline_rate_hz); break;
+            case IDLE:     rates[i] = qMin(stream.default_rate_hz, idle_rate_hz); break;
+            }
+            const double cost = rates[i] * (stream.len + frame_overhead_bytes);
+            if (stream.cls == NEEDED) needed_cost += cost;
+            else other_cost += cost;
+        }
+
+        if (budget > 0.0 && needed_cost + other_cost > budget)
+        {
+            // idle streams give way first, then needed streams share what is left
+            other_cost = 0.0;
+            for (int i = 0; i < keys.size(); i++)
+            {
+                const stream_state& stream = streams_[keys[i]];
+                if (stream.cls == NEEDED) continue;
+                if (stream.cls == IDLE) rates[i] = qMin(stream.default_rate_hz, starved_rate_hz);
+                other_cost += rates[i] * (stream.len + frame_overhead_bytes);
+            }
+            if (needed_cost > 0.0 && needed_cost + other_cost > budget)
+            {
+                const double scale = qMax(0.0, budget - other_cost) / needed_cost;
+                for (int i = 0; i < keys.size(); i++)
+                {
+                    if (streams_[keys[i]].cls == NEEDED) rates[i] = qMax(rates[i] * scale, idle_rate_hz);
+                }
+            }
+        }
+
+        for (int i = 0; i < keys.size(); i++)
+        {
+            stream_state& stream = streams_[keys[i]];
+            // within 10% of the default is left to the vehicle
+            if (qAbs(rates[i] - stream.default_rate_hz) <= 0.1 * stream.default_rate_hz) stream.desired_interval_us = 0;
+            else stream.desired_interval_us = interval_us(rates[i]);
+        }
+    }
+}
+
+// caller holds mutex; one request per target in flight
+void stream_rate_manager::collect_requests(qint64 now_ns, QVector<send_request> &requests_out)
+{
+    for (auto it = streams_.begin(); it != streams_.end(); ++it)
+    {
+        stream_state& stream = it.value();
+        if (stream.rejected || stream.desired_interval_us == stream.requested_interval_us) continue;
+        const quint64 key = it.key();
+        const uint8_t sysid = static_cast<uint8_t>(key >> 32);
+        const uint8_t compid = static_cast<uint8_t>(key >> 24);
+        const quint16 tk = target_key(sysid, compid);
+        auto target = targets_.find(tk);
+        if (target == targets_.end() || target->in_flight || target->unsupported || now_ns < target->retry_ns || target->port_name.isEmpty()) continue;
+
+        target->in_flight = true;
+        target->transaction_id = 0;
+        target->stream_key = key;
+        target->interval_us = stream.desired_interval_us;
+        requests_out.append({tk, target->port_name, static_cast<uint32_t>(key & 0xFFFFFF), stream.desired_interval_us});
+    }
+}
+
+// caller holds mutex
+void stream_rate_manager::process_result(const result_entry &entry, qint64 now_ns)
+{
+    auto target = targets_.find(target_key(entry.sysid, entry.compid));
+    if (target == targets_.end() || !target->in_flight || target->transaction_id != entry.transaction_id) return;
+    target->in_flight = false;
+
+    auto stream = streams_.find(target->stream_key);
+    switch (entry.result)
+    {
+    case MAV_RESULT_ACCEPTED:
+        if (stream != streams_.end()) stream->requested_interval_us = target->interval_us;
+        break;
+    case MAV_RESULT_UNSUPPORTED:
+        target->unsupported = true;
+        break;
+    case MAV_RESULT_DENIED:
+    case MAV_RESULT_FAILED:
+        if (stream != streams_.end()) stream->rejected = true;
+        break;
+    default:
+        // temporarily rejected, no ACK, superseded or not sent: try again later
+        target->retry_ns = now_ns + retry_delay_ns;
+        break;
+    }
+}
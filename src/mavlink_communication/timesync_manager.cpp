@@ -0,0 +1,313 @@
+/****************************************************************************
+ *
+ *    Copyright (C) 2025  Yevhenii Kovryzhenko. All rights reserved.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU Affero General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License Version 3 for more details.
+ *
+ *    You should have received a copy of the
+ *    GNU Affero General Public License Version 3
+ *    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions, and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions, and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *    3. No ownership or credit shall be claimed by anyone not mentioned in
+ *       the above copyright statement.
+ *    4. Any redistribution or public use of this software, in whole or in part,
+ *       whether standalone or as part of a different project, must remain
+ *       under the terms of the GNU Affero General Public License Version 3,
+ *       and all distributions in binary form must be accompanied by a copy of
+ *       the source code, as stated in the GNU Affero General Public License.
+ *
+ ****************************************************************************/
+
+#include "mavlink_communication/timesync_manager.h"
+#include "plot/plot_signal_registry.h"
+#include "time_base.h"
+
+#include <algorithm>
+
+std::atomic<qint64> vehicle_clock::offsets_ns_[256];
+std::atomic<bool> vehicle_clock::valid_[256];
+
+bool vehicle_clock::get_offset_ns(uint8_t sysid, qint64 &offset_ns_out)
+{
+    if (!valid_[sysid].load(std::memory_order_acquire)) return false;
+    offset_ns_out = offsets_ns_[sysid].load(std::memory_order_relaxed);
+    return true;
+}
+
+bool vehicle_clock::to_vehicle_ns(uint8_t sysid, qint64 t_ns, qint64 &vehicle_ns_out)
+{
+    qint64 offset_ns;
+    if (!get_offset_ns(sysid, offset_ns)) return false;
+    vehicle_ns_out = t_ns + offset_ns;
+    return true;
+}
+
+void vehicle_clock::publish(uint8_t sysid, qint64 offset_ns)
+{
+    offsets_ns_[sysid].store(offset_ns, std::memory_order_relaxed);
+    valid_[sysid].store(true, std::memory_order_release);
+}
+
+void vehicle_clock::invalidate(uint8_t sysid)
+{
+    valid_[sysid].store(false, std::memory_order_release);
+}
+
+
+
+QString timesync_estimate::get_QString(qint64 now_ns) const
+{
+    if (samples == 0) return "Timesync: no replies";
+    QString txt = QString("Timesync via %1 (component %2): %3\n").arg(port_name).arg(compid).arg(converged ? "converged" : "converging");
+    txt += QString("Latency: %1 ms (RTT %2 ms, min %3 ms)\n")
+               .arg(time_base::ns_to_ms(latency_ns()), 0, 'f', 2)
+               .arg(time_base::ns_to_ms(rtt_ns), 0, 'f', 2)
+               .arg(time_base::ns_to_ms(rtt_min_ns), 0, 'f', 2);
+    txt += QString("Clock offset: %1 s\n").arg(static_cast<double>(offset_ns) * 1.0E-9, 0, 'f', 6);
+    txt += QString("Samples: %1, rejected: %2, last %3 s ago")
+               .arg(samples).arg(rejected)
+               .arg(static_cast<double>(now_ns - last_sample_ns) * 1.0E-9, 0, 'f', 1);
+    return txt;
+}
+
+
+
+timesync_manager::timesync_manager(QObject* parent, generic_thread_settings* settings_in_, mavlink_manager* mavlink_manager_in_)
+    : periodic_task(parent, settings_in_), mavlink_manager_(mavlink_manager_in_)
+{
+    setObjectName("timesync_manager");
+    mavlink_manager_->subscribe(MAVLINK_MSG_ID_TIMESYNC, this);
+    start(generic_thread_settings_.priority);
+}
+
+timesync_manager::~timesync_manager()
+{
+    if (!mavlink_manager_.isNull()) mavlink_manager_->unsubscribe(this);
+    periodic_scheduler::instance().remove_and_wait(this);
+    for (auto it = estimates_.cbegin(); it != estimates_.cend(); ++it) vehicle_clock::invalidate(it.key());
+}
+
+QString timesync_manager::latency_signal_id(uint8_t sysid)
+{
+    return QString("timesync/%1/latency_ms").arg(sysid);
+}
+
+QString timesync_manager::rtt_signal_id(uint8_t sysid)
+{
+    return QString("timesync/%1/rtt_ms").arg(sysid);
+}
+
+void timesync_manager::on_message(const mavlink_message_t& msg, qint64 t_ns)
+{
+    const bool res = inbox_.push_with([&msg, t_ns](inbox_entry& entry)
+    {
+        entry.t_ns = t_ns;
+        entry.sysid = msg.sysid;
+        entry.compid = msg.compid;
+        mavlink_msg_timesync_decode(&msg, &entry.timesync);
+    });
+    if (!res) inbox_dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool timesync_manager::get_estimate(uint8_t sysid, timesync_estimate &estimate_out)
+{
+    mutex->lock();
+    auto it = estimates_.constFind(sysid);
+    const bool res = it != estimates_.cend();
+    if (res) estimate_out = it.value();
+    mutex->unlock();
+    return res;
+}
+
+QString timesync_manager::get_report_QString(void)
+{
+    const qint64 now_ns = time_base::now_ns();
+    mutex->lock();
+    QList<uint8_t> sysids = estimates_.keys();
+    std::sort(sysids.begin(), sysids.end());
+    QString txt;
+    for (const uint8_t sysid : sysids)
+    {
+        if (!txt.isEmpty()) txt += "\n";
+        txt += QString("System %1: %2").arg(sysid).arg(estimates_.value(sysid).get_QString(now_ns));
+    }
+    mutex->unlock();
+    return txt;
+}
+
+void timesync_manager::update_kgroundcontrol_settings(kgroundcontrol_settings* kground_control_settings_in_)
+{
+    mutex->lock();
+    kgroundcontrol_settings_ = *kground_control_settings_in_;
+    mutex->unlock();
+}
+
+void timesync_manager::tick()
+{
+    QVector<QPair<QString, mavlink_message_t>> outgoing;
+    QVector<PlotSignalTuple> plot_samples;
+    const QVector<QString> all_ports = emit get_port_names();
+
+    // resolve plot handles once per tag change; only tick() touches the cache
+    PlotSignalRegistry& registry = PlotSignalRegistry::instance();
+    const quint64 tag_generation = registry.tagGeneration();
+    if (tag_generation != plot_handles_generation_)
+    {
+        plot_handles_generation_ = tag_generation;
+        plot_handles_.clear();
+    }
+
+    mutex->lock();
+    inbox_entry entry;
+    while (inbox_.pop(entry))
+    {
+        const mavlink_timesync_t& ts = entry.timesync;
+        if (ts.tc1 == 0)
+        {
+            // request from the vehicle: answer with our time at the midpoint of the hold
+            const qint64 now_ns = time_base::now_ns();
+            mavlink_timesync_t reply{};
+            reply.tc1 = entry.t_ns + (now_ns - entry.t_ns) / 2;
+            reply.ts1 = ts.ts1;
+            reply.target_system = entry.sysid;
+            reply.target_component = entry.compid;
+            mavlink_message_t message;
+            mavlink_msg_timesync_encode(kgroundcontrol_settings_.sysid, static_cast<uint8_t>(kgroundcontrol_settings_.compid), &message, &reply);
+
+            auto it = estimates_.constFind(entry.sysid);
+            if (it != estimates_.cend() && !it->port_name.isEmpty())
+            {
+                outgoing.append({it->port_name, message});
+            }
+            else
+            {
+                // port not learned yet
+                for (const QString& port_name : all_ports) outgoing.append({port_name, message});
+            }
+            continue;
+        }
+
+        if (ts.target_system != 0 && ts.target_system != kgroundcontrol_settings_.sysid) continue;
+        const qint64 rtt_ns = entry.t_ns - ts.ts1;
+        auto pending = pending_.find(ts.ts1);
+        if (pending == pending_.end() || rtt_ns < 0 || rtt_ns > max_rtt_ns) continue; // not ours, or too late
+
+        timesync_estimate& estimate = estimates_[entry.sysid];
+        estimate.port_name = pending.value();
+        estimate.compid = entry.compid;
+        // pending entries stay until they expire: every vehicle on the port answers the same request
+
+        // offset assuming symmetric link delay: vehicle stamp taken at the midpoint of the round trip
+        const qint64 offset_sample_ns = ts.tc1 - (ts.ts1 + rtt_ns / 2);
+
+        if (estimate.samples == 0)
+        {
+            estimate.offset_ns = offset_sample_ns;
+            estimate.rtt_ns = rtt_ns;
+            estimate.rtt_min_ns = rtt_ns;
+        }
+        else
+        {
+            if (estimate.converged && rtt_ns > 3 * estimate.rtt_ns + 10000000LL)
+            {
+                estimate.rejected++;
+                continue;
+            }
+            if (qAbs(offset_sample_ns - estimate.offset_ns) > offset_jump_ns)
+            {
+                if (++estimate.offset_outliers < offset_jump_samples) continue;
+                // the vehicle clock moved (reboot or step): start over from this sample
+                reset_estimate(entry.sysid, estimate);
+                estimate.offset_ns = offset_sample_ns;
+                estimate.rtt_ns = rtt_ns;
+                estimate.rtt_min_ns = rtt_ns;
+            }
+            else
+            {
+                const double gain = estimate.samples < static_cast<quint64>(convergence_samples) ? converging_gain : tracking_gain;
+                estimate.offset_ns += static_cast<qint64>(gain * static_cast<double>(offset_sample_ns - estimate.offset_ns));
+                estimate.rtt_ns += static_cast<qint64>(gain * static_cast<double>(rtt_ns - estimate.rtt_ns));
+                estimate.rtt_min_ns = qMin(estimate.rtt_min_ns, rtt_ns);
+            }
+        }
+        estimate.offset_outliers = 0;
+        estimate.samples++;
+        estimate.last_sample_ns = entry.t_ns;
+        if (estimate.samples >= static_cast<quint64>(convergence_samples)) estimate.converged = true;
+        if (estimate.converged) vehicle_clock::publish(entry.sysid, estimate.offset_ns);
+
+        auto handles = plot_handles_.constFind(entry.sysid);
+        if (handles == plot_handles_.constEnd())
+        {
+            handles = plot_handles_.insert(entry.sysid, qMakePair(registry.handleOf(latency_signal_id(entry.sysid)), registry.handleOf(rtt_signal_id(entry.sysid))));
+        }
+        if (handles->first != kInvalidPlotSignalHandle) plot_samples.append(PlotSignalTuple{handles->first, entry.t_ns, time_base::ns_to_ms(estimate.latency_ns())});
+        if (handles->second != kInvalidPlotSignalHandle) plot_samples.append(PlotSignalTuple{handles->second, entry.t_ns, time_base::ns_to_ms(rtt_ns)});
+    }
+
+    const qint64 now_ns = time_base::now_ns();
+
+    // expire requests that can no longer be answered in time, and stale estimates
+    for (auto it = pending_.begin(); it != pending_.end();)
+    {
+        if (now_ns - it.key() > max_rtt_ns) it = pending_.erase(it);
+        else ++it;
+    }
+    bool converging = false;
+    for (auto it = estimates_.begin(); it != estimates_.end(); ++it)
+    {
+        if (it->converged && now_ns - it->last_sample_ns > stale_timeout_ns)
+        {
+            reset_estimate(it.key(), it.value());
+        }
+        if (!it->converged && now_ns - it->last_sample_ns < stale_timeout_ns) converging = true;
+    }
+
+    if (now_ns >= next_request_ns_)
+    {
+        next_request_ns_ = now_ns + (converging ? converging_request_period_ns : request_period_ns);
+        for (const QString& port_name : all_ports)
+        {
+            // distinct ts1 per port: the echo identifies the port the vehicle is on
+            const qint64 ts1 = qMax(time_base::now_ns(), last_ts1_ + 1);
+            last_ts1_ = ts1;
+            mavlink_timesync_t request{};
+            request.tc1 = 0;
+            request.ts1 = ts1;
+            QPair<QString, mavlink_message_t> out;
+            out.first = port_name;
+            mavlink_msg_timesync_encode(kgroundcontrol_settings_.sysid, static_cast<uint8_t>(kgroundcontrol_settings_.compid), &out.second, &request);
+            outgoing.append(out);
+            pending_.insert(ts1, port_name);
+        }
+    }
+    mutex->unlock();
+
+    for (auto& out : outgoing) emit write_message(out.first, &out.second);
+    registry.appendBatch(plot_samples);
+}
+
+// caller holds mutex
+void timesync_manager::reset_estimate(uint8_t sysid, timesync_estimate &estimate)
+{
+    vehicle_clock::invalidate(sysid);
+    const QString port_name = estimate.port_name;
+    const uint8_t compid = estimate.compid;
+    estimate = timesync_estimate();
+    estimate.port_name = port_name;
+    estimate.compid = compid;
+}
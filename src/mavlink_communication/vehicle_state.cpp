@@ -0,0 +1,182 @@
+/****************************************************************************
+ *
+ *    Copyright (C) 2025  Yevhenii Kovryzhenko. All rights reserved.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU Affero General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License Version 3 for more details.
+ *
+ *    You should have received a copy of the
+ *    GNU Affero General Public License Version 3
+ *    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions, and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions, and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *    3. No ownership or credit shall be claimed by anyone not mentioned in
+ *       the above copyright statement.
+ *    4. Any redistribution or public use of this software, in whole or in part,
+ *       whether standalone or as part of a different project, must remain
+ *       under the terms of the GNU Affero General Public License Version 3,
+ *       and all distributions in binary form must be accompanied by a copy of
+ *       the source code, as stated in the GNU Affero General Public License.
+ *
+ ****************************************************************************/
+
+#include <cmath>
+
+#include "mavlink_communication/vehicle_state.h"
+
+bool vehicle_state::update(const mavlink_message_t &msg, qint64 t_ns)
+{
+    mavlink_message_t* msg_ = const_cast<mavlink_message_t*>(&msg);
+
+    switch (msg.msgid)
+    {
+    case MAVLINK_MSG_ID_HEARTBEAT:
+    {
+        mavlink_heartbeat_t heartbeat;
+        mavlink_msg_heartbeat_decode(msg_, &heartbeat);
+        // ground stations, cameras and the like also send heartbeats; only the autopilot defines mode and arming
+        if (heartbeat.autopilot == MAV_AUTOPILOT_INVALID) return false;
+        heartbeat_ns = t_ns;
+        autopilot_compid = msg.compid;
+        type = heartbeat.type;
+        autopilot = heartbeat.autopilot;
+        base_mode = heartbeat.base_mode;
+        system_status = heartbeat.system_status;
+        custom_mode = heartbeat.custom_mode;
+        armed = (heartbeat.base_mode & MAV_MODE_FLAG_SAFETY_ARMED) != 0;
+        return true;
+    }
+    case MAVLINK_MSG_ID_ATTITUDE:
+    {
+        mavlink_attitude_t attitude;
+        mavlink_msg_attitude_decode(msg_, &attitude);
+        attitude_ns = t_ns;
+        roll = attitude.roll;
+        pitch = attitude.pitch;
+        yaw = attitude.yaw;
+        rollspeed = attitude.rollspeed;
+        pitchspeed = attitude.pitchspeed;
+        yawspeed = attitude.yawspeed;
+        return true;
+    }
+    case MAVLINK_MSG_ID_LOCAL_POSITION_NED:
+    {
+        mavlink_local_position_ned_t local;
+        mavlink_msg_local_position_ned_decode(msg_, &local);
+        local_position_ns = t_ns;
+        x = local.x;
+        y = local.y;
+        z = local.z;
+        vx = local.vx;
+        vy = local.vy;
+        vz = local.vz;
+        return true;
+    }
+    case MAVLINK_MSG_ID_GLOBAL_POSITION_INT:
+    {
+        mavlink_global_position_int_t global;
+        mavlink_msg_global_position_int_decode(msg_, &global);
+        global_position_ns = t_ns;
+        lat_deg = static_cast<double>(global.lat) * 1.0E-7;
+        lon_deg = static_cast<double>(global.lon) * 1.0E-7;
+        alt_m = static_cast<float>(global.alt) * 1.0E-3f;
+        relative_alt_m = static_cast<float>(global.relative_alt) * 1.0E-3f;
+        ground_vx = static_cast<float>(global.vx) * 1.0E-2f;
+        ground_vy = static_cast<float>(global.vy) * 1.0E-2f;
+        ground_vz = static_cast<float>(global.vz) * 1.0E-2f;
+        heading_deg = global.hdg == UINT16_MAX ? NAN : static_cast<float>(global.hdg) * 1.0E-2f;
+        return true;
+    }
+    case MAVLINK_MSG_ID_SYS_STATUS:
+    {
+        mavlink_sys_status_t status;
+        mavlink_msg_sys_status_decode(msg_, &status);
+        battery_ns = t_ns;
+        battery_voltage_v = status.voltage_battery == UINT16_MAX ? NAN : static_cast<float>(status.voltage_battery) * 1.0E-3f;
+        battery_current_a = status.current_battery < 0 ? NAN : static_cast<float>(status.current_battery) * 1.0E-2f;
+        battery_remaining_pct = status.battery_remaining;
+        return true;
+    }
+    case MAVLINK_MSG_ID_BATTERY_STATUS:
+    {
+        mavlink_battery_status_t battery;
+        mavlink_msg_battery_status_decode(msg_, &battery);
+        if (battery.id != 0) return false; // first battery only, matching SYS_STATUS
+        // pack voltage: sum of the reported cells
+        float voltage_v = 0.0f;
+        bool any_cell = false;
+        for (int i = 0; i < 10; i++)
+        {
+            if (battery.voltages[i] == UINT16_MAX) break;
+            voltage_v += static_cast<float>(battery.voltages[i]) * 1.0E-3f;
+            any_cell = true;
+        }
+        battery_ns = t_ns;
+        if (any_cell) battery_voltage_v = voltage_v;
+        if (battery.current_battery >= 0) battery_current_a = static_cast<float>(battery.current_battery) * 1.0E-2f;
+        battery_remaining_pct = battery.battery_remaining;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+double vehicle_state::link_loss_ratio(void) const
+{
+    const quint64 expected = rx_count + lost_count;
+    if (expected == 0) return 0.0;
+    return static_cast<double>(lost_count) / static_cast<double>(expected);
+}
+
+QString vehicle_state::get_QString(qint64 now_ns) const
+{
+    QString txt = QString("System %1\n").arg(sysid);
+    if (heartbeat_ns > 0)
+    {
+        txt += QString("Heartbeat: %1 s ago, %2, mode 0x%3/%4\n")
+                   .arg(static_cast<double>(now_ns - heartbeat_ns) * 1.0E-9, 0, 'f', 1)
+                   .arg(armed ? "ARMED" : "DISARMED")
+                   .arg(base_mode, 2, 16, QChar('0'))
+                   .arg(custom_mode);
+    }
+    if (attitude_ns > 0)
+    {
+        txt += QString("Attitude (deg): %1 %2 %3\n")
+                   .arg(roll * 180.0 / M_PI, 0, 'f', 1)
+                   .arg(pitch * 180.0 / M_PI, 0, 'f', 1)
+                   .arg(yaw * 180.0 / M_PI, 0, 'f', 1);
+    }
+    if (local_position_ns > 0)
+    {
+        txt += QString("Local NED (m): %1 %2 %3\n").arg(x, 0, 'f', 2).arg(y, 0, 'f', 2).arg(z, 0, 'f', 2);
+    }
+    if (global_position_ns > 0)
+    {
+        txt += QString("Global: %1, %2, %3 m\n").arg(lat_deg, 0, 'f', 7).arg(lon_deg, 0, 'f', 7).arg(alt_m, 0, 'f', 1);
+    }
+    if (battery_ns > 0)
+    {
+        txt += QString("Battery: %1 V, %2 A, %3 %\n")
+                   .arg(battery_voltage_v, 0, 'f', 2)
+                   .arg(battery_current_a, 0, 'f', 2)
+                   .arg(battery_remaining_pct);
+    }
+    txt += QString("Link: %1 received, %2 lost (%3 %)")
+               .arg(rx_count)
+               .arg(lost_count)
+               .arg(100.0 * link_loss_ratio(), 0, 'f', 1);
+    return txt;
+}
@@ -61,6 +61,8 @@
 #include <QHBoxLayout>
 #include "plot/plot_signal_registry.h"
 #include "plot/plot_signal_ui_helpers.h"
+#include "time_base.h"
+#include "mavlink_communication/timesync_manager.h"
 // no extra includes needed; timer declared in header
 #include <QSettings>
 #include <QWindow>
@@ -176,7 +178,7 @@ QString mocap_data_t::get_QString(void)
                    "Roll: %12 (deg)\n"
                    "Pitch: %13 (deg)\n"
                    "Yaw: %14 (deg)\n")
-    .arg(time_ms)
+    .arg(time_base::ns_to_ms(time_ns), 0, 'f', 3)
     .arg(freq_hz, 0, 'f', 2)
         .arg(id)
         .arg(trackingValid ? "YES" : "NO")
@@ -203,7 +205,7 @@ bool mocap_data_t::equals(const mocap_data_t& other) const
            x == other.x &&
            y == other.y &&
            z == other.z &&
-           time_ms == other.time_ms &&
+           time_ns == other.time_ns &&
            roll == other.roll &&
            pitch == other.pitch &&
            yaw == other.yaw;
@@ -236,7 +238,7 @@ void mocap_data_aggegator::clear(void)
         frame_ids_.clear();
         frames_.clear();
         frame_id_to_index_.clear();
-        last_time_ms_.clear();
+        last_time_ns_.clear();
     }
     mutex->unlock();
 }
@@ -244,12 +246,12 @@ void mocap_data_aggegator::clear(void)
 void mocap_data_aggegator::cleanup_stale_frames()
 {
     mutex->lock();
-    uint64_t current_time = QDateTime::currentMSecsSinceEpoch();
-    const uint64_t timeout_ms = 30000; // 30 seconds
+    const qint64 current_time = time_base::now_ns();
+    const qint64 timeout_ns = 30000000000LL; // 30 seconds
     QVector<int> ids_to_remove;
 
-    for (auto it = last_time_ms_.begin(); it != last_time_ms_.end(); ++it) {
-        if (current_time - it.value() > timeout_ms) {
+    for (auto it = last_time_ns_.begin(); it != last_time_ns_.end(); ++it) {
+        if (current_time - it.value() > timeout_ns) {
             ids_to_remove.append(it.key());
         }
     }
@@ -261,7 +263,7 @@ void mocap_data_aggegator::cleanup_stale_frames()
                 frames_.removeAt(index);
                 frame_ids_.removeAll(id);
                 frame_id_to_index_.remove(id);
-                last_time_ms_.remove(id);
+                last_time_ns_.remove(id);
 
                 // Update indices for remaining frames
                 for (int i = index; i < frames_.size(); ++i) {
@@ -274,12 +276,12 @@ void mocap_data_aggegator::cleanup_stale_frames()
     mutex->unlock();
 }
 
-void mocap_data_aggegator::update(QVector<optitrack_message_t> incoming_data, mocap_rotation rotation)
+void mocap_data_aggegator::update(QVector<optitrack_message_t> incoming_data, mocap_rotation rotation, qint64 rx_time_ns)
 {
     mutex->lock();
     bool frame_ids_updated_ = false;
     QVector<mocap_data_t> updated_frames;
-    uint64_t timestamp = QDateTime::currentMSecsSinceEpoch();
+    const qint64 timestamp = rx_time_ns > 0 ? rx_time_ns : time_base::now_ns();
     foreach(auto msg, incoming_data)
     {
         optitrack_message_t msg_NED = msg;
@@ -303,26 +305,26 @@ void mocap_data_aggegator::update(QVector<optitrack_message_t> incoming_data, mo
             frame_ids_updated_ = true;
 
             __copy_data(frame, msg_NED);
-            frame.time_ms = timestamp;
+            frame.time_ns = timestamp;
             // initialize frequency tracking
-            uint64_t prev = last_time_ms_.value(msg_NED.id, 0);
+            const qint64 prev = last_time_ns_.value(msg_NED.id, 0);
             if (prev > 0)
             {
-                double dt = static_cast<double>(timestamp - prev) / 1000.0;
+                double dt = static_cast<double>(timestamp - prev) * 1.0E-9;
                 if (dt > 0.0) frame.freq_hz = 1.0 / dt;
             }
-            last_time_ms_[msg_NED.id] = timestamp;
+            last_time_ns_[msg_NED.id] = timestamp;
             frames_.push_back(frame);
         }
         else //we have seen this frame id before
         {
             __copy_data(frame, msg_NED);
-            frame.time_ms = timestamp;
+            frame.time_ns = timestamp;
             // frequency estimate with EMA smoothing
-            uint64_t prev = last_time_ms_.value(msg_NED.id, 0);
+            const qint64 prev = last_time_ns_.value(msg_NED.id, 0);
             if (prev > 0)
             {
-                double dt = static_cast<double>(timestamp - prev) / 1000.0;
+                double dt = static_cast<double>(timestamp - prev) * 1.0E-9;
                 if (dt > 0.0)
                 {
                     double f = 1.0 / dt;
@@ -333,7 +335,7 @@ void mocap_data_aggegator::update(QVector<optitrack_message_t> incoming_data, mo
                     frame.freq_hz = (prev_f > 0.0) ? (alpha * f + (1.0 - alpha) * prev_f) : f;
                 }
             }
-            last_time_ms_[msg_NED.id] = timestamp;
+            last_time_ns_[msg_NED.id] = timestamp;
             __copy_data(frames_[new_frame_ind], frame);
         }
         updated_frames.push_back(frame);
@@ -376,6 +378,7 @@ QVector<int> mocap_data_aggegator::get_ids(void)
 mocap_thread::mocap_thread(QObject* parent, generic_thread_settings *new_settings, mocap_settings *mocap_new_settings)
     : generic_thread(parent, new_settings)
 {
+    generic_thread_settings_.realtime_class = realtime_settings::MOCAP;
     start(mocap_new_settings);
 }
 
@@ -528,7 +531,7 @@ void fake_mocap_thread::run()
             msg.qz = sy;
 
             QVector<optitrack_message_t> batch{msg};
-            emit update(batch, mocap_rotation::NONE); // already in desired frame
+            emit update(batch, mocap_rotation::NONE, time_base::now_ns()); // already in desired frame
         }
 
         sleep(std::chrono::nanoseconds{static_cast<uint64_t>(1.0E9/static_cast<double>(generic_thread_settings_.update_rate_hz))});
@@ -589,13 +592,14 @@ void mocap_thread::run()
             QVector<optitrack_message_t> msgs_;
             if (optitrack->read_message(msgs_))
             {
+                const qint64 rx_time_ns = time_base::now_ns();
                 // mark that at least one packet has arrived
                 has_received_data_ = true;
 
                 mutex->lock();
                 mocap_rotation data_rotation = mocap_settings_.data_rotation;
                 mutex->unlock();
-                emit update(msgs_, data_rotation);
+                emit update(msgs_, data_rotation, rx_time_ns);
                 processed_any = true;
             } else {
                 processed_any = false;
@@ -604,7 +608,7 @@ void mocap_thread::run()
 
         // Only sleep when we didn't process data; otherwise loop immediately to drain backlog
         if (!processed_any) {
-            sleep(std::chrono::nanoseconds{static_cast<uint64_t>(1.0E9/static_cast<double>(generic_thread_settings_.update_rate_hz))});
+            sleep_period();
         }
     }
 
@@ -614,21 +618,22 @@ void mocap_thread::run()
 
 
 mocap_relay_thread::mocap_relay_thread(QObject *parent, generic_thread_settings *new_settings, mocap_relay_settings *relay_settings_, mocap_data_aggegator** mocap_data_ptr_)
-    : generic_thread(parent, new_settings)
+    : periodic_task(parent, new_settings)
 {
     relay_settings = new mocap_relay_settings();
     update_settings(relay_settings_);
     if (*(mocap_data_ptr_) != NULL)
     {
         mocap_data_ptr = mocap_data_ptr_;
-        previous_data.time_ms = 0;
-        generic_thread::start(generic_thread_settings_.priority);        
+        previous_data.time_ns = 0;
+        periodic_task::start(generic_thread_settings_.priority);
     }
 
 }
 
 mocap_relay_thread::~mocap_relay_thread()
 {
+    periodic_scheduler::instance().remove_and_wait(this);
     delete relay_settings;
     mocap_data_ptr = nullptr;
 }
@@ -646,42 +651,38 @@ void mocap_relay_thread::get_settings(mocap_relay_settings* settings_out_)
     mutex->unlock();
 }
 
-void mocap_relay_thread::run()
+void mocap_relay_thread::tick()
 {
-    while (*(mocap_data_ptr) != NULL && !(QThread::currentThread()->isInterruptionRequested()))
+    if (*(mocap_data_ptr) == NULL)
     {
-        // Keep processing frames as long as they are available
-        bool frame_processed = false;
-        do {
-            mocap_data_t data;
-            if (!(*mocap_data_ptr)->get_frame(relay_settings->frameid, data)) {
-                frame_processed = false; // No more frames available
-                break;
-            }
+        requestInterruption();
+        return;
+    }
 
-            if (data.trackingValid && !data.equals(previous_data))
-            {
-                QByteArray pending_data = pack_most_recent_msg(data);
-                if (pending_data.isEmpty()) {
-                    frame_processed = false; // Error condition
-                    break;
-                }
+    mocap_data_t data;
+    if (!(*mocap_data_ptr)->get_frame(relay_settings->frameid, data)) return;
 
-                emit write_to_port(pending_data);
-                previous_data = data;
-                frame_processed = true; // Continue processing more frames
-            } else {
-                frame_processed = false; // Frame not valid or same as previous
-            }
-        } while (frame_processed && *(mocap_data_ptr) != NULL && !(QThread::currentThread()->isInterruptionRequested()));
+    // relay each new valid frame once, at most once per period
+    if (data.trackingValid && !data.equals(previous_data))
+    {
+        QByteArray pending_data = pack_most_recent_msg(data);
+        if (pending_data.isEmpty()) return;
 
-        // Only sleep when no frames are available to process
-        if (!frame_processed) {
-            sleep(std::chrono::nanoseconds{static_cast<uint64_t>(1.0E9/static_cast<double>(generic_thread_settings_.update_rate_hz))});
-        }
+        emit write_to_port(pending_data);
+        previous_data = data;
     }
 }
 
+// Ground stamps by default; the vehicle's clock when requested and synchronized.
+// PX4 translates ground stamps itself once it has synchronized with us, so
+// vehicle time is only needed for autopilots that do not.
+qint64 mocap_relay_thread::relay_time_ns(qint64 t_ns)
+{
+    qint64 vehicle_ns = t_ns;
+    if (relay_settings->vehicle_time) vehicle_clock::to_vehicle_ns(relay_settings->sysid, t_ns, vehicle_ns);
+    return vehicle_ns;
+}
+
 QByteArray mocap_relay_thread::pack_most_recent_msg(mocap_data_t data)
 {    
     mavlink_message_t msg;
@@ -690,7 +691,7 @@ QByteArray mocap_relay_thread::pack_most_recent_msg(mocap_data_t data)
     case mocap_relay_settings::mavlink_odometry:
     {
         mavlink_odometry_t odo{};
-        odo.time_usec = data.time_ms*1E3;
+        odo.time_usec = static_cast<uint64_t>(time_base::ns_to_us(relay_time_ns(data.time_ns)));
         odo.x = data.x;
         odo.y = data.y;
         odo.z = data.z;
@@ -708,7 +709,7 @@ QByteArray mocap_relay_thread::pack_most_recent_msg(mocap_data_t data)
     case mocap_relay_settings::mavlink_vision_position_estimate:
     {
         mavlink_vision_position_estimate_t vpe{};
-        vpe.usec = data.time_ms*1E3;
+        vpe.usec = static_cast<uint64_t>(time_base::ns_to_us(relay_time_ns(data.time_ns)));
         vpe.x = data.x;
         vpe.y = data.y;
         vpe.z = data.z;
@@ -737,14 +738,14 @@ QByteArray mocap_relay_thread::pack_most_recent_msg(mocap_data_t data)
 
 
 mocap_data_inspector_thread::mocap_data_inspector_thread(QObject* parent, generic_thread_settings *new_settings)
-    : generic_thread(parent, new_settings)
+    : periodic_task(parent, new_settings)
 {
     start(generic_thread_settings_.priority);
 }
 
 mocap_data_inspector_thread::~mocap_data_inspector_thread()
 {
-
+    periodic_scheduler::instance().remove_and_wait(this);
 }
 
 void mocap_data_inspector_thread::new_data_available(void)
@@ -761,17 +762,13 @@ void mocap_data_inspector_thread::reset(void)
     mutex->unlock();
 }
 
-void mocap_data_inspector_thread::run()
+void mocap_data_inspector_thread::tick()
 {
-    while (!(QThread::currentThread()->isInterruptionRequested()))
-    {
-        mutex->lock();
-        //check if new data is available (may not be the case if this thread is faster)
-        if (new_data_available_) emit time_to_update();
-        new_data_available_ = false;
-        mutex->unlock();
-        sleep(std::chrono::nanoseconds{static_cast<uint64_t>(1.0E9/static_cast<double>(generic_thread_settings_.update_rate_hz))});
-    }
+    mutex->lock();
+    //check if new data is available (may not be the case if this task is faster)
+    if (new_data_available_) emit time_to_update();
+    new_data_available_ = false;
+    mutex->unlock();
 }
 
 
@@ -1721,11 +1718,10 @@ void mocap_manager::update_mocap_tree()
     // Do not append queue metrics here; periodic updater handles plotting
 
     // Frame age (ms): time since frame timestamp
-    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
-    const qint64 ageMs = (buff.time_ms > 0) ? (nowMs - static_cast<qint64>(buff.time_ms)) : 0;
+    const qint64 ageMs = (buff.time_ns > 0) ? (time_base::now_ns() - buff.time_ns) / 1000000LL : 0;
     setValue(ensureLeaf(gCommon, "Frame Age (ms)", "common/frame_age_ms"), QString::number(ageMs));
 
-    setValue(ensureLeaf(gBasic, "Time (ms)",        "time_ms"),        QString::number(buff.time_ms));
+    setValue(ensureLeaf(gBasic, "Time (ms)",        "time_ms"),        QString::number(time_base::ns_to_ms(buff.time_ns), 'f', 3));
     setValue(ensureLeaf(gBasic, "Frequency (Hz)",   "freq_hz"),        QString::number(buff.freq_hz, 'f', 2));
     setValue(ensureLeaf(gBasic, "Tracking Valid",   "trackingValid"),  buff.trackingValid?"YES":"NO");
 
@@ -1754,35 +1750,64 @@ void mocap_manager::onRegistrySignalsChanged() {
     plot_signal_ui_helpers::syncPlotCheckBoxes(mocapTree_);
 }
 
+// Per-frame fields that can be plotted, as "mocap/<id>/<path>". Queue metrics and
+// frame age are sampled by handleQueueMetricsTick() instead.
+static const char* const kMocapPlotFieldPaths[] = {
+    "time_ms", "freq_hz", "trackingValid",
+    "pos/x", "pos/y", "pos/z",
+    "quat/qx", "quat/qy", "quat/qz", "quat/qw",
+    "euler/roll", "euler/pitch", "euler/yaw",
+};
+static constexpr int kMocapPlotFieldCount = sizeof(kMocapPlotFieldPaths) / sizeof(kMocapPlotFieldPaths[0]);
+
+static double mocapPlotFieldValue(const mocap_data_t& buff, int field)
+{
+    switch (field) {
+    case 0:  return time_base::ns_to_ms(buff.time_ns);
+    case 1:  return buff.freq_hz;
+    case 2:  return buff.trackingValid ? 1.0 : 0.0;
+    case 3:  return buff.x;
+    case 4:  return buff.y;
+    case 5:  return buff.z;
+    case 6:  return buff.qx;
+    case 7:  return buff.qy;
+    case 8:  return buff.qz;
+    case 9:  return buff.qw;
+    case 10: return buff.roll; // radians
+    case 11: return buff.pitch;
+    case 12: return buff.yaw;
+    default: return 0.0;
+    }
+}
+
 void mocap_manager::onFramesUpdatedBackground(QVector<mocap_data_t> frames)
 {
     // Append samples for tagged mocap signals independent of UI visibility.
+    PlotSignalRegistry& registry = PlotSignalRegistry::instance();
+    const quint64 generation = registry.tagGeneration();
+    if (generation != mocapPlotGeneration_) {
+        mocapPlotGeneration_ = generation;
+        mocapPlotFields_.clear();
+    }
+
+    QVector<PlotSignalTuple> batch;
     for (const auto& buff : frames) {
-        const QString base = QString("mocap/%1/").arg(buff.id);
-        const auto taggedIds = PlotSignalRegistry::instance().taggedIdsByPrefix(base);
-        if (taggedIds.isEmpty()) continue;
-        const qint64 t_ns = static_cast<qint64>(buff.time_ms) * 1000000LL;
-        for (const auto& id : taggedIds) {
-            double value = 0.0;
-            const QString path = id.mid(base.size());
-            if      (path == "time_ms")       value = static_cast<double>(buff.time_ms);
-            else if (path == "freq_hz")       value = buff.freq_hz;
-            else if (path == "trackingValid") value = buff.trackingValid ? 1.0 : 0.0;
-            else if (path == "pos/x")         value = buff.x;
-            else if (path == "pos/y")         value = buff.y;
-            else if (path == "pos/z")         value = buff.z;
-            else if (path == "quat/qx")       value = buff.qx;
-            else if (path == "quat/qy")       value = buff.qy;
-            else if (path == "quat/qz")       value = buff.qz;
-            else if (path == "quat/qw")       value = buff.qw;
-            else if (path == "euler/roll")    value = buff.roll; // radians
-            else if (path == "euler/pitch")   value = buff.pitch;
-            else if (path == "euler/yaw")     value = buff.yaw;
-            // Skip queue metrics and frame_age here; handled by periodic updater
-            else continue;
-            PlotSignalRegistry::instance().appendSample(id, t_ns, value);
+        auto it = mocapPlotFields_.find(buff.id);
+        if (it == mocapPlotFields_.end()) {
+            // resolve the handles of this frame id once per tag change
+            QVector<QPair<PlotSignalHandle, int>> fields;
+            const QString base = QString("mocap/%1/").arg(buff.id);
+            for (int field = 0; field < kMocapPlotFieldCount; ++field) {
+                const PlotSignalHandle handle = registry.handleOf(base + kMocapPlotFieldPaths[field]);
+                if (handle != kInvalidPlotSignalHandle) fields.append(qMakePair(handle, field));
+            }
+            it = mocapPlotFields_.insert(buff.id, fields);
+        }
+        for (const auto& field : it.value()) {
+            batch.append(PlotSignalTuple{ field.first, buff.time_ns, mocapPlotFieldValue(buff, field.second) });
         }
     }
+    registry.appendBatch(batch);
 }
 
 void mocap_manager::handleQueueMetricsTick()
@@ -1796,8 +1821,7 @@ void mocap_manager::handleQueueMetricsTick()
     if (mocap_thread_) {
         mocap_thread_->get_backlog(backlogBytes, backlogFrames);
     }
-    const qint64 now_ms = QDateTime::currentMSecsSinceEpoch();
-    const qint64 now_ns = now_ms * 1000000LL;
+    const qint64 now_ns = time_base::now_ns();
 
     // For frame age, we need the latest data timestamp per id if available
     // We'll read UI-selected ID and also iterate all mocap ids to cover tagged signals
@@ -1819,8 +1843,8 @@ void mocap_manager::handleQueueMetricsTick()
         } else if (path == "common/queue/frames") {
             PlotSignalRegistry::instance().appendSample(idPath, now_ns, static_cast<double>(backlogFrames));
         } else if (path == "common/frame_age_ms") {
-            const qint64 t_ms = latestById.contains(id) ? static_cast<qint64>(latestById[id].time_ms) : 0;
-            const qint64 age_ms = (t_ms > 0) ? (now_ms - t_ms) : 0;
+            const qint64 t_ns = latestById.contains(id) ? latestById[id].time_ns : 0;
+            const qint64 age_ms = (t_ns > 0) ? (now_ns - t_ns) / 1000000LL : 0;
             PlotSignalRegistry::instance().appendSample(idPath, now_ns, static_cast<double>(age_ms));
         }
     }
@@ -1872,7 +1896,7 @@ void mocap_manager::repopulate_relay_table()
         ui->tableWidget_mocap_relay->setItem(row_index, 2, compItem);
 
         // Message Type
-        QTableWidgetItem *msgItem = new QTableWidgetItem(enum_helpers::value2key(settings.msg_option));
+        QTableWidgetItem *msgItem = new QTableWidgetItem(enum_helpers::value2key(settings.msg_option) + (settings.vehicle_time ? " (vehicle time)" : ""));
         msgItem->setFlags(msgItem->flags() ^ Qt::ItemIsEditable);
         ui->tableWidget_mocap_relay->setItem(row_index, 3, msgItem);
 
@@ -2144,6 +2168,7 @@ void mocap_manager::on_btn_relay_add_clicked()
     QThread::Priority temp_priority;
     default_ui_config::Priority::key2value(ui->cmbx_relay_priority->currentText(), temp_priority);
     relay_settings.priority = static_cast<int>(temp_priority);
+    relay_settings.vehicle_time = ui->checkBox_relay_vehicle_time->isChecked();
 
     // Validate relay settings
     if (relay_settings.frameid < 0) {
@@ -2330,6 +2355,8 @@ QString mocap_manager::get_relay_status_info()
         status += QString("  Port: %1\n").arg(settings.Port_Name);
         status += QString("  Message Type: %1\n").arg(enum_helpers::value2key(settings.msg_option));
         status += QString("  Thread Status: %1\n").arg(mocap_relay[i]->isRunning() ? "Running" : "Stopped");
+        const periodic_task_stats stats = mocap_relay[i]->get_stats();
+        status += QString("  Overruns: %1, Max Jitter: %2 (us)\n").arg(stats.overruns).arg(static_cast<double>(stats.max_jitter_ns) / 1.0E3, 0, 'f', 1);
         status += "\n";
     }
 
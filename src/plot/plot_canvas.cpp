@@ -1,5 +1,6 @@
 #include "plot/plot_canvas.h"
 #include "plot/plot_signal_registry.h"
+#include "time_base.h"
 
 #include <QPainter>
 #include <QPaintEvent>
@@ -14,6 +15,9 @@
 #include <algorithm>
 // quiet build: avoid noisy debug prints in release UI
 
+// Unjoined samples kept per 3D signal while a partner lags or is idle
+static constexpr size_t kMaxPendingSamples = 4096;
+
 PlotCanvas::PlotCanvas(QWidget* parent) : QWidget(parent) {
     setAutoFillBackground(true);
     setMinimumSize(200, 150);
@@ -60,7 +64,7 @@ void PlotCanvas::setRegistry(PlotSignalRegistry* reg) {
     registry_ = reg;
     if (registry_) {
         // Only repaint on data for signals that are currently enabled (visible)
-        connect(registry_, &PlotSignalRegistry::samplesAppended, this, [this](const QString& id){
+        connect(registry_, &PlotSignalRegistry::samplesAppended, this, [this](const QSet<QString>& ids){
             // If data-driven repaints are disabled, ignore sample events; the force timer drives repaints
             if (!dataDrivenRepaint_) return;
             if (mode_ == Mode3D) {
@@ -73,14 +77,165 @@ void PlotCanvas::setRegistry(PlotSignalRegistry* reg) {
                 }
                 return;
             }
-            // In 2D, only request repaint if the appended sample belongs to an enabled signal
-            if (!enabledIds_.isEmpty() && enabledIds_.contains(id)) requestRepaint();
+            // In 2D, only request repaint if the appended samples belong to an enabled signal
+            for (const auto& id : enabledIds_) {
+                if (ids.contains(id)) { requestRepaint(); return; }
+            }
         });
         connect(registry_, &PlotSignalRegistry::samplesCleared, this, [this]{ legendTopLeft_ = QPoint(-1,-1); update(); });
         connect(registry_, &PlotSignalRegistry::epochChanged, this, [this](qint64){ update(); });
     }
 }
 
+bool PlotCanvas::latestValue(const QString& id, double& value) const {
+    bool found = false;
+    if (registry_) {
+        registry_->readSamples(id, [&](const PlotSignalBuffer& samples){
+            if (samples.isEmpty()) return;
+            value = samples.back().value;
+            found = true;
+        });
+    }
+    return found;
+}
+
+const std::deque<PlotCanvas::AlignedPoint>& PlotCanvas::alignedPoints(const Plot3DGroup& group) {
+    auto& trail = trails_[group.signalIds.join('\n')];
+    if (!trail) trail = std::make_shared<AlignedTrail>();
+    trail->lastPaint = paintSerial_;
+    trail->fallback.clear();
+
+    const int dims = group.signalIds.size();
+    if (trail->handles.size() != dims) {
+        trail->handles = QVector<PlotSignalHandle>(dims, kInvalidPlotSignalHandle);
+        trail->cursors = QVector<PlotSignalCursor>(dims);
+        trail->pending = QVector<std::deque<PlotSignalSample>>(dims);
+        trail->points.clear();
+    }
+    if (!registry_ || dims == 0) return trail->points;
+
+    // A signal that is not tagged has no samples, so nothing can be aligned
+    for (int d = 0; d < dims; ++d) {
+        if (trail->handles[d] == kInvalidPlotSignalHandle) trail->handles[d] = registry_->handleOf(group.signalIds[d]);
+        if (trail->handles[d] == kInvalidPlotSignalHandle) {
+            trail->cursors = QVector<PlotSignalCursor>(dims);
+            for (auto& pending : trail->pending) pending.clear();
+            trail->points.clear();
+            return trail->points;
+        }
+    }
+
+    // Pull only what arrived since the last paint. A stale cursor (first read, merge or
+    // clear) means the join starts over from the full histories.
+    QVector<bool> incremental(dims);
+    bool restart = false;
+    for (int d = 0; d < dims; ++d) {
+        incremental[d] = registry_->readNew(trail->handles[d], trail->cursors[d], trailScratch_);
+        if (!incremental[d]) {
+            restart = true;
+            trail->pending[d].clear();
+        }
+        trail->pending[d].insert(trail->pending[d].end(), trailScratch_.cbegin(), trailScratch_.cend());
+    }
+    if (restart) {
+        trail->points.clear();
+        for (int d = 0; d < dims; ++d) {
+            if (!incremental[d]) continue;
+            trail->cursors[d] = PlotSignalCursor();
+            registry_->readNew(trail->handles[d], trail->cursors[d], trailScratch_);
+            trail->pending[d].assign(trailScratch_.cbegin(), trailScratch_.cend());
+        }
+    }
+
+    // Follow the registry's trimming: unjoined samples older than their signal's oldest
+    // sample, and points older than the newest of those, have left the buffer
+    qint64 oldestNs = std::numeric_limits<qint64>::min();
+    bool anyEmpty = false;
+    for (int d = 0; d < dims; ++d) {
+        bool empty = true;
+        qint64 frontNs = 0;
+        registry_->readSamples(group.signalIds[d], [&](const PlotSignalBuffer& samples){
+            if (samples.isEmpty()) return;
+            empty = false;
+            frontNs = samples.front().t_ns;
+        });
+        auto& pending = trail->pending[d];
+        if (empty) {
+            anyEmpty = true;
+            pending.clear();
+            continue;
+        }
+        oldestNs = qMax(oldestNs, frontNs);
+        while (!pending.empty() && pending.front().t_ns < frontNs) pending.pop_front();
+    }
+    if (anyEmpty) trail->points.clear();
+    while (!trail->points.empty() && trail->points.front().t_ns < oldestNs) trail->points.pop_front();
+
+    // Merge join over the time-ordered samples: drop every head older than the latest head
+    // and emit a point when all heads agree. Stops as soon as one signal runs out, leaving
+    // the unmatched heads for the next paint.
+    for (;;) {
+        bool exhausted = false;
+        qint64 t = std::numeric_limits<qint64>::min();
+        for (int d = 0; d < dims && !exhausted; ++d) {
+            if (trail->pending[d].empty()) exhausted = true;
+            else t = qMax(t, trail->pending[d].front().t_ns);
+        }
+        if (exhausted) break;
+        bool match = true;
+        for (int d = 0; d < dims; ++d) {
+            auto& pending = trail->pending[d];
+            while (!pending.empty() && pending.front().t_ns < t) pending.pop_front();
+            if (pending.empty()) { exhausted = true; break; }
+            if (pending.front().t_ns != t) match = false;
+        }
+        if (exhausted) break;
+        if (!match) continue;
+        double v[3] = { 0.0, 0.0, 0.0 };
+        for (int d = 0; d < qMin(dims, 3); ++d) v[d] = trail->pending[d].front().value;
+        trail->points.push_back(AlignedPoint{ t, QVector3D(float(v[0]), float(v[1]), float(v[2])) });
+        for (auto& pending : trail->pending) pending.pop_front();
+    }
+    // A partner that stays silent would otherwise leave the others queueing up to their
+    // whole buffer; beyond the cap the oldest are given up on, as a late match is unlikely
+    for (auto& pending : trail->pending) {
+        if (pending.size() > kMaxPendingSamples) pending.erase(pending.begin(), pending.end() - kMaxPendingSamples);
+    }
+
+    if (!trail->points.empty()) return trail->points;
+
+    // No common timestamps: use the last N sample times of the last signal, N = min(len_i),
+    // with each value taken where a signal has that exact timestamp and 0 otherwise
+    int nMin = INT_MAX;
+    for (const auto& sid : group.signalIds) {
+        int size = 0;
+        registry_->readSamples(sid, [&](const PlotSignalBuffer& samples){ size = samples.size(); });
+        nMin = qMin(nMin, size);
+    }
+    if (nMin <= 0) return trail->fallback;
+    registry_->readSamples(group.signalIds.last(), [&](const PlotSignalBuffer& ref){
+        for (int i = qMax(0, ref.size() - nMin); i < ref.size(); ++i) trail->fallback.push_back(AlignedPoint{ ref.at(i).t_ns, QVector3D() });
+    });
+    for (int d = 0; d < qMin(dims, 3); ++d) {
+        registry_->readSamples(group.signalIds[d], [&](const PlotSignalBuffer& samples){
+            for (auto& point : trail->fallback) {
+                const int at = samples.lowerBound(point.t_ns);
+                if (at < samples.size() && samples.at(at).t_ns == point.t_ns) point.v[d] = float(samples.at(at).value);
+            }
+        });
+    }
+    return trail->fallback;
+}
+
+void PlotCanvas::pruneTrails() {
+    // Drop 3D trails the previous paint did not draw
+    for (auto it = trails_.begin(); it != trails_.end();) {
+        if (it.value()->lastPaint != paintSerial_) it = trails_.erase(it);
+        else ++it;
+    }
+    ++paintSerial_;
+}
+
 void PlotCanvas::setEnabledSignals(const QVector<QString>& ids) {
     enabledIds_ = ids;
     update();
@@ -209,7 +364,7 @@ void PlotCanvas::setPaused(bool paused) {
     paused_ = paused;
     if (paused_) {
         // capture freeze time in UTC ns
-        pausedTimeNs_ = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch() * 1000000LL;
+        pausedTimeNs_ = time_base::now_ns();
     }
     update();
 }
@@ -238,12 +393,9 @@ bool PlotCanvas::autoRangeCamera() {
         if (!group.enabled) continue;
         for (int idx = 0; idx < group.signalIds.size(); ++idx) {
             const QString& signalId = group.signalIds.at(idx);
-            const auto samples = registry_->getSamples(signalId);
-            if (samples.isEmpty()) continue;
+            double localMin, localMax;
+            if (!registry_->minMax(signalId, std::numeric_limits<qint64>::min(), std::numeric_limits<qint64>::max(), localMin, localMax)) continue;
             anyData = true;
-            double localMin = std::numeric_limits<double>::infinity();
-            double localMax = -std::numeric_limits<double>::infinity();
-            for (const auto& s : samples) { localMin = qMin(localMin, s.value); localMax = qMax(localMax, s.value); }
             if (idx == 0) { minX = qMin(minX, localMin); maxX = qMax(maxX, localMax); }
             else if (idx == 1) { minY = qMin(minY, localMin); maxY = qMax(maxY, localMax); }
             else if (idx == 2) { minZ = qMin(minZ, localMin); maxZ = qMax(maxZ, localMax); }
@@ -345,6 +497,7 @@ void PlotCanvas::paintEvent(QPaintEvent* ev) {
     QPainter p(this);
     p.fillRect(rect(), bgColor_.isValid() ? bgColor_ : palette().base());
 
+    pruneTrails();
     if (!registry_) return;
 
     // In 3D mode we render based on 3D groups (not per-signal enabled list).
@@ -359,7 +512,7 @@ void PlotCanvas::paintEvent(QPaintEvent* ev) {
     // 2D mode - existing plotting logic
 
     // Determine time span in absolute UTC nanoseconds; freeze when paused
-    qint64 now_ns = paused_ ? pausedTimeNs_ : (QDateTime::currentDateTimeUtc().toMSecsSinceEpoch() * 1000000LL);
+    qint64 now_ns = paused_ ? pausedTimeNs_ : time_base::now_ns();
     qint64 start_ns = now_ns - static_cast<qint64>(windowSec_ * 1e9);
 
     // We'll compute dynamic margins to allocate space for tick labels and axis labels
@@ -374,14 +527,25 @@ void PlotCanvas::paintEvent(QPaintEvent* ev) {
         bool any = false;
         double mn = 0, mx = 0;
         for (const auto& id : enabledIds_) {
-            auto samples = registry_->getSamples(id);
-            for (const auto& s : samples) {
-                if (s.t_ns < start_ns) continue;
-                double yv;
-                if (!transformValue(id, s.value, yv)) continue; // skip invalid (e.g., division by zero)
-                if (!any) { mn = mx = yv; any = true; }
-                else { mn = qMin(mn, yv); mx = qMax(mx, yv); }
+            // Range query on the registry's min/max pyramid; the linear transform maps the raw
+            // extremes onto the transformed ones, 1/x does not and is scanned sample by sample
+            double lo, hi, yLo, yHi;
+            if (!invertById_.value(id, false) && registry_->minMax(id, start_ns, std::numeric_limits<qint64>::max(), lo, hi)
+                && transformValue(id, lo, yLo) && transformValue(id, hi, yHi)) {
+                if (yLo > yHi) std::swap(yLo, yHi);
+                if (!any) { mn = yLo; mx = yHi; any = true; }
+                else { mn = qMin(mn, yLo); mx = qMax(mx, yHi); }
+                continue;
             }
+            registry_->readSamples(id, [&](const PlotSignalBuffer& samples){
+                for (int i = samples.lowerBound(start_ns); i < samples.size(); ++i) {
+                    const auto& s = samples.at(i);
+                    double yv;
+                    if (!transformValue(id, s.value, yv)) continue; // skip invalid (e.g., division by zero)
+                    if (!any) { mn = mx = yv; any = true; }
+                    else { mn = qMin(mn, yv); mx = qMax(mx, yv); }
+                }
+            });
         }
         if (!any) { mn = -1; mx = 1; }
         if (qFuzzyCompare(mn, mx)) { mn -= 1.0; mx += 1.0; }
@@ -566,7 +730,6 @@ void PlotCanvas::paintEvent(QPaintEvent* ev) {
 
     // Draw each signal with a continuous polyline connecting consecutive visible samples (after transform)
     for (const auto& id : enabledIds_) {
-        auto samples = registry_->getSamples(id);
         Qt::PenStyle style = styleById_.value(id, Qt::SolidLine);
 
         // final min/max computed for drawing
@@ -582,61 +745,134 @@ void PlotCanvas::paintEvent(QPaintEvent* ev) {
             pen.setStyle(style);
         }
         p.setPen(pen);
-        QPointF prev;
-        bool havePrev = false;
-        for (int i = 0; i < samples.size(); ++i) {
-            const auto& s = samples[i];
-            if (s.t_ns < start_ns) continue;
-            const qreal x = mapX(s.t_ns);
-            double yv; if (!transformValue(id, s.value, yv)) { havePrev = false; continue; }
-            const qreal y = mapY(yv);
-            if (style == Qt::DotLine) {
-                // Draw scatter points instead of lines
-                int scatterStyle = scatterStyleById_.value(id, 0); // 0=circle, 1=square, 2=triangle, 3=cross, 4=plus
-                int pointSize = qMax(2, widthById_.value(id, 2) * 2);
-                QPointF center(x, y);
-                
-                // Save current pen and set fill brush
-                QPen oldPen = p.pen();
-                p.setBrush(QBrush(oldPen.color()));
-                
-                switch (scatterStyle) {
-                case 0: // Circle
-                    p.drawEllipse(center, pointSize, pointSize);
-                    break;
-                case 1: // Square
-                    p.drawRect(QRectF(x - pointSize, y - pointSize, pointSize * 2, pointSize * 2));
-                    break;
-                case 2: { // Triangle
-                    QPointF points[3] = {
-                        QPointF(x, y - pointSize),
-                        QPointF(x - pointSize, y + pointSize),
-                        QPointF(x + pointSize, y + pointSize)
-                    };
-                    p.drawPolygon(points, 3);
-                    break;
+        // Lines are decimated to the lowest and highest point of each pixel column (kept in
+        // time order), and every unbroken run is drawn with a single polyline. The geometry is
+        // built while the registry holds the signal's read lock and painted after it is released.
+        QVector<QPolygonF> runs;
+        QVector<QPointF> dots;
+        QPolygonF line;
+        line.reserve(2 * int(plotRect.width()) + 4);
+        int column = 0;
+        bool inColumn = false;
+        bool minFirst = true;
+        QPointF colMin, colMax;
+        auto flushColumn = [&]{
+            if (!inColumn) return;
+            const QPointF& a = minFirst ? colMin : colMax;
+            const QPointF& b = minFirst ? colMax : colMin;
+            line << a;
+            if (b != a) line << b;
+            inColumn = false;
+        };
+        auto flushLine = [&]{
+            flushColumn();
+            if (line.size() >= 2) runs.append(line);
+            line.clear();
+        };
+        registry_->readSamples(id, [&](const PlotSignalBuffer& samples){
+            const int visibleFrom = samples.lowerBound(start_ns);
+            // Dense data (e.g. a long window zoomed out): take each column's extremes from the
+            // min/max pyramid instead of visiting every sample. The linear transform keeps
+            // extremes as extremes; 1/x does not, so inverted signals take the per-sample path.
+            const bool dense = style != Qt::DotLine && !invertById_.value(id, false)
+                               && samples.size() - visibleFrom > 4 * int(plotRect.width());
+            if (dense) {
+                const double nsPerPx = windowSec_ * 1e9 / plotRect.width();
+                const int columns = int(std::ceil(plotRect.width()));
+                int from = visibleFrom;
+                for (int c = 0; c < columns && from < samples.size(); ++c) {
+                    const int to = samples.lowerBound(start_ns + qint64((c + 1) * nsPerPx));
+                    double lo, hi, yLo, yHi;
+                    if (to > from && samples.minMax(from, to, lo, hi)
+                        && transformValue(id, lo, yLo) && transformValue(id, hi, yHi)) {
+                        const qreal x = plotRect.left() + c + 0.5;
+                        qreal first = mapY(yLo), second = mapY(yHi);
+                        // continue from whichever extreme is nearer the previous column
+                        if (!line.isEmpty() && qAbs(line.last().y() - second) < qAbs(line.last().y() - first)) std::swap(first, second);
+                        line << QPointF(x, first);
+                        if (second != first) line << QPointF(x, second);
+                    } else if (to > from) {
+                        // samples but no valid extreme (all NaN or out of the transform's
+                        // domain): break the line as the per-sample path does
+                        flushLine();
+                    }
+                    from = to;
                 }
-                case 3: // Cross (X)
-                    p.setBrush(Qt::NoBrush); // No fill for cross
-                    p.drawLine(QPointF(x - pointSize, y - pointSize), QPointF(x + pointSize, y + pointSize));
-                    p.drawLine(QPointF(x + pointSize, y - pointSize), QPointF(x - pointSize, y + pointSize));
-                    break;
-                case 4: // Plus (+)
-                    p.setBrush(Qt::NoBrush); // No fill for plus
-                    p.drawLine(QPointF(x - pointSize, y), QPointF(x + pointSize, y));
-                    p.drawLine(QPointF(x, y - pointSize), QPointF(x, y + pointSize));
-                    break;
+                flushLine();
+                return;
+            }
+            for (int i = visibleFrom; i < samples.size(); ++i) {
+                const auto& s = samples.at(i);
+                const qreal x = mapX(s.t_ns);
+                double yv; if (!transformValue(id, s.value, yv)) { flushLine(); continue; }
+                const qreal y = mapY(yv);
+                const QPointF pt(x, y);
+                if (style == Qt::DotLine) {
+                    dots.append(pt);
+                    continue;
                 }
-                
-                // Restore pen
-                p.setPen(oldPen);
-                p.setBrush(Qt::NoBrush);
-            } else {
-                // Draw connected lines
-                if (!havePrev) { prev = QPointF(x, y); havePrev = true; continue; }
-                p.drawLine(prev, QPointF(x, y));
-                prev = QPointF(x, y);
+                // Accumulate the pixel column; a new column flushes the previous one
+                const int c = int(std::floor(x));
+                if (!inColumn || c != column) {
+                    flushColumn();
+                    column = c;
+                    colMin = colMax = pt;
+                    minFirst = true;
+                    inColumn = true;
+                } else if (y < colMin.y()) {
+                    colMin = pt;
+                    minFirst = false;
+                } else if (y > colMax.y()) {
+                    colMax = pt;
+                    minFirst = true;
+                }
+            }
+            flushLine();
+        });
+        for (const auto& run : runs) p.drawPolyline(run);
+        if (dots.isEmpty()) continue;
+
+        // Draw scatter points instead of lines
+        int scatterStyle = scatterStyleById_.value(id, 0); // 0=circle, 1=square, 2=triangle, 3=cross, 4=plus
+        int pointSize = qMax(2, widthById_.value(id, 2) * 2);
+        for (const QPointF& center : dots) {
+            const qreal x = center.x(), y = center.y();
+
+            // Save current pen and set fill brush
+            QPen oldPen = p.pen();
+            p.setBrush(QBrush(oldPen.color()));
+
+            switch (scatterStyle) {
+            case 0: // Circle
+                p.drawEllipse(center, pointSize, pointSize);
+                break;
+            case 1: // Square
+                p.drawRect(QRectF(x - pointSize, y - pointSize, pointSize * 2, pointSize * 2));
+                break;
+            case 2: { // Triangle
+                QPointF points[3] = {
+                    QPointF(x, y - pointSize),
+                    QPointF(x - pointSize, y + pointSize),
+                    QPointF(x + pointSize, y + pointSize)
+                };
+                p.drawPolygon(points, 3);
+                break;
             }
+            case 3: // Cross (X)
+                p.setBrush(Qt::NoBrush); // No fill for cross
+                p.drawLine(QPointF(x - pointSize, y - pointSize), QPointF(x + pointSize, y + pointSize));
+                p.drawLine(QPointF(x + pointSize, y - pointSize), QPointF(x - pointSize, y + pointSize));
+                break;
+            case 4: // Plus (+)
+                p.setBrush(Qt::NoBrush); // No fill for plus
+                p.drawLine(QPointF(x - pointSize, y), QPointF(x + pointSize, y));
+                p.drawLine(QPointF(x, y - pointSize), QPointF(x, y + pointSize));
+                break;
+            }
+
+            // Restore pen
+            p.setPen(oldPen);
+            p.setBrush(Qt::NoBrush);
         }
     }
 
@@ -1024,7 +1260,6 @@ void PlotCanvas::render3D(QPainter& p, const QRect& rect) {
     cameraOrientation_.normalize();
 
     // Collect samples for each signal and compute per-dimension min/max across recent samples
-    QHash<QString, double> latestValues;
     double minX = std::numeric_limits<double>::infinity(), maxX = -std::numeric_limits<double>::infinity();
     double minY = std::numeric_limits<double>::infinity(), maxY = -std::numeric_limits<double>::infinity();
     double minZ = std::numeric_limits<double>::infinity(), maxZ = -std::numeric_limits<double>::infinity();
@@ -1032,17 +1267,9 @@ void PlotCanvas::render3D(QPainter& p, const QRect& rect) {
         if (!group.enabled) continue;
         for (int idx = 0; idx < group.signalIds.size(); ++idx) {
             const QString& signalId = group.signalIds.at(idx);
-            const auto samples = registry_->getSamples(signalId);
-            if (samples.isEmpty()) continue;
-            // compute min/max across sample history for this signal
-            double localMin = std::numeric_limits<double>::infinity();
-            double localMax = -std::numeric_limits<double>::infinity();
-            for (const auto& s : samples) {
-                localMin = qMin(localMin, s.value);
-                localMax = qMax(localMax, s.value);
-            }
-            // remember last value for immediate display
-            latestValues[signalId] = samples.last().value;
+            // min/max across sample history for this signal, from the registry's min/max pyramid
+            double localMin, localMax;
+            if (!registry_->minMax(signalId, std::numeric_limits<qint64>::min(), std::numeric_limits<qint64>::max(), localMin, localMax)) continue;
             // expand global min/max for appropriate dimension
             if (idx == 0) { minX = qMin(minX, localMin); maxX = qMax(maxX, localMax); }
             else if (idx == 1) { minY = qMin(minY, localMin); maxY = qMax(maxY, localMax); }
@@ -1123,71 +1350,9 @@ void PlotCanvas::render3D(QPainter& p, const QRect& rect) {
     for (const auto& group : groups3D_) {
         if (!group.enabled || group.signalIds.isEmpty()) continue;
 
-        // Gather samples for each signal in the group
-        const int dims = group.signalIds.size();
-        QVector<QVector<PlotSignalSample>> samplesList; samplesList.reserve(dims);
-        for (const auto& sid : group.signalIds) samplesList.append(registry_->getSamples(sid));
-
-        // Build the set intersection of timestamps present in all signals
-        QSet<qint64> commonTimes;
-        if (!samplesList.isEmpty()) {
-            // Initialize with timestamps from first signal
-            for (const auto& s : samplesList.first()) commonTimes.insert(s.t_ns);
-            // Intersect with remaining
-            for (int i = 1; i < samplesList.size(); ++i) {
-                QSet<qint64> cur;
-                for (const auto& s : samplesList[i]) cur.insert(s.t_ns);
-                commonTimes = commonTimes.intersect(cur);
-                if (commonTimes.isEmpty()) break;
-            }
-        }
-
-        // If no common exact timestamps, fall back to using the last N samples where N = min(len_i)
-        QVector<qint64> timesOrdered;
-        if (!commonTimes.isEmpty()) {
-            timesOrdered = QVector<qint64>::fromList(commonTimes.values());
-            std::sort(timesOrdered.begin(), timesOrdered.end());
-        } else {
-            // Determine minimal length across signals and take last N sample times from each (assume roughly aligned by recency)
-            int Nmin = INT_MAX;
-            for (const auto& v : samplesList) Nmin = qMin(Nmin, v.size());
-            if (Nmin == INT_MAX || Nmin <= 0) {
-                // Nothing to draw; skip group
-                continue;
-            }
-            // Use last Nmin timestamps from the last signal for ordering (could choose any)
-            const auto& ref = samplesList.last();
-            timesOrdered.reserve(Nmin);
-            for (int i = ref.size() - Nmin; i < ref.size(); ++i) timesOrdered.append(ref.at(i).t_ns);
-        }
-
-        if (timesOrdered.isEmpty()) continue;
-
-        // Build quick lookup maps from timestamp -> value for each signal
-        QVector<QHash<qint64, double>> valueMaps; valueMaps.reserve(dims);
-        for (const auto& vec : samplesList) {
-            QHash<qint64, double> m; m.reserve(vec.size());
-            for (const auto& s : vec) m.insert(s.t_ns, s.value);
-            valueMaps.append(std::move(m));
-        }
-
-        // Compute min/max per-dimension using only the selected times to keep scaling tight to the trail
-        double gminX = std::numeric_limits<double>::infinity(), gmaxX = -std::numeric_limits<double>::infinity();
-        double gminY = std::numeric_limits<double>::infinity(), gmaxY = -std::numeric_limits<double>::infinity();
-        double gminZ = std::numeric_limits<double>::infinity(), gmaxZ = -std::numeric_limits<double>::infinity();
-        QVector<QVector3D> pts; pts.reserve(timesOrdered.size());
-        for (qint64 t : timesOrdered) {
-            double vx = (dims >= 1 && valueMaps.size() > 0 && valueMaps[0].contains(t)) ? valueMaps[0].value(t) : 0.0;
-            double vy = (dims >= 2 && valueMaps.size() > 1 && valueMaps[1].contains(t)) ? valueMaps[1].value(t) : 0.0;
-            double vz = (dims >= 3 && valueMaps.size() > 2 && valueMaps[2].contains(t)) ? valueMaps[2].value(t) : 0.0;
-            gminX = qMin(gminX, vx); gmaxX = qMax(gmaxX, vx);
-            gminY = qMin(gminY, vy); gmaxY = qMax(gmaxY, vy);
-            gminZ = qMin(gminZ, vz); gmaxZ = qMax(gmaxZ, vz);
-            pts.append(QVector3D(vx, vy, vz));
-        }
-
-        // Ensure ranges valid
-        ensureRange(gminX, gmaxX); ensureRange(gminY, gmaxY); ensureRange(gminZ, gmaxZ);
+        // Timestamp-aligned points of the group; cached, so only new samples are joined
+        const std::deque<AlignedPoint>& aligned = alignedPoints(group);
+        if (aligned.empty()) continue;
 
         // Use global axis bounds for normalization to keep data aligned with axes
         // (data will be clipped to axis ranges)
@@ -1205,8 +1370,9 @@ void PlotCanvas::render3D(QPainter& p, const QRect& rect) {
                 return 2.0 * ((v - lo) / (hi - lo)) - 1.0;
             }
         };
-        QVector<QPointF> screenPts; screenPts.reserve(pts.size());
-        for (const auto& v : pts) {
+        QVector<QPointF> screenPts; screenPts.reserve(int(aligned.size()));
+        for (const auto& point : aligned) {
+            const QVector3D& v = point.v;
             // Use global axis min/max (minX, maxX, etc.) for normalization
             QVector3D npt(normv(v.x(), minX, maxX, xLog_), normv(v.y(), minY, maxY, yLog_), normv(v.z(), minZ, maxZ, zLog_));
             // rotate using quaternion
@@ -1301,15 +1467,12 @@ void PlotCanvas::render3D(QPainter& p, const QRect& rect) {
             // Optionally filter points by tailTimeSpanSec (only keep those within last T seconds)
             if (group.tailTimeSpanSec > 0.0) {
                 // Use current time (or paused time) instead of last data timestamp so old data expires even when updates stop
-                qint64 nowNs = paused_ ? pausedTimeNs_ : (QDateTime::currentMSecsSinceEpoch() * 1000000LL); // Convert ms to ns
+                qint64 nowNs = paused_ ? pausedTimeNs_ : time_base::now_ns();
                 double spanNs = group.tailTimeSpanSec * 1e9;
-                int startIdx = -1; // -1 means no valid points found
-                for (int i = 0; i < timesOrdered.size(); ++i) {
-                    if (timesOrdered.at(i) >= nowNs - qint64(spanNs)) { 
-                        startIdx = i; 
-                        break; 
-                    }
-                }
+                const qint64 cutoffNs = nowNs - qint64(spanNs);
+                auto firstRecent = std::lower_bound(aligned.begin(), aligned.end(), cutoffNs,
+                                                    [](const AlignedPoint& a, qint64 t){ return a.t_ns < t; });
+                int startIdx = (firstRecent == aligned.end()) ? -1 : int(firstRecent - aligned.begin()); // -1 means no valid points found
                 // If all data is too old, clear the display
                 if (startIdx < 0) {
                     continue; // Skip this group entirely - all data expired
@@ -1384,25 +1547,16 @@ void PlotCanvas::render3D(QPainter& p, const QRect& rect) {
                         if (group.attitudeMode == "Quaternion") {
                             // fetch latest quaternion samples (assume registry provides latest value at index 0)
                             double qx=0,qy=0,qz=0,qw=1; bool ok=false;
-                            const auto s_qx = registry_->getSamples(group.qxSignal);
-                            const auto s_qy = registry_->getSamples(group.qySignal);
-                            const auto s_qz = registry_->getSamples(group.qzSignal);
-                            const auto s_qw = registry_->getSamples(group.qwSignal);
-                            if (!s_qx.isEmpty() && !s_qy.isEmpty() && !s_qz.isEmpty() && !s_qw.isEmpty()) {
-                                qx = s_qx.last().value; qy = s_qy.last().value; qz = s_qz.last().value; qw = s_qw.last().value; ok=true;
-                            }
+                            ok = latestValue(group.qxSignal, qx) && latestValue(group.qySignal, qy)
+                                 && latestValue(group.qzSignal, qz) && latestValue(group.qwSignal, qw);
                             if (ok) {
                                 orient = QQuaternion(float(qw), float(qx), float(qy), float(qz));
                                 orient.normalize();
                             }
                         } else if (group.attitudeMode == "Euler") {
                             double roll=0,pitch=0,yaw=0; bool ok=false;
-                            const auto s_r = registry_->getSamples(group.rollSignal);
-                            const auto s_p = registry_->getSamples(group.pitchSignal);
-                            const auto s_y = registry_->getSamples(group.yawSignal);
-                            if (!s_r.isEmpty() && !s_p.isEmpty() && !s_y.isEmpty()) {
-                                roll = s_r.last().value; pitch = s_p.last().value; yaw = s_y.last().value; ok=true;
-                            }
+                            ok = latestValue(group.rollSignal, roll) && latestValue(group.pitchSignal, pitch)
+                                 && latestValue(group.yawSignal, yaw);
                                 if (ok) {
                                     // Wrap continuous angles first (handles multi-revolution data)
                                     // This function wraps to [-pi, pi] for radians or [-180, 180] for degrees
@@ -1,20 +1,304 @@
 #include "plot/plot_signal_registry.h"
+#include "time_base.h"
 
+#include <QCoreApplication>
+#include <QTimer>
 #include <algorithm>
+#include <limits>
+
+// samplesAppended is coalesced to about one display frame
+static constexpr int kNotifyIntervalMs = 16;
+
+static bool sampleBefore(const PlotSignalSample& a, const PlotSignalSample& b) { return a.t_ns < b.t_ns; }
+
+void PlotSignalBuffer::append(const PlotSignalSample& s) {
+    if (size_ > 0 && s.t_ns < back().t_ns) {
+        merge(QVector<PlotSignalSample>{ s });
+        return;
+    }
+    if (size_ == ring_.size()) {
+        if (size_ >= kMaxCapacity) dropFront(1);
+        else reserveFor(size_ + 1);
+    }
+    ring_[wrap(head_ + size_)] = s;
+    ++size_;
+    ++endSeq_;
+    pyramidAppend(endSeq_ - 1);
+}
+
+void PlotSignalBuffer::merge(const QVector<PlotSignalSample>& samples) {
+    if (samples.isEmpty()) return;
+    QVector<PlotSignalSample> merged = toVector();
+    const int mid = merged.size();
+    merged.append(samples);
+    // Batches may predate samples already present; keep the series time-ordered
+    std::stable_sort(merged.begin() + mid, merged.end(), sampleBefore);
+    std::inplace_merge(merged.begin(), merged.begin() + mid, merged.end(), sampleBefore);
+    if (merged.size() > kMaxCapacity) merged.remove(0, merged.size() - kMaxCapacity);
+    ring_ = merged;
+    head_ = 0;
+    size_ = merged.size();
+    endSeq_ += static_cast<quint64>(samples.size());
+    ++generation_;
+    pyramidRebuild();
+}
+
+void PlotSignalBuffer::trimBefore(qint64 oldest_ns) {
+    if (size_ == 0 || front().t_ns >= oldest_ns) return;
+    dropFront(lowerBound(oldest_ns));
+    // Give memory back once the rate has dropped well below what the ring was sized for
+    if (ring_.size() > kMinCapacity && size_ < ring_.size() / 4) reallocate(qMax(kMinCapacity, ring_.size() / 2));
+}
+
+void PlotSignalBuffer::clear() {
+    ring_.clear();
+    head_ = 0;
+    size_ = 0;
+    ++generation_;
+    pyramid_.clear();
+}
+
+int PlotSignalBuffer::lowerBound(qint64 t_ns) const {
+    int lo = 0, hi = size_;
+    while (lo < hi) {
+        const int mid = (lo + hi) / 2;
+        if (at(mid).t_ns < t_ns) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+QVector<PlotSignalSample> PlotSignalBuffer::toVector() const {
+    QVector<PlotSignalSample> out;
+    copyTo(0, size_, out);
+    return out;
+}
+
+void PlotSignalBuffer::copyTo(int from, int to, QVector<PlotSignalSample>& out) const {
+    if (from >= to) return;
+    out.reserve(out.size() + (to - from));
+    // at most two contiguous runs
+    const int start = wrap(head_ + from);
+    const int firstRun = qMin(to - from, ring_.size() - start);
+    out.append(ring_.constData() + start, firstRun);
+    out.append(ring_.constData(), to - from - firstRun);
+}
+
+bool PlotSignalBuffer::minMax(int from, int to, double& lo, double& hi) const {
+    lo = std::numeric_limits<double>::infinity();
+    hi = -std::numeric_limits<double>::infinity();
+    from = qMax(from, 0);
+    to = qMin(to, size_);
+    if (from >= to) return false;
+    const quint64 block = kPyramidBlock;
+    const quint64 begin = firstSeq() + static_cast<quint64>(from);
+    const quint64 end = firstSeq() + static_cast<quint64>(to);
+    quint64 a = (begin + block - 1) / block; // first whole base block
+    quint64 b = end / block;                 // past the last whole base block
+    if (a >= b) {
+        scanRange(begin, end, lo, hi);
+        return lo <= hi;
+    }
+    scanRange(begin, a * block, lo, hi);
+    scanRange(b * block, end, lo, hi);
+    // Climb while the remaining range still spans whole blocks of the next level,
+    // taking the odd block at either edge on the way
+    for (int level = 0; a < b; ++level) {
+        const quint64 up = (a + 1) / 2;
+        const quint64 down = b / 2;
+        if (level + 1 >= pyramid_.size() || up >= down) {
+            pyramidRange(level, a, b, lo, hi);
+            break;
+        }
+        pyramidRange(level, a, up * 2, lo, hi);
+        pyramidRange(level, down * 2, b, lo, hi);
+        a = up;
+        b = down;
+    }
+    return lo <= hi;
+}
+
+void PlotSignalBuffer::scanRange(quint64 from_seq, quint64 to_seq, double& lo, double& hi) const {
+    from_seq = qMax(from_seq, firstSeq());
+    to_seq = qMin(to_seq, endSeq_);
+    for (quint64 seq = from_seq; seq < to_seq; ++seq) {
+        const double v = at(static_cast<int>(seq - firstSeq())).value;
+        // comparisons are false for NaN, so it is skipped
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+    }
+}
+
+void PlotSignalBuffer::pyramidRange(int level, quint64 from, quint64 to, double& lo, double& hi) const {
+    const quint64 span = static_cast<quint64>(kPyramidBlock) << level;
+    for (quint64 block = from; block < to; ++block) {
+        if (level < pyramid_.size()) {
+            const PyramidLevel& l = pyramid_[level];
+            if (block >= l.first && block - l.first < l.entries.size()) {
+                const PyramidEntry& e = l.entries[block - l.first];
+                lo = qMin(lo, e.min);
+                hi = qMax(hi, e.max);
+                continue;
+            }
+        }
+        scanRange(block * span, (block + 1) * span, lo, hi);
+    }
+}
+
+void PlotSignalBuffer::pyramidAppend(quint64 seq) {
+    if ((seq + 1) % kPyramidBlock != 0) return;
+    const quint64 start = seq + 1 - kPyramidBlock;
+    if (start < firstSeq()) return; // block already partly trimmed
+    PyramidEntry entry{ std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity() };
+    scanRange(start, seq + 1, entry.min, entry.max);
+    quint64 block = start / kPyramidBlock;
+    for (int level = 0; level < kPyramidLevels; ++level) {
+        pyramidPush(level, block, entry);
+        // an odd block completes its pair, which completes one block of the next level
+        if ((block & 1) == 0) return;
+        const PyramidLevel& l = pyramid_[level];
+        if (l.entries.size() < 2) return;
+        const PyramidEntry& sibling = l.entries[l.entries.size() - 2];
+        entry = PyramidEntry{ qMin(sibling.min, entry.min), qMax(sibling.max, entry.max) };
+        block >>= 1;
+    }
+}
+
+void PlotSignalBuffer::pyramidPush(int level, quint64 block, const PyramidEntry& entry) {
+    if (pyramid_.size() <= level) pyramid_.resize(level + 1);
+    PyramidLevel& l = pyramid_[level];
+    // levels hold consecutive blocks; after a gap only the new block is kept
+    if (l.entries.empty() || l.first + l.entries.size() != block) {
+        l.entries.clear();
+        l.first = block;
+    }
+    l.entries.push_back(entry);
+}
+
+void PlotSignalBuffer::pyramidTrim() {
+    const quint64 first = firstSeq();
+    for (int level = 0; level < pyramid_.size(); ++level) {
+        PyramidLevel& l = pyramid_[level];
+        const quint64 span = static_cast<quint64>(kPyramidBlock) << level;
+        while (!l.entries.empty() && (l.first + 1) * span <= first) {
+            l.entries.pop_front();
+            ++l.first;
+        }
+    }
+}
+
+void PlotSignalBuffer::pyramidRebuild() {
+    pyramid_.clear();
+    for (quint64 seq = firstSeq(); seq < endSeq_; ++seq) pyramidAppend(seq);
+}
+
+void PlotSignalBuffer::reserveFor(int needed) {
+    if (needed <= ring_.size()) return;
+    // At most doubles per step: a burst with near-equal timestamps must not be
+    // extrapolated to the whole window
+    int capacity = qMax(kMinCapacity, ring_.size() * 2);
+    while (capacity < needed) capacity *= 2;
+    reallocate(qMin(capacity, kMaxCapacity));
+}
+
+void PlotSignalBuffer::dropFront(int count) {
+    head_ = wrap(head_ + count);
+    size_ -= count;
+    if (size_ == 0) head_ = 0;
+    pyramidTrim();
+}
+
+void PlotSignalBuffer::reallocate(int capacity) {
+    QVector<PlotSignalSample> ring = toVector();
+    ring.resize(qMax(capacity, size_));
+    ring_.swap(ring);
+    head_ = 0;
+}
 
 PlotSignalRegistry& PlotSignalRegistry::instance() {
     static PlotSignalRegistry inst;
     return inst;
 }
 
-PlotSignalRegistry::PlotSignalRegistry() : QObject(nullptr) {}
+PlotSignalRegistry::PlotSignalRegistry() : QObject(nullptr) {
+    // Notifications are flushed by a timer; keep it on the GUI thread whoever touches us first
+    if (QCoreApplication* app = QCoreApplication::instance()) moveToThread(app->thread());
+}
+
+std::shared_ptr<PlotSignalRegistry::SignalData> PlotSignalRegistry::findData(const QString& id) const {
+    QReadLocker guard(&lock_);
+    const PlotSignalHandle handle = handles_.value(id, kInvalidPlotSignalHandle);
+    if (handle == kInvalidPlotSignalHandle) return nullptr;
+    return slots_[handle];
+}
+
+std::shared_ptr<PlotSignalRegistry::SignalData> PlotSignalRegistry::findData(PlotSignalHandle handle) const {
+    QReadLocker guard(&lock_);
+    if (handle < 0 || handle >= slots_.size()) return nullptr;
+    return slots_[handle];
+}
+
+void PlotSignalRegistry::noteFirstSample(qint64 t_ns) {
+    // set global epoch at first sample
+    if (epoch_ns_.load(std::memory_order_relaxed) >= 0) return;
+    qint64 unset = -1;
+    epoch_ns_.compare_exchange_strong(unset, t_ns, std::memory_order_relaxed);
+}
+
+bool PlotSignalRegistry::appendTo(SignalData& data, const PlotSignalSample* samples, int count, qint64 window_ns) {
+    QWriteLocker guard(&data.lock);
+    if (!data.tagged) return false;
+    PlotSignalBuffer& buffer = data.buffer;
+    if (buffer.isEmpty() || samples[0].t_ns >= buffer.back().t_ns) {
+        for (int i = 0; i < count; ++i) buffer.append(samples[i]);
+    } else {
+        buffer.merge(QVector<PlotSignalSample>(samples, samples + count));
+    }
+    // Trim history older than the buffer window
+    if (window_ns > 0) buffer.trimBefore(buffer.back().t_ns - window_ns);
+    return true;
+}
+
+void PlotSignalRegistry::markDirty(SignalData& data) {
+    if (data.dirty.exchange(true, std::memory_order_acq_rel)) return;
+    if (notifyPending_.exchange(true, std::memory_order_acq_rel)) return;
+    // First sample since the last flush: schedule one notification for everything that follows
+    QMetaObject::invokeMethod(this, [this]{
+        QTimer::singleShot(kNotifyIntervalMs, this, &PlotSignalRegistry::flushNotifications);
+    }, Qt::QueuedConnection);
+}
+
+void PlotSignalRegistry::flushNotifications() {
+    notifyPending_.store(false, std::memory_order_release);
+    QSet<QString> ids;
+    {
+        QReadLocker guard(&lock_);
+        for (const auto& data : slots_) {
+            if (data->dirty.exchange(false, std::memory_order_acq_rel)) ids.insert(data->id);
+        }
+    }
+    if (!ids.isEmpty()) emit samplesAppended(ids);
+}
 
 void PlotSignalRegistry::tagSignal(const PlotSignalDef& def) {
     QWriteLocker guard(&lock_);
     if (!defs_.contains(def.id)) {
         defs_.insert(def.id, def);
-        data_.insert(def.id, {});
         order_.push_back(def.id);
+        PlotSignalHandle handle = handles_.value(def.id, kInvalidPlotSignalHandle);
+        if (handle == kInvalidPlotSignalHandle) {
+            // first time this id is seen: its handle stays reserved from now on
+            auto data = std::make_shared<SignalData>();
+            data->id = def.id;
+            handle = slots_.size();
+            slots_.push_back(data);
+            handles_.insert(def.id, handle);
+        }
+        {
+            QWriteLocker dataGuard(&slots_[handle]->lock);
+            slots_[handle]->tagged = true;
+        }
+        tagGeneration_.fetch_add(1, std::memory_order_acq_rel);
         guard.unlock();
         emit signalsChanged();
     }
@@ -24,9 +308,15 @@ void PlotSignalRegistry::untagSignal(const QString& id) {
     QWriteLocker guard(&lock_);
     if (defs_.contains(id)) {
         defs_.remove(id);
-        data_.remove(id);
         int idx = order_.indexOf(id);
         if (idx >= 0) order_.remove(idx);
+        {
+            SignalData& data = *slots_[handles_.value(id)];
+            QWriteLocker dataGuard(&data.lock);
+            data.tagged = false;
+            data.buffer.clear();
+        }
+        tagGeneration_.fetch_add(1, std::memory_order_acq_rel);
         guard.unlock();
         emit signalsChanged();
     }
@@ -63,24 +353,56 @@ QSet<QString> PlotSignalRegistry::taggedIdsByPrefix(const QString& prefix) const
     return out;
 }
 
+PlotSignalHandle PlotSignalRegistry::handleOf(const QString& id) const {
+    QReadLocker guard(&lock_);
+    if (!defs_.contains(id)) return kInvalidPlotSignalHandle;
+    return handles_.value(id, kInvalidPlotSignalHandle);
+}
+
 void PlotSignalRegistry::appendSample(const QString& id, qint64 t_ns, double value) {
-    QWriteLocker guard(&lock_);
-    auto it = data_.find(id);
-    if (it == data_.end()) return;
-    if (epoch_ns_ < 0) epoch_ns_ = t_ns; // set global epoch at first sample
-    it->append({t_ns, value});
-    // Trim history older than bufferDurationSec_
-    if (bufferDurationSec_ > 0) {
-        const qint64 oldest_ns = t_ns - static_cast<qint64>(bufferDurationSec_ * 1e9);
-        auto& vec = *it;
-        // Remove from front while older than window. Keep simple linear trim; samples are appended in time order.
-        int keepFrom = 0;
-        const int N = vec.size();
-        while (keepFrom < N && vec[keepFrom].t_ns < oldest_ns) ++keepFrom;
-        if (keepFrom > 0) vec.erase(vec.begin(), vec.begin() + keepFrom);
-    }
-    guard.unlock();
-    emit samplesAppended(id);
+    const auto data = findData(id);
+    if (!data) return;
+    noteFirstSample(t_ns);
+    const PlotSignalSample sample{ t_ns, value };
+    if (appendTo(*data, &sample, 1, windowNs())) markDirty(*data);
+}
+
+void PlotSignalRegistry::appendSample(PlotSignalHandle handle, qint64 t_ns, double value) {
+    const auto data = findData(handle);
+    if (!data) return;
+    noteFirstSample(t_ns);
+    const PlotSignalSample sample{ t_ns, value };
+    if (appendTo(*data, &sample, 1, windowNs())) markDirty(*data);
+}
+
+void PlotSignalRegistry::appendSamples(const QString& id, const QVector<PlotSignalSample>& samples) {
+    if (samples.isEmpty()) return;
+    const auto data = findData(id);
+    if (!data) return;
+    noteFirstSample(samples.first().t_ns);
+    if (appendTo(*data, samples.constData(), samples.size(), windowNs())) markDirty(*data);
+}
+
+void PlotSignalRegistry::appendSamples(PlotSignalHandle handle, const QVector<PlotSignalSample>& samples) {
+    if (samples.isEmpty()) return;
+    const auto data = findData(handle);
+    if (!data) return;
+    noteFirstSample(samples.first().t_ns);
+    if (appendTo(*data, samples.constData(), samples.size(), windowNs())) markDirty(*data);
+}
+
+void PlotSignalRegistry::appendBatch(const QVector<PlotSignalTuple>& samples) {
+    if (samples.isEmpty()) return;
+    const qint64 window_ns = windowNs();
+    QReadLocker guard(&lock_);
+    for (const PlotSignalTuple& tuple : samples) {
+        if (tuple.handle < 0 || tuple.handle >= slots_.size()) continue;
+        SignalData& data = *slots_[tuple.handle];
+        const PlotSignalSample sample{ tuple.t_ns, tuple.value };
+        if (!appendTo(data, &sample, 1, window_ns)) continue;
+        noteFirstSample(tuple.t_ns);
+        markDirty(data);
+    }
 }
 
 QVector<PlotSignalDef> PlotSignalRegistry::listSignals() const {
@@ -96,54 +418,80 @@ QVector<PlotSignalDef> PlotSignalRegistry::listSignals() const {
 }
 
 QVector<PlotSignalSample> PlotSignalRegistry::getSamples(const QString& id) const {
-    QReadLocker guard(&lock_);
-    return data_.value(id);
+    const auto data = findData(id);
+    if (!data) return {};
+    QReadLocker guard(&data->lock);
+    return data->buffer.toVector();
+}
+
+bool PlotSignalRegistry::minMax(const QString& id, qint64 t0_ns, qint64 t1_ns, double& lo, double& hi) const {
+    const auto data = findData(id);
+    if (!data || t1_ns < t0_ns) return false;
+    QReadLocker guard(&data->lock);
+    const PlotSignalBuffer& buffer = data->buffer;
+    const int from = buffer.lowerBound(t0_ns);
+    const int to = t1_ns == std::numeric_limits<qint64>::max() ? buffer.size() : buffer.lowerBound(t1_ns + 1);
+    return buffer.minMax(from, to, lo, hi);
+}
+
+bool PlotSignalRegistry::readNew(PlotSignalHandle handle, PlotSignalCursor& cursor, QVector<PlotSignalSample>& out) const {
+    out.clear();
+    const auto data = findData(handle);
+    if (!data) {
+        cursor = PlotSignalCursor();
+        return false;
+    }
+    QReadLocker guard(&data->lock);
+    const PlotSignalBuffer& buffer = data->buffer;
+    const bool current = cursor.generation == buffer.generation()
+                         && cursor.next >= buffer.firstSeq() && cursor.next <= buffer.endSeq();
+    const int from = current ? static_cast<int>(cursor.next - buffer.firstSeq()) : 0;
+    buffer.copyTo(from, buffer.size(), out);
+    cursor.generation = buffer.generation();
+    cursor.next = buffer.endSeq();
+    return current;
 }
 
 void PlotSignalRegistry::setBufferDurationSec(double seconds) {
     if (seconds <= 0) seconds = 1.0; // minimal sane value
+    const qint64 window_ns = static_cast<qint64>(seconds * 1e9);
     {
-        QWriteLocker guard(&lock_);
-        if (qFuzzyCompare(bufferDurationSec_, seconds)) return;
-        bufferDurationSec_ = seconds;
+        QReadLocker guard(&lock_);
+        if (windowNs_.exchange(window_ns, std::memory_order_relaxed) == window_ns) return;
         // Perform a trimming pass for all signals based on current time
-        const qint64 now_ns = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch() * 1000000LL;
-        const qint64 oldest_ns = now_ns - static_cast<qint64>(bufferDurationSec_ * 1e9);
-        for (auto it = data_.begin(); it != data_.end(); ++it) {
-            auto& vec = it.value();
-            int keepFrom = 0;
-            const int N = vec.size();
-            while (keepFrom < N && vec[keepFrom].t_ns < oldest_ns) ++keepFrom;
-            if (keepFrom > 0) vec.erase(vec.begin(), vec.begin() + keepFrom);
+        const qint64 oldest_ns = time_base::now_ns() - window_ns;
+        for (const auto& data : slots_) {
+            QWriteLocker dataGuard(&data->lock);
+            data->buffer.trimBefore(oldest_ns);
         }
     }
     emit bufferDurationChanged(seconds);
 }
 
 double PlotSignalRegistry::bufferDurationSec() const {
-    QReadLocker guard(&lock_);
-    return bufferDurationSec_;
+    return static_cast<double>(windowNs()) * 1e-9;
 }
 
 qint64 PlotSignalRegistry::epochNs() const {
-    QReadLocker guard(&lock_);
-    return epoch_ns_;
+    return epoch_ns_.load(std::memory_order_relaxed);
 }
 
 void PlotSignalRegistry::resetEpochToNow() {
-    {
-        QWriteLocker guard(&lock_);
-        epoch_ns_ = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch() * 1000000LL;
-    }
-    emit epochChanged(epoch_ns_);
+    const qint64 epoch_ns = time_base::now_ns();
+    epoch_ns_.store(epoch_ns, std::memory_order_relaxed);
+    emit epochChanged(epoch_ns);
 }
 
 void PlotSignalRegistry::clearAllSamplesAndResetEpoch() {
+    const qint64 epoch_ns = time_base::now_ns();
     {
-        QWriteLocker guard(&lock_);
-        for (auto it = data_.begin(); it != data_.end(); ++it) it.value().clear();
-        epoch_ns_ = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch() * 1000000LL;
+        QReadLocker guard(&lock_);
+        for (const auto& data : slots_) {
+            QWriteLocker dataGuard(&data->lock);
+            data->buffer.clear();
+        }
+        epoch_ns_.store(epoch_ns, std::memory_order_relaxed);
     }
     emit samplesCleared();
-    emit epochChanged(epoch_ns_);
+    emit epochChanged(epoch_ns);
 }
@@ -241,10 +241,90 @@ bool udp_settings::load(QSettings &settings)
 
 
 
+QString realtime_settings::get_QString(void) const
+{
+    if (policy == OFF) return "OFF";
+    QString text_out_ = policy_name(policy) + " " + QString::number(priority);
+    text_out_ += ", CPUs: " + (cpu_mask == 0 ? QString("ANY") : cpu_mask_to_QString(cpu_mask));
+    return text_out_;
+}
+void realtime_settings::save(QSettings &settings, const QString &group) const
+{
+    settings.beginGroup(group);
+    settings.setValue("policy", policy);
+    settings.setValue("priority", priority);
+    settings.setValue("cpu_mask", cpu_mask);
+    settings.endGroup();
+}
+void realtime_settings::load(QSettings &settings, const QString &group)
+{
+    settings.beginGroup(group);
+    policy = settings.value("policy", policy).toInt();
+    priority = qBound(1, settings.value("priority", priority).toInt(), 99);
+    cpu_mask = settings.value("cpu_mask", cpu_mask).toULongLong();
+    settings.endGroup();
+}
+QString realtime_settings::policy_name(int policy)
+{
+    switch (policy)
+    {
+    case FIFO:
+        return "SCHED_FIFO";
+    case RR:
+        return "SCHED_RR";
+    default:
+        return "OFF";
+    }
+}
+QString realtime_settings::thread_class_name(int thread_class)
+{
+    switch (thread_class)
+    {
+    case PORT_IO:
+        return "Port I/O";
+    case RELAYS:
+        return "Relays";
+    case MOCAP:
+        return "Mocap";
+    default:
+        return "None";
+    }
+}
+QString realtime_settings::cpu_mask_to_QString(quint64 mask)
+{
+    QStringList cpus_;
+    for (int cpu = 0; cpu < 64; cpu++)
+    {
+        if (mask & (quint64(1) << cpu)) cpus_.append(QString::number(cpu));
+    }
+    return cpus_.join(",");
+}
+quint64 realtime_settings::cpu_mask_from_QString(const QString &text)
+{
+    // accepts lists like "2,3" or ranges like "0-3,6"
+    quint64 mask = 0;
+    const QStringList parts_ = text.split(',', Qt::SkipEmptyParts);
+    for (const QString &part : parts_)
+    {
+        const QStringList range_ = part.trimmed().split('-');
+        bool ok_first = false, ok_last = true;
+        const int first = range_[0].trimmed().toInt(&ok_first);
+        const int last = (range_.size() > 1) ? range_[1].trimmed().toInt(&ok_last) : first;
+        if (!ok_first || !ok_last) continue;
+        for (int cpu = qMax(0, first); cpu <= qMin(63, last); cpu++) mask |= (quint64(1) << cpu);
+    }
+    return mask;
+}
+
+
 QString generic_thread_settings::get_QString(void)
 {
     QString text_out_ = "Update Rate: " + QString::number(update_rate_hz) + " (Hz)\n";
     text_out_ += default_ui_config::Priority::value2key(priority) + "\n";
+    if (realtime_class != realtime_settings::UNASSIGNED)
+    {
+        text_out_ += "Real-Time Class: " + realtime_settings::thread_class_name(realtime_class) + "\n";
+    }
     return text_out_;
 }
 void generic_thread_settings::save(QSettings &settings)
@@ -295,10 +375,18 @@ void kgroundcontrol_settings::save(QSettings &settings)
     settings.setValue("font_family", font_family);
     settings.setValue("font_point_size", font_point_size);
     settings.setValue("plot_buffer_duration_sec", plot_buffer_duration_sec);
+    settings.setValue("mavlink_history_duration_sec", mavlink_history_duration_sec);
+    settings.setValue("stream_rate_auto", stream_rate_auto);
+    settings.setValue("stream_budget_bytes_per_s", stream_budget_bytes_per_s);
     settings.setValue("check_updates_on_startup", check_updates_on_startup);
     settings.setValue("mavlink_logging_enabled", mavlink_logging_enabled);
     settings.setValue("mavlink_logging_directory", mavlink_logging_directory.trimmed());
     settings.setValue("auto_install_on_startup", auto_install_on_startup);
+    for (int i = 0; i < realtime_settings::THREAD_CLASS_COUNT; i++)
+    {
+        realtime[i].save(settings, QString("realtime/class_%1").arg(i));
+    }
+    settings.setValue("realtime/lock_memory", realtime_lock_memory);
     settings.endGroup();
 }
 bool kgroundcontrol_settings::load(QSettings &settings)
@@ -315,6 +403,9 @@ bool kgroundcontrol_settings::load(QSettings &settings)
     font_family = settings.value("font_family", font_family).toString();
     font_point_size = settings.value("font_point_size", font_point_size).toInt();
     plot_buffer_duration_sec = settings.value("plot_buffer_duration_sec", plot_buffer_duration_sec).toDouble();
+    mavlink_history_duration_sec = settings.value("mavlink_history_duration_sec", mavlink_history_duration_sec).toDouble();
+    stream_rate_auto = settings.value("stream_rate_auto", stream_rate_auto).toBool();
+    stream_budget_bytes_per_s = settings.value("stream_budget_bytes_per_s", stream_budget_bytes_per_s).toInt();
     check_updates_on_startup = settings.value("check_updates_on_startup", check_updates_on_startup).toBool();
     mavlink_logging_enabled = settings.value("mavlink_logging_enabled", mavlink_logging_enabled).toBool();
     const QString default_log_dir = log_manager::default_log_directory();
@@ -323,6 +414,11 @@ bool kgroundcontrol_settings::load(QSettings &settings)
         mavlink_logging_directory = default_log_dir;
     }
     auto_install_on_startup = settings.value("auto_install_on_startup", auto_install_on_startup).toBool();
+    for (int i = 0; i < realtime_settings::THREAD_CLASS_COUNT; i++)
+    {
+        realtime[i].load(settings, QString("realtime/class_%1").arg(i));
+    }
+    realtime_lock_memory = settings.value("realtime/lock_memory", realtime_lock_memory).toBool();
     settings.endGroup();
     return true;
 }
@@ -413,6 +509,7 @@ mocap_relay_settings::mocap_relay_settings(mocap_relay_settings &other)
     msg_option = other.msg_option;
     sysid = other.sysid;
     compid = other.compid;
+    vehicle_time = other.vehicle_time;
 }
 
 mocap_relay_settings::~mocap_relay_settings()
@@ -433,6 +530,7 @@ QString mocap_relay_settings::get_QString(void)
     text_out_ += "Message Option:" + enum_helpers::value2key(msg_option) + "\n";
     text_out_ += "System ID: " + QString::number(sysid);
     text_out_ += "Component ID: " + enum_helpers::value2key(compid);
+    text_out_ += QString("\nTime base: ") + (vehicle_time ? "vehicle" : "ground");
     return text_out_;
 }
 void mocap_relay_settings::save(QSettings &settings)
@@ -448,6 +546,7 @@ void mocap_relay_settings::save(QSettings &settings)
         settings.setValue("compid", static_cast<int32_t>(compid));
         settings.setValue("update_rate_hz", static_cast<int>(update_rate_hz));
         settings.setValue("priority", static_cast<int>(priority));
+        settings.setValue("vehicle_time", vehicle_time);
         // settings.endGroup();
         settings.endGroup();
     }
@@ -469,6 +568,7 @@ bool mocap_relay_settings::load(QSettings &settings)
     // Optional fields with defaults for backward compatibility
     update_rate_hz = settings.value("update_rate_hz", update_rate_hz).toUInt();
     priority = settings.value("priority", priority).toInt();
+    vehicle_time = settings.value("vehicle_time", vehicle_time).toBool();
     settings.endGroup();
     return true;
 }
@@ -33,12 +33,223 @@
  ****************************************************************************/
 
 #include "threads.h"
+#include "time_base.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <chrono>
+
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace realtime
+{
+namespace
+{
+struct thread_entry
+{
+    int thread_class = realtime_settings::UNASSIGNED;
+    QObject* owner = nullptr;
+    latency_histogram* histogram = nullptr;
+#ifdef Q_OS_LINUX
+    pthread_t handle;
+#endif
+    bool applied = false;
+    QString status = "OFF";
+};
+
+QMutex registry_mutex_;
+realtime_settings class_settings_[realtime_settings::THREAD_CLASS_COUNT];
+QHash<Qt::HANDLE, thread_entry> threads_; // key: native thread id
+bool memory_locked_ = false;
+
+void apply_locked(thread_entry& entry, const realtime_settings& settings)
+{
+#ifdef Q_OS_LINUX
+    // nothing to undo if real-time mode was never applied to this thread
+    if (settings.policy == realtime_settings::OFF && !entry.applied)
+    {
+        entry.status = "OFF";
+        return;
+    }
+
+    int policy_ = SCHED_OTHER;
+    if (settings.policy == realtime_settings::FIFO) policy_ = SCHED_FIFO;
+    else if (settings.policy == realtime_settings::RR) policy_ = SCHED_RR;
+
+    sched_param param_{};
+    param_.sched_priority = (policy_ == SCHED_OTHER) ? 0 : qBound(sched_get_priority_min(policy_), settings.priority, sched_get_priority_max(policy_));
+    const int sched_err = pthread_setschedparam(entry.handle, policy_, &param_);
+
+    cpu_set_t cpus_;
+    CPU_ZERO(&cpus_);
+    const long cpu_count = sysconf(_SC_NPROCESSORS_CONF);
+    for (int cpu = 0; cpu < CPU_SETSIZE && cpu < cpu_count; cpu++)
+    {
+        const bool pinned = settings.policy != realtime_settings::OFF && settings.cpu_mask != 0;
+        if (!pinned || (cpu < 64 && (settings.cpu_mask & (quint64(1) << cpu)))) CPU_SET(cpu, &cpus_);
+    }
+    const int affinity_err = pthread_setaffinity_np(entry.handle, sizeof(cpus_), &cpus_);
+
+    entry.applied = (settings.policy != realtime_settings::OFF) && sched_err == 0;
+    if (sched_err != 0 || affinity_err != 0)
+    {
+        entry.status = "FAILED (" + QString::fromLocal8Bit(strerror(sched_err != 0 ? sched_err : affinity_err)) + ")";
+        qWarning() << "Warning: failed to apply real-time settings:" << entry.status;
+    }
+    else entry.status = settings.get_QString();
+#else
+    entry.status = (settings.policy == realtime_settings::OFF) ? "OFF" : "UNSUPPORTED";
+#endif
+}
+}
+
+void latency_histogram::record(int64_t latency_ns)
+{
+    if (latency_ns < 0) latency_ns = 0;
+    int bucket = 0;
+    while (bucket < BUCKET_COUNT - 1 && latency_ns >= bucket_upper_ns(bucket)) bucket++;
+    counts_[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    int64_t max_ = max_ns_.load(std::memory_order_relaxed);
+    while (latency_ns > max_ && !max_ns_.compare_exchange_weak(max_, latency_ns, std::memory_order_relaxed)) {}
+}
+void latency_histogram::reset(void)
+{
+    for (auto& count_ : counts_) count_.store(0, std::memory_order_relaxed);
+    max_ns_.store(0, std::memory_order_relaxed);
+}
+uint64_t latency_histogram::count(void) const
+{
+    uint64_t total_ = 0;
+    for (const auto& count_ : counts_) total_ += count_.load(std::memory_order_relaxed);
+    return total_;
+}
+int64_t latency_histogram::bucket_upper_ns(int bucket)
+{
+    static const int64_t upper_us[BUCKET_COUNT - 1] = {10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000};
+    if (bucket < 0) return 0;
+    if (bucket >= BUCKET_COUNT - 1) return INT64_MAX;
+    return upper_us[bucket] * 1000;
+}
+QString latency_histogram::get_QString(void) const
+{
+    QString text_out_ = "Wake-up Latency: " + QString::number(count()) + " samples, max "
+                        + QString::number(static_cast<double>(max_ns()) / 1.0E3, 'f', 1) + " (us)\n";
+    for (int bucket = 0; bucket < BUCKET_COUNT; bucket++)
+    {
+        const uint64_t count_ = counts_[bucket].load(std::memory_order_relaxed);
+        if (count_ == 0) continue;
+        const QString label_ = (bucket < BUCKET_COUNT - 1)
+                                   ? "< " + QString::number(bucket_upper_ns(bucket) / 1000) + " us"
+                                   : ">= " + QString::number(bucket_upper_ns(bucket - 1) / 1000) + " us";
+        text_out_ += "  " + label_.leftJustified(12, ' ') + QString::number(count_) + "\n";
+    }
+    return text_out_;
+}
+
+void configure(int thread_class, const realtime_settings& settings)
+{
+    if (thread_class < 0 || thread_class >= realtime_settings::THREAD_CLASS_COUNT) return;
+    QMutexLocker locker(&registry_mutex_);
+    class_settings_[thread_class] = settings;
+    for (auto it = threads_.begin(); it != threads_.end(); ++it)
+    {
+        if (it->thread_class == thread_class) apply_locked(*it, settings);
+    }
+}
+void configure(const kgroundcontrol_settings& settings)
+{
+    for (int i = 0; i < realtime_settings::THREAD_CLASS_COUNT; i++) configure(i, settings.realtime[i]);
+    lock_memory(settings.realtime_lock_memory);
+}
+realtime_settings get_class_settings(int thread_class)
+{
+    QMutexLocker locker(&registry_mutex_);
+    if (thread_class < 0 || thread_class >= realtime_settings::THREAD_CLASS_COUNT) return realtime_settings();
+    return class_settings_[thread_class];
+}
+bool lock_memory(bool enable)
+{
+    QMutexLocker locker(&registry_mutex_);
+    if (enable == memory_locked_) return true;
+#ifdef Q_OS_LINUX
+    const int err = enable ? mlockall(MCL_CURRENT | MCL_FUTURE) : munlockall();
+    if (err != 0)
+    {
+        qWarning() << "Warning: failed to" << (enable ? "lock" : "unlock") << "process memory:" << strerror(errno);
+        return false;
+    }
+    memory_locked_ = enable;
+    return true;
+#else
+    return !enable;
+#endif
+}
+
+void attach(int thread_class, QObject* owner, latency_histogram* histogram)
+{
+    if (thread_class < 0 || thread_class >= realtime_settings::THREAD_CLASS_COUNT) return;
+    QMutexLocker locker(&registry_mutex_);
+    thread_entry entry;
+    entry.thread_class = thread_class;
+    entry.owner = owner;
+    entry.histogram = histogram;
+#ifdef Q_OS_LINUX
+    entry.handle = pthread_self();
+#endif
+    apply_locked(entry, class_settings_[thread_class]);
+    threads_.insert(QThread::currentThreadId(), entry);
+}
+void detach(void)
+{
+    QMutexLocker locker(&registry_mutex_);
+    threads_.remove(QThread::currentThreadId());
+}
+
+QString get_report_QString(void)
+{
+    QMutexLocker locker(&registry_mutex_);
+    QString text_out_ = "Memory Lock: " + QString(memory_locked_ ? "ON" : "OFF") + "\n";
+    for (int thread_class = 0; thread_class < realtime_settings::THREAD_CLASS_COUNT; thread_class++)
+    {
+        for (auto it = threads_.constBegin(); it != threads_.constEnd(); ++it)
+        {
+            if (it->thread_class != thread_class) continue;
+            const QString name_ = (it->owner == nullptr || it->owner->objectName().isEmpty())
+                                      ? QString(it->owner ? it->owner->metaObject()->className() : "thread")
+                                      : it->owner->objectName();
+            text_out_ += "\n" + realtime_settings::thread_class_name(thread_class) + " | " + name_ + ": " + it->status + "\n";
+            if (it->histogram) text_out_ += it->histogram->get_QString();
+        }
+    }
+    return text_out_;
+}
+}
+
+
 
 generic_thread::generic_thread(QObject* parent, generic_thread_settings* settings_in_)
     : QThread(parent)
 {
     mutex = new QMutex;
     update_settings(settings_in_);
+
+    // the real-time profile can only be applied from within the thread itself
+    connect(this, &QThread::started, this, [this]() {
+        mutex->lock();
+        const int realtime_class_ = generic_thread_settings_.realtime_class;
+        mutex->unlock();
+        if (realtime_class_ != realtime_settings::UNASSIGNED) realtime::attach(realtime_class_, this, &wakeup_latency_);
+    }, Qt::DirectConnection);
+    connect(this, &QThread::finished, this, []() { realtime::detach(); }, Qt::DirectConnection);
 }
 generic_thread::~generic_thread(void)
 {
@@ -55,16 +266,391 @@ void generic_thread::load_settings(QSettings &qsettings)
 void generic_thread::update_settings(generic_thread_settings* settings_in_)
 {
     mutex->lock();
+    bool priority_changed = false;
     if (generic_thread_settings_.priority != settings_in_->priority && isRunning())
     {
         setPriority(settings_in_->priority);
+        priority_changed = true;
     }
+    const int realtime_class_ = generic_thread_settings_.realtime_class;
     memcpy(&generic_thread_settings_, settings_in_, sizeof(generic_thread_settings));
-
+    // the real-time class is fixed by the thread type, keep it unless explicitly given
+    if (settings_in_->realtime_class == realtime_settings::UNASSIGNED) generic_thread_settings_.realtime_class = realtime_class_;
     mutex->unlock();
+
+    // setPriority() resets the scheduling policy, restore the real-time profile
+    if (priority_changed && generic_thread_settings_.realtime_class != realtime_settings::UNASSIGNED)
+    {
+        realtime::configure(generic_thread_settings_.realtime_class, realtime::get_class_settings(generic_thread_settings_.realtime_class));
+    }
+}
+
+void generic_thread::sleep_period(void)
+{
+    const std::chrono::nanoseconds period_{static_cast<int64_t>(1.0E9/static_cast<double>(generic_thread_settings_.update_rate_hz))};
+    const std::chrono::steady_clock::time_point target_ = std::chrono::steady_clock::now() + period_;
+    sleep(period_);
+    wakeup_latency_.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - target_).count());
 }
 
 QString generic_thread::get_settings_QString(void)
 {
     return generic_thread_settings_.get_QString();
 }
+
+
+
+job_thread::job_thread(QObject* parent, generic_thread_settings* settings_in_, size_t capacity)
+    : generic_thread(parent, settings_in_), jobs_(capacity)
+{
+}
+
+job_thread::~job_thread()
+{
+    requestInterruption();
+    wake();
+    wait();
+}
+
+bool job_thread::post(job_type job)
+{
+    if (!jobs_.push(job)) return false;
+    wake();
+    return true;
+}
+
+void job_thread::wake(void)
+{
+    // pairs with the fence in run(): either we see waiting_ or the consumer sees our push
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!waiting_.load(std::memory_order_relaxed)) return;
+    wake_mutex_.lock();
+    wake_cond_.wakeOne();
+    wake_mutex_.unlock();
+}
+
+void job_thread::run()
+{
+    job_type job;
+    for (;;)
+    {
+        while (jobs_.pop(job))
+        {
+            job();
+            job = nullptr;
+        }
+        if (isInterruptionRequested()) return;
+
+        waiting_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        wake_mutex_.lock();
+        if (jobs_.empty() && !isInterruptionRequested()) wake_cond_.wait(&wake_mutex_);
+        wake_mutex_.unlock();
+        waiting_.store(false, std::memory_order_relaxed);
+    }
+}
+
+
+
+QString periodic_task_stats::get_QString(void) const
+{
+    QString text_out_ = "Period: " + QString::number(static_cast<double>(period_ns) / 1.0E6, 'f', 3) + " (ms)\n";
+    text_out_ += "Dispatches: " + QString::number(dispatches) + ", Overruns: " + QString::number(overruns) + "\n";
+    text_out_ += "Jitter (us): last " + QString::number(static_cast<double>(last_jitter_ns) / 1.0E3, 'f', 1)
+                 + ", mean " + QString::number(mean_jitter_ns / 1.0E3, 'f', 1)
+                 + ", max " + QString::number(static_cast<double>(max_jitter_ns) / 1.0E3, 'f', 1) + "\n";
+    text_out_ += "Execution (us): last " + QString::number(static_cast<double>(last_exec_ns) / 1.0E3, 'f', 1)
+                 + ", max " + QString::number(static_cast<double>(max_exec_ns) / 1.0E3, 'f', 1) + "\n";
+    return text_out_;
+}
+
+
+
+periodic_task::periodic_task(QObject* parent, generic_thread_settings* settings_in_)
+    : QObject(parent)
+{
+    mutex = new QMutex;
+    update_settings(settings_in_);
+}
+periodic_task::~periodic_task(void)
+{
+    // owners are expected to stop the task first, this is only a safety net
+    periodic_scheduler::instance().remove_and_wait(this);
+    delete mutex;
+}
+void periodic_task::start(void)
+{
+    interruption_requested_ = false;
+    state_ = SCHEDULED;
+    periodic_scheduler::instance().add(this);
+}
+void periodic_task::start(QThread::Priority priority)
+{
+    mutex->lock();
+    generic_thread_settings_.priority = priority;
+    mutex->unlock();
+    start();
+}
+void periodic_task::requestInterruption(void)
+{
+    interruption_requested_ = true;
+    periodic_scheduler::instance().remove(this);
+}
+bool periodic_task::isInterruptionRequested(void) const
+{
+    return interruption_requested_;
+}
+bool periodic_task::isRunning(void) const
+{
+    return state_ == SCHEDULED;
+}
+bool periodic_task::isFinished(void) const
+{
+    return state_ == FINISHED;
+}
+bool periodic_task::wait(QDeadlineTimer deadline)
+{
+    if (state_ == IDLE) return true;
+    return periodic_scheduler::instance().wait_finished(this, deadline);
+}
+void periodic_task::terminate(void)
+{
+    interruption_requested_ = true;
+    periodic_scheduler::instance().remove_and_wait(this);
+}
+periodic_task_stats periodic_task::get_stats(void) const
+{
+    return periodic_scheduler::instance().get_stats(this);
+}
+void periodic_task::save_settings(QSettings &qsettings)
+{
+    generic_thread_settings_.save(qsettings);
+}
+void periodic_task::load_settings(QSettings &qsettings)
+{
+    generic_thread_settings_.load(qsettings);
+}
+void periodic_task::update_settings(generic_thread_settings* settings_in_)
+{
+    mutex->lock();
+    memcpy(&generic_thread_settings_, settings_in_, sizeof(generic_thread_settings));
+    mutex->unlock();
+
+    if (state_ == SCHEDULED) periodic_scheduler::instance().reschedule(this);
+}
+QString periodic_task::get_settings_QString(void)
+{
+    return generic_thread_settings_.get_QString();
+}
+
+
+
+periodic_scheduler& periodic_scheduler::instance(void)
+{
+    static periodic_scheduler scheduler_;
+    return scheduler_;
+}
+periodic_scheduler::periodic_scheduler()
+    : QThread(nullptr)
+{
+    setObjectName("periodic_scheduler");
+}
+periodic_scheduler::~periodic_scheduler()
+{
+    requestInterruption();
+    lock_.lock();
+    wakeup_.wakeAll();
+    lock_.unlock();
+    QThread::wait();
+}
+
+int64_t periodic_scheduler::now_ns(void)
+{
+    return time_base::now_ns();
+}
+int64_t periodic_scheduler::period_from_settings(const generic_thread_settings& settings)
+{
+    const unsigned int rate_hz = settings.update_rate_hz > 0 ? settings.update_rate_hz : 1;
+    return static_cast<int64_t>(1.0E9 / static_cast<double>(rate_hz));
+}
+
+void periodic_scheduler::push_locked(periodic_task* task, task_slot& slot)
+{
+    heap_.push_back({slot.deadline_ns, task, slot.generation});
+    std::push_heap(heap_.begin(), heap_.end());
+}
+void periodic_scheduler::raise_priority_locked(QThread::Priority priority)
+{
+    if (priority == QThread::InheritPriority || priority <= priority_) return;
+    priority_ = priority;
+    if (isRunning())
+    {
+        setPriority(priority_);
+        // setPriority() resets the scheduling policy, restore the real-time profile
+        realtime::configure(realtime_settings::RELAYS, realtime::get_class_settings(realtime_settings::RELAYS));
+    }
+}
+
+void periodic_scheduler::add(periodic_task* task)
+{
+    task->mutex->lock();
+    const generic_thread_settings settings_ = task->generic_thread_settings_;
+    task->mutex->unlock();
+
+    QMutexLocker locker(&lock_);
+    task_slot slot;
+    slot.period_ns = period_from_settings(settings_);
+    slot.deadline_ns = now_ns(); // first dispatch right away
+    slot.generation = next_generation_++;
+    slot.stats.period_ns = static_cast<uint64_t>(slot.period_ns);
+    auto it = slots_.insert(task, slot);
+    push_locked(task, *it);
+
+    raise_priority_locked(settings_.priority);
+    if (!isRunning()) start(priority_ == QThread::IdlePriority ? QThread::NormalPriority : priority_);
+    wakeup_.wakeAll();
+}
+void periodic_scheduler::reschedule(periodic_task* task)
+{
+    task->mutex->lock();
+    const generic_thread_settings settings_ = task->generic_thread_settings_;
+    task->mutex->unlock();
+
+    QMutexLocker locker(&lock_);
+    auto it = slots_.find(task);
+    if (it == slots_.end()) return;
+    it->period_ns = period_from_settings(settings_);
+    it->deadline_ns = now_ns() + it->period_ns;
+    it->generation = next_generation_++; // invalidates the pending heap entry
+    it->stats.period_ns = static_cast<uint64_t>(it->period_ns);
+    push_locked(task, *it);
+
+    raise_priority_locked(settings_.priority);
+    wakeup_.wakeAll();
+}
+void periodic_scheduler::remove(periodic_task* task)
+{
+    QMutexLocker locker(&lock_);
+    if (slots_.remove(task) > 0 && current_ != task)
+    {
+        task->state_ = periodic_task::FINISHED;
+        dispatch_done_.wakeAll();
+    }
+    // stale heap entries are discarded lazily by the dispatcher
+}
+void periodic_scheduler::remove_and_wait(periodic_task* task)
+{
+    QMutexLocker locker(&lock_);
+    slots_.remove(task);
+    while (current_ == task && QThread::currentThread() != this) dispatch_done_.wait(&lock_);
+    if (task->state_ == periodic_task::SCHEDULED && current_ != task)
+    {
+        task->state_ = periodic_task::FINISHED;
+        dispatch_done_.wakeAll();
+    }
+}
+bool periodic_scheduler::wait_finished(periodic_task* task, QDeadlineTimer deadline)
+{
+    QMutexLocker locker(&lock_);
+    while (task->state_ == periodic_task::SCHEDULED)
+    {
+        if (!dispatch_done_.wait(&lock_, deadline)) return task->state_ != periodic_task::SCHEDULED;
+    }
+    return true;
+}
+
+periodic_task_stats periodic_scheduler::get_stats(const periodic_task* task)
+{
+    QMutexLocker locker(&lock_);
+    return slots_.value(const_cast<periodic_task*>(task)).stats;
+}
+QString periodic_scheduler::get_stats_QString(void)
+{
+    QMutexLocker locker(&lock_);
+    QString text_out_ = "Periodic Tasks: " + QString::number(slots_.size()) + "\n";
+    for (auto it = slots_.constBegin(); it != slots_.constEnd(); ++it)
+    {
+        const QString name_ = it.key()->objectName().isEmpty() ? QString(it.key()->metaObject()->className()) : it.key()->objectName();
+        text_out_ += "\n" + name_ + ":\n" + it.value().stats.get_QString();
+    }
+    return text_out_;
+}
+
+void periodic_scheduler::run()
+{
+    realtime::attach(realtime_settings::RELAYS, this, &wakeup_latency_);
+
+    QMutexLocker locker(&lock_);
+    while (!isInterruptionRequested())
+    {
+        // discard entries of removed or rescheduled tasks
+        while (!heap_.empty())
+        {
+            const heap_entry& top_ = heap_.front();
+            auto it = slots_.constFind(top_.task);
+            if (it != slots_.constEnd() && it->generation == top_.generation) break;
+            std::pop_heap(heap_.begin(), heap_.end());
+            heap_.pop_back();
+        }
+        if (heap_.empty())
+        {
+            wakeup_.wait(&lock_);
+            continue;
+        }
+
+        const heap_entry next_ = heap_.front();
+        if (now_ns() < next_.deadline_ns)
+        {
+            const std::chrono::steady_clock::time_point deadline_{std::chrono::nanoseconds{next_.deadline_ns}};
+            wakeup_.wait(&lock_, QDeadlineTimer(deadline_, Qt::PreciseTimer));
+            continue;
+        }
+        std::pop_heap(heap_.begin(), heap_.end());
+        heap_.pop_back();
+
+        periodic_task* task = next_.task;
+        current_ = task;
+        locker.unlock();
+        const int64_t start_ns = now_ns();
+        task->tick();
+        const int64_t end_ns = now_ns();
+        locker.relock();
+        current_ = nullptr;
+
+        auto it = slots_.find(task);
+        if (it == slots_.end())
+        {
+            // removed while it was being dispatched
+            task->state_ = periodic_task::FINISHED;
+            dispatch_done_.wakeAll();
+            continue;
+        }
+        dispatch_done_.wakeAll();
+        if (it->generation != next_.generation) continue; // rescheduled meanwhile
+
+        periodic_task_stats& stats_ = it->stats;
+        const int64_t jitter_ns = start_ns - next_.deadline_ns;
+        wakeup_latency_.record(jitter_ns);
+        stats_.dispatches++;
+        stats_.last_jitter_ns = jitter_ns;
+        stats_.max_jitter_ns = std::max(stats_.max_jitter_ns, jitter_ns);
+        stats_.mean_jitter_ns = (stats_.dispatches == 1) ? static_cast<double>(jitter_ns)
+                                                         : stats_.mean_jitter_ns + (static_cast<double>(jitter_ns) - stats_.mean_jitter_ns) / 16.0;
+        stats_.last_exec_ns = end_ns - start_ns;
+        stats_.max_exec_ns = std::max(stats_.max_exec_ns, stats_.last_exec_ns);
+
+        // next absolute deadline; skip (and count) periods we are already late for
+        int64_t deadline_ns = next_.deadline_ns + it->period_ns;
+        if (deadline_ns <= end_ns)
+        {
+            const int64_t missed_ = (end_ns - next_.deadline_ns) / it->period_ns;
+            stats_.overruns += static_cast<uint64_t>(missed_);
+            deadline_ns = next_.deadline_ns + (missed_ + 1) * it->period_ns;
+        }
+        it->deadline_ns = deadline_ns;
+        push_locked(task, *it);
+    }
+    locker.unlock();
+
+    realtime::detach();
+}
@@ -0,0 +1,203 @@
+/****************************************************************************
+ *
+ *    Copyright (C) 2025  Yevhenii Kovryzhenko. All rights reserved.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU Affero General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License Version 3 for more details.
+ *
+ *    You should have received a copy of the
+ *    GNU Affero General Public License Version 3
+ *    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions, and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions, and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *    3. No ownership or credit shall be claimed by anyone not mentioned in
+ *       the above copyright statement.
+ *    4. Any redistribution or public use of this software, in whole or in part,
+ *       whether standalone or as part of a different project, must remain
+ *       under the terms of the GNU Affero General Public License Version 3,
+ *       and all distributions in binary form must be accompanied by a copy of
+ *       the source code, as stated in the GNU Affero General Public License.
+ *
+ ****************************************************************************/
+
+#include <QMap>
+
+#include "ftp_responder.h"
+
+static QString request_path(const mavlink_ftp::payload &request)
+{
+    return QString::fromUtf8(reinterpret_cast<const char*>(request.data), qstrnlen(reinterpret_cast<const char*>(request.data), request.size));
+}
+
+mavlink_ftp::payload ftp_responder::make_reply(const mavlink_ftp::payload &request, bool ack) const
+{
+    mavlink_ftp::payload reply;
+    reply.seq = static_cast<uint16_t>(request.seq + 1);
+    reply.session = request.session;
+    reply.opcode = ack ? mavlink_ftp::RSP_ACK : mavlink_ftp::RSP_NAK;
+    reply.req_opcode = request.opcode;
+    reply.offset = request.offset;
+    return reply;
+}
+
+mavlink_ftp::payload ftp_responder::make_nak(const mavlink_ftp::payload &request, uint8_t error) const
+{
+    mavlink_ftp::payload reply = make_reply(request, false);
+    reply.size = 1;
+    reply.data[0] = error;
+    return reply;
+}
+
+void ftp_responder::handle(const mavlink_ftp::payload &request, payload_list &out)
+{
+    switch (request.opcode)
+    {
+    case mavlink_ftp::CMD_OPEN_FILE_RO:
+    {
+        const QString path = request_path(request);
+        if (!files_.contains(path))
+        {
+            out.append(make_nak(request, mavlink_ftp::ERR_FILE_NOT_FOUND));
+            return;
+        }
+        if (sessions_.size() >= max_sessions)
+        {
+            out.append(make_nak(request, mavlink_ftp::ERR_NO_SESSIONS_AVAILABLE));
+            return;
+        }
+        const uint8_t session = next_session_++;
+        sessions_.insert(session, path);
+        mavlink_ftp::payload reply = make_reply(request, true);
+        reply.session = session;
+        const uint32_t size = static_cast<uint32_t>(files_.value(path).size());
+        memcpy(reply.data, &size, sizeof(size));
+        reply.size = sizeof(size);
+        out.append(reply);
+        return;
+    }
+
+    case mavlink_ftp::CMD_BURST_READ_FILE:
+    case mavlink_ftp::CMD_READ_FILE:
+    {
+        if (!sessions_.contains(request.session))
+        {
+            out.append(make_nak(request, mavlink_ftp::ERR_INVALID_SESSION));
+            return;
+        }
+        const QByteArray data = files_.value(sessions_.value(request.session));
+        if (request.offset >= static_cast<uint32_t>(data.size()))
+        {
+            out.append(make_nak(request, mavlink_ftp::ERR_EOF));
+            return;
+        }
+        if (request.opcode == mavlink_ftp::CMD_BURST_READ_FILE)
+        {
+            handle_burst(request, data, out);
+            return;
+        }
+        reads++;
+        mavlink_ftp::payload reply = make_reply(request, true);
+        reply.size = static_cast<uint8_t>(qMin<qint64>(qMin<int>(request.size, mavlink_ftp::max_data), data.size() - request.offset));
+        memcpy(reply.data, data.constData() + request.offset, reply.size);
+        out.append(reply);
+        return;
+    }
+
+    case mavlink_ftp::CMD_LIST_DIRECTORY:
+        handle_list(request, out);
+        return;
+
+    case mavlink_ftp::CMD_TERMINATE_SESSION:
+        if (!sessions_.remove(request.session)) out.append(make_nak(request, mavlink_ftp::ERR_INVALID_SESSION));
+        else out.append(make_reply(request, true));
+        return;
+
+    case mavlink_ftp::CMD_RESET_SESSIONS:
+        reset_sessions();
+        out.append(make_reply(request, true));
+        return;
+
+    default:
+        out.append(make_nak(request, mavlink_ftp::ERR_UNKNOWN_COMMAND));
+        return;
+    }
+}
+
+void ftp_responder::handle_burst(const mavlink_ftp::payload &request, const QByteArray &data, payload_list &out)
+{
+    bursts++;
+    const int first = static_cast<int>(request.offset / mavlink_ftp::max_data);
+    const int chunk_count = static_cast<int>((data.size() + mavlink_ftp::max_data - 1) / mavlink_ftp::max_data);
+    const int last = burst_chunks > 0 ? qMin(chunk_count, first + burst_chunks) - 1 : chunk_count - 1;
+    uint16_t seq = static_cast<uint16_t>(request.seq + 1);
+    for (int chunk = first; chunk <= last; chunk++)
+    {
+        const qint64 offset = static_cast<qint64>(chunk) * mavlink_ftp::max_data;
+        mavlink_ftp::payload reply = make_reply(request, true);
+        reply.seq = seq++;
+        reply.offset = static_cast<uint32_t>(offset);
+        reply.size = static_cast<uint8_t>(qMin<qint64>(mavlink_ftp::max_data, data.size() - offset));
+        memcpy(reply.data, data.constData() + offset, reply.size);
+        reply.burst_complete = chunk == last && !(eof_after_burst && last == chunk_count - 1);
+        if (drop_chunks.remove(chunk)) continue; // lost on the link
+        out.append(reply);
+    }
+    if (eof_after_burst && last == chunk_count - 1)
+    {
+        mavlink_ftp::payload reply = make_nak(request, mavlink_ftp::ERR_EOF);
+        reply.seq = seq;
+        reply.burst_complete = 1;
+        out.append(reply);
+    }
+}
+
+void ftp_responder::handle_list(const mavlink_ftp::payload &request, payload_list &out)
+{
+    QString dir = request_path(request);
+    if (!dir.endsWith('/')) dir += '/';
+
+    // immediate children of dir, in name order
+    QMap<QString, qint64> children; // size, -1 for directories
+    for (auto it = files_.constBegin(); it != files_.constEnd(); ++it)
+    {
+        if (!it.key().startsWith(dir)) continue;
+        const QString rest = it.key().mid(dir.size());
+        const int slash = rest.indexOf('/');
+        if (slash < 0) children.insert(rest, it.value().size());
+        else children.insert(rest.left(slash), -1);
+    }
+    if (children.isEmpty())
+    {
+        out.append(make_nak(request, mavlink_ftp::ERR_FILE_NOT_FOUND));
+        return;
+    }
+    if (request.offset >= static_cast<uint32_t>(children.size()))
+    {
+        out.append(make_nak(request, mavlink_ftp::ERR_EOF));
+        return;
+    }
+
+    mavlink_ftp::payload reply = make_reply(request, true);
+    int index = 0;
+    for (auto it = children.constBegin(); it != children.constEnd(); ++it, ++index)
+    {
+        if (index < static_cast<int>(request.offset)) continue;
+        const QByteArray entry = (it.value() < 0 ? "D" + it.key().toUtf8() : "F" + it.key().toUtf8() + "\t" + QByteArray::number(it.value())) + '\0';
+        if (reply.size + entry.size() > mavlink_ftp::max_data) break;
+        memcpy(reply.data + reply.size, entry.constData(), entry.size());
+        reply.size = static_cast<uint8_t>(reply.size + entry.size());
+    }
+    out.append(reply);
+}
@@ -0,0 +1,84 @@
+/****************************************************************************
+ *
+ *    Copyright (C) 2025  Yevhenii Kovryzhenko. All rights reserved.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU Affero General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License Version 3 for more details.
+ *
+ *    You should have received a copy of the
+ *    GNU Affero General Public License Version 3
+ *    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions, and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions, and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *    3. No ownership or credit shall be claimed by anyone not mentioned in
+ *       the above copyright statement.
+ *    4. Any redistribution or public use of this software, in whole or in part,
+ *       whether standalone or as part of a different project, must remain
+ *       under the terms of the GNU Affero General Public License Version 3,
+ *       and all distributions in binary form must be accompanied by a copy of
+ *       the source code, as stated in the GNU Affero General Public License.
+ *
+ ****************************************************************************/
+
+#ifndef FTP_RESPONDER_H
+#define FTP_RESPONDER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+#include "mavlink_communication/ftp_session.h"
+
+/*
+ * FTP Responder Class
+ *
+ * Minimal in-process stand-in for the vehicle side of MAVLink FTP, serving
+ * files from memory. Covers what ftp_session uses: read-only open, burst and
+ * single reads, directory listing, terminate and reset. Burst packets can be
+ * dropped to simulate a lossy link.
+ */
+class ftp_responder
+{
+public:
+    typedef QVector<mavlink_ftp::payload> payload_list;
+
+    void add_file(const QString &path, const QByteArray &data) { files_.insert(path, data); }
+    void handle(const mavlink_ftp::payload &request, payload_list &out);
+    // forget every open session, as a vehicle reboot would
+    void reset_sessions(void) { sessions_.clear(); }
+    int open_sessions(void) const { return sessions_.size(); }
+
+    QSet<int> drop_chunks;          // burst packets of these chunks are lost, once each
+    int burst_chunks = 0;           // chunks per burst, 0 streams to the end of the file
+    bool eof_after_burst = false;   // a burst that reaches the end is followed by a NAK EOF
+    int max_sessions = 1;
+
+    int bursts = 0;
+    int reads = 0;
+
+private:
+    mavlink_ftp::payload make_reply(const mavlink_ftp::payload &request, bool ack) const;
+    mavlink_ftp::payload make_nak(const mavlink_ftp::payload &request, uint8_t error) const;
+    void handle_burst(const mavlink_ftp::payload &request, const QByteArray &data, payload_list &out);
+    void handle_list(const mavlink_ftp::payload &request, payload_list &out);
+
+    QHash<QString, QByteArray> files_;
+    QHash<uint8_t, QString> sessions_;
+    uint8_t next_session_ = 0;
+};
+
+#endif // FTP_RESPONDER_H
@@ -0,0 +1,348 @@
+/****************************************************************************
+ *
+ *    Copyright (C) 2025  Yevhenii Kovryzhenko. All rights reserved.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU Affero General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License Version 3 for more details.
+ *
+ *    You should have received a copy of the
+ *    GNU Affero General Public License Version 3
+ *    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions, and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions, and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *    3. No ownership or credit shall be claimed by anyone not mentioned in
+ *       the above copyright statement.
+ *    4. Any redistribution or public use of this software, in whole or in part,
+ *       whether standalone or as part of a different project, must remain
+ *       under the terms of the GNU Affero General Public License Version 3,
+ *       and all distributions in binary form must be accompanied by a copy of
+ *       the source code, as stated in the GNU Affero General Public License.
+ *
+ ****************************************************************************/
+
+#include <QtTest>
+
+#include "ftp_responder.h"
+
+/*
+ * Drives ftp_session against the in-process ftp_responder on a simulated
+ * clock: requests are answered at once, and the clock only moves (and the
+ * session's timers run) when nothing is in flight.
+ */
+class memory_sink : public ftp_data_sink
+{
+public:
+    bool allocate(qint64 size) override { data = QByteArray(size, '\0'); return true; }
+    bool write(qint64 offset, const uint8_t* bytes, int size) override
+    {
+        if (fail_writes) return false;
+        memcpy(data.data() + offset, bytes, size);
+        return true;
+    }
+    QString error_QString(void) const override { return "Disk full"; }
+
+    QByteArray data;
+    bool fail_writes = false;
+};
+
+class ftp_session_test : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void download_clean(void);
+    void download_fills_burst_gaps(void);
+    void download_restarts_burst_on_long_gap(void);
+    void download_ends_burst_on_eof(void);
+    void download_recovers_lost_burst_end(void);
+    void download_missing_file(void);
+    void download_fails_after_session_reset(void);
+    void sessions_are_terminated(void);
+    void sink_failure_fails_download(void);
+    void list_directory(void);
+
+private:
+    static constexpr qint64 step_ns = 100000000LL;
+
+    static QByteArray make_file(int size);
+    // returns the number of exchange steps taken, or -1 if the session never finished
+    static int run(ftp_session &session, ftp_responder &responder, qint64 &now_ns, ftp_session::payload_list requests, int max_steps = 10000);
+};
+
+QByteArray ftp_session_test::make_file(int size)
+{
+    QByteArray data(size, '\0');
+    for (int i = 0; i < size; i++) data[i] = static_cast<char>((i * 131 + i / 239) & 0xFF);
+    return data;
+}
+
+int ftp_session_test::run(ftp_session &session, ftp_responder &responder, qint64 &now_ns, ftp_session::payload_list requests, int max_steps)
+{
+    int step = 0;
+    for (; step < max_steps && session.is_active(); step++)
+    {
+        ftp_responder::payload_list replies;
+        for (const mavlink_ftp::payload& request : std::as_const(requests)) responder.handle(request, replies);
+        requests.clear();
+        for (const mavlink_ftp::payload& reply : std::as_const(replies)) session.handle(reply, now_ns, requests);
+        if (requests.isEmpty() && session.is_active())
+        {
+            now_ns += step_ns;
+            session.service(now_ns, requests);
+        }
+    }
+    // deliver what the session sent on the way out (TerminateSession)
+    ftp_responder::payload_list replies;
+    for (const mavlink_ftp::payload& request : std::as_const(requests)) responder.handle(request, replies);
+    return session.is_active() ? -1 : step;
+}
+
+void ftp_session_test::download_clean(void)
+{
+    const QByteArray file = make_file(100 * mavlink_ftp::max_data + 17);
+    ftp_responder responder;
+    responder.add_file("/log/a.ulg", file);
+    memory_sink sink;
+    ftp_session session;
+    qint64 now_ns = 0;
+    ftp_session::payload_list requests;
+    session.start_download("/log/a.ulg", &sink, now_ns, requests);
+    QVERIFY(run(session, responder, now_ns, requests) >= 0);
+
+    const ftp_transfer_status status = session.get_status(now_ns);
+    QCOMPARE(status.phase, int(ftp_transfer_status::DONE));
+    QCOMPARE(status.bytes_received, qint64(file.size()));
+    QCOMPARE(status.bursts, 1);
+    QCOMPARE(status.reads_sent, 0);
+    QCOMPARE(sink.data, file);
+}
+
+void ftp_session_test::download_fills_burst_gaps(void)
+{
+    const QByteArray file = make_file(50 * mavlink_ftp::max_data);
+    ftp_responder responder;
+    responder.add_file("/log/a.ulg", file);
+    responder.drop_chunks = {3, 7, 20};
+    memory_sink sink;
+    ftp_session session;
+    qint64 now_ns = 0;
+    ftp_session::payload_list requests;
+    session.start_download("/log/a.ulg", &sink, now_ns, requests);
+    QVERIFY(run(session, responder, now_ns, requests) >= 0);
+
+    const ftp_transfer_status status = session.get_status(now_ns);
+    QCOMPARE(status.phase, int(ftp_transfer_status::DONE));
+    QCOMPARE(status.bursts, 1);
+    QCOMPARE(status.reads_sent, 3);
+    QCOMPARE(responder.reads, 3);
+    QCOMPARE(sink.data, file);
+}
+
+void ftp_session_test::download_restarts_burst_on_long_gap(void)
+{
+    const QByteArray file = make_file(100 * mavlink_ftp::max_data);
+    ftp_responder responder;
+    responder.add_file("/log/a.ulg", file);
+    for (int chunk = 10; chunk < 60; chunk++) responder.drop_chunks.insert(chunk);
+    memory_sink sink;
+    ftp_session session;
+    qint64 now_ns = 0;
+    ftp_session::payload_list requests;
+    session.start_download("/log/a.ulg", &sink, now_ns, requests);
+    QVERIFY(run(session, responder, now_ns, requests) >= 0);
+
+    const ftp_transfer_status status = session.get_status(now_ns);
+    QCOMPARE(status.phase, int(ftp_transfer_status::DONE));
+    QCOMPARE(status.bursts, 2);
+    QCOMPARE(status.reads_sent, 0);
+    QCOMPARE(sink.data, file);
+}
+
+void ftp_session_test::download_ends_burst_on_eof(void)
+{
+    // the last chunk is lost and the responder says EOF: no need to wait for the burst to stall
+    const QByteArray file = make_file(20 * mavlink_ftp::max_data + 5);
+    ftp_responder responder;
+    responder.add_file("/log/a.ulg", file);
+    responder.eof_after_burst = true;
+    responder.drop_chunks = {20};
+    memory_sink sink;
+    ftp_session session;
+    qint64 now_ns = 0;
+    ftp_session::payload_list requests;
+    session.start_download("/log/a.ulg", &sink, now_ns, requests);
+    QVERIFY(run(session, responder, now_ns, requests) >= 0);
+
+    const ftp_transfer_status status = session.get_status(now_ns);
+    QCOMPARE(status.phase, int(ftp_transfer_status::DONE));
+    QCOMPARE(status.reads_sent, 1);
+    QVERIFY(now_ns < ftp_session::burst_stall_ns);
+    QCOMPARE(sink.data, file);
+}
+
+void ftp_session_test::download_recovers_lost_burst_end(void)
+{
+    // the packet carrying burst_complete is lost: the burst has to time out
+    const QByteArray file = make_file(20 * mavlink_ftp::max_data);
+    ftp_responder responder;
+    responder.add_file("/log/a.ulg", file);
+    responder.drop_chunks = {19};
+    memory_sink sink;
+    ftp_session session;
+    qint64 now_ns = 0;
+    ftp_session::payload_list requests;
+    session.start_download("/log/a.ulg", &sink, now_ns, requests);
+    QVERIFY(run(session, responder, now_ns, requests) >= 0);
+
+    const ftp_transfer_status status = session.get_status(now_ns);
+    QCOMPARE(status.phase, int(ftp_transfer_status::DONE));
+    QCOMPARE(status.reads_sent, 1);
+    QVERIFY(now_ns > ftp_session::burst_stall_ns);
+    QCOMPARE(sink.data, file);
+}
+
+void ftp_session_test::download_missing_file(void)
+{
+    ftp_responder responder;
+    memory_sink sink;
+    ftp_session session;
+    qint64 now_ns = 0;
+    ftp_session::payload_list requests;
+    session.start_download("/log/missing.ulg", &sink, now_ns, requests);
+    QVERIFY(run(session, responder, now_ns, requests) >= 0);
+
+    const ftp_transfer_status status = session.get_status(now_ns);
+    QCOMPARE(status.phase, int(ftp_transfer_status::FAILED));
+    QCOMPARE(status.error, QString("File not found"));
+    QCOMPARE(responder.open_sessions(), 0);
+}
+
+void ftp_session_test::download_fails_after_session_reset(void)
+{
+    const QByteArray file = make_file(60 * mavlink_ftp::max_data);
+    ftp_responder responder;
+    responder.add_file("/log/a.ulg", file);
+    responder.burst_chunks = 8; // 52 chunks left after the first burst: the session bursts again
+    memory_sink sink;
+    ftp_session session;
+    qint64 now_ns = 0;
+    ftp_session::payload_list requests;
+    session.start_download("/log/a.ulg", &sink, now_ns, requests);
+
+    // open, then the first burst
+    for (int step = 0; step < 2; step++)
+    {
+        ftp_responder::payload_list replies;
+        for (const mavlink_ftp::payload& request : std::as_const(requests)) responder.handle(request, replies);
+        requests.clear();
+        for (const mavlink_ftp::payload& reply : std::as_const(replies)) session.handle(reply, now_ns, requests);
+    }
+    QCOMPARE(session.get_status(now_ns).chunks_received, 8);
+    QCOMPARE(responder.open_sessions(), 1);
+
+    responder.reset_sessions();
+    QVERIFY(run(session, responder, now_ns, requests) >= 0);
+
+    const ftp_transfer_status status = session.get_status(now_ns);
+    QCOMPARE(status.phase, int(ftp_transfer_status::FAILED));
+    QCOMPARE(status.error, QString("Invalid session"));
+    QCOMPARE(responder.open_sessions(), 0);
+}
+
+void ftp_session_test::sessions_are_terminated(void)
+{
+    // the responder has a single session: a second download only opens if the first was closed
+    const QByteArray file = make_file(3 * mavlink_ftp::max_data);
+    ftp_responder responder;
+    responder.add_file("/log/a.ulg", file);
+    memory_sink sink;
+    ftp_session session;
+    qint64 now_ns = 0;
+    ftp_session::payload_list requests;
+    for (int i = 0; i < 2; i++)
+    {
+        requests.clear();
+        session.start_download("/log/a.ulg", &sink, now_ns, requests);
+        QVERIFY(run(session, responder, now_ns, requests) >= 0);
+        QCOMPARE(session.get_status(now_ns).phase, int(ftp_transfer_status::DONE));
+        QCOMPARE(responder.open_sessions(), 0);
+    }
+
+    // a cancelled download closes its session as well
+    requests.clear();
+    session.start_download("/log/a.ulg", &sink, now_ns, requests);
+    ftp_responder::payload_list replies;
+    for (const mavlink_ftp::payload& request : std::as_const(requests)) responder.handle(request, replies);
+    requests.clear();
+    for (const mavlink_ftp::payload& reply : std::as_const(replies)) session.handle(reply, now_ns, requests);
+    QCOMPARE(responder.open_sessions(), 1);
+    session.cancel(now_ns, requests);
+    QVERIFY(run(session, responder, now_ns, requests) >= 0);
+    QCOMPARE(session.get_status(now_ns).error, QString("Cancelled"));
+    QCOMPARE(responder.open_sessions(), 0);
+}
+
+void ftp_session_test::sink_failure_fails_download(void)
+{
+    ftp_responder responder;
+    responder.add_file("/log/a.ulg", make_file(10 * mavlink_ftp::max_data));
+    memory_sink sink;
+    sink.fail_writes = true;
+    ftp_session session;
+    qint64 now_ns = 0;
+    ftp_session::payload_list requests;
+    session.start_download("/log/a.ulg", &sink, now_ns, requests);
+    QVERIFY(run(session, responder, now_ns, requests) >= 0);
+
+    const ftp_transfer_status status = session.get_status(now_ns);
+    QCOMPARE(status.phase, int(ftp_transfer_status::FAILED));
+    QCOMPARE(status.error, QString("Disk full"));
+    QCOMPARE(responder.open_sessions(), 0);
+}
+
+void ftp_session_test::list_directory(void)
+{
+    // enough entries to need several ListDirectory replies
+    ftp_responder responder;
+    QStringList expected;
+    for (int i = 0; i < 40; i++)
+    {
+        const QString name = QString("log_%1_with_a_long_name.ulg").arg(i, 3, 10, QChar('0'));
+        responder.add_file("/log/" + name, make_file(i + 1));
+        expected.append(name);
+    }
+    responder.add_file("/log/sub/c.ulg", make_file(1));
+    expected.append("sub");
+    ftp_session session;
+    qint64 now_ns = 0;
+    ftp_session::payload_list requests;
+    session.start_list("/log", now_ns, requests);
+    const int steps = run(session, responder, now_ns, requests);
+    QVERIFY(steps > 2);
+
+    QCOMPARE(session.get_status(now_ns).phase, int(ftp_transfer_status::DONE));
+    QStringList names;
+    for (const ftp_entry& entry : session.entries())
+    {
+        names.append(entry.name);
+        QCOMPARE(entry.is_directory, entry.name == "sub");
+        if (!entry.is_directory) QCOMPARE(entry.size, qint64(entry.name.mid(4, 3).toInt() + 1));
+    }
+    QCOMPARE(names, expected);
+}
+
+QTEST_APPLESS_MAIN(ftp_session_test)
+
+#include "ftp_session_test.moc"